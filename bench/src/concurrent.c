@@ -0,0 +1,83 @@
+#include <stdio.h>
+#include <time.h>
+
+#include "levelz.h"
+
+// Each worker fills its own slab of a SIZE^3 world, so workers touch disjoint chunks.
+#define SIZE 128
+
+typedef struct Worker {
+    ConcurrentLevel3D* level;
+    Block* block;
+    int from;
+    int to;
+} Worker;
+
+void* fill(void* arg) {
+    Worker* w = (Worker*) arg;
+    for (int x = w->from; x < w->to; x++)
+        for (int y = 0; y < SIZE; y++)
+            for (int z = 0; z < SIZE; z++)
+                ConcurrentLevel3D_addBlock(w->level, createLevelObject3DAt(w->block, makeCoordinate3D(x, y, z)));
+
+    return 0;
+}
+
+double now() {
+    struct timespec t;
+    timespec_get(&t, TIME_UTC);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+double run(int threads, int stripes) {
+    ConcurrentLevel3D* level = createConcurrentLevel3D(stripes);
+    Block* block = createBlock("stone");
+
+    __Thread* handles = (__Thread*) malloc(threads * sizeof(__Thread));
+    Worker* workers = (Worker*) malloc(threads * sizeof(Worker));
+
+    double start = now();
+    for (int i = 0; i < threads; i++) {
+        workers[i].level = level;
+        workers[i].block = block;
+        workers[i].from = SIZE * i / threads;
+        workers[i].to = SIZE * (i + 1) / threads;
+        __Thread_create(&handles[i], fill, &workers[i]);
+    }
+
+    for (int i = 0; i < threads; i++)
+        __Thread_join(handles[i]);
+    double elapsed = now() - start;
+
+    if (ConcurrentLevel3D_getBlockCount(level) != SIZE * SIZE * SIZE)
+        printf("unexpected block count %d\n", ConcurrentLevel3D_getBlockCount(level));
+
+    // the level does not free its blocks; each object embeds its coordinate and shares one block
+    for (int i = 0; i < level->stripeCount; i++)
+        for (int j = 0; j < level->stripes[i].capacity; j++)
+            free(level->stripes[i].objects[j]);
+
+    free(handles);
+    free(workers);
+    ConcurrentLevel3D_free(level);
+    __Block_free(block);
+    return elapsed;
+}
+
+int main() {
+    int cpus = __cpuCount();
+    int cells = SIZE * SIZE * SIZE;
+    printf("%d cells, %d cpus\n", cells, cpus);
+    printf("%8s %12s %14s %10s %14s\n", "threads", "striped (s)", "Mcells/s", "speedup", "1 lock (s)");
+
+    double base = 0;
+    for (int threads = 1; threads <= 2 * cpus; threads *= 2) {
+        double striped = run(threads, 0);
+        double single = run(threads, 1);
+        if (threads == 1) base = striped;
+
+        printf("%8d %12.3f %14.2f %10.2f %14.3f\n", threads, striped, cells / striped / 1e6, base / striped, single);
+    }
+
+    return 0;
+}
@@ -5,11 +5,21 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <stdarg.h>
 
 #include "levelz/coordinate.h"
 #include "levelz/block.h"
 #include "levelz/level.h"
 #include "levelz/matrix.h"
+#include "levelz/chunk.h"
+#include "levelz/snapshot.h"
+#include "levelz/concurrent.h"
+#include "levelz/merge.h"
+#include "levelz/mesh.h"
+#include "levelz/collision.h"
+#include "levelz/components.h"
+#include "levelz/path.h"
+#include "levelz/viewport.h"
 
 /**
  * Marks the end of the header section
@@ -21,8 +31,177 @@ const char* LEVELZ_HEADER_END = "---";
  */
 const char* LEVELZ_END = "end";
 
+/**
+ * Limits applied while reading a level, so that hostile files fail before anything
+ * large is allocated. A limit of 0 means no limit.
+ */
+typedef struct LevelParseOptions {
+    /**
+     * The maximum number of block cells in the level, counting every coordinate
+     * of every line, including cells that replace earlier ones.
+     */
+    int64_t maxCells;
+
+    /**
+     * The maximum number of cells of a single coordinate matrix.
+     */
+    int64_t maxMatrixVolume;
+
+    /**
+     * The maximum length of a line, in bytes.
+     */
+    size_t maxLineLength;
+
+    /**
+     * The maximum number of properties of a single block.
+     */
+    int maxProperties;
+
+    /**
+     * The maximum memory the level may take while it is read, in bytes. Memory is
+     * estimated from the input, headers, blocks and cells before they are allocated.
+     */
+    size_t maxMemory;
+} LevelParseOptions;
+
+/**
+ * The outcome of reading a level.
+ */
+typedef enum LevelParseStatus {
+    /**
+     * The level was read.
+     */
+    LEVEL_PARSE_OK,
+
+    /**
+     * The file could not be opened.
+     */
+    LEVEL_PARSE_UNREADABLE,
+
+    /**
+     * The type header does not match the dimension being read.
+     */
+    LEVEL_PARSE_WRONG_TYPE,
+
+    /**
+     * A line could not be read, such as a coordinate missing a value or a header without a name.
+     */
+    LEVEL_PARSE_MALFORMED,
+
+    /**
+     * A line is longer than maxLineLength.
+     */
+    LEVEL_PARSE_LINE_TOO_LONG,
+
+    /**
+     * A block has more properties than maxProperties.
+     */
+    LEVEL_PARSE_TOO_MANY_PROPERTIES,
+
+    /**
+     * A coordinate matrix has more cells than maxMatrixVolume, or than fit in an int.
+     */
+    LEVEL_PARSE_MATRIX_TOO_LARGE,
+
+    /**
+     * The level has more cells than maxCells.
+     */
+    LEVEL_PARSE_TOO_MANY_CELLS,
+
+    /**
+     * The level would take more memory than maxMemory.
+     */
+    LEVEL_PARSE_OUT_OF_BUDGET
+} LevelParseStatus;
+
+/**
+ * Describes why reading a level failed.
+ */
+typedef struct LevelParseError {
+    /**
+     * The outcome of reading the level.
+     */
+    LevelParseStatus status;
+
+    /**
+     * The line the failure was found on, starting at 1, or 0 if it is not tied to a line.
+     */
+    int line;
+
+    /**
+     * The value that went over the limit, such as the volume of a matrix.
+     */
+    int64_t value;
+
+    /**
+     * The limit that was broken.
+     */
+    int64_t limit;
+} LevelParseError;
+
 // Internal
 
+// Tracks what reading a level has used so far against its options, which may be 0.
+typedef struct __LevelParseBudget {
+    LevelParseOptions* options;
+    LevelParseError* error;
+    int line;
+    int64_t cells;
+    int64_t memory;
+
+    // the estimated memory of one cell, from parsing until it is a block in the level
+    int64_t cellBytes;
+} __LevelParseBudget;
+
+// Records a broken limit. Always returns 0, so checks can fail with its result.
+int __LevelParseBudget_fail(__LevelParseBudget* budget, LevelParseStatus status, int64_t value, int64_t limit) {
+    if (budget == 0) return 0;
+
+    budget->error->status = status;
+    budget->error->line = budget->line;
+    budget->error->value = value;
+    budget->error->limit = limit;
+    return 0;
+}
+
+int __LevelParseBudget_check(__LevelParseBudget* budget, LevelParseStatus status, int64_t value, int64_t limit) {
+    if (limit <= 0 || value <= limit) return 1;
+
+    return __LevelParseBudget_fail(budget, status, value, limit);
+}
+
+// Records input that could not be read, unless a limit was already broken by it.
+int __LevelParseBudget_malformed(__LevelParseBudget* budget) {
+    if (budget == 0 || budget->error->status != LEVEL_PARSE_OK) return 0;
+
+    return __LevelParseBudget_fail(budget, LEVEL_PARSE_MALFORMED, 0, 0);
+}
+
+// Accounts for memory about to be allocated.
+int __LevelParseBudget_spend(__LevelParseBudget* budget, int64_t bytes) {
+    if (budget == 0 || budget->options == 0) return 1;
+
+    budget->memory = bytes > INT64_MAX - budget->memory ? INT64_MAX : budget->memory + bytes;
+    return __LevelParseBudget_check(budget, LEVEL_PARSE_OUT_OF_BUDGET, budget->memory, (int64_t) budget->options->maxMemory);
+}
+
+// Accounts for the cells of a matrix, or of a single point, before they are expanded.
+// Matrices are also capped so the coordinates of a line can be counted with an int.
+int __LevelParseBudget_addCells(__LevelParseBudget* budget, int64_t volume, int length) {
+    if (volume > INT_MAX - 1 - length)
+        return __LevelParseBudget_fail(budget, LEVEL_PARSE_MATRIX_TOO_LARGE, volume, INT_MAX - 1 - length);
+
+    if (budget == 0 || budget->options == 0) return 1;
+
+    LevelParseOptions* options = budget->options;
+    if (!__LevelParseBudget_check(budget, LEVEL_PARSE_MATRIX_TOO_LARGE, volume, options->maxMatrixVolume)) return 0;
+
+    budget->cells += volume;
+    if (!__LevelParseBudget_check(budget, LEVEL_PARSE_TOO_MANY_CELLS, budget->cells, options->maxCells)) return 0;
+
+    return __LevelParseBudget_spend(budget, __multiplyCounts(volume, budget->cellBytes));
+}
+
 char* __trim(const char* str) {
     char* str0 = (char*) malloc(strlen(str) + 1);
     strcpy(str0, str);
@@ -31,7 +210,7 @@ char* __trim(const char* str) {
     while (isspace(str0[i])) i++;
 
     int j = strlen(str0) - 1;
-    while (isspace(str0[j])) j--;
+    while (j >= i && isspace(str0[j])) j--;
 
     char* str1 = (char*) malloc(j - i + 2);
     strncpy(str1, str0 + i, j - i + 1);
@@ -41,6 +220,258 @@ char* __trim(const char* str) {
     return str1;
 }
 
+void __appendf(char** str, size_t* length, size_t* capacity, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+
+    va_list copy;
+    va_copy(copy, args);
+    int size = vsnprintf(0, 0, format, copy);
+    va_end(copy);
+
+    if (*length + size + 1 > *capacity) {
+        size_t newCapacity = *capacity == 0 ? 64 : *capacity;
+        while (*length + size + 1 > newCapacity) newCapacity *= 2;
+
+        *str = (char*) realloc(*str, newCapacity);
+        *capacity = newCapacity;
+    }
+
+    vsnprintf(*str + *length, size + 1, format, args);
+    *length += size;
+    va_end(args);
+}
+
+void __appendDouble(char** str, size_t* length, size_t* capacity, double d) {
+    char buffer[32];
+    __formatDouble(buffer, sizeof(buffer), d);
+
+    __appendf(str, length, capacity, "%s", buffer);
+}
+
+char* __copyString(const char* str) {
+    return strcpy((char*) malloc(strlen(str) + 1), str);
+}
+
+typedef struct __BlockEntry {
+    char* key;
+    int index;
+} __BlockEntry;
+
+int __compareBlockEntries(const void* a, const void* b) {
+    int c = strcmp(((const __BlockEntry*) a)->key, ((const __BlockEntry*) b)->key);
+    if (c != 0) return c;
+
+    return ((const __BlockEntry*) a)->index - ((const __BlockEntry*) b)->index;
+}
+
+void __appendCoordinate2D(char** str, size_t* length, size_t* capacity, Coordinate2D* c) {
+    __appendf(str, length, capacity, "[");
+    __appendDouble(str, length, capacity, c->x);
+    __appendf(str, length, capacity, ", ");
+    __appendDouble(str, length, capacity, c->y);
+    __appendf(str, length, capacity, "]");
+}
+
+void __appendCoordinate3D(char** str, size_t* length, size_t* capacity, Coordinate3D* c) {
+    __appendf(str, length, capacity, "[");
+    __appendDouble(str, length, capacity, c->x);
+    __appendf(str, length, capacity, ", ");
+    __appendDouble(str, length, capacity, c->y);
+    __appendf(str, length, capacity, ", ");
+    __appendDouble(str, length, capacity, c->z);
+    __appendf(str, length, capacity, "]");
+}
+
+// Writes one line per distinct block. Blocks on whole-number coordinates are merged
+// into boxes, so filled regions are written as a few matrices instead of every cell.
+void __appendBlocks2D(char** str, size_t* length, size_t* capacity, LevelObject2D** blocks, int count, const char* prefix) {
+    if (count == 0) return;
+
+    __BlockEntry* entries = (__BlockEntry*) malloc(count * sizeof(__BlockEntry));
+    for (int i = 0; i < count; i++) {
+        entries[i].key = Block_toString(blocks[i]->block);
+        entries[i].index = i;
+    }
+
+    qsort(entries, count, sizeof(__BlockEntry), __compareBlockEntries);
+
+    __Cell2D* cells = (__Cell2D*) malloc(count * sizeof(__Cell2D));
+    for (int i = 0; i < count;) {
+        int end = i + 1;
+        while (end < count && strcmp(entries[end].key, entries[i].key) == 0) end++;
+
+        __appendf(str, length, capacity, "%s%s: ", prefix, entries[i].key);
+
+        int written = 0;
+        int cellCount = 0;
+        for (int j = i; j < end; j++) {
+            Coordinate2D* c = blocks[entries[j].index]->coordinate;
+            if (__isCell(c->x) && __isCell(c->y)) {
+                cells[cellCount].x = (int) c->x;
+                cells[cellCount].y = (int) c->y;
+                cellCount++;
+            } else {
+                if (written++ > 0) __appendf(str, length, capacity, "*");
+                __appendCoordinate2D(str, length, capacity, c);
+            }
+        }
+
+        __Box2D* boxes;
+        int boxCount = __mergeCells2D(cells, cellCount, &boxes);
+        for (int k = 0; k < boxCount; k++) {
+            if (written++ > 0) __appendf(str, length, capacity, "*");
+
+            if (boxes[k].minX == boxes[k].maxX && boxes[k].minY == boxes[k].maxY)
+                __appendf(str, length, capacity, "[%d, %d]", boxes[k].minX, boxes[k].minY);
+            else
+                __appendf(str, length, capacity, "(%d, %d, %d, %d)^[0, 0]", boxes[k].minX, boxes[k].maxX, boxes[k].minY, boxes[k].maxY);
+        }
+        free(boxes);
+
+        __appendf(str, length, capacity, "\n");
+        i = end;
+    }
+    free(cells);
+
+    for (int i = 0; i < count; i++)
+        free(entries[i].key);
+    free(entries);
+}
+
+// Writes one line per distinct block. Blocks on whole-number coordinates are merged
+// into boxes, so filled regions are written as a few matrices instead of every cell.
+void __appendBlocks3D(char** str, size_t* length, size_t* capacity, LevelObject3D** blocks, int count, const char* prefix) {
+    if (count == 0) return;
+
+    __BlockEntry* entries = (__BlockEntry*) malloc(count * sizeof(__BlockEntry));
+    for (int i = 0; i < count; i++) {
+        entries[i].key = Block_toString(blocks[i]->block);
+        entries[i].index = i;
+    }
+
+    qsort(entries, count, sizeof(__BlockEntry), __compareBlockEntries);
+
+    __Cell3D* cells = (__Cell3D*) malloc(count * sizeof(__Cell3D));
+    for (int i = 0; i < count;) {
+        int end = i + 1;
+        while (end < count && strcmp(entries[end].key, entries[i].key) == 0) end++;
+
+        __appendf(str, length, capacity, "%s%s: ", prefix, entries[i].key);
+
+        int written = 0;
+        int cellCount = 0;
+        for (int j = i; j < end; j++) {
+            Coordinate3D* c = blocks[entries[j].index]->coordinate;
+            if (__isCell(c->x) && __isCell(c->y) && __isCell(c->z)) {
+                cells[cellCount].x = (int) c->x;
+                cells[cellCount].y = (int) c->y;
+                cells[cellCount].z = (int) c->z;
+                cellCount++;
+            } else {
+                if (written++ > 0) __appendf(str, length, capacity, "*");
+                __appendCoordinate3D(str, length, capacity, c);
+            }
+        }
+
+        __Box3D* boxes;
+        int boxCount = __mergeCells3D(cells, cellCount, &boxes);
+        for (int k = 0; k < boxCount; k++) {
+            if (written++ > 0) __appendf(str, length, capacity, "*");
+
+            if (boxes[k].minX == boxes[k].maxX && boxes[k].minY == boxes[k].maxY && boxes[k].minZ == boxes[k].maxZ)
+                __appendf(str, length, capacity, "[%d, %d, %d]", boxes[k].minX, boxes[k].minY, boxes[k].minZ);
+            else
+                __appendf(str, length, capacity, "(%d, %d, %d, %d, %d, %d)^[0, 0, 0]", boxes[k].minX, boxes[k].maxX, boxes[k].minY, boxes[k].maxY, boxes[k].minZ, boxes[k].maxZ);
+        }
+        free(boxes);
+
+        __appendf(str, length, capacity, "\n");
+        i = end;
+    }
+    free(cells);
+
+    for (int i = 0; i < count; i++)
+        free(entries[i].key);
+    free(entries);
+}
+
+char* __nextLine(char** cursor) {
+    char* line = *cursor;
+    if (line == 0 || *line == 0) return 0;
+
+    char* end = strchr(line, '\n');
+    if (end == 0) {
+        *cursor = line + strlen(line);
+    } else {
+        *end = '\0';
+        *cursor = end + 1;
+    }
+
+    return line;
+}
+
+// Gets the length of a file in bytes without reading it, or -1 if it cannot be opened.
+long __fileLength(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (file == 0) return -1;
+
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fclose(file);
+
+    return length;
+}
+
+char* __readFile(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (file == 0) return 0;
+
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    char* buffer = (char*) malloc(length + 1);
+    size_t read = fread(buffer, 1, length, file);
+    buffer[read] = '\0';
+    fclose(file);
+
+    return buffer;
+}
+
+int __temporaryFiles = 0;
+
+int __writeFileAtomic(const char* path, const char* data, size_t length) {
+    // the temporary name is unique, so concurrent writers never share a file
+    char* temp = (char*) malloc(strlen(path) + 32);
+    sprintf(temp, "%s.%d.%d.tmp", path, __processId(), __atomicIncrement(&__temporaryFiles));
+
+    FILE* file = fopen(temp, "wb");
+    if (file == 0) {
+        free(temp);
+        return 0;
+    }
+
+    size_t written = fwrite(data, 1, length, file);
+    int closed = fclose(file);
+    if (written != length || closed != 0) {
+        remove(temp);
+        free(temp);
+        return 0;
+    }
+
+    // replace the destination in one step, so a crash leaves either the old or the new file
+#ifdef _WIN32
+    int renamed = MoveFileExA(temp, path, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    int renamed = rename(temp, path) == 0;
+#endif
+    if (!renamed) remove(temp);
+
+    free(temp);
+    return renamed;
+}
+
 LevelHeader** __readHeaders(char** input) {
     LevelHeader** headers = 0;
 
@@ -63,12 +494,20 @@ LevelHeader** __readHeaders(char** input) {
     return headers;
 }
 
-Coordinate2D** __read2DPoints(const char* input) {
+void __free2DPoints(Coordinate2D** points, int length) {
+    for (int i = 0; i < length; i++)
+        free(points[i]);
+    free(points);
+}
+
+Coordinate2D** __read2DPointsWithin(const char* input, __LevelParseBudget* budget) {
     Coordinate2D** points = 0;
+    int length = 0;
 
     char* trimmed = __trim(input);
     char* str0 = (char*) malloc(strlen(trimmed) + 1);
     strcpy(str0, trimmed);
+    free(trimmed);
 
     char* start = str0;
     char* end;
@@ -81,49 +520,53 @@ Coordinate2D** __read2DPoints(const char* input) {
 
         if (token[0] == '(') {
             CoordinateMatrix2D* matrix = CoordinateMatrix2D_fromString(token);
+            free(token);
             if (matrix == 0) {
+                __LevelParseBudget_malformed(budget);
+                __free2DPoints(points, length);
                 free(str0);
                 return 0;
             }
-            
-            int size = CoordinateMatrix2D_size(matrix);
-
-            if (points == 0)
-                points = CoordinateMatrix2D_coordinates(matrix);
-            else {
-                int length = 0;
-                while (points[length] != 0) length++;
 
-                points = (Coordinate2D**) realloc(points, (length + size + 1) * sizeof(Coordinate2D));
+            // the size is checked before the points are allocated
+            int64_t volume = CoordinateMatrix2D_volume(matrix);
+            if (!__LevelParseBudget_addCells(budget, volume, length)) {
+                free(matrix->start);
+                free(matrix);
+                __free2DPoints(points, length);
+                free(str0);
+                return 0;
+            }
 
-                Coordinate2D** matrixPoints = CoordinateMatrix2D_coordinates(matrix);
-                for (int i = 0; i < size; i++) {
-                    points[length + i] = matrixPoints[i];
-                }
+            int size = (int) volume;
+            points = (Coordinate2D**) realloc(points, (length + size + 1) * sizeof(Coordinate2D*));
 
-                points[length + size] = 0;
+            CoordinateMatrix2DCursor cursor = CoordinateMatrix2D_cursor(matrix, COORDINATE_MATRIX_ROW_MAJOR);
+            while (CoordinateMatrix2DCursor_next(&cursor)) {
+                points[length + cursor.index] = (Coordinate2D*) malloc(sizeof(Coordinate2D));
+                *points[length + cursor.index] = cursor.coordinate;
             }
+
+            points[length + size] = 0;
+            length += size;
+
+            free(matrix->start);
+            free(matrix);
         } else {
-            Coordinate2D* point = Coordinate2D_fromString(token);
+            Coordinate2D* point = __LevelParseBudget_addCells(budget, 1, length) ? Coordinate2D_fromString(token) : 0;
+            free(token);
 
             if (point == 0) {
+                __LevelParseBudget_malformed(budget);
+                __free2DPoints(points, length);
                 free(str0);
                 return 0;
             }
 
-            if (points == 0) {
-                points = (Coordinate2D**) malloc(2 * sizeof(Coordinate2D));
-                points[0] = point;
-                points[1] = 0;
-            } else {
-                int length = 0;
-                while (points[length] != 0) length++;
-
-                points = (Coordinate2D**) realloc(points, (length + 2) * sizeof(Coordinate2D));
-                
-                points[length] = point;
-                points[length + 1] = 0;
-            }
+            points = (Coordinate2D**) realloc(points, (length + 2) * sizeof(Coordinate2D*));
+            points[length] = point;
+            points[length + 1] = 0;
+            length++;
         }
 
         start = (*end) ? end + 1 : end;
@@ -133,12 +576,24 @@ Coordinate2D** __read2DPoints(const char* input) {
     return points;
 }
 
-Coordinate3D** __read3DPoints(char* input) {
+Coordinate2D** __read2DPoints(const char* input) {
+    return __read2DPointsWithin(input, 0);
+}
+
+void __free3DPoints(Coordinate3D** points, int length) {
+    for (int i = 0; i < length; i++)
+        free(points[i]);
+    free(points);
+}
+
+Coordinate3D** __read3DPointsWithin(const char* input, __LevelParseBudget* budget) {
     Coordinate3D** points = 0;
+    int length = 0;
 
     char* trimmed = __trim(input);
     char* str0 = (char*) malloc(strlen(trimmed) + 1);
     strcpy(str0, trimmed);
+    free(trimmed);
 
     char* start = str0;
     char* end;
@@ -151,49 +606,53 @@ Coordinate3D** __read3DPoints(char* input) {
 
         if (token[0] == '(') {
             CoordinateMatrix3D* matrix = CoordinateMatrix3D_fromString(token);
+            free(token);
             if (matrix == 0) {
+                __LevelParseBudget_malformed(budget);
+                __free3DPoints(points, length);
                 free(str0);
                 return 0;
             }
-            
-            int size = CoordinateMatrix3D_size(matrix);
-
-            if (points == 0)
-                points = CoordinateMatrix3D_coordinates(matrix);
-            else {
-                int length = 0;
-                while (points[length] != 0) length++;
 
-                points = (Coordinate3D**) realloc(points, (length + size + 1) * sizeof(Coordinate3D));
+            // the size is checked before the points are allocated
+            int64_t volume = CoordinateMatrix3D_volume(matrix);
+            if (!__LevelParseBudget_addCells(budget, volume, length)) {
+                free(matrix->start);
+                free(matrix);
+                __free3DPoints(points, length);
+                free(str0);
+                return 0;
+            }
 
-                Coordinate3D** matrixPoints = CoordinateMatrix3D_coordinates(matrix);
-                for (int i = 0; i < size; i++) {
-                    points[length + i] = matrixPoints[i];
-                }
+            int size = (int) volume;
+            points = (Coordinate3D**) realloc(points, (length + size + 1) * sizeof(Coordinate3D*));
 
-                points[length + size] = 0;
+            CoordinateMatrix3DCursor cursor = CoordinateMatrix3D_cursor(matrix, COORDINATE_MATRIX_ROW_MAJOR);
+            while (CoordinateMatrix3DCursor_next(&cursor)) {
+                points[length + cursor.index] = (Coordinate3D*) malloc(sizeof(Coordinate3D));
+                *points[length + cursor.index] = cursor.coordinate;
             }
+
+            points[length + size] = 0;
+            length += size;
+
+            free(matrix->start);
+            free(matrix);
         } else {
-            Coordinate3D* point = Coordinate3D_fromString(token);
+            Coordinate3D* point = __LevelParseBudget_addCells(budget, 1, length) ? Coordinate3D_fromString(token) : 0;
+            free(token);
 
             if (point == 0) {
+                __LevelParseBudget_malformed(budget);
+                __free3DPoints(points, length);
                 free(str0);
                 return 0;
             }
 
-            if (points == 0) {
-                points = (Coordinate3D**) malloc(2 * sizeof(Coordinate3D));
-                points[0] = point;
-                points[1] = 0;
-            } else {
-                int length = 0;
-                while (points[length] != 0) length++;
-
-                points = (Coordinate3D**) realloc(points, (length + 2) * sizeof(Coordinate3D));
-                
-                points[length] = point;
-                points[length + 1] = 0;
-            }
+            points = (Coordinate3D**) realloc(points, (length + 2) * sizeof(Coordinate3D*));
+            points[length] = point;
+            points[length + 1] = 0;
+            length++;
         }
 
         start = (*end) ? end + 1 : end;
@@ -203,102 +662,352 @@ Coordinate3D** __read3DPoints(char* input) {
     return points;
 }
 
+Coordinate3D** __read3DPoints(char* input) {
+    return __read3DPointsWithin(input, 0);
+}
+
 typedef struct LevelZLine2D {
     Block* block;
     Coordinate2D** coordinates;
 } LevelZLine2D;
 
-LevelZLine2D* __read2DLine(const char* input) {
+// Counts the properties of a block string, which come as name=value pairs.
+int __countProperties(const char* str) {
+    int count = 0;
+    for (const char* c = str; *c != 0; c++)
+        if (*c == '=') count++;
+
+    return count;
+}
+
+LevelZLine2D* __read2DLineWithin(const char* input, __LevelParseBudget* budget) {
     LevelZLine2D* line = (LevelZLine2D*) malloc(sizeof(LevelZLine2D));
+    line->block = 0;
+    line->coordinates = 0;
 
     char* str0 = (char*) malloc(strlen(input) + 1);
     strcpy(str0, input);
 
-    char* blockStr = __trim(strtok(str0, ":"));
-    char* coordinateStr = __trim(strtok(0, ":"));
+    char* blockToken = strtok(str0, ":");
+    char* coordinateToken = strtok(0, ":");
+    if (blockToken == 0 || coordinateToken == 0) {
+        __LevelParseBudget_malformed(budget);
+        free(str0);
+        return line;
+    }
+
+    char* blockStr = __trim(blockToken);
+    char* coordinateStr = __trim(coordinateToken);
 
-    Block* block = Block_fromString(blockStr);
-    Coordinate2D** coordinates = __read2DPoints(coordinateStr);
+    int properties = __countProperties(blockStr);
+    if (budget != 0 && budget->options != 0) {
+        if (!__LevelParseBudget_check(budget, LEVEL_PARSE_TOO_MANY_PROPERTIES, properties, budget->options->maxProperties)
+            || !__LevelParseBudget_spend(budget, sizeof(Block) + strlen(blockStr) + properties * sizeof(BlockProperty))) {
+            free(blockStr);
+            free(coordinateStr);
+            free(str0);
+            return line;
+        }
+    }
 
-    line->block = block;
-    line->coordinates = coordinates;
+    line->block = Block_fromString(blockStr);
+    line->coordinates = line->block != 0 ? __read2DPointsWithin(coordinateStr, budget) : 0;
+    if (line->coordinates == 0) __LevelParseBudget_malformed(budget);
 
+    free(blockStr);
+    free(coordinateStr);
     free(str0);
     return line;
 }
 
+LevelZLine2D* __read2DLine(const char* input) {
+    return __read2DLineWithin(input, 0);
+}
+
 typedef struct LevelZLine3D {
     Block* block;
     Coordinate3D** coordinates;
 } LevelZLine3D;
 
-LevelZLine3D* __read3DLine(const char* input) {
+LevelZLine3D* __read3DLineWithin(const char* input, __LevelParseBudget* budget) {
     LevelZLine3D* line = (LevelZLine3D*) malloc(sizeof(LevelZLine3D));
+    line->block = 0;
+    line->coordinates = 0;
 
     char* str0 = (char*) malloc(strlen(input) + 1);
     strcpy(str0, input);
 
-    char* blockStr = __trim(strtok(str0, ":"));
-    char* coordinateStr = __trim(strtok(0, ":"));
+    char* blockToken = strtok(str0, ":");
+    char* coordinateToken = strtok(0, ":");
+    if (blockToken == 0 || coordinateToken == 0) {
+        __LevelParseBudget_malformed(budget);
+        free(str0);
+        return line;
+    }
 
-    Block* block = Block_fromString(blockStr);
-    Coordinate3D** coordinates = __read3DPoints(coordinateStr);
-    line->block = block;
-    line->coordinates = coordinates;
+    char* blockStr = __trim(blockToken);
+    char* coordinateStr = __trim(coordinateToken);
 
+    int properties = __countProperties(blockStr);
+    if (budget != 0 && budget->options != 0) {
+        if (!__LevelParseBudget_check(budget, LEVEL_PARSE_TOO_MANY_PROPERTIES, properties, budget->options->maxProperties)
+            || !__LevelParseBudget_spend(budget, sizeof(Block) + strlen(blockStr) + properties * sizeof(BlockProperty))) {
+            free(blockStr);
+            free(coordinateStr);
+            free(str0);
+            return line;
+        }
+    }
+
+    line->block = Block_fromString(blockStr);
+    line->coordinates = line->block != 0 ? __read3DPointsWithin(coordinateStr, budget) : 0;
+    if (line->coordinates == 0) __LevelParseBudget_malformed(budget);
+
+    free(blockStr);
+    free(coordinateStr);
     free(str0);
     return line;
 }
 
+LevelZLine3D* __read3DLine(const char* input) {
+    return __read3DLineWithin(input, 0);
+}
+
+// Frees a level built by a reader, which owns its blocks and the strings of its headers.
+// Objects read from one line share their block, so each distinct block is freed once.
+void __Level2D_free(Level2D* level) {
+    Block** blocks = (Block**) malloc((level->blockCount + 1) * sizeof(Block*));
+    for (int i = 0; i < level->blockCount; i++) {
+        blocks[i] = level->blocks[i]->block;
+        free(level->blocks[i]);
+    }
+
+    qsort(blocks, level->blockCount, sizeof(Block*), __comparePointers);
+    for (int i = 0; i < level->blockCount; i++)
+        if (i == 0 || blocks[i] != blocks[i - 1]) __Block_free(blocks[i]);
+
+    free(blocks);
+
+    int headerCount = Level2D_getHeaderCount(level);
+    for (int i = 0; i < headerCount; i++) {
+        free(level->headers[i]->name);
+        free(level->headers[i]->value);
+        free(level->headers[i]);
+    }
+
+    for (int i = 0; i < level->tileCapacity; i++) {
+        if (level->tiles[i] == 0) continue;
+
+        free(level->tiles[i]->cells);
+        free(level->tiles[i]);
+    }
+
+    for (int i = 0; i < level->chunks.capacity; i++) {
+        LevelChunk2D* chunk = level->chunks.chunks[i];
+        if (chunk == 0) continue;
+
+        __LevelChunkSnapshot2D_release(chunk->snapshot);
+        free(chunk->objects);
+        free(chunk);
+    }
+
+    free(level->headers);
+    free(level->blocks);
+    free(level->blockIndex);
+    free(level->tiles);
+    free(level->chunks.chunks);
+    free(level->spawn);
+    free(level);
+}
+
+// Frees a level built by a reader, which owns its blocks and the strings of its headers.
+void __Level3D_free(Level3D* level) {
+    Block** blocks = (Block**) malloc((level->blockCount + 1) * sizeof(Block*));
+    for (int i = 0; i < level->blockCount; i++) {
+        blocks[i] = level->blocks[i]->block;
+        free(level->blocks[i]);
+    }
+
+    qsort(blocks, level->blockCount, sizeof(Block*), __comparePointers);
+    for (int i = 0; i < level->blockCount; i++)
+        if (i == 0 || blocks[i] != blocks[i - 1]) __Block_free(blocks[i]);
+
+    free(blocks);
+
+    int headerCount = Level3D_getHeaderCount(level);
+    for (int i = 0; i < headerCount; i++) {
+        free(level->headers[i]->name);
+        free(level->headers[i]->value);
+        free(level->headers[i]);
+    }
+
+    for (int i = 0; i < level->chunks.capacity; i++) {
+        LevelChunk3D* chunk = level->chunks.chunks[i];
+        if (chunk == 0) continue;
+
+        __LevelChunkSnapshot3D_release(chunk->snapshot);
+        free(chunk->objects);
+        free(chunk);
+    }
+
+    free(level->headers);
+    free(level->blocks);
+    free(level->blockIndex);
+    free(level->chunks.chunks);
+    free(level->spawn);
+    free(level);
+}
+
 // Implementation
 
 /**
- * Reads a Level2D from a string.
+ * Reads a Level2D from a string, within the limits of parse options. Limits are checked
+ * before the memory they guard is allocated, so hostile input fails early.
  * @param str The string representation of the Level2D.
- * @return The Level2D.
+ * @param options The limits to read within, or null for no limits.
+ * @param error Set to why reading failed, or to LEVEL_PARSE_OK. May be null.
+ * @return The Level2D, or null if reading failed.
  */
-Level2D* readLevel2D(const char* str) {
-    Level2D* level = (Level2D*) malloc(sizeof(Level2D));
+Level2D* readLevel2DWithOptions(const char* str, LevelParseOptions* options, LevelParseError* error) {
+    LevelParseError ignored;
+    if (error == 0) error = &ignored;
+    memset(error, 0, sizeof(LevelParseError));
 
-    char* str0 = (char*) malloc(strlen(str) + 1);
+    __LevelParseBudget budget;
+    memset(&budget, 0, sizeof(__LevelParseBudget));
+    budget.options = options;
+    budget.error = error;
+    budget.cellBytes = sizeof(LevelObject2D) + 2 * sizeof(LevelObject2D*) + sizeof(Coordinate2D*) + sizeof(Coordinate2D) + 2 * sizeof(int);
+
+    size_t length = strlen(str);
+    if (!__LevelParseBudget_spend(&budget, length + 1)) return 0;
+
+    Level2D* level = createLevel2D(createCoordinate2D(0, 0));
+
+    char* str0 = (char*) malloc(length + 1);
     strcpy(str0, str);
 
-    char* token = strtok(str0, "\n");
+    char* cursor = str0;
+    char* token = __nextLine(&cursor);
+    budget.line++;
     while (token != 0) {
-        if (strcmp(token, LEVELZ_HEADER_END) == 0) {
+        if (options != 0 && !__LevelParseBudget_check(&budget, LEVEL_PARSE_LINE_TOO_LONG, strlen(token), options->maxLineLength)) {
+            free(str0);
+            __Level2D_free(level);
+            return 0;
+        }
+
+        char* trimmed = __trim(token);
+        if (strcmp(trimmed, LEVELZ_HEADER_END) == 0) {
+            free(trimmed);
             break;
         }
 
-        LevelHeader* header = LevelHeader_fromString(__trim(token));
-        if (header->name == "type" && header->value != "2") {
+        if (*trimmed == 0) {
+            free(trimmed);
+            token = __nextLine(&cursor);
+            budget.line++;
+            continue;
+        }
+
+        if (!__LevelParseBudget_spend(&budget, sizeof(LevelHeader) + sizeof(LevelHeader*) + strlen(trimmed))) {
+            free(trimmed);
+            free(str0);
+            __Level2D_free(level);
+            return 0;
+        }
+
+        LevelHeader* header = LevelHeader_fromString(trimmed);
+        free(trimmed);
+
+        Coordinate2D* spawn = 0;
+        int valid = header != 0;
+        if (valid && strcmp(header->name, "spawn") == 0) {
+            spawn = Coordinate2D_fromString(header->value);
+            valid = spawn != 0;
+        }
+
+        if (!valid) {
+            __LevelParseBudget_malformed(&budget);
+        } else if (strcmp(header->name, "type") == 0 && strcmp(header->value, "2") != 0) {
+            __LevelParseBudget_fail(&budget, LEVEL_PARSE_WRONG_TYPE, 0, 0);
+            valid = 0;
+        }
+
+        if (!valid) {
+            if (header != 0) {
+                free(header->name);
+                free(header->value);
+                free(header);
+            }
+
             free(str0);
+            __Level2D_free(level);
             return 0;
         }
 
         Level2D_addHeader(level, header->name, header->value);
 
-        if (header->name == "spawn") {
-            Coordinate2D* spawn = Coordinate2D_fromString(header->value);
+        if (spawn != 0) {
+            free(level->spawn);
             level->spawn = spawn;
         }
 
-        token = strtok(0, "\n");
+        free(header);
+        token = __nextLine(&cursor);
+        budget.line++;
     }
 
-    token = strtok(0, "\n");
+    token = __nextLine(&cursor);
+    budget.line++;
     while (token != 0) {
-        if (strcmp(token, LEVELZ_END) == 0) {
+        if (options != 0 && !__LevelParseBudget_check(&budget, LEVEL_PARSE_LINE_TOO_LONG, strlen(token), options->maxLineLength)) {
+            free(str0);
+            __Level2D_free(level);
+            return 0;
+        }
+
+        char* trimmed = __trim(token);
+        if (strcmp(trimmed, LEVELZ_END) == 0) {
+            free(trimmed);
             break;
         }
 
-        LevelZLine2D* line = __read2DLine(__trim(token));
-        
-        for (int i = 0; i < sizeof(line->coordinates) / sizeof(Coordinate2D); i++) {
-            LevelObject2D* obj = createLevelObject2D(line->block, line->coordinates[i]);
-            Level2D_addBlock(level, obj);
+        if (*trimmed == 0) {
+            free(trimmed);
+            token = __nextLine(&cursor);
+            budget.line++;
+            continue;
         }
 
-        token = strtok(0, "\n");
+        LevelZLine2D* line = __read2DLineWithin(trimmed, &budget);
+        free(trimmed);
+
+        if (error->status != LEVEL_PARSE_OK) {
+            if (line->block != 0) __Block_free(line->block);
+            free(line);
+            free(str0);
+            __Level2D_free(level);
+            return 0;
+        }
+
+        int count = 0;
+        while (line->coordinates[count] != 0) count++;
+
+        LevelObject2D** objects = (LevelObject2D**) malloc((count + 1) * sizeof(LevelObject2D*));
+        for (int i = 0; i < count; i++) {
+            objects[i] = createLevelObject2DAt(line->block, *line->coordinates[i]);
+            free(line->coordinates[i]);
+        }
+
+        Level2D_addBlocks(level, objects, count);
+
+        free(objects);
+        free(line->coordinates);
+        free(line);
+
+        token = __nextLine(&cursor);
+        budget.line++;
     }
 
     free(str0);
@@ -306,52 +1015,162 @@ Level2D* readLevel2D(const char* str) {
 }
 
 /**
- * Reads a Level3D from a string.
+ * Reads a Level2D from a string.
+ * @param str The string representation of the Level2D.
+ * @return The Level2D.
+ */
+Level2D* readLevel2D(const char* str) {
+    return readLevel2DWithOptions(str, 0, 0);
+}
+
+/**
+ * Reads a Level3D from a string, within the limits of parse options. Limits are checked
+ * before the memory they guard is allocated, so hostile input fails early.
  * @param str The string representation of the Level3D.
- * @return The Level3D.
+ * @param options The limits to read within, or null for no limits.
+ * @param error Set to why reading failed, or to LEVEL_PARSE_OK. May be null.
+ * @return The Level3D, or null if reading failed.
  */
-Level3D* readLevel3D(const char* str) {
+Level3D* readLevel3DWithOptions(const char* str, LevelParseOptions* options, LevelParseError* error) {
+    LevelParseError ignored;
+    if (error == 0) error = &ignored;
+    memset(error, 0, sizeof(LevelParseError));
+
+    __LevelParseBudget budget;
+    memset(&budget, 0, sizeof(__LevelParseBudget));
+    budget.options = options;
+    budget.error = error;
+    budget.cellBytes = sizeof(LevelObject3D) + 2 * sizeof(LevelObject3D*) + sizeof(Coordinate3D*) + sizeof(Coordinate3D) + 2 * sizeof(int);
+
+    size_t length = strlen(str);
+    if (!__LevelParseBudget_spend(&budget, length + 1)) return 0;
+
     Level3D* level = createLevel3D(createCoordinate3D(0, 0, 0));
 
-    char* str0 = (char*) malloc(strlen(str) + 1);
+    char* str0 = (char*) malloc(length + 1);
     strcpy(str0, str);
 
-    char* token = strtok(str0, "\n");
+    char* cursor = str0;
+    char* token = __nextLine(&cursor);
+    budget.line++;
     while (token != 0) {
-        if (strcmp(token, LEVELZ_HEADER_END) == 0) {
+        if (options != 0 && !__LevelParseBudget_check(&budget, LEVEL_PARSE_LINE_TOO_LONG, strlen(token), options->maxLineLength)) {
+            free(str0);
+            __Level3D_free(level);
+            return 0;
+        }
+
+        char* trimmed = __trim(token);
+        if (strcmp(trimmed, LEVELZ_HEADER_END) == 0) {
+            free(trimmed);
             break;
         }
 
-        LevelHeader* header = LevelHeader_fromString(__trim(token));
-        if (header->name == "type" && header->value != "3") {
+        if (*trimmed == 0) {
+            free(trimmed);
+            token = __nextLine(&cursor);
+            budget.line++;
+            continue;
+        }
+
+        if (!__LevelParseBudget_spend(&budget, sizeof(LevelHeader) + sizeof(LevelHeader*) + strlen(trimmed))) {
+            free(trimmed);
+            free(str0);
+            __Level3D_free(level);
+            return 0;
+        }
+
+        LevelHeader* header = LevelHeader_fromString(trimmed);
+        free(trimmed);
+
+        Coordinate3D* spawn = 0;
+        int valid = header != 0;
+        if (valid && strcmp(header->name, "spawn") == 0) {
+            spawn = Coordinate3D_fromString(header->value);
+            valid = spawn != 0;
+        }
+
+        if (!valid) {
+            __LevelParseBudget_malformed(&budget);
+        } else if (strcmp(header->name, "type") == 0 && strcmp(header->value, "3") != 0) {
+            __LevelParseBudget_fail(&budget, LEVEL_PARSE_WRONG_TYPE, 0, 0);
+            valid = 0;
+        }
+
+        if (!valid) {
+            if (header != 0) {
+                free(header->name);
+                free(header->value);
+                free(header);
+            }
+
             free(str0);
+            __Level3D_free(level);
             return 0;
         }
 
         Level3D_addHeader(level, header->name, header->value);
 
-        if (header->name == "spawn") {
-            Coordinate3D* spawn = Coordinate3D_fromString(header->value);
+        if (spawn != 0) {
+            free(level->spawn);
             level->spawn = spawn;
         }
 
-        token = strtok(0, "\n");
+        free(header);
+        token = __nextLine(&cursor);
+        budget.line++;
     }
 
-    token = strtok(0, "\n");
+    token = __nextLine(&cursor);
+    budget.line++;
     while (token != 0) {
-        if (strcmp(token, LEVELZ_END) == 0) {
+        if (options != 0 && !__LevelParseBudget_check(&budget, LEVEL_PARSE_LINE_TOO_LONG, strlen(token), options->maxLineLength)) {
+            free(str0);
+            __Level3D_free(level);
+            return 0;
+        }
+
+        char* trimmed = __trim(token);
+        if (strcmp(trimmed, LEVELZ_END) == 0) {
+            free(trimmed);
             break;
         }
 
-        LevelZLine3D* line = __read3DLine(__trim(token));
+        if (*trimmed == 0) {
+            free(trimmed);
+            token = __nextLine(&cursor);
+            budget.line++;
+            continue;
+        }
+
+        LevelZLine3D* line = __read3DLineWithin(trimmed, &budget);
+        free(trimmed);
 
-        for (int i = 0; i < sizeof(line->coordinates) / sizeof(Coordinate3D); i++) {
-            LevelObject3D* obj = createLevelObject3D(line->block, line->coordinates[i]);
-            Level3D_addBlock(level, obj);
+        if (error->status != LEVEL_PARSE_OK) {
+            if (line->block != 0) __Block_free(line->block);
+            free(line);
+            free(str0);
+            __Level3D_free(level);
+            return 0;
+        }
+
+        int count = 0;
+        while (line->coordinates[count] != 0) count++;
+
+        LevelObject3D** objects = (LevelObject3D**) malloc((count + 1) * sizeof(LevelObject3D*));
+        for (int i = 0; i < count; i++) {
+            objects[i] = createLevelObject3DAt(line->block, *line->coordinates[i]);
+            free(line->coordinates[i]);
         }
 
-        token = strtok(0, "\n");
+        Level3D_addBlocks(level, objects, count);
+
+        free(objects);
+        free(line->coordinates);
+        free(line);
+
+        token = __nextLine(&cursor);
+        budget.line++;
     }
 
     free(str0);
@@ -359,49 +1178,286 @@ Level3D* readLevel3D(const char* str) {
 }
 
 /**
- * Parses a Level2D from a file.
+ * Reads a Level3D from a string.
+ * @param str The string representation of the Level3D.
+ * @return The Level3D.
+ */
+Level3D* readLevel3D(const char* str) {
+    return readLevel3DWithOptions(str, 0, 0);
+}
+
+/**
+ * Converts a Level2D to its LevelZ string representation. Blocks that are
+ * equal are written together on a single line.
+ * @param level The Level2D.
+ * @return The string representation of the Level2D.
+ */
+char* Level2D_toString(Level2D* level) {
+    if (level == 0) return 0;
+
+    char* str = 0;
+    size_t length = 0;
+    size_t capacity = 0;
+
+    if (Level2D_getHeader(level, "type") == 0)
+        __appendf(&str, &length, &capacity, "@type 2\n");
+
+    if (Level2D_getHeader(level, "spawn") == 0 && level->spawn != 0) {
+        __appendf(&str, &length, &capacity, "@spawn ");
+        __appendCoordinate2D(&str, &length, &capacity, level->spawn);
+        __appendf(&str, &length, &capacity, "\n");
+    }
+
+    int headerCount = Level2D_getHeaderCount(level);
+    for (int i = 0; i < headerCount; i++)
+        __appendf(&str, &length, &capacity, "@%s %s\n", level->headers[i]->name, level->headers[i]->value);
+
+    __appendf(&str, &length, &capacity, "%s\n", LEVELZ_HEADER_END);
+    __appendBlocks2D(&str, &length, &capacity, level->blocks, level->blockCount, "");
+    __appendf(&str, &length, &capacity, "%s\n", LEVELZ_END);
+
+    return str;
+}
+
+/**
+ * Converts a Level3D to its LevelZ string representation. Blocks that are
+ * equal are written together on a single line.
+ * @param level The Level3D.
+ * @return The string representation of the Level3D.
+ */
+char* Level3D_toString(Level3D* level) {
+    if (level == 0) return 0;
+
+    char* str = 0;
+    size_t length = 0;
+    size_t capacity = 0;
+
+    if (Level3D_getHeader(level, "type") == 0)
+        __appendf(&str, &length, &capacity, "@type 3\n");
+
+    if (Level3D_getHeader(level, "spawn") == 0 && level->spawn != 0) {
+        __appendf(&str, &length, &capacity, "@spawn ");
+        __appendCoordinate3D(&str, &length, &capacity, level->spawn);
+        __appendf(&str, &length, &capacity, "\n");
+    }
+
+    int headerCount = Level3D_getHeaderCount(level);
+    for (int i = 0; i < headerCount; i++)
+        __appendf(&str, &length, &capacity, "@%s %s\n", level->headers[i]->name, level->headers[i]->value);
+
+    __appendf(&str, &length, &capacity, "%s\n", LEVELZ_HEADER_END);
+    __appendBlocks3D(&str, &length, &capacity, level->blocks, level->blockCount, "");
+    __appendf(&str, &length, &capacity, "%s\n", LEVELZ_END);
+
+    return str;
+}
+
+int __Level2D_replayJournal(Level2D* level, const char* path);
+int __Level3D_replayJournal(Level3D* level, const char* path);
+Level2D* __Level2D_loadCache(const char* path, const char* buffer);
+Level3D* __Level3D_loadCache(const char* path, const char* buffer);
+void __Level2D_storeCache(const char* path, const char* buffer, Level2D* level);
+void __Level3D_storeCache(const char* path, const char* buffer, Level3D* level);
+void __removeIndex(const char* path);
+
+// Parses the contents of a level file, going through the cache and replaying its journal.
+// Cached images and journals are not read within any limits, so both are skipped when
+// options are given.
+Level2D* __parseBuffer2DWithOptions(const char* path, const char* buffer, LevelParseOptions* options, LevelParseError* error) {
+    Level2D* level = options == 0 ? __Level2D_loadCache(path, buffer) : 0;
+    if (level == 0) {
+        level = readLevel2DWithOptions(buffer, options, error);
+        if (level != 0)
+            __Level2D_storeCache(path, buffer, level);
+    }
+
+    if (level != 0 && options == 0)
+        __Level2D_replayJournal(level, path);
+
+    return level;
+}
+
+Level2D* __parseBuffer2D(const char* path, const char* buffer) {
+    return __parseBuffer2DWithOptions(path, buffer, 0, 0);
+}
+
+// Cached images and journals are not read within any limits, so both are skipped when
+// options are given.
+Level3D* __parseBuffer3DWithOptions(const char* path, const char* buffer, LevelParseOptions* options, LevelParseError* error) {
+    Level3D* level = options == 0 ? __Level3D_loadCache(path, buffer) : 0;
+    if (level == 0) {
+        level = readLevel3DWithOptions(buffer, options, error);
+        if (level != 0)
+            __Level3D_storeCache(path, buffer, level);
+    }
+
+    if (level != 0 && options == 0)
+        __Level3D_replayJournal(level, path);
+
+    return level;
+}
+
+Level3D* __parseBuffer3D(const char* path, const char* buffer) {
+    return __parseBuffer3DWithOptions(path, buffer, 0, 0);
+}
+
+/**
+ * Parses a Level2D from a file. Edits recorded in the file's journal are replayed on top.
+ * When a cache directory is set, an unchanged file is loaded from its cached image.
  * @param path The path to the file.
  * @return The Level2D.
  */
 Level2D* parseFile2D(const char* path) {
-    FILE* file = fopen(path, "r");
-    if (file == 0) return 0;
+    char* buffer = __readFile(path);
+    if (buffer == 0) return 0;
 
-    fseek(file, 0, SEEK_END);
-    long length = ftell(file);
-    fseek(file, 0, SEEK_SET);
+    Level2D* level = __parseBuffer2D(path, buffer);
+    free(buffer);
 
-    char* buffer = (char*) malloc(length);
-    fread(buffer, 1, length, file);
-    fclose(file);
+    return level;
+}
+
+/**
+ * Parses a Level2D from a file within the limits of parse options. Files larger than the
+ * memory limit are rejected before they are read. The file's journal is only replayed when
+ * options is null, since its edits are not checked against the limits.
+ * @param path The path to the file.
+ * @param options The limits to read within, or null for no limits.
+ * @param error Set to why parsing failed, or to LEVEL_PARSE_OK. May be null.
+ * @return The Level2D, or null if parsing failed.
+ */
+Level2D* parseFile2DWithOptions(const char* path, LevelParseOptions* options, LevelParseError* error) {
+    LevelParseError ignored;
+    if (error == 0) error = &ignored;
+    memset(error, 0, sizeof(LevelParseError));
+
+    long length = __fileLength(path);
+    if (length < 0) {
+        error->status = LEVEL_PARSE_UNREADABLE;
+        return 0;
+    }
+
+    if (options != 0 && options->maxMemory > 0 && (size_t) length >= options->maxMemory) {
+        error->status = LEVEL_PARSE_OUT_OF_BUDGET;
+        error->value = length;
+        error->limit = (int64_t) options->maxMemory;
+        return 0;
+    }
+
+    char* buffer = __readFile(path);
+    if (buffer == 0) {
+        error->status = LEVEL_PARSE_UNREADABLE;
+        return 0;
+    }
 
-    Level2D* level = readLevel2D(buffer);
+    Level2D* level = __parseBuffer2DWithOptions(path, buffer, options, error);
     free(buffer);
 
     return level;
 }
 
 /**
- * Parses a Level3D from a file.
+ * Parses a Level3D from a file. Edits recorded in the file's journal are replayed on top.
+ * When a cache directory is set, an unchanged file is loaded from its cached image.
  * @param path The path to the file.
  * @return The Level3D.
  */
 Level3D* parseFile3D(const char* path) {
-    FILE* file = fopen(path, "r");
-    if (file == 0) return 0;
+    char* buffer = __readFile(path);
+    if (buffer == 0) return 0;
 
-    fseek(file, 0, SEEK_END);
-    long length = ftell(file);
-    fseek(file, 0, SEEK_SET);
+    Level3D* level = __parseBuffer3D(path, buffer);
+    free(buffer);
 
-    char* buffer = (char*) malloc(length);
-    fread(buffer, 1, length, file);
-    fclose(file);
+    return level;
+}
+
+/**
+ * Parses a Level3D from a file within the limits of parse options. Files larger than the
+ * memory limit are rejected before they are read. The file's journal is only replayed when
+ * options is null, since its edits are not checked against the limits.
+ * @param path The path to the file.
+ * @param options The limits to read within, or null for no limits.
+ * @param error Set to why parsing failed, or to LEVEL_PARSE_OK. May be null.
+ * @return The Level3D, or null if parsing failed.
+ */
+Level3D* parseFile3DWithOptions(const char* path, LevelParseOptions* options, LevelParseError* error) {
+    LevelParseError ignored;
+    if (error == 0) error = &ignored;
+    memset(error, 0, sizeof(LevelParseError));
+
+    long length = __fileLength(path);
+    if (length < 0) {
+        error->status = LEVEL_PARSE_UNREADABLE;
+        return 0;
+    }
+
+    if (options != 0 && options->maxMemory > 0 && (size_t) length >= options->maxMemory) {
+        error->status = LEVEL_PARSE_OUT_OF_BUDGET;
+        error->value = length;
+        error->limit = (int64_t) options->maxMemory;
+        return 0;
+    }
+
+    char* buffer = __readFile(path);
+    if (buffer == 0) {
+        error->status = LEVEL_PARSE_UNREADABLE;
+        return 0;
+    }
 
-    Level3D* level = readLevel3D(buffer);
+    Level3D* level = __parseBuffer3DWithOptions(path, buffer, options, error);
     free(buffer);
 
     return level;
 }
 
+/**
+ * Writes a Level2D to a file. The level is written to a temporary file that then
+ * replaces the destination, so readers never observe a partially written file.
+ * @param path The path to the file.
+ * @param level The Level2D.
+ * @return 1 if the file was written, 0 otherwise.
+ */
+int writeFile2D(const char* path, Level2D* level) {
+    if (path == 0) return 0;
+    if (level == 0) return 0;
+
+    char* str = Level2D_toString(level);
+    int written = __writeFileAtomic(path, str, strlen(str));
+    free(str);
+
+    return written;
+}
+
+/**
+ * Writes a Level3D to a file. The level is written to a temporary file that then
+ * replaces the destination, so readers never observe a partially written file.
+ * Any region index stored next to the file is removed, since it no longer matches.
+ * @param path The path to the file.
+ * @param level The Level3D.
+ * @return 1 if the file was written, 0 otherwise.
+ */
+int writeFile3D(const char* path, Level3D* level) {
+    if (path == 0) return 0;
+    if (level == 0) return 0;
+
+    char* str = Level3D_toString(level);
+    int written = __writeFileAtomic(path, str, strlen(str));
+    free(str);
+
+    if (written)
+        __removeIndex(path);
+
+    return written;
+}
+
+// Extensions
+
+#include "levelz/patch.h"
+#include "levelz/journal.h"
+#include "levelz/cache.h"
+#include "levelz/region.h"
+#include "levelz/stream.h"
+#include "levelz/async.h"
+
 #endif
\ No newline at end of file
@@ -0,0 +1,645 @@
+#ifndef LEVELZ_ASYNC_H
+#define LEVELZ_ASYNC_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+
+#include "../levelz.h"
+#include "thread.h"
+
+// io_uring is used on Linux unless LEVELZ_NO_IO_URING is defined or the kernel
+// headers are missing. It is set up through raw syscalls, so liburing is not needed.
+// syscall and MAP_POPULATE are extensions that strict ISO C modes such as -std=c11
+// hide, so those builds fall back to the thread pool instead.
+#if defined(__linux__) && !defined(LEVELZ_NO_IO_URING) && defined(__has_include) \
+    && (defined(_GNU_SOURCE) || defined(_DEFAULT_SOURCE))
+#if __has_include(<linux/io_uring.h>)
+#define _LEVELZ_IO_URING 1
+#endif
+#endif
+
+#ifdef _LEVELZ_IO_URING
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+
+#define _LEVEL_LOADER_QUEUE_DEPTH 64
+
+struct LevelLoad;
+
+/**
+ * Called with every completed load of a LevelLoader.
+ * @param load The completed load. It is freed once the callback returns, but the loaded level belongs to the callback.
+ * @param data The user data passed when the load was submitted.
+ */
+typedef void (*LevelLoadCallback)(struct LevelLoad* load, void* data);
+
+/**
+ * Represents a level file being loaded by a LevelLoader.
+ */
+typedef struct LevelLoad {
+    /**
+     * The path to the file.
+     */
+    char* path;
+
+    /**
+     * The dimension of the level, 2 or 3.
+     */
+    int dimension;
+
+    /**
+     * The loaded level if the dimension is 2, or null if it could not be loaded.
+     */
+    Level2D* level2D;
+
+    /**
+     * The loaded level if the dimension is 3, or null if it could not be loaded.
+     */
+    Level3D* level3D;
+
+    /**
+     * Zero if the file was read, or the error that stopped it from being read.
+     */
+    int error;
+
+    /**
+     * The callback to deliver the load to.
+     */
+    LevelLoadCallback callback;
+
+    /**
+     * The user data for the callback.
+     */
+    void* data;
+
+    /**
+     * The contents of the file read so far.
+     */
+    char* buffer;
+
+    /**
+     * The size of the file.
+     */
+    size_t size;
+
+    /**
+     * The number of bytes read so far.
+     */
+    size_t done;
+
+    /**
+     * The file descriptor of the file while it is being read with io_uring.
+     */
+    int fd;
+
+    /**
+     * The next load in the same queue.
+     */
+    struct LevelLoad* next;
+} LevelLoad;
+
+// Internal
+
+#ifdef _LEVELZ_IO_URING
+
+typedef struct __IoUring {
+    int fd;
+    unsigned* sqHead;
+    unsigned* sqTail;
+    unsigned* sqMask;
+    unsigned* sqArray;
+    unsigned* cqHead;
+    unsigned* cqTail;
+    unsigned* cqMask;
+    struct io_uring_sqe* sqes;
+    struct io_uring_cqe* cqes;
+    void* sqRing;
+    size_t sqRingSize;
+    void* cqRing;
+    size_t cqRingSize;
+    size_t sqesSize;
+} __IoUring;
+
+int __IoUring_setup(__IoUring* ring, unsigned entries) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    ring->fd = (int) syscall(__NR_io_uring_setup, entries, &params);
+    if (ring->fd < 0) return 0;
+
+    ring->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    ring->sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    int single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single) {
+        if (ring->cqRingSize > ring->sqRingSize) ring->sqRingSize = ring->cqRingSize;
+        ring->cqRingSize = ring->sqRingSize;
+    }
+
+    ring->sqRing = mmap(0, ring->sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    if (ring->sqRing == MAP_FAILED) {
+        close(ring->fd);
+        return 0;
+    }
+
+    ring->cqRing = single ? ring->sqRing : mmap(0, ring->cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+    if (ring->cqRing == MAP_FAILED) {
+        munmap(ring->sqRing, ring->sqRingSize);
+        close(ring->fd);
+        return 0;
+    }
+
+    ring->sqes = (struct io_uring_sqe*) mmap(0, ring->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) {
+        if (!single) munmap(ring->cqRing, ring->cqRingSize);
+        munmap(ring->sqRing, ring->sqRingSize);
+        close(ring->fd);
+        return 0;
+    }
+
+    char* sq = (char*) ring->sqRing;
+    char* cq = (char*) ring->cqRing;
+    ring->sqHead = (unsigned*) (sq + params.sq_off.head);
+    ring->sqTail = (unsigned*) (sq + params.sq_off.tail);
+    ring->sqMask = (unsigned*) (sq + params.sq_off.ring_mask);
+    ring->sqArray = (unsigned*) (sq + params.sq_off.array);
+    ring->cqHead = (unsigned*) (cq + params.cq_off.head);
+    ring->cqTail = (unsigned*) (cq + params.cq_off.tail);
+    ring->cqMask = (unsigned*) (cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe*) (cq + params.cq_off.cqes);
+
+    return 1;
+}
+
+void __IoUring_free(__IoUring* ring) {
+    munmap(ring->sqes, ring->sqesSize);
+    if (ring->cqRing != ring->sqRing) munmap(ring->cqRing, ring->cqRingSize);
+    munmap(ring->sqRing, ring->sqRingSize);
+    close(ring->fd);
+}
+
+// Queues a read of the rest of a file. The caller keeps the number of reads in
+// flight below the ring size, so there is always room for the entry. Returns 0 if
+// the kernel did not take the entry, which is then withdrawn from the ring.
+int __IoUring_read(__IoUring* ring, LevelLoad* load) {
+    unsigned tail = *ring->sqTail;
+    unsigned index = tail & *ring->sqMask;
+
+    struct io_uring_sqe* sqe = &ring->sqes[index];
+    memset(sqe, 0, sizeof(struct io_uring_sqe));
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = load->fd;
+    sqe->off = load->done;
+    sqe->addr = (uint64_t) (uintptr_t) (load->buffer + load->done);
+    sqe->len = (unsigned) (load->size - load->done);
+    sqe->user_data = (uint64_t) (uintptr_t) load;
+
+    ring->sqArray[index] = index;
+    __atomic_store_n(ring->sqTail, tail + 1, __ATOMIC_RELEASE);
+
+    long submitted;
+    do {
+        submitted = syscall(__NR_io_uring_enter, ring->fd, 1, 0, 0, 0, 0);
+    } while (submitted < 0 && errno == EINTR);
+
+    // an entry the kernel has consumed completes later, whatever the call returned
+    if (__atomic_load_n(ring->sqHead, __ATOMIC_ACQUIRE) != tail) return 1;
+
+    // otherwise it must not stay queued, since the caller frees the buffer
+    __atomic_store_n(ring->sqTail, tail, __ATOMIC_RELEASE);
+    return 0;
+}
+
+int __IoUring_wait(__IoUring* ring) {
+    int result = (int) syscall(__NR_io_uring_enter, ring->fd, 0, 1, IORING_ENTER_GETEVENTS, 0, 0);
+    return result >= 0 || errno == EINTR;
+}
+
+#endif
+
+// Implementation
+
+/**
+ * Loads many level files at once. Files are read asynchronously, with io_uring
+ * on Linux and a pool of reader threads elsewhere, while the calling thread
+ * parses the files that have already been read.
+ */
+typedef struct LevelLoader {
+    /**
+     * Whether files are read with io_uring rather than the reader threads.
+     */
+    int ioUring;
+
+#ifdef _LEVELZ_IO_URING
+    /**
+     * The io_uring instance.
+     */
+    __IoUring ring;
+#endif
+
+    /**
+     * The number of reads submitted to io_uring and not yet completed.
+     */
+    int inFlight;
+
+    /**
+     * The number of loads submitted and not yet delivered.
+     */
+    int outstanding;
+
+    /**
+     * The loads waiting to be read.
+     */
+    LevelLoad* queued;
+
+    /**
+     * The last load waiting to be read.
+     */
+    LevelLoad* queuedTail;
+
+    /**
+     * The loads that were read and wait to be parsed.
+     */
+    LevelLoad* completed;
+
+    /**
+     * The reader threads.
+     */
+    __Thread* threads;
+
+    /**
+     * The number of reader threads.
+     */
+    int threadCount;
+
+    /**
+     * Whether the reader threads should keep running.
+     */
+    int running;
+
+    /**
+     * Guards the queues when reader threads are used.
+     */
+    __Mutex lock;
+
+    /**
+     * Signalled when a load is queued for the reader threads.
+     */
+    __Cond queuedSignal;
+
+    /**
+     * Signalled when a reader thread completes a load.
+     */
+    __Cond completedSignal;
+} LevelLoader;
+
+// Internal
+
+void* __LevelLoader_work(void* arg) {
+    LevelLoader* loader = (LevelLoader*) arg;
+
+    __Mutex_lock(&loader->lock);
+    while (1) {
+        while (loader->running && loader->queued == 0)
+            __Cond_wait(&loader->queuedSignal, &loader->lock);
+
+        if (loader->queued == 0) break;
+
+        LevelLoad* load = loader->queued;
+        loader->queued = load->next;
+        if (loader->queued == 0) loader->queuedTail = 0;
+        __Mutex_unlock(&loader->lock);
+
+        errno = 0;
+        load->buffer = __readFile(load->path);
+        if (load->buffer == 0) load->error = errno != 0 ? errno : EIO;
+
+        __Mutex_lock(&loader->lock);
+        load->next = loader->completed;
+        loader->completed = load;
+        __Cond_signal(&loader->completedSignal);
+    }
+    __Mutex_unlock(&loader->lock);
+
+    return 0;
+}
+
+void __LevelLoader_complete(LevelLoader* loader, LevelLoad* load) {
+    load->next = loader->completed;
+    loader->completed = load;
+}
+
+#ifdef _LEVELZ_IO_URING
+
+// Opens queued files and submits their reads while the ring has room.
+void __LevelLoader_submit(LevelLoader* loader) {
+    while (loader->queued != 0 && loader->inFlight < _LEVEL_LOADER_QUEUE_DEPTH) {
+        LevelLoad* load = loader->queued;
+        loader->queued = load->next;
+        if (loader->queued == 0) loader->queuedTail = 0;
+
+        struct stat info;
+        load->fd = open(load->path, O_RDONLY | O_CLOEXEC);
+        if (load->fd < 0 || fstat(load->fd, &info) != 0) {
+            load->error = errno;
+            if (load->fd >= 0) close(load->fd);
+            __LevelLoader_complete(loader, load);
+            continue;
+        }
+
+        load->size = (size_t) info.st_size;
+        load->buffer = (char*) malloc(load->size + 1);
+        if (load->size == 0 || !__IoUring_read(&loader->ring, load)) {
+            if (load->size != 0) load->error = EIO;
+            close(load->fd);
+            __LevelLoader_complete(loader, load);
+            continue;
+        }
+
+        loader->inFlight++;
+    }
+}
+
+void __LevelLoader_reap(LevelLoader* loader) {
+    __IoUring* ring = &loader->ring;
+
+    unsigned head = *ring->cqHead;
+    while (head != __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE)) {
+        struct io_uring_cqe* cqe = &ring->cqes[head & *ring->cqMask];
+        LevelLoad* load = (LevelLoad*) (uintptr_t) cqe->user_data;
+        int result = cqe->res;
+        head++;
+        __atomic_store_n(ring->cqHead, head, __ATOMIC_RELEASE);
+        loader->inFlight--;
+
+        if (result > 0) {
+            load->done += (size_t) result;
+
+            // short reads continue where they stopped
+            if (load->done < load->size) {
+                if (__IoUring_read(ring, load)) {
+                    loader->inFlight++;
+                    continue;
+                }
+
+                load->error = EIO;
+            }
+        } else if (result == 0 && load->done < load->size) {
+            // the file shrank after it was measured
+            load->error = EIO;
+        } else if (result == -EINVAL || result == -EOPNOTSUPP) {
+            // kernels before 5.6 have io_uring but not IORING_OP_READ
+            close(load->fd);
+            free(load->buffer);
+            load->buffer = __readFile(load->path);
+            load->error = load->buffer == 0 ? EIO : 0;
+            load->size = load->buffer == 0 ? 0 : strlen(load->buffer);
+            __LevelLoader_complete(loader, load);
+            continue;
+        } else if (result < 0) {
+            load->error = -result;
+        }
+
+        close(load->fd);
+        load->size = load->done;
+        __LevelLoader_complete(loader, load);
+    }
+}
+
+#endif
+
+// Parses and delivers the loads that were read. Returns the number delivered.
+int __LevelLoader_deliver(LevelLoader* loader, LevelLoad* completed) {
+    int delivered = 0;
+    while (completed != 0) {
+        LevelLoad* load = completed;
+        completed = load->next;
+
+        if (load->error == 0 && load->buffer != 0) {
+            if (loader->ioUring) load->buffer[load->size] = '\0';
+
+            if (load->dimension == 2)
+                load->level2D = __parseBuffer2D(load->path, load->buffer);
+            else
+                load->level3D = __parseBuffer3D(load->path, load->buffer);
+        }
+
+        free(load->buffer);
+        load->buffer = 0;
+
+        if (load->callback != 0)
+            load->callback(load, load->data);
+
+        free(load->path);
+        free(load);
+
+        loader->outstanding--;
+        delivered++;
+    }
+
+    return delivered;
+}
+
+LevelLoader* __createLevelLoader(int threads, int ioUring) {
+    LevelLoader* loader = (LevelLoader*) calloc(1, sizeof(LevelLoader));
+
+#ifdef _LEVELZ_IO_URING
+    if (ioUring && __IoUring_setup(&loader->ring, _LEVEL_LOADER_QUEUE_DEPTH)) {
+        loader->ioUring = 1;
+        return loader;
+    }
+#else
+    (void) ioUring;
+#endif
+
+    __Mutex_init(&loader->lock);
+    __Cond_init(&loader->queuedSignal);
+    __Cond_init(&loader->completedSignal);
+
+    loader->running = 1;
+    loader->threadCount = threads > 0 ? threads : __cpuCount();
+    loader->threads = (__Thread*) malloc(loader->threadCount * sizeof(__Thread));
+    for (int i = 0; i < loader->threadCount; i++) {
+        if (!__Thread_create(&loader->threads[i], __LevelLoader_work, loader)) {
+            loader->threadCount = i;
+            break;
+        }
+    }
+
+    return loader;
+}
+
+int __LevelLoader_submitLoad(LevelLoader* loader, const char* path, int dimension, LevelLoadCallback callback, void* data) {
+    if (loader == 0) return 0;
+    if (path == 0) return 0;
+
+    LevelLoad* load = (LevelLoad*) calloc(1, sizeof(LevelLoad));
+    load->path = __copyString(path);
+    load->dimension = dimension;
+    load->callback = callback;
+    load->data = data;
+    load->fd = -1;
+
+    loader->outstanding++;
+
+    if (loader->ioUring) {
+        if (loader->queuedTail == 0) loader->queued = load;
+        else loader->queuedTail->next = load;
+        loader->queuedTail = load;
+
+#ifdef _LEVELZ_IO_URING
+        __LevelLoader_submit(loader);
+#endif
+        return 1;
+    }
+
+    __Mutex_lock(&loader->lock);
+    if (loader->queuedTail == 0) loader->queued = load;
+    else loader->queuedTail->next = load;
+    loader->queuedTail = load;
+    __Cond_signal(&loader->queuedSignal);
+    __Mutex_unlock(&loader->lock);
+
+    return 1;
+}
+
+// Implementation
+
+/**
+ * Creates a new LevelLoader. io_uring is used when the kernel supports it, and
+ * a pool of reader threads otherwise.
+ * @param threads The number of reader threads to use without io_uring, or 0 for one per CPU.
+ * @return A new LevelLoader.
+ */
+LevelLoader* createLevelLoader(int threads) {
+    return __createLevelLoader(threads, 1);
+}
+
+/**
+ * Submits a Level2D file to a LevelLoader. The file is read in the background and
+ * parsed like parseFile2D, and the result is delivered to the callback from
+ * LevelLoader_poll or LevelLoader_wait.
+ * @param loader The LevelLoader.
+ * @param path The path to the file.
+ * @param callback The callback to deliver the load to.
+ * @param data The user data for the callback.
+ * @return 1 if the load was submitted, 0 otherwise.
+ */
+int LevelLoader_load2D(LevelLoader* loader, const char* path, LevelLoadCallback callback, void* data) {
+    return __LevelLoader_submitLoad(loader, path, 2, callback, data);
+}
+
+/**
+ * Submits a Level3D file to a LevelLoader. The file is read in the background and
+ * parsed like parseFile3D, and the result is delivered to the callback from
+ * LevelLoader_poll or LevelLoader_wait.
+ * @param loader The LevelLoader.
+ * @param path The path to the file.
+ * @param callback The callback to deliver the load to.
+ * @param data The user data for the callback.
+ * @return 1 if the load was submitted, 0 otherwise.
+ */
+int LevelLoader_load3D(LevelLoader* loader, const char* path, LevelLoadCallback callback, void* data) {
+    return __LevelLoader_submitLoad(loader, path, 3, callback, data);
+}
+
+/**
+ * Delivers the loads of a LevelLoader whose files have been read, without blocking.
+ * Callbacks run on the calling thread.
+ * @param loader The LevelLoader.
+ * @return The number of loads delivered.
+ */
+int LevelLoader_poll(LevelLoader* loader) {
+    if (loader == 0) return 0;
+
+    LevelLoad* completed;
+    if (loader->ioUring) {
+#ifdef _LEVELZ_IO_URING
+        __LevelLoader_reap(loader);
+        __LevelLoader_submit(loader);
+#endif
+        completed = loader->completed;
+        loader->completed = 0;
+    } else {
+        __Mutex_lock(&loader->lock);
+        completed = loader->completed;
+        loader->completed = 0;
+        __Mutex_unlock(&loader->lock);
+    }
+
+    return __LevelLoader_deliver(loader, completed);
+}
+
+/**
+ * Delivers every load submitted to a LevelLoader, blocking until all files have
+ * been read. Files that were read are parsed while the others are still being read.
+ * @param loader The LevelLoader.
+ * @return The number of loads delivered.
+ */
+int LevelLoader_wait(LevelLoader* loader) {
+    if (loader == 0) return 0;
+
+    int delivered = 0;
+    while (loader->outstanding > 0) {
+        int count = LevelLoader_poll(loader);
+        delivered += count;
+        if (count > 0 || loader->outstanding == 0) continue;
+
+        if (loader->ioUring) {
+#ifdef _LEVELZ_IO_URING
+            if (!__IoUring_wait(&loader->ring)) break;
+#endif
+        } else {
+            __Mutex_lock(&loader->lock);
+            while (loader->completed == 0)
+                __Cond_wait(&loader->completedSignal, &loader->lock);
+            __Mutex_unlock(&loader->lock);
+        }
+    }
+
+    return delivered;
+}
+
+/**
+ * Frees a LevelLoader, delivering the loads still outstanding first.
+ * @param loader The LevelLoader.
+ */
+void LevelLoader_free(LevelLoader* loader) {
+    if (loader == 0) return;
+
+    LevelLoader_wait(loader);
+
+    if (loader->ioUring) {
+#ifdef _LEVELZ_IO_URING
+        __IoUring_free(&loader->ring);
+#endif
+        free(loader);
+        return;
+    }
+
+    __Mutex_lock(&loader->lock);
+    loader->running = 0;
+    __Cond_broadcast(&loader->queuedSignal);
+    __Mutex_unlock(&loader->lock);
+
+    for (int i = 0; i < loader->threadCount; i++)
+        __Thread_join(loader->threads[i]);
+
+    __Cond_destroy(&loader->completedSignal);
+    __Cond_destroy(&loader->queuedSignal);
+    __Mutex_destroy(&loader->lock);
+
+    free(loader->threads);
+    free(loader);
+}
+
+#endif
@@ -1,20 +1,24 @@
 #ifndef LEVELZ_BLOCK_H
 #define LEVELZ_BLOCK_H
 
-#define _BLOCK_PROPERTIES_INIT_CAPACITY 16
+#define _BLOCK_PROPERTIES_INLINE 3
+#define _BLOCK_PROPERTIES_HASHED 8
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "coordinate.h"
+#include "intern.h"
+
+// Implementation
 
 /**
  * Represents the properties of a Block.
  */
 typedef struct BlockProperty {
     /**
-     * The name of the property.
+     * The name of the property. It is interned and must not be modified or freed.
      */
     char* name;
     
@@ -22,6 +26,11 @@ typedef struct BlockProperty {
      * The value of the property.
      */
     char* value;
+
+    /**
+     * The interned ID of the property name.
+     */
+    int nameId;
 } BlockProperty;
 
 /**
@@ -29,14 +38,20 @@ typedef struct BlockProperty {
  */
 typedef struct Block {
     /**
-     * The name of the block.
+     * The name of the block. It is interned and must not be modified or freed.
      */
     char* name;
+
+    /**
+     * The interned ID of the block name.
+     */
+    int nameId;
     
     /**
-     * The properties of the block.
+     * The properties of the block. Up to three properties are stored inside the
+     * block itself, and more spill into a heap array.
      */
-    BlockProperty** properties;
+    BlockProperty* properties;
 
     /**
      * The number of properties in the block.
@@ -47,18 +62,151 @@ typedef struct Block {
      * The capacity of the properties array.
      */
     int propertyCapacity;
+
+    /**
+     * The hash index of the properties, kept once a block has many of them, or null.
+     */
+    int* propertyIndex;
+
+    /**
+     * The capacity of the property index.
+     */
+    int propertyIndexCapacity;
+
+    /**
+     * The inline storage for the first properties.
+     */
+    BlockProperty inlineProperties[_BLOCK_PROPERTIES_INLINE];
 } Block;
 
 /**
- * Creates a new Block.
+ * A function that selects blocks, such as the blocks that are solid.
+ * @param block The block.
+ * @param data The data passed alongside the predicate.
+ * @return 1 if the block is selected, 0 otherwise.
+ */
+typedef int (*BlockPredicate)(Block* block, void* data);
+
+// Internal
+
+// Entries of the index are property positions + 1, so 0 marks an empty slot.
+void __Block_rebuildIndex(Block* b) {
+    free(b->propertyIndex);
+    b->propertyIndex = 0;
+    b->propertyIndexCapacity = 0;
+    if (b->propertyCount < _BLOCK_PROPERTIES_HASHED) return;
+
+    int capacity = 16;
+    while (capacity < b->propertyCount * 2) capacity *= 2;
+
+    b->propertyIndex = (int*) calloc(capacity, sizeof(int));
+    b->propertyIndexCapacity = capacity;
+
+    for (int i = 0; i < b->propertyCount; i++) {
+        int slot = (int) (__mix64((uint64_t) b->properties[i].nameId) & (capacity - 1));
+        while (b->propertyIndex[slot] != 0) slot = (slot + 1) & (capacity - 1);
+        b->propertyIndex[slot] = i + 1;
+    }
+}
+
+int __Block_findProperty(Block* b, int id) {
+    if (id == 0) return -1;
+
+    if (b->propertyIndex != 0) {
+        int mask = b->propertyIndexCapacity - 1;
+        int slot = (int) (__mix64((uint64_t) id) & mask);
+        while (b->propertyIndex[slot] != 0) {
+            int i = b->propertyIndex[slot] - 1;
+            if (b->properties[i].nameId == id) return i;
+
+            slot = (slot + 1) & mask;
+        }
+
+        return -1;
+    }
+
+    for (int i = 0; i < b->propertyCount; i++)
+        if (b->properties[i].nameId == id) return i;
+
+    return -1;
+}
+
+void __Block_setProperty(Block* b, char* name, int id, char* value) {
+    char* copy = (char*) malloc(strlen(value) + 1);
+    strcpy(copy, value);
+
+    int i = __Block_findProperty(b, id);
+    if (i >= 0) {
+        free(b->properties[i].value);
+        b->properties[i].value = copy;
+        return;
+    }
+
+    if (b->propertyCount == b->propertyCapacity) {
+        b->propertyCapacity *= 2;
+        if (b->properties == b->inlineProperties) {
+            b->properties = (BlockProperty*) malloc(b->propertyCapacity * sizeof(BlockProperty));
+            memcpy(b->properties, b->inlineProperties, b->propertyCount * sizeof(BlockProperty));
+        } else {
+            b->properties = (BlockProperty*) realloc(b->properties, b->propertyCapacity * sizeof(BlockProperty));
+        }
+    }
+
+    b->properties[b->propertyCount].name = name;
+    b->properties[b->propertyCount].value = copy;
+    b->properties[b->propertyCount].nameId = id;
+    b->propertyCount++;
+
+    if (b->propertyIndex != 0 && b->propertyCount * 2 <= b->propertyIndexCapacity) {
+        int mask = b->propertyIndexCapacity - 1;
+        int slot = (int) (__mix64((uint64_t) id) & mask);
+        while (b->propertyIndex[slot] != 0) slot = (slot + 1) & mask;
+        b->propertyIndex[slot] = b->propertyCount;
+    } else if (b->propertyCount >= _BLOCK_PROPERTIES_HASHED) {
+        __Block_rebuildIndex(b);
+    }
+}
+
+void __Block_free(Block* b) {
+    for (int i = 0; i < b->propertyCount; i++)
+        free(b->properties[i].value);
+
+    if (b->properties != b->inlineProperties) free(b->properties);
+    free(b->propertyIndex);
+    free(b);
+}
+
+Block* __Block_copy(Block* b) {
+    Block* copy = (Block*) malloc(sizeof(Block));
+    copy->name = b->name;
+    copy->nameId = b->nameId;
+    copy->properties = copy->inlineProperties;
+    copy->propertyCount = 0;
+    copy->propertyCapacity = _BLOCK_PROPERTIES_INLINE;
+    copy->propertyIndex = 0;
+    copy->propertyIndexCapacity = 0;
+
+    for (int i = 0; i < b->propertyCount; i++)
+        __Block_setProperty(copy, b->properties[i].name, b->properties[i].nameId, b->properties[i].value);
+
+    return copy;
+}
+
+// Implementation
+
+/**
+ * Creates a new Block. The name is interned, so it is not owned by the block.
  * @param name The name of the block.
  */
 Block* createBlock(char* name) {
     Block* b = (Block*) malloc(sizeof(Block));
-    b->name = name;
+
+    b->name = __internString(name, &b->nameId);
+    b->properties = b->inlineProperties;
     b->propertyCount = 0;
-    b->propertyCapacity = _BLOCK_PROPERTIES_INIT_CAPACITY;
-    b->properties = (BlockProperty**) malloc(b->propertyCapacity * sizeof(BlockProperty*));
+    b->propertyCapacity = _BLOCK_PROPERTIES_INLINE;
+    b->propertyIndex = 0;
+    b->propertyIndexCapacity = 0;
     
     return b;
 }
@@ -72,14 +220,27 @@ Block* createBlock(char* name) {
 char* Block_getProperty(Block* b, char* name) {
     if (b == 0) return 0;
     if (name == 0) return 0;
+    if (b->propertyCount == 0) return "";
 
-    for (int i = 0; i < b->propertyCount; i++) {
-        if (strcmp(b->properties[i]->name, name) == 0) {
-            return b->properties[i]->value;
-        }
-    }
+    int i = __Block_findProperty(b, getInternedId(name));
+    if (i < 0) return "";
 
-    return "";
+    return b->properties[i].value;
+}
+
+/**
+ * Gets the value of a property of a Block by the interned ID of its name.
+ * @param b The block.
+ * @param id The interned ID of the property name.
+ * @return The value of the property.
+ */
+char* Block_getPropertyById(Block* b, int id) {
+    if (b == 0) return 0;
+
+    int i = __Block_findProperty(b, id);
+    if (i < 0) return "";
+
+    return b->properties[i].value;
 }
 
 /**
@@ -93,26 +254,25 @@ void Block_setProperty(Block* b, char* name, char* value) {
     if (name == 0) return;
     if (value == 0) return;
 
-    for (int i = 0; i < b->propertyCount; i++) {
-        if (strcmp(b->properties[i]->name, name) == 0) {
-            b->properties[i]->value = value;
-            return;
-        }
-    }
-
-    BlockProperty* p = (BlockProperty*) malloc(sizeof(BlockProperty));
-    p->name = strcpy((char*) malloc(strlen(name) + 1), name);
-    p->value = strcpy((char*) malloc(strlen(value) + 1), value);
+    int id;
+    char* interned = __internString(name, &id);
+    __Block_setProperty(b, interned, id, value);
+}
 
-    if (b->propertyCount == b->propertyCapacity) {
-        b->propertyCapacity *= 2;
-        b->properties = (BlockProperty**) realloc(b->properties, b->propertyCapacity * sizeof(BlockProperty*));
-    }
+/**
+ * Sets a property of a Block by the interned ID of its name.
+ * @param b The block.
+ * @param id The interned ID of the property name.
+ * @param value The value of the property.
+ */
+void Block_setPropertyById(Block* b, int id, char* value) {
+    if (b == 0) return;
+    if (value == 0) return;
 
-    b->properties[b->propertyCount] = p;
-    b->propertyCount++;
+    char* name = getInternedString(id);
+    if (name == 0) return;
 
-    return;
+    __Block_setProperty(b, name, id, value);
 }
 
 /**
@@ -125,55 +285,101 @@ void Block_removeProperty(Block* b, char* name) {
     if (name == 0) return;
     if (b->propertyCount == 0) return;
 
-    for (int i = 0; i < b->propertyCount; i++) {
-        if (strcmp(b->properties[i]->name, name) == 0) {
-            free(b->properties[i]);
-            for (int j = i; j < b->propertyCount - 1; j++) {
-                b->properties[j] = b->properties[j + 1];
-            }
-            b->propertyCount--;
-            return;
-        }
-    
-        if (b->propertyCount < b->propertyCapacity / 2) {
-            b->propertyCapacity /= 2;
-            b->properties = (BlockProperty**) realloc(b->properties, b->propertyCapacity * sizeof(BlockProperty*));
-        }
+    int i = __Block_findProperty(b, getInternedId(name));
+    if (i < 0) return;
+
+    free(b->properties[i].value);
+    for (int j = i; j < b->propertyCount - 1; j++) {
+        b->properties[j] = b->properties[j + 1];
     }
+    b->propertyCount--;
+
+    if (b->propertyIndex != 0)
+        __Block_rebuildIndex(b);
 }
 
 /**
- * Converts a Block to a string.
+ * Checks whether two Blocks have the same name and properties.
+ * @param a The first block.
+ * @param b The second block.
+ * @return 1 if the blocks are equal, 0 otherwise.
+ */
+int Block_equals(Block* a, Block* b) {
+    if (a == b) return 1;
+    if (a == 0 || b == 0) return 0;
+    if (a->nameId != b->nameId) return 0;
+    if (a->propertyCount != b->propertyCount) return 0;
+
+    for (int i = 0; i < a->propertyCount; i++) {
+        int j = __Block_findProperty(b, a->properties[i].nameId);
+        if (j < 0 || strcmp(a->properties[i].value, b->properties[j].value) != 0) return 0;
+    }
+
+    return 1;
+}
+
+// Internal
+
+uint64_t __Block_hash(Block* b, uint64_t seed) {
+    uint64_t h = __hashString(b->name, seed);
+
+    // properties are summed, so their order does not matter
+    uint64_t properties = 0;
+    for (int i = 0; i < b->propertyCount; i++)
+        properties += __mix64(__hashString(b->properties[i].name, seed) ^ (__hashString(b->properties[i].value, seed) + 0x9e3779b97f4a7c15ULL));
+
+    return __mix64(h ^ properties);
+}
+
+// Implementation
+
+/**
+ * Hashes a Block. Equal blocks hash equally, regardless of the order of their properties.
  * @param b The block.
- * @return The string representation of the block.
+ * @return The hash of the block.
  */
-char* Block_toString(Block* b) {
+uint64_t Block_hash(Block* b) {
     if (b == 0) return 0;
 
-    char* name = (char*) malloc(strlen(b->name) + 1);
-    sprintf(name, "%s", b->name);
+    return __Block_hash(b, 0);
+}
 
-    if (b->propertyCount == 0)
-        return name;
-    
-    int bytes = strlen(name) + 1;
-    for (int i = 0; i < b->propertyCount; i++) {
-        bytes += strlen(b->properties[i]->name) + strlen(b->properties[i]->value) + 4;
-    }
+/**
+ * Writes a Block into a buffer, in the same form as Block_toString.
+ * Like snprintf, the output is truncated to fit and always terminated when size is not 0.
+ * @param b The block.
+ * @param buffer The buffer to write to. It may be null if size is 0.
+ * @param size The size of the buffer.
+ * @return The length of the full string, excluding the terminator, or -1 if the block is null.
+ */
+int Block_toBuffer(Block* b, char* buffer, size_t size) {
+    if (b == 0) return -1;
 
-    char* str = (char*) malloc(bytes);
-    sprintf(str, "%s<", name);
+    int length = snprintf(buffer, size, "%s", b->name);
+    if (b->propertyCount == 0)
+        return length;
 
+    length = __formatAt(buffer, size, length, "<");
     for (int i = 0; i < b->propertyCount; i++) {
-        sprintf(str, "%s%s=%s", str, b->properties[i]->name, b->properties[i]->value);
+        length = __formatAt(buffer, size, length, "%s=%s", b->properties[i].name, b->properties[i].value);
         if (i < b->propertyCount - 1)
-            sprintf(str, "%s, ", str);
+            length = __formatAt(buffer, size, length, ", ");
     }
 
-    int l = strlen(str);
-    if (str[l - 1] != '>')
-        sprintf(str, "%s>", str);
+    return __formatAt(buffer, size, length, ">");
+}
+
+/**
+ * Converts a Block to a string.
+ * @param b The block.
+ * @return The string representation of the block.
+ */
+char* Block_toString(Block* b) {
+    if (b == 0) return 0;
 
+    int length = Block_toBuffer(b, 0, 0);
+    char* str = (char*) malloc(length + 1);
+    Block_toBuffer(b, str, length + 1);
     return str;
 }
 
@@ -197,10 +403,7 @@ Block* Block_fromString(const char* str) {
         return 0;
     }
 
-    char* name0 = (char*) malloc(strlen(name) + 1);
-    strcpy(name0, name);
-
-    Block* b = createBlock(name0);
+    Block* b = createBlock(name);
 
     char* properties = strtok(0, "<");
     if (properties == 0) {
@@ -249,6 +452,12 @@ typedef struct LevelObject2D {
      * The 2D coordinate of the object.
      */
     Coordinate2D* coordinate;
+
+    /**
+     * The embedded coordinate of objects made with createLevelObject2DAt, which
+     * the coordinate points to.
+     */
+    Coordinate2D position;
 } LevelObject2D;
 
 /**
@@ -265,24 +474,54 @@ LevelObject2D* createLevelObject2D(Block* block, Coordinate2D* coordinate) {
     return o;
 }
 
+/**
+ * Creates a new LevelObject2D that embeds its coordinate, so the object and its
+ * coordinate are a single allocation.
+ * @param block The block of the object.
+ * @param coordinate The 2D coordinate of the object.
+ * @return A new LevelObject2D.
+ */
+LevelObject2D* createLevelObject2DAt(Block* block, Coordinate2D coordinate) {
+    LevelObject2D* o = (LevelObject2D*) malloc(sizeof(LevelObject2D));
+    o->block = block;
+    o->position = coordinate;
+    o->coordinate = &o->position;
+    return o;
+}
+
+/**
+ * Writes a LevelObject2D into a buffer, in the same form as LevelObject2D_toString.
+ * Like snprintf, the output is truncated to fit and always terminated when size is not 0.
+ * @param object The LevelObject2D.
+ * @param buffer The buffer to write to. It may be null if size is 0.
+ * @param size The size of the buffer.
+ * @return The length of the full string, excluding the terminator, or -1 if the object is null.
+ */
+int LevelObject2D_toBuffer(LevelObject2D* object, char* buffer, size_t size) {
+    if (object == 0) return -1;
+
+    int length = Block_toBuffer(object->block, buffer, size);
+    length = __formatAt(buffer, size, length, ": ");
+    return length + Coordinate2D_toBuffer(object->coordinate, __bufferAt(buffer, size, length), __sizeAt(size, length));
+}
+
 /**
  * Converts a LevelObject2D to a string.
  * @param block The LevelObject2D.
  */
 char* LevelObject2D_toString(LevelObject2D* object) {
-    char* block = Block_toString(object->block);
-    char* coordinate = Coordinate2D_toString(object->coordinate);
-
-    char* str = (char*) malloc(strlen(block) + strlen(coordinate) + 3);
-    sprintf(str, "%s: %s", block, coordinate);
+    if (object == 0) return 0;
 
+    int length = LevelObject2D_toBuffer(object, 0, 0);
+    char* str = (char*) malloc(length + 1);
+    LevelObject2D_toBuffer(object, str, length + 1);
     return str;
 }
 
 /**
  * Converts a string to a LevelObject2D.
  * @param str The string representation of the LevelObject2D.
- * @return The LevelObject2D.
+ * @return The LevelObject2D, or null if the string is malformed.
  */
 LevelObject2D* LevelObject2D_fromString(char* str) {
     char* blockStr = strtok(str, ":");
@@ -290,8 +529,15 @@ LevelObject2D* LevelObject2D_fromString(char* str) {
 
     Block* block = Block_fromString(blockStr);
     Coordinate2D* coordinate = Coordinate2D_fromString(coordinateStr);
+    if (block == 0 || coordinate == 0) {
+        if (block != 0) __Block_free(block);
+        free(coordinate);
+        return 0;
+    }
 
-    return createLevelObject2D(block, coordinate);
+    LevelObject2D* object = createLevelObject2DAt(block, *coordinate);
+    free(coordinate);
+    return object;
 }
 
 /**
@@ -308,6 +554,12 @@ typedef struct LevelObject3D {
      * The 3D coordinate of the object.
      */
     Coordinate3D* coordinate;
+
+    /**
+     * The embedded coordinate of objects made with createLevelObject3DAt, which
+     * the coordinate points to.
+     */
+    Coordinate3D position;
 } LevelObject3D;
 
 /**
@@ -323,24 +575,54 @@ LevelObject3D* createLevelObject3D(Block* block, Coordinate3D* coordinate) {
     return o;
 }
 
+/**
+ * Creates a new LevelObject3D that embeds its coordinate, so the object and its
+ * coordinate are a single allocation.
+ * @param block The block of the object.
+ * @param coordinate The 3D coordinate of the object.
+ * @return A new LevelObject3D.
+ */
+LevelObject3D* createLevelObject3DAt(Block* block, Coordinate3D coordinate) {
+    LevelObject3D* o = (LevelObject3D*) malloc(sizeof(LevelObject3D));
+    o->block = block;
+    o->position = coordinate;
+    o->coordinate = &o->position;
+    return o;
+}
+
+/**
+ * Writes a LevelObject3D into a buffer, in the same form as LevelObject3D_toString.
+ * Like snprintf, the output is truncated to fit and always terminated when size is not 0.
+ * @param object The LevelObject3D.
+ * @param buffer The buffer to write to. It may be null if size is 0.
+ * @param size The size of the buffer.
+ * @return The length of the full string, excluding the terminator, or -1 if the object is null.
+ */
+int LevelObject3D_toBuffer(LevelObject3D* object, char* buffer, size_t size) {
+    if (object == 0) return -1;
+
+    int length = Block_toBuffer(object->block, buffer, size);
+    length = __formatAt(buffer, size, length, ": ");
+    return length + Coordinate3D_toBuffer(object->coordinate, __bufferAt(buffer, size, length), __sizeAt(size, length));
+}
+
 /**
  * Converts a LevelObject3D to a string.
  * @param block The LevelObject3D.
  */
 char* LevelObject3D_toString(LevelObject3D* object) {
-    char* block = Block_toString(object->block);
-    char* coordinate = Coordinate3D_toString(object->coordinate);
-
-    char* str = (char*) malloc(strlen(block) + strlen(coordinate) + 3);
-    sprintf(str, "%s: %s", block, coordinate);
+    if (object == 0) return 0;
 
+    int length = LevelObject3D_toBuffer(object, 0, 0);
+    char* str = (char*) malloc(length + 1);
+    LevelObject3D_toBuffer(object, str, length + 1);
     return str;
 }
 
 /**
  * Converts a string to a LevelObject3D.
  * @param str The string representation of the LevelObject3D.
- * @return The LevelObject3D.
+ * @return The LevelObject3D, or null if the string is malformed.
  */
 LevelObject3D* LevelObject3D_fromString(char* str) {
     char* blockStr = strtok(str, ":");
@@ -348,8 +630,15 @@ LevelObject3D* LevelObject3D_fromString(char* str) {
 
     Block* block = Block_fromString(blockStr);
     Coordinate3D* coordinate = Coordinate3D_fromString(coordinateStr);
+    if (block == 0 || coordinate == 0) {
+        if (block != 0) __Block_free(block);
+        free(coordinate);
+        return 0;
+    }
 
-    return createLevelObject3D(block, coordinate);
+    LevelObject3D* object = createLevelObject3DAt(block, *coordinate);
+    free(coordinate);
+    return object;
 }
 
 #endif
\ No newline at end of file
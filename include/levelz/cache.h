@@ -0,0 +1,608 @@
+#ifndef LEVELZ_CACHE_H
+#define LEVELZ_CACHE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/stat.h>
+
+#include "../levelz.h"
+
+/**
+ * The magic number at the start of every cached level image.
+ */
+const char* LEVELZ_CACHE_MAGIC = "LVZC";
+
+/**
+ * The version of the cached level image format. Images with a different version are ignored.
+ */
+const uint32_t LEVELZ_CACHE_VERSION = 1;
+
+/**
+ * The extension of cached level images.
+ */
+const char* LEVELZ_CACHE_SUFFIX = ".lvlzc";
+
+// Internal
+
+char* __levelCacheDirectory = 0;
+
+typedef struct __CacheKey {
+    uint64_t size;
+    int64_t mtime;
+    uint64_t content;
+} __CacheKey;
+
+uint64_t __hashBytes(const char* data, size_t length, uint64_t seed) {
+    uint64_t h = seed ^ (length * 0x9e3779b97f4a7c15ULL);
+
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+        h = (h ^ __mix64(word)) * 0xff51afd7ed558ccdULL;
+    }
+
+    uint64_t tail = 0;
+    memcpy(&tail, data + i, length - i);
+
+    return __mix64(h ^ __mix64(tail));
+}
+
+char* __cachePath(const char* path, int dimension) {
+    if (__levelCacheDirectory == 0) return 0;
+
+    size_t length = strlen(path);
+    uint64_t low = __hashBytes(path, length, 0x243f6a8885a308d3ULL);
+    uint64_t high = __hashBytes(path, length, 0x13198a2e03707344ULL);
+
+    char* cachePath = (char*) malloc(strlen(__levelCacheDirectory) + 48);
+    sprintf(cachePath, "%s/%016llx%016llx.%dd%s", __levelCacheDirectory, (unsigned long long) high, (unsigned long long) low, dimension, LEVELZ_CACHE_SUFFIX);
+    return cachePath;
+}
+
+int __cacheKey(__CacheKey* key, const char* path, const char* buffer) {
+    struct stat info;
+    if (stat(path, &info) != 0) return 0;
+
+    size_t length = strlen(buffer);
+    key->size = (uint64_t) length;
+    key->mtime = (int64_t) info.st_mtime;
+    key->content = __hashBytes(buffer, length, 0);
+
+    return 1;
+}
+
+// Writing
+
+void __appendBytes(char** str, size_t* length, size_t* capacity, const void* data, size_t size) {
+    if (*length + size > *capacity) {
+        while (*length + size > *capacity) *capacity *= 2;
+        *str = (char*) realloc(*str, *capacity);
+    }
+
+    memcpy(*str + *length, data, size);
+    *length += size;
+}
+
+void __appendUInt32(char** str, size_t* length, size_t* capacity, uint32_t value) {
+    __appendBytes(str, length, capacity, &value, sizeof(uint32_t));
+}
+
+void __appendString(char** str, size_t* length, size_t* capacity, const char* value) {
+    uint32_t size = (uint32_t) strlen(value);
+    __appendUInt32(str, length, capacity, size);
+    __appendBytes(str, length, capacity, value, size);
+}
+
+// Blocks are shared between the objects of a parsed level, so each distinct
+// block is written once to a table and objects refer to it by index.
+
+typedef struct __BlockTable {
+    Block** blocks;
+    int count;
+    int* slots;
+    int slotCapacity;
+} __BlockTable;
+
+uint32_t __BlockTable_indexOf(__BlockTable* table, Block* block) {
+    int mask = table->slotCapacity - 1;
+    int slot = (int) (__mix64((uint64_t) (uintptr_t) block) & mask);
+    while (table->slots[slot] != 0) {
+        if (table->blocks[table->slots[slot] - 1] == block)
+            return (uint32_t) (table->slots[slot] - 1);
+
+        slot = (slot + 1) & mask;
+    }
+
+    table->blocks[table->count] = block;
+    table->slots[slot] = ++table->count;
+    return (uint32_t) (table->count - 1);
+}
+
+void __appendCacheHeader(char** str, size_t* length, size_t* capacity, const char* path, __CacheKey* key, uint32_t dimension) {
+    __appendBytes(str, length, capacity, LEVELZ_CACHE_MAGIC, 4);
+    __appendUInt32(str, length, capacity, LEVELZ_CACHE_VERSION);
+    __appendUInt32(str, length, capacity, dimension);
+    __appendBytes(str, length, capacity, key, sizeof(__CacheKey));
+    __appendString(str, length, capacity, path);
+
+    // reserved for the checksum of the payload
+    uint64_t checksum = 0;
+    __appendBytes(str, length, capacity, &checksum, sizeof(uint64_t));
+}
+
+void __appendCacheBlocks(char** str, size_t* length, size_t* capacity, Block** blocks, int count) {
+    __appendUInt32(str, length, capacity, (uint32_t) count);
+    for (int i = 0; i < count; i++) {
+        Block* block = blocks[i];
+        __appendString(str, length, capacity, block->name);
+        __appendUInt32(str, length, capacity, (uint32_t) block->propertyCount);
+        for (int j = 0; j < block->propertyCount; j++) {
+            __appendString(str, length, capacity, block->properties[j].name);
+            __appendString(str, length, capacity, block->properties[j].value);
+        }
+    }
+}
+
+int __writeCacheImage(const char* cachePath, char* str, size_t length, size_t payload) {
+    uint64_t checksum = __hashBytes(str + payload, length - payload, 0);
+    memcpy(str + payload - sizeof(uint64_t), &checksum, sizeof(uint64_t));
+
+    return __writeFileAtomic(cachePath, str, length);
+}
+
+void __Level2D_storeCache(const char* path, const char* buffer, Level2D* level) {
+    // the image always holds a spawnpoint, so levels without one are not cached
+    if (level->spawn == 0) return;
+
+    char* cachePath = __cachePath(path, 2);
+    if (cachePath == 0) return;
+
+    __CacheKey key;
+    if (!__cacheKey(&key, path, buffer)) {
+        free(cachePath);
+        return;
+    }
+
+    size_t length = 0;
+    size_t capacity = 256;
+    char* str = (char*) malloc(capacity);
+
+    __appendCacheHeader(&str, &length, &capacity, path, &key, 2);
+    size_t payload = length;
+
+    int headerCount = Level2D_getHeaderCount(level);
+    __appendUInt32(&str, &length, &capacity, (uint32_t) headerCount);
+    for (int i = 0; i < headerCount; i++) {
+        __appendString(&str, &length, &capacity, level->headers[i]->name);
+        __appendString(&str, &length, &capacity, level->headers[i]->value);
+    }
+
+    __appendBytes(&str, &length, &capacity, &level->spawn->x, sizeof(double));
+    __appendBytes(&str, &length, &capacity, &level->spawn->y, sizeof(double));
+
+    __BlockTable table;
+    table.blocks = (Block**) malloc((level->blockCount + 1) * sizeof(Block*));
+    table.count = 0;
+    table.slotCapacity = 16;
+    while (table.slotCapacity < level->blockCount * 2) table.slotCapacity *= 2;
+    table.slots = (int*) calloc(table.slotCapacity, sizeof(int));
+
+    uint32_t* indices = (uint32_t*) malloc((level->blockCount + 1) * sizeof(uint32_t));
+    for (int i = 0; i < level->blockCount; i++)
+        indices[i] = __BlockTable_indexOf(&table, level->blocks[i]->block);
+
+    __appendCacheBlocks(&str, &length, &capacity, table.blocks, table.count);
+
+    __appendUInt32(&str, &length, &capacity, (uint32_t) level->blockCount);
+    for (int i = 0; i < level->blockCount; i++) {
+        Coordinate2D* c = level->blocks[i]->coordinate;
+        __appendUInt32(&str, &length, &capacity, indices[i]);
+        __appendBytes(&str, &length, &capacity, &c->x, sizeof(double));
+        __appendBytes(&str, &length, &capacity, &c->y, sizeof(double));
+    }
+
+    __writeCacheImage(cachePath, str, length, payload);
+
+    free(indices);
+    free(table.slots);
+    free(table.blocks);
+    free(str);
+    free(cachePath);
+}
+
+void __Level3D_storeCache(const char* path, const char* buffer, Level3D* level) {
+    // the image always holds a spawnpoint, so levels without one are not cached
+    if (level->spawn == 0) return;
+
+    char* cachePath = __cachePath(path, 3);
+    if (cachePath == 0) return;
+
+    __CacheKey key;
+    if (!__cacheKey(&key, path, buffer)) {
+        free(cachePath);
+        return;
+    }
+
+    size_t length = 0;
+    size_t capacity = 256;
+    char* str = (char*) malloc(capacity);
+
+    __appendCacheHeader(&str, &length, &capacity, path, &key, 3);
+    size_t payload = length;
+
+    int headerCount = Level3D_getHeaderCount(level);
+    __appendUInt32(&str, &length, &capacity, (uint32_t) headerCount);
+    for (int i = 0; i < headerCount; i++) {
+        __appendString(&str, &length, &capacity, level->headers[i]->name);
+        __appendString(&str, &length, &capacity, level->headers[i]->value);
+    }
+
+    __appendBytes(&str, &length, &capacity, &level->spawn->x, sizeof(double));
+    __appendBytes(&str, &length, &capacity, &level->spawn->y, sizeof(double));
+    __appendBytes(&str, &length, &capacity, &level->spawn->z, sizeof(double));
+
+    __BlockTable table;
+    table.blocks = (Block**) malloc((level->blockCount + 1) * sizeof(Block*));
+    table.count = 0;
+    table.slotCapacity = 16;
+    while (table.slotCapacity < level->blockCount * 2) table.slotCapacity *= 2;
+    table.slots = (int*) calloc(table.slotCapacity, sizeof(int));
+
+    uint32_t* indices = (uint32_t*) malloc((level->blockCount + 1) * sizeof(uint32_t));
+    for (int i = 0; i < level->blockCount; i++)
+        indices[i] = __BlockTable_indexOf(&table, level->blocks[i]->block);
+
+    __appendCacheBlocks(&str, &length, &capacity, table.blocks, table.count);
+
+    __appendUInt32(&str, &length, &capacity, (uint32_t) level->blockCount);
+    for (int i = 0; i < level->blockCount; i++) {
+        Coordinate3D* c = level->blocks[i]->coordinate;
+        __appendUInt32(&str, &length, &capacity, indices[i]);
+        __appendBytes(&str, &length, &capacity, &c->x, sizeof(double));
+        __appendBytes(&str, &length, &capacity, &c->y, sizeof(double));
+        __appendBytes(&str, &length, &capacity, &c->z, sizeof(double));
+    }
+
+    __writeCacheImage(cachePath, str, length, payload);
+
+    free(indices);
+    free(table.slots);
+    free(table.blocks);
+    free(str);
+    free(cachePath);
+}
+
+// Reading
+
+typedef struct __CacheReader {
+    const char* cursor;
+    const char* end;
+} __CacheReader;
+
+int __CacheReader_read(__CacheReader* reader, void* out, size_t size) {
+    if ((size_t) (reader->end - reader->cursor) < size) return 0;
+
+    memcpy(out, reader->cursor, size);
+    reader->cursor += size;
+    return 1;
+}
+
+int __CacheReader_readUInt32(__CacheReader* reader, uint32_t* out) {
+    return __CacheReader_read(reader, out, sizeof(uint32_t));
+}
+
+char* __CacheReader_readString(__CacheReader* reader) {
+    uint32_t size;
+    if (!__CacheReader_readUInt32(reader, &size)) return 0;
+    if ((size_t) (reader->end - reader->cursor) < size) return 0;
+
+    char* str = (char*) malloc(size + 1);
+    memcpy(str, reader->cursor, size);
+    str[size] = '\0';
+    reader->cursor += size;
+    return str;
+}
+
+// Checks the header of an image against the source file, and leaves the reader
+// at the start of a payload whose checksum matches.
+int __CacheReader_open(__CacheReader* reader, char* image, size_t length, const char* path, const char* buffer, uint32_t dimension) {
+    reader->cursor = image;
+    reader->end = image + length;
+
+    char magic[4];
+    uint32_t version;
+    uint32_t imageDimension;
+    if (!__CacheReader_read(reader, magic, 4) || memcmp(magic, LEVELZ_CACHE_MAGIC, 4) != 0) return 0;
+    if (!__CacheReader_readUInt32(reader, &version) || version != LEVELZ_CACHE_VERSION) return 0;
+    if (!__CacheReader_readUInt32(reader, &imageDimension) || imageDimension != dimension) return 0;
+
+    // the size and mtime are compared before hashing the contents
+    __CacheKey stored;
+    __CacheKey key;
+    if (!__CacheReader_read(reader, &stored, sizeof(__CacheKey))) return 0;
+
+    struct stat info;
+    if (stat(path, &info) != 0) return 0;
+    if (stored.mtime != (int64_t) info.st_mtime) return 0;
+    if (stored.size != (uint64_t) strlen(buffer)) return 0;
+    if (!__cacheKey(&key, path, buffer) || stored.content != key.content) return 0;
+
+    char* imagePath = __CacheReader_readString(reader);
+    if (imagePath == 0) return 0;
+
+    int samePath = strcmp(imagePath, path) == 0;
+    free(imagePath);
+    if (!samePath) return 0;
+
+    uint64_t checksum;
+    if (!__CacheReader_read(reader, &checksum, sizeof(uint64_t))) return 0;
+
+    return checksum == __hashBytes(reader->cursor, reader->end - reader->cursor, 0);
+}
+
+void __freeCacheBlocks(Block** blocks, uint32_t count) {
+    if (blocks == 0) return;
+
+    for (uint32_t i = 0; i < count; i++)
+        __Block_free(blocks[i]);
+    free(blocks);
+}
+
+Block** __CacheReader_readBlocks(__CacheReader* reader, uint32_t* count) {
+    if (!__CacheReader_readUInt32(reader, count)) return 0;
+    if (*count > (size_t) (reader->end - reader->cursor) / 8) return 0;
+
+    Block** blocks = (Block**) malloc((*count + 1) * sizeof(Block*));
+    for (uint32_t i = 0; i < *count; i++) {
+        char* name = __CacheReader_readString(reader);
+        uint32_t propertyCount;
+        if (name == 0 || !__CacheReader_readUInt32(reader, &propertyCount)) {
+            free(name);
+            __freeCacheBlocks(blocks, i);
+            return 0;
+        }
+
+        Block* block = createBlock(name);
+        free(name);
+        for (uint32_t j = 0; j < propertyCount; j++) {
+            char* propertyName = __CacheReader_readString(reader);
+            char* propertyValue = __CacheReader_readString(reader);
+            if (propertyName == 0 || propertyValue == 0) {
+                free(propertyName);
+                free(propertyValue);
+                __Block_free(block);
+                __freeCacheBlocks(blocks, i);
+                return 0;
+            }
+
+            Block_setProperty(block, propertyName, propertyValue);
+            free(propertyName);
+            free(propertyValue);
+        }
+
+        blocks[i] = block;
+    }
+
+    return blocks;
+}
+
+Level2D* __Level2D_loadCache(const char* path, const char* buffer) {
+    char* cachePath = __cachePath(path, 2);
+    if (cachePath == 0) return 0;
+
+    FILE* file = fopen(cachePath, "rb");
+    free(cachePath);
+    if (file == 0) return 0;
+
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (length <= 0) {
+        fclose(file);
+        return 0;
+    }
+
+    char* image = (char*) malloc(length);
+    size_t read = fread(image, 1, length, file);
+    fclose(file);
+
+    __CacheReader reader;
+    if (read != (size_t) length || !__CacheReader_open(&reader, image, read, path, buffer, 2)) {
+        free(image);
+        return 0;
+    }
+
+    // the checksum only shows the payload is as it was written, so every read and index
+    // is still checked, and any mismatch falls back to parsing the file
+    uint32_t headerCount;
+    if (!__CacheReader_readUInt32(&reader, &headerCount)) {
+        free(image);
+        return 0;
+    }
+
+    Level2D* level = createLevel2D(createCoordinate2D(0, 0));
+    int valid = 1;
+    for (uint32_t i = 0; valid && i < headerCount; i++) {
+        char* name = __CacheReader_readString(&reader);
+        char* value = __CacheReader_readString(&reader);
+        valid = name != 0 && value != 0;
+        if (valid) {
+            Level2D_addHeader(level, name, value);
+        } else {
+            free(name);
+            free(value);
+        }
+    }
+
+    valid = valid
+        && __CacheReader_read(&reader, &level->spawn->x, sizeof(double))
+        && __CacheReader_read(&reader, &level->spawn->y, sizeof(double));
+
+    uint32_t blockCount = 0;
+    Block** blocks = valid ? __CacheReader_readBlocks(&reader, &blockCount) : 0;
+
+    // every object takes an index and two coordinates
+    uint32_t count = 0;
+    valid = blocks != 0
+        && __CacheReader_readUInt32(&reader, &count)
+        && count <= _LEVEL_BLOCKS_MAX_CAPACITY
+        && count <= (size_t) (reader.end - reader.cursor) / (sizeof(uint32_t) + 2 * sizeof(double));
+
+    LevelObject2D** objects = (LevelObject2D**) malloc(((valid ? count : 0) + 1) * sizeof(LevelObject2D*));
+    uint32_t created = 0;
+    while (valid && created < count) {
+        uint32_t index;
+        double x, y;
+        valid = __CacheReader_readUInt32(&reader, &index) && index < blockCount
+            && __CacheReader_read(&reader, &x, sizeof(double))
+            && __CacheReader_read(&reader, &y, sizeof(double));
+
+        if (valid) objects[created++] = createLevelObject2DAt(blocks[index], makeCoordinate2D(x, y));
+    }
+
+    if (!valid) {
+        for (uint32_t i = 0; i < created; i++)
+            free(objects[i]);
+
+        free(objects);
+        __freeCacheBlocks(blocks, blockCount);
+        __Level2D_free(level);
+        free(image);
+        return 0;
+    }
+
+    Level2D_reserve(level, (int) count);
+    Level2D_addBlocks(level, objects, (int) count);
+
+    free(objects);
+    free(blocks);
+    free(image);
+
+    return level;
+}
+
+Level3D* __Level3D_loadCache(const char* path, const char* buffer) {
+    char* cachePath = __cachePath(path, 3);
+    if (cachePath == 0) return 0;
+
+    FILE* file = fopen(cachePath, "rb");
+    free(cachePath);
+    if (file == 0) return 0;
+
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (length <= 0) {
+        fclose(file);
+        return 0;
+    }
+
+    char* image = (char*) malloc(length);
+    size_t read = fread(image, 1, length, file);
+    fclose(file);
+
+    __CacheReader reader;
+    if (read != (size_t) length || !__CacheReader_open(&reader, image, read, path, buffer, 3)) {
+        free(image);
+        return 0;
+    }
+
+    // the checksum only shows the payload is as it was written, so every read and index
+    // is still checked, and any mismatch falls back to parsing the file
+    uint32_t headerCount;
+    if (!__CacheReader_readUInt32(&reader, &headerCount)) {
+        free(image);
+        return 0;
+    }
+
+    Level3D* level = createLevel3D(createCoordinate3D(0, 0, 0));
+    int valid = 1;
+    for (uint32_t i = 0; valid && i < headerCount; i++) {
+        char* name = __CacheReader_readString(&reader);
+        char* value = __CacheReader_readString(&reader);
+        valid = name != 0 && value != 0;
+        if (valid) {
+            Level3D_addHeader(level, name, value);
+        } else {
+            free(name);
+            free(value);
+        }
+    }
+
+    valid = valid
+        && __CacheReader_read(&reader, &level->spawn->x, sizeof(double))
+        && __CacheReader_read(&reader, &level->spawn->y, sizeof(double))
+        && __CacheReader_read(&reader, &level->spawn->z, sizeof(double));
+
+    uint32_t blockCount = 0;
+    Block** blocks = valid ? __CacheReader_readBlocks(&reader, &blockCount) : 0;
+
+    // every object takes an index and three coordinates
+    uint32_t count = 0;
+    valid = blocks != 0
+        && __CacheReader_readUInt32(&reader, &count)
+        && count <= _LEVEL_BLOCKS_MAX_CAPACITY
+        && count <= (size_t) (reader.end - reader.cursor) / (sizeof(uint32_t) + 3 * sizeof(double));
+
+    LevelObject3D** objects = (LevelObject3D**) malloc(((valid ? count : 0) + 1) * sizeof(LevelObject3D*));
+    uint32_t created = 0;
+    while (valid && created < count) {
+        uint32_t index;
+        double x, y, z;
+        valid = __CacheReader_readUInt32(&reader, &index) && index < blockCount
+            && __CacheReader_read(&reader, &x, sizeof(double))
+            && __CacheReader_read(&reader, &y, sizeof(double))
+            && __CacheReader_read(&reader, &z, sizeof(double));
+
+        if (valid) objects[created++] = createLevelObject3DAt(blocks[index], makeCoordinate3D(x, y, z));
+    }
+
+    if (!valid) {
+        for (uint32_t i = 0; i < created; i++)
+            free(objects[i]);
+
+        free(objects);
+        __freeCacheBlocks(blocks, blockCount);
+        __Level3D_free(level);
+        free(image);
+        return 0;
+    }
+
+    Level3D_reserve(level, (int) count);
+    Level3D_addBlocks(level, objects, (int) count);
+
+    free(objects);
+    free(blocks);
+    free(image);
+
+    return level;
+}
+
+// Implementation
+
+/**
+ * Sets the directory that parsed levels are cached in. When set, parseFile2D and
+ * parseFile3D store a binary image of every level they parse in this directory,
+ * and load that image instead of reparsing the file as long as the file's size,
+ * modification time and contents are unchanged. Images are written atomically,
+ * so several processes can share one directory. The directory must already exist
+ * and should be set before any files are parsed.
+ * @param directory The cache directory, or null to disable caching.
+ */
+void setLevelCacheDirectory(const char* directory) {
+    free(__levelCacheDirectory);
+    __levelCacheDirectory = directory == 0 ? 0 : __copyString(directory);
+}
+
+/**
+ * Gets the directory that parsed levels are cached in.
+ * @return The cache directory, or null if caching is disabled.
+ */
+const char* getLevelCacheDirectory() {
+    return __levelCacheDirectory;
+}
+
+#endif
@@ -0,0 +1,743 @@
+#ifndef LEVELZ_CHUNK_H
+#define LEVELZ_CHUNK_H
+
+#define _LEVEL_CHUNK_SIZE 16
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <tgmath.h>
+
+#include "block.h"
+#include "coordinate.h"
+#include "thread.h"
+
+// Internal
+
+// Whether a coordinate value lies well inside the range of an int, so it can be
+// converted to a chunk or a cell without overflowing. NaN never does.
+int __inChunkRange(double d) {
+    return d > -1073741824.0 && d < 1073741824.0;
+}
+
+// The chunk of a coordinate value. Values outside the chunk range land just past its
+// edge, on a chunk that never holds blocks.
+int __chunkOf(double value) {
+    if (!__inChunkRange(value)) return value < 0 ? -1073741824 / _LEVEL_CHUNK_SIZE - 1 : 1073741824 / _LEVEL_CHUNK_SIZE;
+    return (int) floor(value / _LEVEL_CHUNK_SIZE);
+}
+
+// Rounds a coordinate value down to a cell, clamped to the chunk range. NaN rounds to 0.
+int __cellFloor(double value) {
+    if (value != value) return 0;
+    if (value <= -1073741824.0) return -1073741824;
+    if (value >= 1073741824.0) return 1073741823;
+    return (int) floor(value);
+}
+
+// The position of a coordinate value inside its chunk.
+int __cellOf(double value) {
+    if (!__inChunkRange(value)) return 0;
+    return ((int) floor(value)) & (_LEVEL_CHUNK_SIZE - 1);
+}
+
+int __popCount64(uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(v);
+#else
+    v = v - ((v >> 1) & 0x5555555555555555ULL);
+    v = (v & 0x3333333333333333ULL) + ((v >> 2) & 0x3333333333333333ULL);
+    v = (v + (v >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (int) ((v * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+// The occupied cells of a row of a chunk between two local x values, inclusive.
+// Each 64-bit word of an occupancy bitset holds four rows of 16 cells.
+int __countRow(uint64_t word, int row, int x0, int x1) {
+    uint64_t bits = (word >> ((row & 3) * _LEVEL_CHUNK_SIZE)) & 0xFFFF;
+    uint64_t mask = ((1ULL << (x1 + 1)) - 1) & ~((1ULL << x0) - 1);
+    return __popCount64(bits & mask);
+}
+
+/**
+ * Represents a region of a Level2D, used to track which parts of a level change.
+ */
+typedef struct LevelChunk2D {
+    /**
+     * The x coordinate of the chunk, in chunks.
+     */
+    int x;
+
+    /**
+     * The y coordinate of the chunk, in chunks.
+     */
+    int y;
+
+    /**
+     * The blocks inside the chunk.
+     */
+    LevelObject2D** objects;
+
+    /**
+     * The number of blocks inside the chunk.
+     */
+    int count;
+
+    /**
+     * The capacity of the objects array.
+     */
+    int capacity;
+
+    /**
+     * An immutable copy of the chunk made by a previous snapshot, or 0 if the chunk
+     * changed since then.
+     */
+    struct LevelChunkSnapshot2D* snapshot;
+
+    /**
+     * Incremented whenever a block of the chunk is added, removed or replaced.
+     */
+    int version;
+
+    /**
+     * One bit per cell of the chunk, set when a block lies in the cell.
+     */
+    uint64_t occupancy[_LEVEL_CHUNK_SIZE * _LEVEL_CHUNK_SIZE / 64];
+
+    /**
+     * The number of occupied cells. A chunk with no occupied cells can be skipped.
+     */
+    int filled;
+} LevelChunk2D;
+
+/**
+ * Represents an immutable copy of a LevelChunk2D, shared between snapshots.
+ */
+typedef struct LevelChunkSnapshot2D {
+    /**
+     * The number of references to the copy.
+     */
+    int refs;
+
+    /**
+     * The x coordinate of the chunk, in chunks.
+     */
+    int x;
+
+    /**
+     * The y coordinate of the chunk, in chunks.
+     */
+    int y;
+
+    /**
+     * The blocks inside the chunk, ordered by their cell inside the chunk.
+     */
+    LevelObject2D** objects;
+
+    /**
+     * The number of blocks inside the chunk.
+     */
+    int count;
+} LevelChunkSnapshot2D;
+
+/**
+ * Represents the set of chunks of a Level2D, keyed by chunk coordinate.
+ */
+typedef struct LevelChunkMap2D {
+    /**
+     * Open-addressed table of chunks, with 0 for empty entries.
+     */
+    LevelChunk2D** chunks;
+
+    /**
+     * The number of chunks in the map.
+     */
+    int count;
+
+    /**
+     * The capacity of the table. Always zero or a power of two.
+     */
+    int capacity;
+} LevelChunkMap2D;
+
+// Internal
+
+int __cellKey2D(Coordinate2D* c) {
+    return __cellOf(c->x) | __cellOf(c->y) << 4;
+}
+
+int __compareCells2D(const void* a, const void* b) {
+    return __cellKey2D((*(LevelObject2D* const*) a)->coordinate) - __cellKey2D((*(LevelObject2D* const*) b)->coordinate);
+}
+
+void __LevelChunkSnapshot2D_release(LevelChunkSnapshot2D* snapshot) {
+    if (snapshot == 0) return;
+    if (__atomicDecrement(&snapshot->refs) != 0) return;
+
+    free(snapshot->objects);
+    free(snapshot);
+}
+
+LevelChunkSnapshot2D* __LevelChunkSnapshot2D_create(LevelChunk2D* chunk) {
+    LevelChunkSnapshot2D* s = (LevelChunkSnapshot2D*) malloc(sizeof(LevelChunkSnapshot2D));
+    s->refs = 1;
+    s->x = chunk->x;
+    s->y = chunk->y;
+    s->count = chunk->count;
+    s->objects = (LevelObject2D**) malloc((chunk->count + 1) * sizeof(LevelObject2D*));
+    memcpy(s->objects, chunk->objects, chunk->count * sizeof(LevelObject2D*));
+    qsort(s->objects, s->count, sizeof(LevelObject2D*), __compareCells2D);
+
+    return s;
+}
+
+LevelObject2D* __LevelChunkSnapshot2D_find(LevelChunkSnapshot2D* snapshot, Coordinate2D* c) {
+    int key = __cellKey2D(c);
+
+    int lo = 0;
+    int hi = snapshot->count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (__cellKey2D(snapshot->objects[mid]->coordinate) < key) lo = mid + 1;
+        else hi = mid;
+    }
+
+    for (int i = lo; i < snapshot->count; i++) {
+        Coordinate2D* o = snapshot->objects[i]->coordinate;
+        if (__cellKey2D(o) != key) break;
+        if (o->x == c->x && o->y == c->y) return snapshot->objects[i];
+    }
+
+    return 0;
+}
+
+void __LevelChunk2D_invalidate(LevelChunk2D* chunk) {
+    chunk->version++;
+    if (chunk->snapshot == 0) return;
+
+    __LevelChunkSnapshot2D_release(chunk->snapshot);
+    chunk->snapshot = 0;
+}
+
+void __LevelChunk2D_add(LevelChunk2D* chunk, LevelObject2D* object) {
+    if (chunk == 0) return;
+
+    if (chunk->count == chunk->capacity) {
+        chunk->capacity = chunk->capacity == 0 ? 4 : 2 * chunk->capacity;
+        chunk->objects = (LevelObject2D**) realloc(chunk->objects, chunk->capacity * sizeof(LevelObject2D*));
+    }
+
+    chunk->objects[chunk->count++] = object;
+    __LevelChunk2D_invalidate(chunk);
+
+    int key = __cellKey2D(object->coordinate);
+    uint64_t bit = 1ULL << (key & 63);
+    if ((chunk->occupancy[key >> 6] & bit) == 0) {
+        chunk->occupancy[key >> 6] |= bit;
+        chunk->filled++;
+    }
+}
+
+void __LevelChunk2D_remove(LevelChunk2D* chunk, LevelObject2D* object) {
+    if (chunk == 0) return;
+
+    for (int i = 0; i < chunk->count; i++) {
+        if (chunk->objects[i] == object) {
+            chunk->objects[i] = chunk->objects[--chunk->count];
+            __LevelChunk2D_invalidate(chunk);
+            break;
+        }
+    }
+
+    // the cell stays occupied while another block lies in it
+    int key = __cellKey2D(object->coordinate);
+    for (int i = 0; i < chunk->count; i++)
+        if (__cellKey2D(chunk->objects[i]->coordinate) == key) return;
+
+    uint64_t bit = 1ULL << (key & 63);
+    if (chunk->occupancy[key >> 6] & bit) {
+        chunk->occupancy[key >> 6] &= ~bit;
+        chunk->filled--;
+    }
+}
+
+void __LevelChunk2D_replace(LevelChunk2D* chunk, LevelObject2D* object, LevelObject2D* replacement) {
+    if (chunk == 0) return;
+
+    for (int i = 0; i < chunk->count; i++) {
+        if (chunk->objects[i] == object) {
+            chunk->objects[i] = replacement;
+            __LevelChunk2D_invalidate(chunk);
+            return;
+        }
+    }
+}
+
+// Counts the occupied cells of a chunk between two cells, inclusive.
+int __LevelChunk2D_count(LevelChunk2D* chunk, int* lo, int* hi) {
+    if (chunk == 0 || chunk->filled == 0) return 0;
+
+    int x0 = chunk->x * _LEVEL_CHUNK_SIZE;
+    int y0 = chunk->y * _LEVEL_CHUNK_SIZE;
+    int x1 = x0 + _LEVEL_CHUNK_SIZE - 1;
+    int y1 = y0 + _LEVEL_CHUNK_SIZE - 1;
+    if (lo[0] <= x0 && lo[1] <= y0 && hi[0] >= x1 && hi[1] >= y1) return chunk->filled;
+
+    if (lo[0] > x0) x0 = lo[0];
+    if (lo[1] > y0) y0 = lo[1];
+    if (hi[0] < x1) x1 = hi[0];
+    if (hi[1] < y1) y1 = hi[1];
+    if (x0 > x1 || y0 > y1) return 0;
+
+    int count = 0;
+    for (int y = y0; y <= y1; y++) {
+        int row = y & (_LEVEL_CHUNK_SIZE - 1);
+        count += __countRow(chunk->occupancy[row >> 2], row, x0 & (_LEVEL_CHUNK_SIZE - 1), x1 & (_LEVEL_CHUNK_SIZE - 1));
+    }
+
+    return count;
+}
+
+uint64_t __hashChunk2D(int x, int y) {
+    return Coordinate2D_hash(x, y);
+}
+
+void __LevelChunkMap2D_put(LevelChunkMap2D* map, LevelChunk2D* chunk) {
+    int mask = map->capacity - 1;
+    int i = (int) (__hashChunk2D(chunk->x, chunk->y) & mask);
+    while (map->chunks[i] != 0) i = (i + 1) & mask;
+
+    map->chunks[i] = chunk;
+}
+
+// Implementation
+
+/**
+ * Gets a chunk from a LevelChunkMap2D.
+ * @param map The LevelChunkMap2D.
+ * @param x The x coordinate of the chunk.
+ * @param y The y coordinate of the chunk.
+ * @return The chunk, or 0 if the map has no such chunk.
+ */
+LevelChunk2D* LevelChunkMap2D_get(LevelChunkMap2D* map, int x, int y) {
+    if (map == 0) return 0;
+    if (map->capacity == 0) return 0;
+
+    int mask = map->capacity - 1;
+    int i = (int) (__hashChunk2D(x, y) & mask);
+    while (map->chunks[i] != 0) {
+        LevelChunk2D* chunk = map->chunks[i];
+        if (chunk->x == x && chunk->y == y) return chunk;
+
+        i = (i + 1) & mask;
+    }
+
+    return 0;
+}
+
+/**
+ * Gets a chunk from a LevelChunkMap2D, creating it if it does not exist.
+ * @param map The LevelChunkMap2D.
+ * @param x The x coordinate of the chunk.
+ * @param y The y coordinate of the chunk.
+ * @return The chunk.
+ */
+LevelChunk2D* LevelChunkMap2D_getOrCreate(LevelChunkMap2D* map, int x, int y) {
+    LevelChunk2D* chunk = LevelChunkMap2D_get(map, x, y);
+    if (chunk != 0) return chunk;
+
+    if (2 * (map->count + 1) > map->capacity) {
+        LevelChunk2D** old = map->chunks;
+        int oldCapacity = map->capacity;
+
+        map->capacity = oldCapacity == 0 ? 16 : 2 * oldCapacity;
+        map->chunks = (LevelChunk2D**) calloc(map->capacity, sizeof(LevelChunk2D*));
+        for (int i = 0; i < oldCapacity; i++) {
+            if (old[i] != 0) __LevelChunkMap2D_put(map, old[i]);
+        }
+
+        free(old);
+    }
+
+    chunk = (LevelChunk2D*) malloc(sizeof(LevelChunk2D));
+    chunk->x = x;
+    chunk->y = y;
+    chunk->objects = 0;
+    chunk->count = 0;
+    chunk->capacity = 0;
+    chunk->snapshot = 0;
+    chunk->version = 0;
+    memset(chunk->occupancy, 0, sizeof(chunk->occupancy));
+    chunk->filled = 0;
+
+    __LevelChunkMap2D_put(map, chunk);
+    map->count++;
+
+    return chunk;
+}
+
+/**
+ * Gets the chunk of a LevelChunkMap2D containing a coordinate, creating it if it does not exist.
+ * Coordinates too large to address a chunk, or NaN, have none.
+ * @param map The LevelChunkMap2D.
+ * @param coordinate The coordinate.
+ * @return The chunk, or 0 if the coordinate is outside the chunk range.
+ */
+LevelChunk2D* LevelChunkMap2D_chunkAt(LevelChunkMap2D* map, Coordinate2D* coordinate) {
+    if (!__inChunkRange(coordinate->x) || !__inChunkRange(coordinate->y)) return 0;
+    return LevelChunkMap2D_getOrCreate(map, __chunkOf(coordinate->x), __chunkOf(coordinate->y));
+}
+
+/**
+ * Represents a region of a Level3D, used to track which parts of a level change.
+ */
+typedef struct LevelChunk3D {
+    /**
+     * The x coordinate of the chunk, in chunks.
+     */
+    int x;
+
+    /**
+     * The y coordinate of the chunk, in chunks.
+     */
+    int y;
+
+    /**
+     * The z coordinate of the chunk, in chunks.
+     */
+    int z;
+
+    /**
+     * The blocks inside the chunk.
+     */
+    LevelObject3D** objects;
+
+    /**
+     * The number of blocks inside the chunk.
+     */
+    int count;
+
+    /**
+     * The capacity of the objects array.
+     */
+    int capacity;
+
+    /**
+     * An immutable copy of the chunk made by a previous snapshot, or 0 if the chunk
+     * changed since then.
+     */
+    struct LevelChunkSnapshot3D* snapshot;
+
+    /**
+     * Incremented whenever a block of the chunk is added, removed or replaced.
+     */
+    int version;
+
+    /**
+     * One bit per cell of the chunk, set when a block lies in the cell.
+     */
+    uint64_t occupancy[_LEVEL_CHUNK_SIZE * _LEVEL_CHUNK_SIZE * _LEVEL_CHUNK_SIZE / 64];
+
+    /**
+     * The number of occupied cells. A chunk with no occupied cells can be skipped.
+     */
+    int filled;
+} LevelChunk3D;
+
+/**
+ * Represents an immutable copy of a LevelChunk3D, shared between snapshots.
+ */
+typedef struct LevelChunkSnapshot3D {
+    /**
+     * The number of references to the copy.
+     */
+    int refs;
+
+    /**
+     * The x coordinate of the chunk, in chunks.
+     */
+    int x;
+
+    /**
+     * The y coordinate of the chunk, in chunks.
+     */
+    int y;
+
+    /**
+     * The z coordinate of the chunk, in chunks.
+     */
+    int z;
+
+    /**
+     * The blocks inside the chunk, ordered by their cell inside the chunk.
+     */
+    LevelObject3D** objects;
+
+    /**
+     * The number of blocks inside the chunk.
+     */
+    int count;
+} LevelChunkSnapshot3D;
+
+/**
+ * Represents the set of chunks of a Level3D, keyed by chunk coordinate.
+ */
+typedef struct LevelChunkMap3D {
+    /**
+     * Open-addressed table of chunks, with 0 for empty entries.
+     */
+    LevelChunk3D** chunks;
+
+    /**
+     * The number of chunks in the map.
+     */
+    int count;
+
+    /**
+     * The capacity of the table. Always zero or a power of two.
+     */
+    int capacity;
+} LevelChunkMap3D;
+
+// Internal
+
+int __cellKey3D(Coordinate3D* c) {
+    return __cellOf(c->x) | __cellOf(c->y) << 4 | __cellOf(c->z) << 8;
+}
+
+int __compareCells3D(const void* a, const void* b) {
+    return __cellKey3D((*(LevelObject3D* const*) a)->coordinate) - __cellKey3D((*(LevelObject3D* const*) b)->coordinate);
+}
+
+void __LevelChunkSnapshot3D_release(LevelChunkSnapshot3D* snapshot) {
+    if (snapshot == 0) return;
+    if (__atomicDecrement(&snapshot->refs) != 0) return;
+
+    free(snapshot->objects);
+    free(snapshot);
+}
+
+LevelChunkSnapshot3D* __LevelChunkSnapshot3D_create(LevelChunk3D* chunk) {
+    LevelChunkSnapshot3D* s = (LevelChunkSnapshot3D*) malloc(sizeof(LevelChunkSnapshot3D));
+    s->refs = 1;
+    s->x = chunk->x;
+    s->y = chunk->y;
+    s->z = chunk->z;
+    s->count = chunk->count;
+    s->objects = (LevelObject3D**) malloc((chunk->count + 1) * sizeof(LevelObject3D*));
+    memcpy(s->objects, chunk->objects, chunk->count * sizeof(LevelObject3D*));
+    qsort(s->objects, s->count, sizeof(LevelObject3D*), __compareCells3D);
+
+    return s;
+}
+
+LevelObject3D* __LevelChunkSnapshot3D_find(LevelChunkSnapshot3D* snapshot, Coordinate3D* c) {
+    int key = __cellKey3D(c);
+
+    int lo = 0;
+    int hi = snapshot->count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (__cellKey3D(snapshot->objects[mid]->coordinate) < key) lo = mid + 1;
+        else hi = mid;
+    }
+
+    for (int i = lo; i < snapshot->count; i++) {
+        Coordinate3D* o = snapshot->objects[i]->coordinate;
+        if (__cellKey3D(o) != key) break;
+        if (o->x == c->x && o->y == c->y && o->z == c->z) return snapshot->objects[i];
+    }
+
+    return 0;
+}
+
+void __LevelChunk3D_invalidate(LevelChunk3D* chunk) {
+    chunk->version++;
+    if (chunk->snapshot == 0) return;
+
+    __LevelChunkSnapshot3D_release(chunk->snapshot);
+    chunk->snapshot = 0;
+}
+
+void __LevelChunk3D_add(LevelChunk3D* chunk, LevelObject3D* object) {
+    if (chunk == 0) return;
+
+    if (chunk->count == chunk->capacity) {
+        chunk->capacity = chunk->capacity == 0 ? 4 : 2 * chunk->capacity;
+        chunk->objects = (LevelObject3D**) realloc(chunk->objects, chunk->capacity * sizeof(LevelObject3D*));
+    }
+
+    chunk->objects[chunk->count++] = object;
+    __LevelChunk3D_invalidate(chunk);
+
+    int key = __cellKey3D(object->coordinate);
+    uint64_t bit = 1ULL << (key & 63);
+    if ((chunk->occupancy[key >> 6] & bit) == 0) {
+        chunk->occupancy[key >> 6] |= bit;
+        chunk->filled++;
+    }
+}
+
+void __LevelChunk3D_remove(LevelChunk3D* chunk, LevelObject3D* object) {
+    if (chunk == 0) return;
+
+    for (int i = 0; i < chunk->count; i++) {
+        if (chunk->objects[i] == object) {
+            chunk->objects[i] = chunk->objects[--chunk->count];
+            __LevelChunk3D_invalidate(chunk);
+            break;
+        }
+    }
+
+    // the cell stays occupied while another block lies in it
+    int key = __cellKey3D(object->coordinate);
+    for (int i = 0; i < chunk->count; i++)
+        if (__cellKey3D(chunk->objects[i]->coordinate) == key) return;
+
+    uint64_t bit = 1ULL << (key & 63);
+    if (chunk->occupancy[key >> 6] & bit) {
+        chunk->occupancy[key >> 6] &= ~bit;
+        chunk->filled--;
+    }
+}
+
+void __LevelChunk3D_replace(LevelChunk3D* chunk, LevelObject3D* object, LevelObject3D* replacement) {
+    if (chunk == 0) return;
+
+    for (int i = 0; i < chunk->count; i++) {
+        if (chunk->objects[i] == object) {
+            chunk->objects[i] = replacement;
+            __LevelChunk3D_invalidate(chunk);
+            return;
+        }
+    }
+}
+
+// Counts the occupied cells of a chunk between two cells, inclusive.
+int __LevelChunk3D_count(LevelChunk3D* chunk, int* lo, int* hi) {
+    if (chunk == 0 || chunk->filled == 0) return 0;
+
+    int x0 = chunk->x * _LEVEL_CHUNK_SIZE;
+    int y0 = chunk->y * _LEVEL_CHUNK_SIZE;
+    int z0 = chunk->z * _LEVEL_CHUNK_SIZE;
+    int x1 = x0 + _LEVEL_CHUNK_SIZE - 1;
+    int y1 = y0 + _LEVEL_CHUNK_SIZE - 1;
+    int z1 = z0 + _LEVEL_CHUNK_SIZE - 1;
+    if (lo[0] <= x0 && lo[1] <= y0 && lo[2] <= z0 && hi[0] >= x1 && hi[1] >= y1 && hi[2] >= z1) return chunk->filled;
+
+    if (lo[0] > x0) x0 = lo[0];
+    if (lo[1] > y0) y0 = lo[1];
+    if (lo[2] > z0) z0 = lo[2];
+    if (hi[0] < x1) x1 = hi[0];
+    if (hi[1] < y1) y1 = hi[1];
+    if (hi[2] < z1) z1 = hi[2];
+    if (x0 > x1 || y0 > y1 || z0 > z1) return 0;
+
+    int count = 0;
+    for (int z = z0; z <= z1; z++) {
+        for (int y = y0; y <= y1; y++) {
+            int row = y & (_LEVEL_CHUNK_SIZE - 1);
+            int word = (row >> 2) | (z & (_LEVEL_CHUNK_SIZE - 1)) << 2;
+            count += __countRow(chunk->occupancy[word], row, x0 & (_LEVEL_CHUNK_SIZE - 1), x1 & (_LEVEL_CHUNK_SIZE - 1));
+        }
+    }
+
+    return count;
+}
+
+uint64_t __hashChunk3D(int x, int y, int z) {
+    return Coordinate3D_hash(x, y, z);
+}
+
+void __LevelChunkMap3D_put(LevelChunkMap3D* map, LevelChunk3D* chunk) {
+    int mask = map->capacity - 1;
+    int i = (int) (__hashChunk3D(chunk->x, chunk->y, chunk->z) & mask);
+    while (map->chunks[i] != 0) i = (i + 1) & mask;
+
+    map->chunks[i] = chunk;
+}
+
+// Implementation
+
+/**
+ * Gets a chunk from a LevelChunkMap3D.
+ * @param map The LevelChunkMap3D.
+ * @param x The x coordinate of the chunk.
+ * @param y The y coordinate of the chunk.
+ * @param z The z coordinate of the chunk.
+ * @return The chunk, or 0 if the map has no such chunk.
+ */
+LevelChunk3D* LevelChunkMap3D_get(LevelChunkMap3D* map, int x, int y, int z) {
+    if (map == 0) return 0;
+    if (map->capacity == 0) return 0;
+
+    int mask = map->capacity - 1;
+    int i = (int) (__hashChunk3D(x, y, z) & mask);
+    while (map->chunks[i] != 0) {
+        LevelChunk3D* chunk = map->chunks[i];
+        if (chunk->x == x && chunk->y == y && chunk->z == z) return chunk;
+
+        i = (i + 1) & mask;
+    }
+
+    return 0;
+}
+
+/**
+ * Gets a chunk from a LevelChunkMap3D, creating it if it does not exist.
+ * @param map The LevelChunkMap3D.
+ * @param x The x coordinate of the chunk.
+ * @param y The y coordinate of the chunk.
+ * @param z The z coordinate of the chunk.
+ * @return The chunk.
+ */
+LevelChunk3D* LevelChunkMap3D_getOrCreate(LevelChunkMap3D* map, int x, int y, int z) {
+    LevelChunk3D* chunk = LevelChunkMap3D_get(map, x, y, z);
+    if (chunk != 0) return chunk;
+
+    if (2 * (map->count + 1) > map->capacity) {
+        LevelChunk3D** old = map->chunks;
+        int oldCapacity = map->capacity;
+
+        map->capacity = oldCapacity == 0 ? 16 : 2 * oldCapacity;
+        map->chunks = (LevelChunk3D**) calloc(map->capacity, sizeof(LevelChunk3D*));
+        for (int i = 0; i < oldCapacity; i++) {
+            if (old[i] != 0) __LevelChunkMap3D_put(map, old[i]);
+        }
+
+        free(old);
+    }
+
+    chunk = (LevelChunk3D*) malloc(sizeof(LevelChunk3D));
+    chunk->x = x;
+    chunk->y = y;
+    chunk->z = z;
+    chunk->objects = 0;
+    chunk->count = 0;
+    chunk->capacity = 0;
+    chunk->snapshot = 0;
+    chunk->version = 0;
+    memset(chunk->occupancy, 0, sizeof(chunk->occupancy));
+    chunk->filled = 0;
+
+    __LevelChunkMap3D_put(map, chunk);
+    map->count++;
+
+    return chunk;
+}
+
+/**
+ * Gets the chunk of a LevelChunkMap3D containing a coordinate, creating it if it does not exist.
+ * Coordinates too large to address a chunk, or NaN, have none.
+ * @param map The LevelChunkMap3D.
+ * @param coordinate The coordinate.
+ * @return The chunk, or 0 if the coordinate is outside the chunk range.
+ */
+LevelChunk3D* LevelChunkMap3D_chunkAt(LevelChunkMap3D* map, Coordinate3D* coordinate) {
+    if (!__inChunkRange(coordinate->x) || !__inChunkRange(coordinate->y) || !__inChunkRange(coordinate->z)) return 0;
+    return LevelChunkMap3D_getOrCreate(map, __chunkOf(coordinate->x), __chunkOf(coordinate->y), __chunkOf(coordinate->z));
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,738 @@
+#ifndef LEVELZ_COLLISION_H
+#define LEVELZ_COLLISION_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <tgmath.h>
+
+#include "block.h"
+#include "chunk.h"
+#include "coordinate.h"
+#include "level.h"
+
+// Internal
+
+typedef struct __SolidChunk2D {
+    int x, y;
+    int version;
+    int count;
+    uint64_t bits[_LEVEL_CHUNK_SIZE * _LEVEL_CHUNK_SIZE / 64];
+} __SolidChunk2D;
+
+// Implementation
+
+/**
+ * Answers collision queries against the solid blocks of a Level2D. Each block fills the
+ * whole-number cell containing its coordinate. Solid cells are kept as a bitmask per
+ * chunk, rebuilt when the chunk changes, so queries only visit the chunks they touch.
+ */
+typedef struct LevelCollider2D {
+    /**
+     * The level the collider queries.
+     */
+    Level2D* level;
+
+    /**
+     * Selects the solid blocks, or 0 if every block is solid.
+     */
+    BlockPredicate solid;
+
+    /**
+     * The data passed to the predicate.
+     */
+    void* data;
+
+    /**
+     * Open-addressed table of solid chunks, with 0 for empty entries.
+     */
+    __SolidChunk2D** chunks;
+
+    /**
+     * The number of solid chunks.
+     */
+    int count;
+
+    /**
+     * The capacity of the table. Always zero or a power of two.
+     */
+    int capacity;
+} LevelCollider2D;
+
+/**
+ * Represents the first contact of a box moving through a level.
+ */
+typedef struct LevelContact2D {
+    /**
+     * Whether the box hits a solid cell.
+     */
+    int hit;
+
+    /**
+     * The fraction of the motion before the contact, between 0 and 1. 1 if nothing was hit.
+     */
+    double time;
+
+    /**
+     * The cell that was hit.
+     */
+    Coordinate2D cell;
+
+    /**
+     * The normal of the face that was hit, pointing against the motion.
+     */
+    Coordinate2D normal;
+} LevelContact2D;
+
+// Internal
+
+void __LevelCollider2D_put(LevelCollider2D* collider, __SolidChunk2D* chunk) {
+    int mask = collider->capacity - 1;
+    int i = (int) (__hashChunk2D(chunk->x, chunk->y) & mask);
+    while (collider->chunks[i] != 0) i = (i + 1) & mask;
+
+    collider->chunks[i] = chunk;
+}
+
+__SolidChunk2D* __LevelCollider2D_find(LevelCollider2D* collider, int x, int y) {
+    if (collider->capacity == 0) return 0;
+
+    int mask = collider->capacity - 1;
+    int i = (int) (__hashChunk2D(x, y) & mask);
+    while (collider->chunks[i] != 0) {
+        __SolidChunk2D* chunk = collider->chunks[i];
+        if (chunk->x == x && chunk->y == y) return chunk;
+
+        i = (i + 1) & mask;
+    }
+
+    return 0;
+}
+
+// Gets the solid cells of a chunk, rebuilding them if the chunk changed. Returns 0 when
+// the chunk has no solid cells.
+__SolidChunk2D* __LevelCollider2D_chunk(LevelCollider2D* collider, int x, int y) {
+    LevelChunk2D* chunk = LevelChunkMap2D_get(&collider->level->chunks, x, y);
+    if (chunk == 0 || chunk->count == 0) return 0;
+
+    __SolidChunk2D* solid = __LevelCollider2D_find(collider, x, y);
+    if (solid == 0) {
+        if (2 * (collider->count + 1) > collider->capacity) {
+            __SolidChunk2D** old = collider->chunks;
+            int oldCapacity = collider->capacity;
+
+            collider->capacity = oldCapacity == 0 ? 16 : 2 * oldCapacity;
+            collider->chunks = (__SolidChunk2D**) calloc(collider->capacity, sizeof(__SolidChunk2D*));
+            for (int i = 0; i < oldCapacity; i++) {
+                if (old[i] != 0) __LevelCollider2D_put(collider, old[i]);
+            }
+
+            free(old);
+        }
+
+        solid = (__SolidChunk2D*) malloc(sizeof(__SolidChunk2D));
+        solid->x = x;
+        solid->y = y;
+        solid->version = chunk->version - 1;
+        __LevelCollider2D_put(collider, solid);
+        collider->count++;
+    }
+
+    if (solid->version != chunk->version) {
+        memset(solid->bits, 0, sizeof(solid->bits));
+        solid->count = 0;
+
+        for (int i = 0; i < chunk->count; i++) {
+            LevelObject2D* o = chunk->objects[i];
+            if (collider->solid != 0 && !collider->solid(o->block, collider->data)) continue;
+
+            int key = __cellKey2D(o->coordinate);
+            uint64_t bit = 1ULL << (key & 63);
+            if (solid->bits[key >> 6] & bit) continue;
+
+            solid->bits[key >> 6] |= bit;
+            solid->count++;
+        }
+
+        solid->version = chunk->version;
+    }
+
+    return solid->count == 0 ? 0 : solid;
+}
+
+// Calls a function for each solid cell between two cells, inclusive, skipping chunks
+// without solid cells.
+void __LevelCollider2D_each(LevelCollider2D* collider, int* lo, int* hi, void (*visit)(int, int, void*), void* data) {
+    for (int cx = __chunkOf(lo[0]); cx <= __chunkOf(hi[0]); cx++) {
+        for (int cy = __chunkOf(lo[1]); cy <= __chunkOf(hi[1]); cy++) {
+            __SolidChunk2D* solid = __LevelCollider2D_chunk(collider, cx, cy);
+            if (solid == 0) continue;
+
+            int x0 = cx * _LEVEL_CHUNK_SIZE;
+            int y0 = cy * _LEVEL_CHUNK_SIZE;
+            int x1 = hi[0] < x0 + _LEVEL_CHUNK_SIZE - 1 ? hi[0] : x0 + _LEVEL_CHUNK_SIZE - 1;
+            int y1 = hi[1] < y0 + _LEVEL_CHUNK_SIZE - 1 ? hi[1] : y0 + _LEVEL_CHUNK_SIZE - 1;
+            if (lo[0] > x0) x0 = lo[0];
+            if (lo[1] > y0) y0 = lo[1];
+
+            for (int x = x0; x <= x1; x++) {
+                for (int y = y0; y <= y1; y++) {
+                    int key = (x & (_LEVEL_CHUNK_SIZE - 1)) | (y & (_LEVEL_CHUNK_SIZE - 1)) << 4;
+                    if (solid->bits[key >> 6] & (1ULL << (key & 63))) visit(x, y, data);
+                }
+            }
+        }
+    }
+}
+
+// The cells overlapped by the open box between two corners.
+void __boxCells(double* min, double* max, int* lo, int* hi, int dimensions) {
+    for (int i = 0; i < dimensions; i++) {
+        lo[i] = __cellFloor(min[i]);
+        hi[i] = -__cellFloor(-max[i]) - 1;
+    }
+}
+
+typedef struct __Overlap2D {
+    Coordinate2D* cells;
+    int capacity;
+    int count;
+} __Overlap2D;
+
+void __visitOverlap2D(int x, int y, void* data) {
+    __Overlap2D* overlap = (__Overlap2D*) data;
+    if (overlap->count < overlap->capacity)
+        overlap->cells[overlap->count] = makeCoordinate2D(x, y);
+
+    overlap->count++;
+}
+
+// Finds when a moving box enters a cell along one axis, using the slab method.
+int __sweepAxis(double boxMin, double boxMax, double cellMin, double cellMax, double motion, double* entry, double* exit) {
+    if (motion == 0) {
+        if (boxMax <= cellMin || boxMin >= cellMax) return 0;
+
+        *entry = -INFINITY;
+        *exit = INFINITY;
+    } else if (motion > 0) {
+        *entry = (cellMin - boxMax) / motion;
+        *exit = (cellMax - boxMin) / motion;
+    } else {
+        *entry = (cellMax - boxMin) / motion;
+        *exit = (cellMin - boxMax) / motion;
+    }
+
+    return 1;
+}
+
+typedef struct __Sweep2D {
+    double min[2];
+    double max[2];
+    double motion[2];
+    LevelContact2D contact;
+} __Sweep2D;
+
+void __visitSweep2D(int x, int y, void* data) {
+    __Sweep2D* sweep = (__Sweep2D*) data;
+    int cell[2] = {x, y};
+
+    double entry = -INFINITY;
+    double exit = INFINITY;
+    int axis = -1;
+    for (int i = 0; i < 2; i++) {
+        double e0, e1;
+        if (!__sweepAxis(sweep->min[i], sweep->max[i], cell[i], cell[i] + 1, sweep->motion[i], &e0, &e1)) return;
+
+        if (e0 > entry) {
+            entry = e0;
+            axis = i;
+        }
+        if (e1 < exit) exit = e1;
+    }
+
+    // cells the box already overlaps are ignored, so boxes can move out of them
+    if (axis < 0 || entry < 0 || entry >= exit || entry > 1) return;
+    if (sweep->contact.hit && entry >= sweep->contact.time) return;
+
+    double normal[2] = {0, 0};
+    normal[axis] = sweep->motion[axis] > 0 ? -1 : 1;
+
+    sweep->contact.hit = 1;
+    sweep->contact.time = entry;
+    sweep->contact.cell = makeCoordinate2D(x, y);
+    sweep->contact.normal = makeCoordinate2D(normal[0], normal[1]);
+}
+
+// Implementation
+
+/**
+ * Creates a collider for a Level2D.
+ * @param level The Level2D.
+ * @param solid Selects the solid blocks, or 0 if every block is solid.
+ * @param data The data passed to the predicate.
+ * @return A new LevelCollider2D.
+ */
+LevelCollider2D* createLevelCollider2D(Level2D* level, BlockPredicate solid, void* data) {
+    if (level == 0) return 0;
+
+    LevelCollider2D* collider = (LevelCollider2D*) malloc(sizeof(LevelCollider2D));
+    collider->level = level;
+    collider->solid = solid;
+    collider->data = data;
+    collider->chunks = 0;
+    collider->count = 0;
+    collider->capacity = 0;
+
+    return collider;
+}
+
+/**
+ * Checks whether a cell of a LevelCollider2D is solid.
+ * @param collider The LevelCollider2D.
+ * @param cell The cell.
+ * @return 1 if the cell holds a solid block, 0 otherwise.
+ */
+int LevelCollider2D_isSolid(LevelCollider2D* collider, Coordinate2D cell) {
+    if (collider == 0) return 0;
+
+    __SolidChunk2D* solid = __LevelCollider2D_chunk(collider, __chunkOf(cell.x), __chunkOf(cell.y));
+    if (solid == 0) return 0;
+
+    int key = __cellKey2D(&cell);
+    return (solid->bits[key >> 6] >> (key & 63)) & 1;
+}
+
+/**
+ * Finds the solid cells overlapping a box. Boxes that only touch a cell do not overlap it.
+ * @param collider The LevelCollider2D.
+ * @param min The lower corner of the box.
+ * @param max The upper corner of the box.
+ * @param cells The array to write the cells to, or 0 to only count them.
+ * @param capacity The capacity of the array. At most this many cells are written.
+ * @return The number of overlapping cells, which may exceed the capacity.
+ */
+int LevelCollider2D_overlap(LevelCollider2D* collider, Coordinate2D min, Coordinate2D max, Coordinate2D* cells, int capacity) {
+    if (collider == 0) return 0;
+
+    double lower[2] = {min.x, min.y};
+    double upper[2] = {max.x, max.y};
+    int lo[2], hi[2];
+    __boxCells(lower, upper, lo, hi, 2);
+
+    __Overlap2D overlap = {cells, cells == 0 ? 0 : capacity, 0};
+    __LevelCollider2D_each(collider, lo, hi, __visitOverlap2D, &overlap);
+    return overlap.count;
+}
+
+/**
+ * Moves a box through a LevelCollider2D and finds the first solid cell it hits.
+ * Only the cells inside the swept box are visited. Cells the box overlaps at the
+ * start are ignored.
+ * @param collider The LevelCollider2D.
+ * @param min The lower corner of the box.
+ * @param max The upper corner of the box.
+ * @param motion The motion of the box.
+ * @return The first contact, with hit set to 0 and time set to 1 if the box moves freely.
+ */
+LevelContact2D LevelCollider2D_sweep(LevelCollider2D* collider, Coordinate2D min, Coordinate2D max, Coordinate2D motion) {
+    __Sweep2D sweep;
+    sweep.min[0] = min.x;
+    sweep.min[1] = min.y;
+    sweep.max[0] = max.x;
+    sweep.max[1] = max.y;
+    sweep.motion[0] = motion.x;
+    sweep.motion[1] = motion.y;
+    sweep.contact.hit = 0;
+    sweep.contact.time = 1;
+    sweep.contact.cell = makeCoordinate2D(0, 0);
+    sweep.contact.normal = makeCoordinate2D(0, 0);
+    if (collider == 0) return sweep.contact;
+
+    double lower[2], upper[2];
+    for (int i = 0; i < 2; i++) {
+        lower[i] = sweep.motion[i] < 0 ? sweep.min[i] + sweep.motion[i] : sweep.min[i];
+        upper[i] = sweep.motion[i] > 0 ? sweep.max[i] + sweep.motion[i] : sweep.max[i];
+    }
+
+    // touching cells are included, since the box can hit them straight away
+    int lo[2], hi[2];
+    __boxCells(lower, upper, lo, hi, 2);
+    for (int i = 0; i < 2; i++) {
+        if (sweep.motion[i] < 0 && lower[i] == floor(lower[i])) lo[i]--;
+        if (sweep.motion[i] > 0 && upper[i] == ceil(upper[i])) hi[i]++;
+    }
+
+    __LevelCollider2D_each(collider, lo, hi, __visitSweep2D, &sweep);
+    return sweep.contact;
+}
+
+/**
+ * Frees a LevelCollider2D. The level is not freed.
+ * @param collider The LevelCollider2D.
+ */
+void LevelCollider2D_free(LevelCollider2D* collider) {
+    if (collider == 0) return;
+
+    for (int i = 0; i < collider->capacity; i++)
+        free(collider->chunks[i]);
+
+    free(collider->chunks);
+    free(collider);
+}
+
+// Internal
+
+typedef struct __SolidChunk3D {
+    int x, y, z;
+    int version;
+    int count;
+    uint64_t bits[_LEVEL_CHUNK_SIZE * _LEVEL_CHUNK_SIZE * _LEVEL_CHUNK_SIZE / 64];
+} __SolidChunk3D;
+
+// Implementation
+
+/**
+ * Answers collision queries against the solid blocks of a Level3D. Each block fills the
+ * whole-number cell containing its coordinate. Solid cells are kept as a bitmask per
+ * chunk, rebuilt when the chunk changes, so queries only visit the chunks they touch.
+ */
+typedef struct LevelCollider3D {
+    /**
+     * The level the collider queries.
+     */
+    Level3D* level;
+
+    /**
+     * Selects the solid blocks, or 0 if every block is solid.
+     */
+    BlockPredicate solid;
+
+    /**
+     * The data passed to the predicate.
+     */
+    void* data;
+
+    /**
+     * Open-addressed table of solid chunks, with 0 for empty entries.
+     */
+    __SolidChunk3D** chunks;
+
+    /**
+     * The number of solid chunks.
+     */
+    int count;
+
+    /**
+     * The capacity of the table. Always zero or a power of two.
+     */
+    int capacity;
+} LevelCollider3D;
+
+/**
+ * Represents the first contact of a box moving through a level.
+ */
+typedef struct LevelContact3D {
+    /**
+     * Whether the box hits a solid cell.
+     */
+    int hit;
+
+    /**
+     * The fraction of the motion before the contact, between 0 and 1. 1 if nothing was hit.
+     */
+    double time;
+
+    /**
+     * The cell that was hit.
+     */
+    Coordinate3D cell;
+
+    /**
+     * The normal of the face that was hit, pointing against the motion.
+     */
+    Coordinate3D normal;
+} LevelContact3D;
+
+// Internal
+
+void __LevelCollider3D_put(LevelCollider3D* collider, __SolidChunk3D* chunk) {
+    int mask = collider->capacity - 1;
+    int i = (int) (__hashChunk3D(chunk->x, chunk->y, chunk->z) & mask);
+    while (collider->chunks[i] != 0) i = (i + 1) & mask;
+
+    collider->chunks[i] = chunk;
+}
+
+__SolidChunk3D* __LevelCollider3D_find(LevelCollider3D* collider, int x, int y, int z) {
+    if (collider->capacity == 0) return 0;
+
+    int mask = collider->capacity - 1;
+    int i = (int) (__hashChunk3D(x, y, z) & mask);
+    while (collider->chunks[i] != 0) {
+        __SolidChunk3D* chunk = collider->chunks[i];
+        if (chunk->x == x && chunk->y == y && chunk->z == z) return chunk;
+
+        i = (i + 1) & mask;
+    }
+
+    return 0;
+}
+
+// Gets the solid cells of a chunk, rebuilding them if the chunk changed. Returns 0 when
+// the chunk has no solid cells.
+__SolidChunk3D* __LevelCollider3D_chunk(LevelCollider3D* collider, int x, int y, int z) {
+    LevelChunk3D* chunk = LevelChunkMap3D_get(&collider->level->chunks, x, y, z);
+    if (chunk == 0 || chunk->count == 0) return 0;
+
+    __SolidChunk3D* solid = __LevelCollider3D_find(collider, x, y, z);
+    if (solid == 0) {
+        if (2 * (collider->count + 1) > collider->capacity) {
+            __SolidChunk3D** old = collider->chunks;
+            int oldCapacity = collider->capacity;
+
+            collider->capacity = oldCapacity == 0 ? 16 : 2 * oldCapacity;
+            collider->chunks = (__SolidChunk3D**) calloc(collider->capacity, sizeof(__SolidChunk3D*));
+            for (int i = 0; i < oldCapacity; i++) {
+                if (old[i] != 0) __LevelCollider3D_put(collider, old[i]);
+            }
+
+            free(old);
+        }
+
+        solid = (__SolidChunk3D*) malloc(sizeof(__SolidChunk3D));
+        solid->x = x;
+        solid->y = y;
+        solid->z = z;
+        solid->version = chunk->version - 1;
+        __LevelCollider3D_put(collider, solid);
+        collider->count++;
+    }
+
+    if (solid->version != chunk->version) {
+        memset(solid->bits, 0, sizeof(solid->bits));
+        solid->count = 0;
+
+        for (int i = 0; i < chunk->count; i++) {
+            LevelObject3D* o = chunk->objects[i];
+            if (collider->solid != 0 && !collider->solid(o->block, collider->data)) continue;
+
+            int key = __cellKey3D(o->coordinate);
+            uint64_t bit = 1ULL << (key & 63);
+            if (solid->bits[key >> 6] & bit) continue;
+
+            solid->bits[key >> 6] |= bit;
+            solid->count++;
+        }
+
+        solid->version = chunk->version;
+    }
+
+    return solid->count == 0 ? 0 : solid;
+}
+
+// Calls a function for each solid cell between two cells, inclusive, skipping chunks
+// without solid cells.
+void __LevelCollider3D_each(LevelCollider3D* collider, int* lo, int* hi, void (*visit)(int, int, int, void*), void* data) {
+    for (int cx = __chunkOf(lo[0]); cx <= __chunkOf(hi[0]); cx++) {
+        for (int cy = __chunkOf(lo[1]); cy <= __chunkOf(hi[1]); cy++) {
+            for (int cz = __chunkOf(lo[2]); cz <= __chunkOf(hi[2]); cz++) {
+                __SolidChunk3D* solid = __LevelCollider3D_chunk(collider, cx, cy, cz);
+                if (solid == 0) continue;
+
+                int x0 = cx * _LEVEL_CHUNK_SIZE;
+                int y0 = cy * _LEVEL_CHUNK_SIZE;
+                int z0 = cz * _LEVEL_CHUNK_SIZE;
+                int x1 = hi[0] < x0 + _LEVEL_CHUNK_SIZE - 1 ? hi[0] : x0 + _LEVEL_CHUNK_SIZE - 1;
+                int y1 = hi[1] < y0 + _LEVEL_CHUNK_SIZE - 1 ? hi[1] : y0 + _LEVEL_CHUNK_SIZE - 1;
+                int z1 = hi[2] < z0 + _LEVEL_CHUNK_SIZE - 1 ? hi[2] : z0 + _LEVEL_CHUNK_SIZE - 1;
+                if (lo[0] > x0) x0 = lo[0];
+                if (lo[1] > y0) y0 = lo[1];
+                if (lo[2] > z0) z0 = lo[2];
+
+                for (int x = x0; x <= x1; x++) {
+                    for (int y = y0; y <= y1; y++) {
+                        for (int z = z0; z <= z1; z++) {
+                            int key = (x & (_LEVEL_CHUNK_SIZE - 1)) | (y & (_LEVEL_CHUNK_SIZE - 1)) << 4 | (z & (_LEVEL_CHUNK_SIZE - 1)) << 8;
+                            if (solid->bits[key >> 6] & (1ULL << (key & 63))) visit(x, y, z, data);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+typedef struct __Overlap3D {
+    Coordinate3D* cells;
+    int capacity;
+    int count;
+} __Overlap3D;
+
+void __visitOverlap3D(int x, int y, int z, void* data) {
+    __Overlap3D* overlap = (__Overlap3D*) data;
+    if (overlap->count < overlap->capacity)
+        overlap->cells[overlap->count] = makeCoordinate3D(x, y, z);
+
+    overlap->count++;
+}
+
+typedef struct __Sweep3D {
+    double min[3];
+    double max[3];
+    double motion[3];
+    LevelContact3D contact;
+} __Sweep3D;
+
+void __visitSweep3D(int x, int y, int z, void* data) {
+    __Sweep3D* sweep = (__Sweep3D*) data;
+    int cell[3] = {x, y, z};
+
+    double entry = -INFINITY;
+    double exit = INFINITY;
+    int axis = -1;
+    for (int i = 0; i < 3; i++) {
+        double e0, e1;
+        if (!__sweepAxis(sweep->min[i], sweep->max[i], cell[i], cell[i] + 1, sweep->motion[i], &e0, &e1)) return;
+
+        if (e0 > entry) {
+            entry = e0;
+            axis = i;
+        }
+        if (e1 < exit) exit = e1;
+    }
+
+    // cells the box already overlaps are ignored, so boxes can move out of them
+    if (axis < 0 || entry < 0 || entry >= exit || entry > 1) return;
+    if (sweep->contact.hit && entry >= sweep->contact.time) return;
+
+    double normal[3] = {0, 0, 0};
+    normal[axis] = sweep->motion[axis] > 0 ? -1 : 1;
+
+    sweep->contact.hit = 1;
+    sweep->contact.time = entry;
+    sweep->contact.cell = makeCoordinate3D(x, y, z);
+    sweep->contact.normal = makeCoordinate3D(normal[0], normal[1], normal[2]);
+}
+
+// Implementation
+
+/**
+ * Creates a collider for a Level3D.
+ * @param level The Level3D.
+ * @param solid Selects the solid blocks, or 0 if every block is solid.
+ * @param data The data passed to the predicate.
+ * @return A new LevelCollider3D.
+ */
+LevelCollider3D* createLevelCollider3D(Level3D* level, BlockPredicate solid, void* data) {
+    if (level == 0) return 0;
+
+    LevelCollider3D* collider = (LevelCollider3D*) malloc(sizeof(LevelCollider3D));
+    collider->level = level;
+    collider->solid = solid;
+    collider->data = data;
+    collider->chunks = 0;
+    collider->count = 0;
+    collider->capacity = 0;
+
+    return collider;
+}
+
+/**
+ * Checks whether a cell of a LevelCollider3D is solid.
+ * @param collider The LevelCollider3D.
+ * @param cell The cell.
+ * @return 1 if the cell holds a solid block, 0 otherwise.
+ */
+int LevelCollider3D_isSolid(LevelCollider3D* collider, Coordinate3D cell) {
+    if (collider == 0) return 0;
+
+    __SolidChunk3D* solid = __LevelCollider3D_chunk(collider, __chunkOf(cell.x), __chunkOf(cell.y), __chunkOf(cell.z));
+    if (solid == 0) return 0;
+
+    int key = __cellKey3D(&cell);
+    return (solid->bits[key >> 6] >> (key & 63)) & 1;
+}
+
+/**
+ * Finds the solid cells overlapping a box. Boxes that only touch a cell do not overlap it.
+ * @param collider The LevelCollider3D.
+ * @param min The lower corner of the box.
+ * @param max The upper corner of the box.
+ * @param cells The array to write the cells to, or 0 to only count them.
+ * @param capacity The capacity of the array. At most this many cells are written.
+ * @return The number of overlapping cells, which may exceed the capacity.
+ */
+int LevelCollider3D_overlap(LevelCollider3D* collider, Coordinate3D min, Coordinate3D max, Coordinate3D* cells, int capacity) {
+    if (collider == 0) return 0;
+
+    double lower[3] = {min.x, min.y, min.z};
+    double upper[3] = {max.x, max.y, max.z};
+    int lo[3], hi[3];
+    __boxCells(lower, upper, lo, hi, 3);
+
+    __Overlap3D overlap = {cells, cells == 0 ? 0 : capacity, 0};
+    __LevelCollider3D_each(collider, lo, hi, __visitOverlap3D, &overlap);
+    return overlap.count;
+}
+
+/**
+ * Moves a box through a LevelCollider3D and finds the first solid cell it hits.
+ * Only the cells inside the swept box are visited. Cells the box overlaps at the
+ * start are ignored.
+ * @param collider The LevelCollider3D.
+ * @param min The lower corner of the box.
+ * @param max The upper corner of the box.
+ * @param motion The motion of the box.
+ * @return The first contact, with hit set to 0 and time set to 1 if the box moves freely.
+ */
+LevelContact3D LevelCollider3D_sweep(LevelCollider3D* collider, Coordinate3D min, Coordinate3D max, Coordinate3D motion) {
+    __Sweep3D sweep;
+    sweep.min[0] = min.x;
+    sweep.min[1] = min.y;
+    sweep.min[2] = min.z;
+    sweep.max[0] = max.x;
+    sweep.max[1] = max.y;
+    sweep.max[2] = max.z;
+    sweep.motion[0] = motion.x;
+    sweep.motion[1] = motion.y;
+    sweep.motion[2] = motion.z;
+    sweep.contact.hit = 0;
+    sweep.contact.time = 1;
+    sweep.contact.cell = makeCoordinate3D(0, 0, 0);
+    sweep.contact.normal = makeCoordinate3D(0, 0, 0);
+    if (collider == 0) return sweep.contact;
+
+    double lower[3], upper[3];
+    for (int i = 0; i < 3; i++) {
+        lower[i] = sweep.motion[i] < 0 ? sweep.min[i] + sweep.motion[i] : sweep.min[i];
+        upper[i] = sweep.motion[i] > 0 ? sweep.max[i] + sweep.motion[i] : sweep.max[i];
+    }
+
+    // touching cells are included, since the box can hit them straight away
+    int lo[3], hi[3];
+    __boxCells(lower, upper, lo, hi, 3);
+    for (int i = 0; i < 3; i++) {
+        if (sweep.motion[i] < 0 && lower[i] == floor(lower[i])) lo[i]--;
+        if (sweep.motion[i] > 0 && upper[i] == ceil(upper[i])) hi[i]++;
+    }
+
+    __LevelCollider3D_each(collider, lo, hi, __visitSweep3D, &sweep);
+    return sweep.contact;
+}
+
+/**
+ * Frees a LevelCollider3D. The level is not freed.
+ * @param collider The LevelCollider3D.
+ */
+void LevelCollider3D_free(LevelCollider3D* collider) {
+    if (collider == 0) return;
+
+    for (int i = 0; i < collider->capacity; i++)
+        free(collider->chunks[i]);
+
+    free(collider->chunks);
+    free(collider);
+}
+
+#endif
@@ -0,0 +1,797 @@
+#ifndef LEVELZ_COMPONENTS_H
+#define LEVELZ_COMPONENTS_H
+
+#define _COMPONENTS_CELLS_2D (_LEVEL_CHUNK_SIZE * _LEVEL_CHUNK_SIZE)
+#define _COMPONENTS_CELLS_3D (_LEVEL_CHUNK_SIZE * _LEVEL_CHUNK_SIZE * _LEVEL_CHUNK_SIZE)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <tgmath.h>
+
+#include "block.h"
+#include "chunk.h"
+#include "coordinate.h"
+#include "level.h"
+#include "thread.h"
+
+// Internal
+
+typedef struct __MaskChunk2D {
+    int x, y;
+    uint64_t selected[_COMPONENTS_CELLS_2D / 64];
+    uint64_t visited[_COMPONENTS_CELLS_2D / 64];
+    int* labels;
+    int base;
+    int count;
+} __MaskChunk2D;
+
+typedef struct __MaskTable2D {
+    __MaskChunk2D** chunks;
+    int count;
+    int capacity;
+} __MaskTable2D;
+
+void __MaskTable2D_put(__MaskTable2D* table, __MaskChunk2D* chunk) {
+    int mask = table->capacity - 1;
+    int i = (int) (__hashChunk2D(chunk->x, chunk->y) & mask);
+    while (table->chunks[i] != 0) i = (i + 1) & mask;
+
+    table->chunks[i] = chunk;
+}
+
+__MaskChunk2D* __MaskTable2D_find(__MaskTable2D* table, int x, int y) {
+    if (table->capacity == 0) return 0;
+
+    int mask = table->capacity - 1;
+    int i = (int) (__hashChunk2D(x, y) & mask);
+    while (table->chunks[i] != 0) {
+        __MaskChunk2D* chunk = table->chunks[i];
+        if (chunk->x == x && chunk->y == y) return chunk;
+
+        i = (i + 1) & mask;
+    }
+
+    return 0;
+}
+
+__MaskChunk2D* __MaskTable2D_add(__MaskTable2D* table, int x, int y) {
+    if (2 * (table->count + 1) > table->capacity) {
+        __MaskChunk2D** old = table->chunks;
+        int oldCapacity = table->capacity;
+
+        table->capacity = oldCapacity == 0 ? 16 : 2 * oldCapacity;
+        table->chunks = (__MaskChunk2D**) calloc(table->capacity, sizeof(__MaskChunk2D*));
+        for (int i = 0; i < oldCapacity; i++) {
+            if (old[i] != 0) __MaskTable2D_put(table, old[i]);
+        }
+
+        free(old);
+    }
+
+    __MaskChunk2D* chunk = (__MaskChunk2D*) calloc(1, sizeof(__MaskChunk2D));
+    chunk->x = x;
+    chunk->y = y;
+    __MaskTable2D_put(table, chunk);
+    table->count++;
+
+    return chunk;
+}
+
+void __MaskTable2D_free(__MaskTable2D* table) {
+    for (int i = 0; i < table->capacity; i++) {
+        if (table->chunks[i] == 0) continue;
+
+        free(table->chunks[i]->labels);
+        free(table->chunks[i]);
+    }
+
+    free(table->chunks);
+}
+
+// Marks the cells of a chunk holding a selected block.
+void __MaskChunk2D_select(__MaskChunk2D* mask, LevelChunk2D* chunk, BlockPredicate selected, void* data) {
+    for (int i = 0; i < chunk->count; i++) {
+        LevelObject2D* o = chunk->objects[i];
+        if (selected != 0 && !selected(o->block, data)) continue;
+
+        int key = __cellKey2D(o->coordinate);
+        mask->selected[key >> 6] |= 1ULL << (key & 63);
+    }
+}
+
+int __isSelected(uint64_t* bits, int key) {
+    return (bits[key >> 6] >> (key & 63)) & 1;
+}
+
+int __findLabel(int* parent, int i) {
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+
+    return i;
+}
+
+// Joins two sets, keeping the smaller root so roots are the first member visited.
+void __unionLabels(int* parent, int a, int b) {
+    a = __findLabel(parent, a);
+    b = __findLabel(parent, b);
+    if (a < b) parent[b] = a;
+    else if (b < a) parent[a] = b;
+}
+
+// Labels the selected cells of a chunk with local labels, starting at 1.
+void __MaskChunk2D_label(__MaskChunk2D* mask) {
+    int parent[_COMPONENTS_CELLS_2D];
+    for (int key = 0; key < _COMPONENTS_CELLS_2D; key++) {
+        if (!__isSelected(mask->selected, key)) continue;
+
+        parent[key] = key;
+        if ((key & 0xF) != 0 && __isSelected(mask->selected, key - 1)) __unionLabels(parent, key, key - 1);
+        if ((key >> 4) != 0 && __isSelected(mask->selected, key - 16)) __unionLabels(parent, key, key - 16);
+    }
+
+    mask->labels = (int*) calloc(_COMPONENTS_CELLS_2D, sizeof(int));
+    mask->count = 0;
+    for (int key = 0; key < _COMPONENTS_CELLS_2D; key++) {
+        if (!__isSelected(mask->selected, key)) continue;
+
+        int root = __findLabel(parent, key);
+        if (root == key) mask->labels[key] = ++mask->count;
+        else mask->labels[key] = mask->labels[root];
+    }
+}
+
+typedef struct __LabelWork2D {
+    __MaskChunk2D** masks;
+    LevelChunk2D** chunks;
+    int count;
+    int next;
+    BlockPredicate selected;
+    void* data;
+} __LabelWork2D;
+
+void* __LabelWork2D_run(void* arg) {
+    __LabelWork2D* work = (__LabelWork2D*) arg;
+
+    int i;
+    while ((i = __atomicIncrement(&work->next) - 1) < work->count) {
+        __MaskChunk2D_select(work->masks[i], work->chunks[i], work->selected, work->data);
+        __MaskChunk2D_label(work->masks[i]);
+    }
+
+    return 0;
+}
+
+// Implementation
+
+/**
+ * Represents the connected components of the selected blocks of a Level2D. Cells are
+ * connected when they share an edge.
+ */
+typedef struct LevelComponents2D {
+    /**
+     * The number of components. Components are labelled from 1 to the count.
+     */
+    int count;
+
+    /**
+     * The number of cells in each component, indexed by label - 1.
+     */
+    int* sizes;
+
+    /**
+     * The labelled chunks.
+     */
+    __MaskTable2D table;
+} LevelComponents2D;
+
+/**
+ * Finds the connected components of the selected blocks of a Level2D. Chunks are
+ * labelled in parallel, then labels that touch across chunk borders are joined.
+ * Blocks fill the whole-number cell containing their coordinate.
+ * @param level The Level2D.
+ * @param selected Selects the blocks to label, or 0 for every block. It is called from
+ * several threads at once.
+ * @param data The data passed to the predicate.
+ * @param threads The number of threads to use, or 0 for one per CPU.
+ * @return The components of the level.
+ */
+LevelComponents2D* Level2D_components(Level2D* level, BlockPredicate selected, void* data, int threads) {
+    if (level == 0) return 0;
+
+    LevelComponents2D* components = (LevelComponents2D*) malloc(sizeof(LevelComponents2D));
+    components->count = 0;
+    components->sizes = 0;
+    components->table.chunks = 0;
+    components->table.count = 0;
+    components->table.capacity = 0;
+
+    __LabelWork2D work;
+    work.masks = (__MaskChunk2D**) malloc((level->chunks.count + 1) * sizeof(__MaskChunk2D*));
+    work.chunks = (LevelChunk2D**) malloc((level->chunks.count + 1) * sizeof(LevelChunk2D*));
+    work.count = 0;
+    work.next = 0;
+    work.selected = selected;
+    work.data = data;
+
+    for (int i = 0; i < level->chunks.capacity; i++) {
+        LevelChunk2D* chunk = level->chunks.chunks[i];
+        if (chunk == 0 || chunk->filled == 0) continue;
+
+        work.masks[work.count] = __MaskTable2D_add(&components->table, chunk->x, chunk->y);
+        work.chunks[work.count] = chunk;
+        work.count++;
+    }
+
+    if (threads <= 0) threads = __cpuCount();
+    if (threads > work.count) threads = work.count;
+
+    __Thread* workers = (__Thread*) malloc((threads + 1) * sizeof(__Thread));
+    int started = 0;
+    for (int i = 1; i < threads; i++)
+        if (__Thread_create(&workers[started], __LabelWork2D_run, &work)) started++;
+
+    __LabelWork2D_run(&work);
+    for (int i = 0; i < started; i++)
+        __Thread_join(workers[i]);
+    free(workers);
+
+    int total = 0;
+    for (int i = 0; i < work.count; i++) {
+        work.masks[i]->base = total;
+        total += work.masks[i]->count;
+    }
+
+    int* parent = (int*) malloc((total + 1) * sizeof(int));
+    for (int i = 0; i <= total; i++) parent[i] = i;
+
+    for (int i = 0; i < work.count; i++) {
+        __MaskChunk2D* a = work.masks[i];
+        __MaskChunk2D* right = __MaskTable2D_find(&components->table, a->x + 1, a->y);
+        __MaskChunk2D* up = __MaskTable2D_find(&components->table, a->x, a->y + 1);
+
+        for (int j = 0; j < _LEVEL_CHUNK_SIZE; j++) {
+            if (right != 0) {
+                int la = a->labels[(_LEVEL_CHUNK_SIZE - 1) | j << 4];
+                int lb = right->labels[j << 4];
+                if (la != 0 && lb != 0) __unionLabels(parent, a->base + la, right->base + lb);
+            }
+
+            if (up != 0) {
+                int la = a->labels[j | (_LEVEL_CHUNK_SIZE - 1) << 4];
+                int lb = up->labels[j];
+                if (la != 0 && lb != 0) __unionLabels(parent, a->base + la, up->base + lb);
+            }
+        }
+    }
+
+    // renumber the roots from 1, then relabel every cell with its component
+    int* compact = (int*) calloc(total + 1, sizeof(int));
+    for (int i = 1; i <= total; i++) {
+        int root = __findLabel(parent, i);
+        if (compact[root] == 0) compact[root] = ++components->count;
+        compact[i] = compact[root];
+    }
+
+    components->sizes = (int*) calloc(components->count + 1, sizeof(int));
+    for (int i = 0; i < work.count; i++) {
+        __MaskChunk2D* m = work.masks[i];
+        for (int key = 0; key < _COMPONENTS_CELLS_2D; key++) {
+            if (m->labels[key] == 0) continue;
+
+            m->labels[key] = compact[m->base + m->labels[key]];
+            components->sizes[m->labels[key] - 1]++;
+        }
+    }
+
+    free(compact);
+    free(parent);
+    free(work.masks);
+    free(work.chunks);
+    return components;
+}
+
+/**
+ * Gets the component of a cell.
+ * @param components The LevelComponents2D.
+ * @param coordinate A coordinate in the cell.
+ * @return The label of the component, or 0 if the cell has no selected block.
+ */
+int LevelComponents2D_labelOf(LevelComponents2D* components, Coordinate2D* coordinate) {
+    if (components == 0) return 0;
+    if (coordinate == 0) return 0;
+
+    __MaskChunk2D* mask = __MaskTable2D_find(&components->table, __chunkOf(coordinate->x), __chunkOf(coordinate->y));
+    if (mask == 0) return 0;
+
+    return mask->labels[__cellKey2D(coordinate)];
+}
+
+/**
+ * Gets the number of cells in a component.
+ * @param components The LevelComponents2D.
+ * @param label The label of the component.
+ * @return The number of cells, or 0 if there is no such component.
+ */
+int LevelComponents2D_sizeOf(LevelComponents2D* components, int label) {
+    if (components == 0) return 0;
+    if (label < 1 || label > components->count) return 0;
+
+    return components->sizes[label - 1];
+}
+
+/**
+ * Frees a LevelComponents2D.
+ * @param components The LevelComponents2D.
+ */
+void LevelComponents2D_free(LevelComponents2D* components) {
+    if (components == 0) return;
+
+    __MaskTable2D_free(&components->table);
+    free(components->sizes);
+    free(components);
+}
+
+/**
+ * Finds the cells reachable from a cell through selected blocks of a Level2D. Cells are
+ * connected when they share an edge. Only the chunks the fill reaches are visited.
+ * @param level The Level2D.
+ * @param start A coordinate in the starting cell.
+ * @param selected Selects the blocks to fill through, or 0 for every block.
+ * @param data The data passed to the predicate.
+ * @param cells The array to write the reached cells to, or 0 to only count them.
+ * @param capacity The capacity of the array. At most this many cells are written.
+ * @return The number of reached cells, or 0 if the starting cell has no selected block.
+ */
+int Level2D_floodFill(Level2D* level, Coordinate2D* start, BlockPredicate selected, void* data, Coordinate2D* cells, int capacity) {
+    if (level == 0) return 0;
+    if (start == 0) return 0;
+    if (!__inChunkRange(start->x) || !__inChunkRange(start->y)) return 0;
+
+    __MaskTable2D table = {0, 0, 0};
+    int queueCapacity = 64;
+    int* queue = (int*) malloc(queueCapacity * 2 * sizeof(int));
+    int head = 0;
+    int tail = 0;
+
+    queue[0] = __cellFloor(start->x);
+    queue[1] = __cellFloor(start->y);
+    tail = 1;
+
+    int count = 0;
+    while (head < tail) {
+        int x = queue[head * 2];
+        int y = queue[head * 2 + 1];
+        head++;
+
+        int cx = __chunkOf(x);
+        int cy = __chunkOf(y);
+        __MaskChunk2D* mask = __MaskTable2D_find(&table, cx, cy);
+        if (mask == 0) {
+            mask = __MaskTable2D_add(&table, cx, cy);
+            LevelChunk2D* chunk = LevelChunkMap2D_get(&level->chunks, cx, cy);
+            if (chunk != 0 && chunk->filled != 0) __MaskChunk2D_select(mask, chunk, selected, data);
+        }
+
+        int key = (x & (_LEVEL_CHUNK_SIZE - 1)) | (y & (_LEVEL_CHUNK_SIZE - 1)) << 4;
+        if (!__isSelected(mask->selected, key) || __isSelected(mask->visited, key)) continue;
+        mask->visited[key >> 6] |= 1ULL << (key & 63);
+
+        if (cells != 0 && count < capacity) cells[count] = makeCoordinate2D(x, y);
+        count++;
+
+        if (tail + 4 > queueCapacity) {
+            // compact the queue before growing it
+            memmove(queue, queue + head * 2, (tail - head) * 2 * sizeof(int));
+            tail -= head;
+            head = 0;
+            if (tail + 4 > queueCapacity) {
+                queueCapacity *= 2;
+                queue = (int*) realloc(queue, queueCapacity * 2 * sizeof(int));
+            }
+        }
+
+        int neighbours[4][2] = {{x - 1, y}, {x + 1, y}, {x, y - 1}, {x, y + 1}};
+        for (int i = 0; i < 4; i++) {
+            queue[tail * 2] = neighbours[i][0];
+            queue[tail * 2 + 1] = neighbours[i][1];
+            tail++;
+        }
+    }
+
+    free(queue);
+    __MaskTable2D_free(&table);
+    return count;
+}
+
+// Internal
+
+typedef struct __MaskChunk3D {
+    int x, y, z;
+    uint64_t selected[_COMPONENTS_CELLS_3D / 64];
+    uint64_t visited[_COMPONENTS_CELLS_3D / 64];
+    int* labels;
+    int base;
+    int count;
+} __MaskChunk3D;
+
+typedef struct __MaskTable3D {
+    __MaskChunk3D** chunks;
+    int count;
+    int capacity;
+} __MaskTable3D;
+
+void __MaskTable3D_put(__MaskTable3D* table, __MaskChunk3D* chunk) {
+    int mask = table->capacity - 1;
+    int i = (int) (__hashChunk3D(chunk->x, chunk->y, chunk->z) & mask);
+    while (table->chunks[i] != 0) i = (i + 1) & mask;
+
+    table->chunks[i] = chunk;
+}
+
+__MaskChunk3D* __MaskTable3D_find(__MaskTable3D* table, int x, int y, int z) {
+    if (table->capacity == 0) return 0;
+
+    int mask = table->capacity - 1;
+    int i = (int) (__hashChunk3D(x, y, z) & mask);
+    while (table->chunks[i] != 0) {
+        __MaskChunk3D* chunk = table->chunks[i];
+        if (chunk->x == x && chunk->y == y && chunk->z == z) return chunk;
+
+        i = (i + 1) & mask;
+    }
+
+    return 0;
+}
+
+__MaskChunk3D* __MaskTable3D_add(__MaskTable3D* table, int x, int y, int z) {
+    if (2 * (table->count + 1) > table->capacity) {
+        __MaskChunk3D** old = table->chunks;
+        int oldCapacity = table->capacity;
+
+        table->capacity = oldCapacity == 0 ? 16 : 2 * oldCapacity;
+        table->chunks = (__MaskChunk3D**) calloc(table->capacity, sizeof(__MaskChunk3D*));
+        for (int i = 0; i < oldCapacity; i++) {
+            if (old[i] != 0) __MaskTable3D_put(table, old[i]);
+        }
+
+        free(old);
+    }
+
+    __MaskChunk3D* chunk = (__MaskChunk3D*) calloc(1, sizeof(__MaskChunk3D));
+    chunk->x = x;
+    chunk->y = y;
+    chunk->z = z;
+    __MaskTable3D_put(table, chunk);
+    table->count++;
+
+    return chunk;
+}
+
+void __MaskTable3D_free(__MaskTable3D* table) {
+    for (int i = 0; i < table->capacity; i++) {
+        if (table->chunks[i] == 0) continue;
+
+        free(table->chunks[i]->labels);
+        free(table->chunks[i]);
+    }
+
+    free(table->chunks);
+}
+
+// Marks the cells of a chunk holding a selected block.
+void __MaskChunk3D_select(__MaskChunk3D* mask, LevelChunk3D* chunk, BlockPredicate selected, void* data) {
+    for (int i = 0; i < chunk->count; i++) {
+        LevelObject3D* o = chunk->objects[i];
+        if (selected != 0 && !selected(o->block, data)) continue;
+
+        int key = __cellKey3D(o->coordinate);
+        mask->selected[key >> 6] |= 1ULL << (key & 63);
+    }
+}
+
+// Labels the selected cells of a chunk with local labels, starting at 1.
+void __MaskChunk3D_label(__MaskChunk3D* mask) {
+    int* parent = (int*) malloc(_COMPONENTS_CELLS_3D * sizeof(int));
+    for (int key = 0; key < _COMPONENTS_CELLS_3D; key++) {
+        if (!__isSelected(mask->selected, key)) continue;
+
+        parent[key] = key;
+        if ((key & 0xF) != 0 && __isSelected(mask->selected, key - 1)) __unionLabels(parent, key, key - 1);
+        if (((key >> 4) & 0xF) != 0 && __isSelected(mask->selected, key - 16)) __unionLabels(parent, key, key - 16);
+        if ((key >> 8) != 0 && __isSelected(mask->selected, key - 256)) __unionLabels(parent, key, key - 256);
+    }
+
+    mask->labels = (int*) calloc(_COMPONENTS_CELLS_3D, sizeof(int));
+    mask->count = 0;
+    for (int key = 0; key < _COMPONENTS_CELLS_3D; key++) {
+        if (!__isSelected(mask->selected, key)) continue;
+
+        int root = __findLabel(parent, key);
+        if (root == key) mask->labels[key] = ++mask->count;
+        else mask->labels[key] = mask->labels[root];
+    }
+
+    free(parent);
+}
+
+typedef struct __LabelWork3D {
+    __MaskChunk3D** masks;
+    LevelChunk3D** chunks;
+    int count;
+    int next;
+    BlockPredicate selected;
+    void* data;
+} __LabelWork3D;
+
+void* __LabelWork3D_run(void* arg) {
+    __LabelWork3D* work = (__LabelWork3D*) arg;
+
+    int i;
+    while ((i = __atomicIncrement(&work->next) - 1) < work->count) {
+        __MaskChunk3D_select(work->masks[i], work->chunks[i], work->selected, work->data);
+        __MaskChunk3D_label(work->masks[i]);
+    }
+
+    return 0;
+}
+
+// Implementation
+
+/**
+ * Represents the connected components of the selected blocks of a Level3D. Cells are
+ * connected when they share a face.
+ */
+typedef struct LevelComponents3D {
+    /**
+     * The number of components. Components are labelled from 1 to the count.
+     */
+    int count;
+
+    /**
+     * The number of cells in each component, indexed by label - 1.
+     */
+    int* sizes;
+
+    /**
+     * The labelled chunks.
+     */
+    __MaskTable3D table;
+} LevelComponents3D;
+
+/**
+ * Finds the connected components of the selected blocks of a Level3D. Chunks are
+ * labelled in parallel, then labels that touch across chunk borders are joined.
+ * Blocks fill the whole-number cell containing their coordinate.
+ * @param level The Level3D.
+ * @param selected Selects the blocks to label, or 0 for every block. It is called from
+ * several threads at once.
+ * @param data The data passed to the predicate.
+ * @param threads The number of threads to use, or 0 for one per CPU.
+ * @return The components of the level.
+ */
+LevelComponents3D* Level3D_components(Level3D* level, BlockPredicate selected, void* data, int threads) {
+    if (level == 0) return 0;
+
+    LevelComponents3D* components = (LevelComponents3D*) malloc(sizeof(LevelComponents3D));
+    components->count = 0;
+    components->sizes = 0;
+    components->table.chunks = 0;
+    components->table.count = 0;
+    components->table.capacity = 0;
+
+    __LabelWork3D work;
+    work.masks = (__MaskChunk3D**) malloc((level->chunks.count + 1) * sizeof(__MaskChunk3D*));
+    work.chunks = (LevelChunk3D**) malloc((level->chunks.count + 1) * sizeof(LevelChunk3D*));
+    work.count = 0;
+    work.next = 0;
+    work.selected = selected;
+    work.data = data;
+
+    for (int i = 0; i < level->chunks.capacity; i++) {
+        LevelChunk3D* chunk = level->chunks.chunks[i];
+        if (chunk == 0 || chunk->filled == 0) continue;
+
+        work.masks[work.count] = __MaskTable3D_add(&components->table, chunk->x, chunk->y, chunk->z);
+        work.chunks[work.count] = chunk;
+        work.count++;
+    }
+
+    if (threads <= 0) threads = __cpuCount();
+    if (threads > work.count) threads = work.count;
+
+    __Thread* workers = (__Thread*) malloc((threads + 1) * sizeof(__Thread));
+    int started = 0;
+    for (int i = 1; i < threads; i++)
+        if (__Thread_create(&workers[started], __LabelWork3D_run, &work)) started++;
+
+    __LabelWork3D_run(&work);
+    for (int i = 0; i < started; i++)
+        __Thread_join(workers[i]);
+    free(workers);
+
+    int total = 0;
+    for (int i = 0; i < work.count; i++) {
+        work.masks[i]->base = total;
+        total += work.masks[i]->count;
+    }
+
+    int* parent = (int*) malloc((total + 1) * sizeof(int));
+    for (int i = 0; i <= total; i++) parent[i] = i;
+
+    for (int i = 0; i < work.count; i++) {
+        __MaskChunk3D* a = work.masks[i];
+        __MaskChunk3D* right = __MaskTable3D_find(&components->table, a->x + 1, a->y, a->z);
+        __MaskChunk3D* up = __MaskTable3D_find(&components->table, a->x, a->y + 1, a->z);
+        __MaskChunk3D* front = __MaskTable3D_find(&components->table, a->x, a->y, a->z + 1);
+
+        for (int j = 0; j < _LEVEL_CHUNK_SIZE; j++) {
+            for (int k = 0; k < _LEVEL_CHUNK_SIZE; k++) {
+                if (right != 0) {
+                    int la = a->labels[(_LEVEL_CHUNK_SIZE - 1) | j << 4 | k << 8];
+                    int lb = right->labels[j << 4 | k << 8];
+                    if (la != 0 && lb != 0) __unionLabels(parent, a->base + la, right->base + lb);
+                }
+
+                if (up != 0) {
+                    int la = a->labels[j | (_LEVEL_CHUNK_SIZE - 1) << 4 | k << 8];
+                    int lb = up->labels[j | k << 8];
+                    if (la != 0 && lb != 0) __unionLabels(parent, a->base + la, up->base + lb);
+                }
+
+                if (front != 0) {
+                    int la = a->labels[j | k << 4 | (_LEVEL_CHUNK_SIZE - 1) << 8];
+                    int lb = front->labels[j | k << 4];
+                    if (la != 0 && lb != 0) __unionLabels(parent, a->base + la, front->base + lb);
+                }
+            }
+        }
+    }
+
+    // renumber the roots from 1, then relabel every cell with its component
+    int* compact = (int*) calloc(total + 1, sizeof(int));
+    for (int i = 1; i <= total; i++) {
+        int root = __findLabel(parent, i);
+        if (compact[root] == 0) compact[root] = ++components->count;
+        compact[i] = compact[root];
+    }
+
+    components->sizes = (int*) calloc(components->count + 1, sizeof(int));
+    for (int i = 0; i < work.count; i++) {
+        __MaskChunk3D* m = work.masks[i];
+        for (int key = 0; key < _COMPONENTS_CELLS_3D; key++) {
+            if (m->labels[key] == 0) continue;
+
+            m->labels[key] = compact[m->base + m->labels[key]];
+            components->sizes[m->labels[key] - 1]++;
+        }
+    }
+
+    free(compact);
+    free(parent);
+    free(work.masks);
+    free(work.chunks);
+    return components;
+}
+
+/**
+ * Gets the component of a cell.
+ * @param components The LevelComponents3D.
+ * @param coordinate A coordinate in the cell.
+ * @return The label of the component, or 0 if the cell has no selected block.
+ */
+int LevelComponents3D_labelOf(LevelComponents3D* components, Coordinate3D* coordinate) {
+    if (components == 0) return 0;
+    if (coordinate == 0) return 0;
+
+    __MaskChunk3D* mask = __MaskTable3D_find(&components->table, __chunkOf(coordinate->x), __chunkOf(coordinate->y), __chunkOf(coordinate->z));
+    if (mask == 0) return 0;
+
+    return mask->labels[__cellKey3D(coordinate)];
+}
+
+/**
+ * Gets the number of cells in a component.
+ * @param components The LevelComponents3D.
+ * @param label The label of the component.
+ * @return The number of cells, or 0 if there is no such component.
+ */
+int LevelComponents3D_sizeOf(LevelComponents3D* components, int label) {
+    if (components == 0) return 0;
+    if (label < 1 || label > components->count) return 0;
+
+    return components->sizes[label - 1];
+}
+
+/**
+ * Frees a LevelComponents3D.
+ * @param components The LevelComponents3D.
+ */
+void LevelComponents3D_free(LevelComponents3D* components) {
+    if (components == 0) return;
+
+    __MaskTable3D_free(&components->table);
+    free(components->sizes);
+    free(components);
+}
+
+/**
+ * Finds the cells reachable from a cell through selected blocks of a Level3D. Cells are
+ * connected when they share a face. Only the chunks the fill reaches are visited.
+ * @param level The Level3D.
+ * @param start A coordinate in the starting cell.
+ * @param selected Selects the blocks to fill through, or 0 for every block.
+ * @param data The data passed to the predicate.
+ * @param cells The array to write the reached cells to, or 0 to only count them.
+ * @param capacity The capacity of the array. At most this many cells are written.
+ * @return The number of reached cells, or 0 if the starting cell has no selected block.
+ */
+int Level3D_floodFill(Level3D* level, Coordinate3D* start, BlockPredicate selected, void* data, Coordinate3D* cells, int capacity) {
+    if (level == 0) return 0;
+    if (start == 0) return 0;
+    if (!__inChunkRange(start->x) || !__inChunkRange(start->y) || !__inChunkRange(start->z)) return 0;
+
+    __MaskTable3D table = {0, 0, 0};
+    int queueCapacity = 64;
+    int* queue = (int*) malloc(queueCapacity * 3 * sizeof(int));
+    int head = 0;
+    int tail = 0;
+
+    queue[0] = __cellFloor(start->x);
+    queue[1] = __cellFloor(start->y);
+    queue[2] = __cellFloor(start->z);
+    tail = 1;
+
+    int count = 0;
+    while (head < tail) {
+        int x = queue[head * 3];
+        int y = queue[head * 3 + 1];
+        int z = queue[head * 3 + 2];
+        head++;
+
+        int cx = __chunkOf(x);
+        int cy = __chunkOf(y);
+        int cz = __chunkOf(z);
+        __MaskChunk3D* mask = __MaskTable3D_find(&table, cx, cy, cz);
+        if (mask == 0) {
+            mask = __MaskTable3D_add(&table, cx, cy, cz);
+            LevelChunk3D* chunk = LevelChunkMap3D_get(&level->chunks, cx, cy, cz);
+            if (chunk != 0 && chunk->filled != 0) __MaskChunk3D_select(mask, chunk, selected, data);
+        }
+
+        int key = (x & (_LEVEL_CHUNK_SIZE - 1)) | (y & (_LEVEL_CHUNK_SIZE - 1)) << 4 | (z & (_LEVEL_CHUNK_SIZE - 1)) << 8;
+        if (!__isSelected(mask->selected, key) || __isSelected(mask->visited, key)) continue;
+        mask->visited[key >> 6] |= 1ULL << (key & 63);
+
+        if (cells != 0 && count < capacity) cells[count] = makeCoordinate3D(x, y, z);
+        count++;
+
+        if (tail + 6 > queueCapacity) {
+            // compact the queue before growing it
+            memmove(queue, queue + head * 3, (tail - head) * 3 * sizeof(int));
+            tail -= head;
+            head = 0;
+            if (tail + 6 > queueCapacity) {
+                queueCapacity *= 2;
+                queue = (int*) realloc(queue, queueCapacity * 3 * sizeof(int));
+            }
+        }
+
+        int neighbours[6][3] = {{x - 1, y, z}, {x + 1, y, z}, {x, y - 1, z}, {x, y + 1, z}, {x, y, z - 1}, {x, y, z + 1}};
+        for (int i = 0; i < 6; i++) {
+            queue[tail * 3] = neighbours[i][0];
+            queue[tail * 3 + 1] = neighbours[i][1];
+            queue[tail * 3 + 2] = neighbours[i][2];
+            tail++;
+        }
+    }
+
+    free(queue);
+    __MaskTable3D_free(&table);
+    return count;
+}
+
+#endif
@@ -0,0 +1,310 @@
+#ifndef LEVELZ_CONCURRENT_H
+#define LEVELZ_CONCURRENT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "block.h"
+#include "coordinate.h"
+#include "chunk.h"
+#include "level.h"
+#include "thread.h"
+
+/**
+ * The number of stripes per CPU used when no stripe count is given.
+ */
+#define _CONCURRENT_STRIPES_PER_CPU 8
+
+/**
+ * The size of a cache line, which each lock stripe is aligned to.
+ */
+#define _CONCURRENT_CACHE_LINE 64
+
+// Aligns the stripes to cache lines, so the locks of two stripes never share one.
+#ifdef _MSC_VER
+#define __CACHE_ALIGNED_STRUCT __declspec(align(_CONCURRENT_CACHE_LINE))
+#define __CACHE_ALIGNED_MEMBER
+#else
+#define __CACHE_ALIGNED_STRUCT
+#define __CACHE_ALIGNED_MEMBER _Alignas(_CONCURRENT_CACHE_LINE)
+#endif
+
+/**
+ * Represents one lock stripe of a ConcurrentLevel3D, owning the blocks of every
+ * chunk that hashes to it.
+ */
+typedef struct __CACHE_ALIGNED_STRUCT ConcurrentStripe3D {
+    /**
+     * The lock guarding the stripe. Aligned to a cache line, which also pads the
+     * stripe to a whole number of cache lines.
+     */
+    __CACHE_ALIGNED_MEMBER __Mutex lock;
+
+    /**
+     * Open-addressed table of the blocks in the stripe, keyed by coordinate.
+     */
+    LevelObject3D** objects;
+
+    /**
+     * The number of blocks in the stripe.
+     */
+    int count;
+
+    /**
+     * The capacity of the table. Always a power of two.
+     */
+    int capacity;
+} ConcurrentStripe3D;
+
+/**
+ * Represents a Level3D that many threads can edit at once.
+ *
+ * Blocks are partitioned into lock stripes by chunk, so threads working on
+ * different regions rarely contend, and every block of one chunk lives in the
+ * same stripe. Each operation holds only its stripe's lock: a write is visible to
+ * any later operation on the same stripe from any thread, and no ordering is
+ * implied between different stripes. Once the writers are joined, the blocks can
+ * be moved into a regular Level3D with ConcurrentLevel3D_toLevel.
+ */
+typedef struct ConcurrentLevel3D {
+    /**
+     * The lock stripes.
+     */
+    ConcurrentStripe3D* stripes;
+
+    /**
+     * The number of lock stripes. Always a power of two.
+     */
+    int stripeCount;
+} ConcurrentLevel3D;
+
+// Internal
+
+// Allocates memory aligned to a cache line. The size must be a multiple of the alignment.
+void* __allocCacheAligned(size_t size) {
+#ifdef _WIN32
+    return _aligned_malloc(size, _CONCURRENT_CACHE_LINE);
+#else
+    return aligned_alloc(_CONCURRENT_CACHE_LINE, size);
+#endif
+}
+
+void __freeCacheAligned(void* memory) {
+#ifdef _WIN32
+    _aligned_free(memory);
+#else
+    free(memory);
+#endif
+}
+
+ConcurrentStripe3D* __ConcurrentLevel3D_stripe(ConcurrentLevel3D* level, Coordinate3D* c) {
+    uint64_t hash = __hashChunk3D(__chunkOf(c->x), __chunkOf(c->y), __chunkOf(c->z));
+    return &level->stripes[(hash >> 32) & (level->stripeCount - 1)];
+}
+
+int __ConcurrentStripe3D_find(ConcurrentStripe3D* stripe, Coordinate3D* c) {
+    int mask = stripe->capacity - 1;
+    int i = (int) (Coordinate3D_hash(c->x, c->y, c->z) & mask);
+    while (stripe->objects[i] != 0) {
+        Coordinate3D* o = stripe->objects[i]->coordinate;
+        if (o->x == c->x && o->y == c->y && o->z == c->z) return i;
+
+        i = (i + 1) & mask;
+    }
+
+    return i;
+}
+
+void __ConcurrentStripe3D_grow(ConcurrentStripe3D* stripe) {
+    LevelObject3D** old = stripe->objects;
+    int oldCapacity = stripe->capacity;
+
+    stripe->capacity *= 2;
+    stripe->objects = (LevelObject3D**) calloc(stripe->capacity, sizeof(LevelObject3D*));
+    for (int i = 0; i < oldCapacity; i++) {
+        if (old[i] != 0)
+            stripe->objects[__ConcurrentStripe3D_find(stripe, old[i]->coordinate)] = old[i];
+    }
+
+    free(old);
+}
+
+// Implementation
+
+/**
+ * Creates a new, empty ConcurrentLevel3D.
+ * @param stripes The number of lock stripes, rounded up to a power of two, or 0 to
+ * pick a number based on the CPU count.
+ * @return A new ConcurrentLevel3D.
+ */
+ConcurrentLevel3D* createConcurrentLevel3D(int stripes) {
+    if (stripes <= 0) stripes = _CONCURRENT_STRIPES_PER_CPU * __cpuCount();
+
+    int count = 1;
+    while (count < stripes) count *= 2;
+
+    ConcurrentLevel3D* level = (ConcurrentLevel3D*) malloc(sizeof(ConcurrentLevel3D));
+    level->stripeCount = count;
+    level->stripes = (ConcurrentStripe3D*) __allocCacheAligned(count * sizeof(ConcurrentStripe3D));
+    for (int i = 0; i < count; i++) {
+        __Mutex_init(&level->stripes[i].lock);
+        level->stripes[i].count = 0;
+        level->stripes[i].capacity = 16;
+        level->stripes[i].objects = (LevelObject3D**) calloc(16, sizeof(LevelObject3D*));
+    }
+
+    return level;
+}
+
+/**
+ * Frees a ConcurrentLevel3D. The blocks it still holds are not freed.
+ * @param level The ConcurrentLevel3D.
+ */
+void ConcurrentLevel3D_free(ConcurrentLevel3D* level) {
+    if (level == 0) return;
+
+    for (int i = 0; i < level->stripeCount; i++) {
+        __Mutex_destroy(&level->stripes[i].lock);
+        free(level->stripes[i].objects);
+    }
+
+    __freeCacheAligned(level->stripes);
+    free(level);
+}
+
+/**
+ * Adds a block to a ConcurrentLevel3D. A block already at the same coordinate is
+ * replaced and handed back to the caller. Safe to call from any thread.
+ * @param level The ConcurrentLevel3D.
+ * @param block The block to add.
+ * @return The replaced block, owned by the caller, or 0 if the coordinate was empty.
+ */
+LevelObject3D* ConcurrentLevel3D_addBlock(ConcurrentLevel3D* level, LevelObject3D* block) {
+    if (level == 0) return 0;
+    if (block == 0) return 0;
+
+    ConcurrentStripe3D* stripe = __ConcurrentLevel3D_stripe(level, block->coordinate);
+    __Mutex_lock(&stripe->lock);
+
+    if (2 * (stripe->count + 1) > stripe->capacity)
+        __ConcurrentStripe3D_grow(stripe);
+
+    int i = __ConcurrentStripe3D_find(stripe, block->coordinate);
+    LevelObject3D* replaced = stripe->objects[i];
+    if (replaced == 0) stripe->count++;
+    stripe->objects[i] = block;
+
+    __Mutex_unlock(&stripe->lock);
+    return replaced;
+}
+
+/**
+ * Gets a block from a ConcurrentLevel3D. Safe to call from any thread.
+ * @param level The ConcurrentLevel3D.
+ * @param coordinate The coordinate of the block.
+ * @return The block at the coordinate, or 0 if no block is found.
+ */
+Block* ConcurrentLevel3D_getBlock(ConcurrentLevel3D* level, Coordinate3D* coordinate) {
+    if (level == 0) return 0;
+    if (coordinate == 0) return 0;
+
+    ConcurrentStripe3D* stripe = __ConcurrentLevel3D_stripe(level, coordinate);
+    __Mutex_lock(&stripe->lock);
+
+    LevelObject3D* object = stripe->objects[__ConcurrentStripe3D_find(stripe, coordinate)];
+    Block* block = object == 0 ? 0 : object->block;
+
+    __Mutex_unlock(&stripe->lock);
+    return block;
+}
+
+/**
+ * Removes the block at a coordinate from a ConcurrentLevel3D. Safe to call from any thread.
+ * @param level The ConcurrentLevel3D.
+ * @param coordinate The coordinate of the block.
+ * @return The removed block, owned by the caller, or 0 if no block is found.
+ */
+LevelObject3D* ConcurrentLevel3D_removeBlock(ConcurrentLevel3D* level, Coordinate3D* coordinate) {
+    if (level == 0) return 0;
+    if (coordinate == 0) return 0;
+
+    ConcurrentStripe3D* stripe = __ConcurrentLevel3D_stripe(level, coordinate);
+    __Mutex_lock(&stripe->lock);
+
+    int i = __ConcurrentStripe3D_find(stripe, coordinate);
+    LevelObject3D* removed = stripe->objects[i];
+    if (removed != 0) {
+        // backward-shift deletion keeps probe sequences intact without tombstones
+        int mask = stripe->capacity - 1;
+        int j = i;
+        while (1) {
+            j = (j + 1) & mask;
+            if (stripe->objects[j] == 0) break;
+
+            Coordinate3D* o = stripe->objects[j]->coordinate;
+            int home = (int) (Coordinate3D_hash(o->x, o->y, o->z) & mask);
+            if ((j > i && (home <= i || home > j)) || (j < i && home <= i && home > j)) {
+                stripe->objects[i] = stripe->objects[j];
+                i = j;
+            }
+        }
+
+        stripe->objects[i] = 0;
+        stripe->count--;
+    }
+
+    __Mutex_unlock(&stripe->lock);
+    return removed;
+}
+
+/**
+ * Gets the number of blocks in a ConcurrentLevel3D. The count is exact only while
+ * no other thread is editing the level.
+ * @param level The ConcurrentLevel3D.
+ * @return The number of blocks in the level.
+ */
+int ConcurrentLevel3D_getBlockCount(ConcurrentLevel3D* level) {
+    if (level == 0) return 0;
+
+    int count = 0;
+    for (int i = 0; i < level->stripeCount; i++) {
+        __Mutex_lock(&level->stripes[i].lock);
+        count += level->stripes[i].count;
+        __Mutex_unlock(&level->stripes[i].lock);
+    }
+
+    return count;
+}
+
+/**
+ * Moves every block of a ConcurrentLevel3D into a Level3D, leaving the
+ * ConcurrentLevel3D empty. Must not run concurrently with other operations on
+ * the ConcurrentLevel3D.
+ * @param concurrent The ConcurrentLevel3D.
+ * @param level The Level3D to add the blocks to.
+ */
+void ConcurrentLevel3D_toLevel(ConcurrentLevel3D* concurrent, Level3D* level) {
+    if (concurrent == 0) return;
+    if (level == 0) return;
+
+    Level3D_reserve(level, level->blockCount + ConcurrentLevel3D_getBlockCount(concurrent));
+
+    for (int i = 0; i < concurrent->stripeCount; i++) {
+        ConcurrentStripe3D* stripe = &concurrent->stripes[i];
+        __Mutex_lock(&stripe->lock);
+
+        int count = 0;
+        for (int j = 0; j < stripe->capacity; j++) {
+            if (stripe->objects[j] != 0) stripe->objects[count++] = stripe->objects[j];
+        }
+
+        Level3D_addBlocks(level, stripe->objects, count);
+        memset(stripe->objects, 0, stripe->capacity * sizeof(LevelObject3D*));
+        stripe->count = 0;
+
+        __Mutex_unlock(&stripe->lock);
+    }
+}
+
+#endif
@@ -3,8 +3,60 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdarg.h>
 #include <tgmath.h>
 
+// Internal
+
+uint64_t __mix64(uint64_t h) {
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    return h;
+}
+
+uint64_t __hashDouble(double d) {
+    if (d == 0) d = 0; // -0.0 and 0.0 compare equal, so they must hash equal
+
+    uint64_t bits;
+    memcpy(&bits, &d, sizeof(bits));
+    return __mix64(bits);
+}
+
+int __formatDouble(char* buffer, size_t size, double d) {
+    // shortest of the two precisions that still reads back as the same value
+    char temp[32];
+    snprintf(temp, sizeof(temp), "%.15g", d);
+    if (strtod(temp, 0) != d)
+        snprintf(temp, sizeof(temp), "%.17g", d);
+
+    return snprintf(buffer, size, "%s", temp);
+}
+
+// Writes like snprintf at an offset into a buffer, returning the length the whole output needs.
+int __formatAt(char* buffer, size_t size, int offset, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int n = (size_t) offset < size ? vsnprintf(buffer + offset, size - offset, format, args) : vsnprintf(0, 0, format, args);
+    va_end(args);
+
+    return n < 0 ? n : offset + n;
+}
+
+char* __bufferAt(char* buffer, size_t size, int offset) {
+    return (size_t) offset < size ? buffer + offset : 0;
+}
+
+size_t __sizeAt(size_t size, int offset) {
+    return (size_t) offset < size ? size - offset : 0;
+}
+
+// Implementation
+
 /**
  * Represents a coordinate in a 2D space.
  */
@@ -33,6 +85,60 @@ Coordinate2D* createCoordinate2D(double x, double y) {
     return c;
 }
 
+/**
+ * Makes a Coordinate2D value, without allocating.
+ * @param x The x value of the coordinate.
+ * @param y The y value of the coordinate.
+ * @return The coordinate.
+ */
+Coordinate2D makeCoordinate2D(double x, double y) {
+    Coordinate2D c;
+    c.x = x;
+    c.y = y;
+    return c;
+}
+
+/**
+ * Calculates the distance between two 2D coordinate values.
+ * @param a The first coordinate.
+ * @param b The second coordinate.
+ * @return The distance between the two coordinates.
+ */
+double Coordinate2D_distanceValue(Coordinate2D a, Coordinate2D b) {
+    double dx = a.x - b.x;
+    double dy = a.y - b.y;
+    return sqrt(dx * dx + dy * dy);
+}
+
+/**
+ * Calculates the magnitude of a 2D coordinate value.
+ * @param a The coordinate.
+ * @return The magnitude of the coordinate.
+ */
+double Coordinate2D_magnitudeValue(Coordinate2D a) {
+    return sqrt(a.x * a.x + a.y * a.y);
+}
+
+/**
+ * Adds two 2D coordinate values.
+ * @param a The coordinate.
+ * @param b The second coordinate.
+ * @return The sum of the two coordinates.
+ */
+Coordinate2D Coordinate2D_addValue(Coordinate2D a, Coordinate2D b) {
+    return makeCoordinate2D(a.x + b.x, a.y + b.y);
+}
+
+/**
+ * Subtracts two 2D coordinate values.
+ * @param a The coordinate.
+ * @param b The second coordinate.
+ * @return The difference of the two coordinates.
+ */
+Coordinate2D Coordinate2D_subtractValue(Coordinate2D a, Coordinate2D b) {
+    return makeCoordinate2D(a.x - b.x, a.y - b.y);
+}
+
 /**
  * Calculates the distance between two 2D coordinates.
  * @param a The first coordinate.
@@ -72,36 +178,69 @@ Coordinate2D* Coordinate2D_subtract(Coordinate2D* a, Coordinate2D* b) {
     return createCoordinate2D(a->x - b->x, a->y - b->y);
 }
 
+/**
+ * Writes a Coordinate2D into a buffer, in the same form as Coordinate2D_toString.
+ * Like snprintf, the output is truncated to fit and always terminated when size is not 0.
+ * @param c The coordinate.
+ * @param buffer The buffer to write to. It may be null if size is 0.
+ * @param size The size of the buffer.
+ * @return The length of the full string, excluding the terminator, or -1 if the coordinate is null.
+ */
+int Coordinate2D_toBuffer(Coordinate2D* c, char* buffer, size_t size) {
+    if (c == 0) return -1;
+
+    return snprintf(buffer, size, "[%g, %g]", c->x, c->y);
+}
+
 /**
  * Converts a Coordinate2D to a string.
  * @param c The coordinate.
  * @return The string representation of the coordinate.
  */
 char* Coordinate2D_toString(Coordinate2D* c) {
-    char* str = (char*) malloc(20);
-    sprintf(str, "[%g, %g]", c->x, c->y);
+    if (c == 0) return 0;
+
+    int length = Coordinate2D_toBuffer(c, 0, 0);
+    char* str = (char*) malloc(length + 1);
+    Coordinate2D_toBuffer(c, str, length + 1);
     return str;
 }
 
 /**
  * Converts a string to a Coordinate2D.
  * @param str The string representation of the coordinate.
- * @return The Coordinate2D.
+ * @return The Coordinate2D, or null if the string is missing a value.
  */
 Coordinate2D* Coordinate2D_fromString(const char* str) {
+    if (str == 0) return 0;
+
     char* str0 = (char*) malloc(strlen(str) + 1);
     strcpy(str0, str);
 
     char* x0 = strtok(str0, "[], \t");
-    double x = atof(x0);
-
     char* y0 = strtok(0, "[], \t");
+    if (x0 == 0 || y0 == 0) {
+        free(str0);
+        return 0;
+    }
+
+    double x = atof(x0);
     double y = atof(y0);
 
     free(str0);
     return createCoordinate2D(x, y);
 }
 
+/**
+ * Hashes the value of a 2D coordinate.
+ * @param x The x value of the coordinate.
+ * @param y The y value of the coordinate.
+ * @return The hash of the coordinate.
+ */
+uint64_t Coordinate2D_hash(double x, double y) {
+    return __mix64(__hashDouble(x) ^ (__hashDouble(y) + 0x9e3779b97f4a7c15ULL));
+}
+
 /**
  * Represents a coordinate in a 3D space.
  */
@@ -137,6 +276,63 @@ Coordinate3D* createCoordinate3D(double x, double y, double z) {
     return c;
 }
 
+/**
+ * Makes a Coordinate3D value, without allocating.
+ * @param x The x value of the coordinate.
+ * @param y The y value of the coordinate.
+ * @param z The z value of the coordinate.
+ * @return The coordinate.
+ */
+Coordinate3D makeCoordinate3D(double x, double y, double z) {
+    Coordinate3D c;
+    c.x = x;
+    c.y = y;
+    c.z = z;
+    return c;
+}
+
+/**
+ * Calculates the distance between two 3D coordinate values.
+ * @param a The first coordinate.
+ * @param b The second coordinate.
+ * @return The distance between the two coordinates.
+ */
+double Coordinate3D_distanceValue(Coordinate3D a, Coordinate3D b) {
+    double dx = a.x - b.x;
+    double dy = a.y - b.y;
+    double dz = a.z - b.z;
+    return sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+/**
+ * Calculates the magnitude of a 3D coordinate value.
+ * @param a The coordinate.
+ * @return The magnitude of the coordinate.
+ */
+double Coordinate3D_magnitudeValue(Coordinate3D a) {
+    return sqrt(a.x * a.x + a.y * a.y + a.z * a.z);
+}
+
+/**
+ * Adds two 3D coordinate values.
+ * @param a The coordinate.
+ * @param b The second coordinate.
+ * @return The sum of the two coordinates.
+ */
+Coordinate3D Coordinate3D_addValue(Coordinate3D a, Coordinate3D b) {
+    return makeCoordinate3D(a.x + b.x, a.y + b.y, a.z + b.z);
+}
+
+/**
+ * Subtracts two 3D coordinate values.
+ * @param a The coordinate.
+ * @param b The second coordinate.
+ * @return The difference of the two coordinates.
+ */
+Coordinate3D Coordinate3D_subtractValue(Coordinate3D a, Coordinate3D b) {
+    return makeCoordinate3D(a.x - b.x, a.y - b.y, a.z - b.z);
+}
+
 /**
  * Calculates the distance between two 3D coordinates.
  * @param a The first coordinate.
@@ -176,37 +372,71 @@ Coordinate3D* Coordinate3D_subtract(Coordinate3D* a, Coordinate3D* b) {
     return createCoordinate3D(a->x - b->x, a->y - b->y, a->z - b->z);
 }
 
+/**
+ * Writes a Coordinate3D into a buffer, in the same form as Coordinate3D_toString.
+ * Like snprintf, the output is truncated to fit and always terminated when size is not 0.
+ * @param c The coordinate.
+ * @param buffer The buffer to write to. It may be null if size is 0.
+ * @param size The size of the buffer.
+ * @return The length of the full string, excluding the terminator, or -1 if the coordinate is null.
+ */
+int Coordinate3D_toBuffer(Coordinate3D* c, char* buffer, size_t size) {
+    if (c == 0) return -1;
+
+    return snprintf(buffer, size, "[%g, %g, %g]", c->x, c->y, c->z);
+}
+
 /**
  * Converts a Coordinate3D to a string.
  * @param c The coordinate.
  * @return The string representation of the coordinate.
  */
 char* Coordinate3D_toString(Coordinate3D* c) {
-    char* str = (char*) malloc(20);
-    sprintf(str, "[%g, %g, %g]", c->x, c->y, c->z);
+    if (c == 0) return 0;
+
+    int length = Coordinate3D_toBuffer(c, 0, 0);
+    char* str = (char*) malloc(length + 1);
+    Coordinate3D_toBuffer(c, str, length + 1);
     return str;
 }
 
 /**
  * Converts a string to a Coordinate3D.
  * @param str The string representation of the coordinate.
- * @return The Coordinate3D.
+ * @return The Coordinate3D, or null if the string is missing a value.
  */
 Coordinate3D* Coordinate3D_fromString(char* str) {
+    if (str == 0) return 0;
+
     char* str0 = (char*) malloc(strlen(str) + 1);
     strcpy(str0, str);
 
     char* x0 = strtok(str0, "[], \t");
-    double x = atof(x0);
-
     char* y0 = strtok(0, "[], \t");
-    double y = atof(y0);
-
     char* z0 = strtok(0, "[], \t");
+    if (x0 == 0 || y0 == 0 || z0 == 0) {
+        free(str0);
+        return 0;
+    }
+
+    double x = atof(x0);
+    double y = atof(y0);
     double z = atof(z0);
 
     free(str0);
     return createCoordinate3D(x, y, z);
 }
 
+/**
+ * Hashes the value of a 3D coordinate.
+ * @param x The x value of the coordinate.
+ * @param y The y value of the coordinate.
+ * @param z The z value of the coordinate.
+ * @return The hash of the coordinate.
+ */
+uint64_t Coordinate3D_hash(double x, double y, double z) {
+    uint64_t h = __hashDouble(x) ^ (__hashDouble(y) + 0x9e3779b97f4a7c15ULL);
+    return __mix64(__mix64(h) ^ (__hashDouble(z) + 0x632be59bd9b4e019ULL));
+}
+
 #endif
\ No newline at end of file
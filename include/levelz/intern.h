@@ -0,0 +1,218 @@
+#ifndef LEVELZ_INTERN_H
+#define LEVELZ_INTERN_H
+
+#define _INTERN_ARENA_SIZE 65536
+#define _INTERN_INIT_CAPACITY 64
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "coordinate.h"
+#include "thread.h"
+
+// Internal
+
+uint64_t __hashString(const char* str, uint64_t seed) {
+    uint64_t h = 0xcbf29ce484222325ULL ^ seed;
+    while (*str) {
+        h ^= (unsigned char) *str++;
+        h *= 0x100000001b3ULL;
+    }
+
+    return __mix64(h);
+}
+
+typedef struct __InternArena {
+    struct __InternArena* next;
+    size_t used;
+    size_t capacity;
+    char data[];
+} __InternArena;
+
+typedef struct __InternTable {
+    __Mutex lock;
+    __InternArena* arena;
+    char** strings;
+    uint64_t* hashes;
+    int count;
+    int capacity;
+    int* slots;
+    int slotCapacity;
+} __InternTable;
+
+__InternTable __interned = {__MUTEX_INITIALIZER, 0, 0, 0, 0, 0, 0, 0};
+
+char* __InternTable_allocate(__InternTable* table, size_t size) {
+    // large strings get an arena of their own behind the current one, so its free space is kept
+    if (size > _INTERN_ARENA_SIZE / 4 && table->arena != 0) {
+        __InternArena* arena = (__InternArena*) malloc(sizeof(__InternArena) + size);
+        arena->used = size;
+        arena->capacity = size;
+        arena->next = table->arena->next;
+        table->arena->next = arena;
+        return arena->data;
+    }
+
+    __InternArena* arena = table->arena;
+    if (arena == 0 || arena->capacity - arena->used < size) {
+        size_t capacity = size > _INTERN_ARENA_SIZE ? size : _INTERN_ARENA_SIZE;
+        arena = (__InternArena*) malloc(sizeof(__InternArena) + capacity);
+        arena->used = 0;
+        arena->capacity = capacity;
+        arena->next = table->arena;
+        table->arena = arena;
+    }
+
+    char* str = arena->data + arena->used;
+    arena->used += size;
+    return str;
+}
+
+// Slots hold string IDs, and ID 0 is never handed out, so 0 marks an empty slot.
+int __InternTable_find(__InternTable* table, const char* str, uint64_t hash) {
+    if (table->slotCapacity == 0) return 0;
+
+    int mask = table->slotCapacity - 1;
+    int slot = (int) (hash & mask);
+    while (table->slots[slot] != 0) {
+        int id = table->slots[slot];
+        if (table->hashes[id] == hash && strcmp(table->strings[id], str) == 0) return id;
+
+        slot = (slot + 1) & mask;
+    }
+
+    return 0;
+}
+
+void __InternTable_rehash(__InternTable* table, int capacity) {
+    free(table->slots);
+    table->slots = (int*) calloc(capacity, sizeof(int));
+    table->slotCapacity = capacity;
+
+    for (int id = 1; id < table->count; id++) {
+        int slot = (int) (table->hashes[id] & (capacity - 1));
+        while (table->slots[slot] != 0) slot = (slot + 1) & (capacity - 1);
+        table->slots[slot] = id;
+    }
+}
+
+int __InternTable_add(__InternTable* table, const char* str, uint64_t hash) {
+    if (table->count == 0) table->count = 1;
+
+    if (table->count == table->capacity || table->capacity == 0) {
+        table->capacity = table->capacity == 0 ? _INTERN_INIT_CAPACITY : table->capacity * 2;
+        table->strings = (char**) realloc(table->strings, table->capacity * sizeof(char*));
+        table->hashes = (uint64_t*) realloc(table->hashes, table->capacity * sizeof(uint64_t));
+    }
+
+    if ((table->count + 1) * 2 > table->slotCapacity)
+        __InternTable_rehash(table, table->slotCapacity == 0 ? _INTERN_INIT_CAPACITY * 2 : table->slotCapacity * 2);
+
+    size_t size = strlen(str) + 1;
+    char* copy = __InternTable_allocate(table, size);
+    memcpy(copy, str, size);
+
+    int id = table->count++;
+    table->strings[id] = copy;
+    table->hashes[id] = hash;
+
+    int mask = table->slotCapacity - 1;
+    int slot = (int) (hash & mask);
+    while (table->slots[slot] != 0) slot = (slot + 1) & mask;
+    table->slots[slot] = id;
+
+    return id;
+}
+
+char* __internString(const char* str, int* id) {
+    uint64_t hash = __hashString(str, 0);
+
+    __Mutex_lock(&__interned.lock);
+    *id = __InternTable_find(&__interned, str, hash);
+    if (*id == 0) *id = __InternTable_add(&__interned, str, hash);
+    char* interned = __interned.strings[*id];
+    __Mutex_unlock(&__interned.lock);
+
+    return interned;
+}
+
+// Implementation
+
+/**
+ * Interns a string, returning its ID. Equal strings always receive the same ID, so
+ * they can be compared as integers. IDs start at 1 and are never reused.
+ * Interned strings are copied into a shared arena and live until the program exits.
+ * This function is thread-safe.
+ * @param str The string to intern.
+ * @return The ID of the string, or 0 if the string is null.
+ */
+int internStringId(const char* str) {
+    if (str == 0) return 0;
+
+    int id;
+    __internString(str, &id);
+    return id;
+}
+
+/**
+ * Gets the ID of a string without interning it.
+ * This function is thread-safe.
+ * @param str The string.
+ * @return The ID of the string, or 0 if it has not been interned.
+ */
+int getInternedId(const char* str) {
+    if (str == 0) return 0;
+
+    uint64_t hash = __hashString(str, 0);
+
+    __Mutex_lock(&__interned.lock);
+    int id = __InternTable_find(&__interned, str, hash);
+    __Mutex_unlock(&__interned.lock);
+
+    return id;
+}
+
+/**
+ * Gets the interned string with an ID. The returned string must not be modified or freed.
+ * This function is thread-safe.
+ * @param id The ID of the string.
+ * @return The interned string, or null if no string has the ID.
+ */
+char* getInternedString(int id) {
+    if (id <= 0) return 0;
+
+    __Mutex_lock(&__interned.lock);
+    char* str = id < __interned.count ? __interned.strings[id] : 0;
+    __Mutex_unlock(&__interned.lock);
+
+    return str;
+}
+
+/**
+ * Interns a string. Equal strings always return the same pointer, so they can be
+ * compared by address. The returned string must not be modified or freed.
+ * This function is thread-safe.
+ * @param str The string to intern.
+ * @return The interned copy of the string, or null if the string is null.
+ */
+char* internString(const char* str) {
+    if (str == 0) return 0;
+
+    int id;
+    return __internString(str, &id);
+}
+
+/**
+ * Gets the number of strings that have been interned.
+ * @return The number of interned strings.
+ */
+int getInternedCount() {
+    __Mutex_lock(&__interned.lock);
+    int count = __interned.count == 0 ? 0 : __interned.count - 1;
+    __Mutex_unlock(&__interned.lock);
+
+    return count;
+}
+
+#endif
@@ -0,0 +1,573 @@
+#ifndef LEVELZ_JOURNAL_H
+#define LEVELZ_JOURNAL_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../levelz.h"
+
+/**
+ * The suffix appended to a level file's path to form the path of its journal.
+ */
+const char* LEVELZ_JOURNAL_SUFFIX = ".journal";
+
+// Internal
+
+char* __journalPath(const char* path) {
+    char* journalPath = (char*) malloc(strlen(path) + strlen(LEVELZ_JOURNAL_SUFFIX) + 1);
+    sprintf(journalPath, "%s%s", path, LEVELZ_JOURNAL_SUFFIX);
+    return journalPath;
+}
+
+// Drops the start of a journal that a compacted file already holds, keeping the
+// entries appended since. An open journal is reopened on the trimmed file.
+void __trimJournal(const char* path, long offset, FILE** journal) {
+    char* journalPath = __journalPath(path);
+    if (*journal != 0) fclose(*journal);
+
+    char* buffer = __readFile(journalPath);
+    if (buffer != 0) {
+        size_t length = strlen(buffer);
+        size_t start = offset < 0 ? 0 : (size_t) offset;
+        if (start > length) start = length;
+
+        __writeFileAtomic(journalPath, buffer + start, length - start);
+        free(buffer);
+    }
+
+    if (*journal != 0) *journal = fopen(journalPath, "ab");
+    free(journalPath);
+}
+
+// The length of a journal once everything written to it so far is on disk.
+long __journalLength(const char* path, FILE* journal) {
+    if (journal != 0) fflush(journal);
+
+    char* journalPath = __journalPath(path);
+    long length = __fileLength(journalPath);
+    free(journalPath);
+
+    return length < 0 ? 0 : length;
+}
+
+// Replays the journal of a level file. A final line without its newline was cut
+// short while being written and is skipped. Any other entry that does not parse
+// stops the replay, since later entries may build on it.
+// Returns 1 if every complete entry was applied, 0 if the replay stopped early.
+int __Level2D_replayJournal(Level2D* level, const char* path) {
+    char* journalPath = __journalPath(path);
+    char* buffer = __readFile(journalPath);
+    free(journalPath);
+    if (buffer == 0) return 1;
+
+    size_t length = strlen(buffer);
+    int torn = length > 0 && buffer[length - 1] != '\n';
+
+    // entries must be applied in order, since later edits may undo earlier ones
+    FILE* journal = level->journal;
+    level->journal = 0;
+
+    int complete = 1;
+    char* cursor = buffer;
+    char* line = __nextLine(&cursor);
+    while (line != 0) {
+        if (torn && *cursor == '\0') break;
+
+        LevelPatch2D* patch = LevelPatch2D_fromString(line);
+        if (patch == 0) {
+            complete = 0;
+            break;
+        }
+
+        Level2D_applyPatch(level, patch);
+        LevelPatch2D_free(patch);
+
+        line = __nextLine(&cursor);
+    }
+
+    level->journal = journal;
+    free(buffer);
+    return complete;
+}
+
+// Writes a snapshot in the same form as Level2D_toString.
+char* __LevelSnapshot2D_toString(LevelSnapshot2D* snapshot) {
+    char* str = 0;
+    size_t length = 0;
+    size_t capacity = 0;
+
+    if (LevelSnapshot2D_getHeader(snapshot, "type") == 0)
+        __appendf(&str, &length, &capacity, "@type 2\n");
+
+    if (LevelSnapshot2D_getHeader(snapshot, "spawn") == 0 && snapshot->spawn != 0) {
+        __appendf(&str, &length, &capacity, "@spawn ");
+        __appendCoordinate2D(&str, &length, &capacity, snapshot->spawn);
+        __appendf(&str, &length, &capacity, "\n");
+    }
+
+    for (int i = 0; i < snapshot->headerCount; i++)
+        __appendf(&str, &length, &capacity, "@%s %s\n", snapshot->headerNames[i], snapshot->headerValues[i]);
+
+    LevelObject2D** objects = (LevelObject2D**) malloc((snapshot->blockCount + 1) * sizeof(LevelObject2D*));
+    int count = 0;
+    for (int i = 0; i < snapshot->chunkCapacity; i++) {
+        LevelChunkSnapshot2D* chunk = snapshot->chunks[i];
+        if (chunk == 0) continue;
+
+        memcpy(objects + count, chunk->objects, chunk->count * sizeof(LevelObject2D*));
+        count += chunk->count;
+    }
+
+    memcpy(objects + count, snapshot->outlying, snapshot->outlyingCount * sizeof(LevelObject2D*));
+    count += snapshot->outlyingCount;
+
+    __appendf(&str, &length, &capacity, "%s\n", LEVELZ_HEADER_END);
+    __appendBlocks2D(&str, &length, &capacity, objects, count, "");
+    __appendf(&str, &length, &capacity, "%s\n", LEVELZ_END);
+
+    free(objects);
+    return str;
+}
+
+// Replays the journal of a level file. A final line without its newline was cut
+// short while being written and is skipped. Any other entry that does not parse
+// stops the replay, since later entries may build on it.
+// Returns 1 if every complete entry was applied, 0 if the replay stopped early.
+int __Level3D_replayJournal(Level3D* level, const char* path) {
+    char* journalPath = __journalPath(path);
+    char* buffer = __readFile(journalPath);
+    free(journalPath);
+    if (buffer == 0) return 1;
+
+    size_t length = strlen(buffer);
+    int torn = length > 0 && buffer[length - 1] != '\n';
+
+    // entries must be applied in order, since later edits may undo earlier ones
+    FILE* journal = level->journal;
+    level->journal = 0;
+
+    int complete = 1;
+    char* cursor = buffer;
+    char* line = __nextLine(&cursor);
+    while (line != 0) {
+        if (torn && *cursor == '\0') break;
+
+        LevelPatch3D* patch = LevelPatch3D_fromString(line);
+        if (patch == 0) {
+            complete = 0;
+            break;
+        }
+
+        Level3D_applyPatch(level, patch);
+        LevelPatch3D_free(patch);
+
+        line = __nextLine(&cursor);
+    }
+
+    level->journal = journal;
+    free(buffer);
+    return complete;
+}
+
+// Writes a snapshot in the same form as Level3D_toString.
+char* __LevelSnapshot3D_toString(LevelSnapshot3D* snapshot) {
+    char* str = 0;
+    size_t length = 0;
+    size_t capacity = 0;
+
+    if (LevelSnapshot3D_getHeader(snapshot, "type") == 0)
+        __appendf(&str, &length, &capacity, "@type 3\n");
+
+    if (LevelSnapshot3D_getHeader(snapshot, "spawn") == 0 && snapshot->spawn != 0) {
+        __appendf(&str, &length, &capacity, "@spawn ");
+        __appendCoordinate3D(&str, &length, &capacity, snapshot->spawn);
+        __appendf(&str, &length, &capacity, "\n");
+    }
+
+    for (int i = 0; i < snapshot->headerCount; i++)
+        __appendf(&str, &length, &capacity, "@%s %s\n", snapshot->headerNames[i], snapshot->headerValues[i]);
+
+    LevelObject3D** objects = (LevelObject3D**) malloc((snapshot->blockCount + 1) * sizeof(LevelObject3D*));
+    int count = 0;
+    for (int i = 0; i < snapshot->chunkCapacity; i++) {
+        LevelChunkSnapshot3D* chunk = snapshot->chunks[i];
+        if (chunk == 0) continue;
+
+        memcpy(objects + count, chunk->objects, chunk->count * sizeof(LevelObject3D*));
+        count += chunk->count;
+    }
+
+    memcpy(objects + count, snapshot->outlying, snapshot->outlyingCount * sizeof(LevelObject3D*));
+    count += snapshot->outlyingCount;
+
+    __appendf(&str, &length, &capacity, "%s\n", LEVELZ_HEADER_END);
+    __appendBlocks3D(&str, &length, &capacity, objects, count, "");
+    __appendf(&str, &length, &capacity, "%s\n", LEVELZ_END);
+
+    free(objects);
+    return str;
+}
+
+// Implementation
+
+/**
+ * Starts journaling a Level2D. From now on, every block and header mutation is
+ * appended to a journal next to the level file, and is replayed by parseFile2D.
+ * @param level The Level2D.
+ * @param path The path to the level file the journal belongs to.
+ * @return 1 if the journal was opened, 0 otherwise.
+ */
+int Level2D_openJournal(Level2D* level, const char* path) {
+    if (level == 0) return 0;
+    if (path == 0) return 0;
+
+    char* journalPath = __journalPath(path);
+    FILE* journal = fopen(journalPath, "ab");
+    free(journalPath);
+    if (journal == 0) return 0;
+
+    if (level->journal != 0) fclose(level->journal);
+    level->journal = journal;
+
+    return 1;
+}
+
+/**
+ * Stops journaling a Level2D. Recorded edits stay in the journal.
+ * @param level The Level2D.
+ */
+void Level2D_closeJournal(Level2D* level) {
+    if (level == 0) return;
+    if (level->journal == 0) return;
+
+    fclose(level->journal);
+    level->journal = 0;
+}
+
+/**
+ * Folds the journal of a Level2D into its level file. The level is written to a
+ * fresh file that atomically replaces the old one, after which the journal is
+ * emptied. If the process stops in between, replaying the journal over the new
+ * file yields the same level, since every entry only sets the final state of its
+ * cell or header. Level2D_compactInBackground does the same without blocking.
+ * @param level The Level2D.
+ * @param path The path to the level file.
+ * @return 1 if the level was compacted, 0 otherwise.
+ */
+int Level2D_compact(Level2D* level, const char* path) {
+    if (level == 0) return 0;
+    if (path == 0) return 0;
+
+    if (!writeFile2D(path, level)) return 0;
+
+    char* journalPath = __journalPath(path);
+    if (level->journal != 0) {
+        fclose(level->journal);
+        level->journal = fopen(journalPath, "wb");
+    } else {
+        remove(journalPath);
+    }
+
+    free(journalPath);
+    return 1;
+}
+
+/**
+ * A compaction of a Level2D running on a background thread.
+ */
+typedef struct LevelCompaction2D {
+    /**
+     * The level being compacted.
+     */
+    Level2D* level;
+
+    /**
+     * The path to the level file.
+     */
+    char* path;
+
+    /**
+     * The state of the level written to the file.
+     */
+    LevelSnapshot2D* snapshot;
+
+    /**
+     * The length of the journal when the snapshot was taken. Only entries past it
+     * are kept once the compaction finishes.
+     */
+    long journalLength;
+
+    /**
+     * 1 once the file has been written, 0 if writing it failed.
+     */
+    int written;
+
+    /**
+     * 1 once the background thread is done.
+     */
+    int done;
+
+    /**
+     * The background thread.
+     */
+    __Thread thread;
+} LevelCompaction2D;
+
+void* __LevelCompaction2D_run(void* arg) {
+    LevelCompaction2D* compaction = (LevelCompaction2D*) arg;
+
+    char* str = __LevelSnapshot2D_toString(compaction->snapshot);
+    compaction->written = __writeFileAtomic(compaction->path, str, strlen(str));
+    free(str);
+
+    __atomicIncrement(&compaction->done);
+    return 0;
+}
+
+/**
+ * Starts folding the journal of a Level2D into its level file on a background
+ * thread. The thread writes a snapshot of the level, so the level can keep being
+ * edited meanwhile; edits made after this call stay in the journal.
+ * LevelCompaction2D_finish must be called on the thread that edits the level
+ * before the level is freed.
+ * @param level The Level2D.
+ * @param path The path to the level file.
+ * @return The running compaction, or 0 if the thread could not be started.
+ */
+LevelCompaction2D* Level2D_compactInBackground(Level2D* level, const char* path) {
+    if (level == 0) return 0;
+    if (path == 0) return 0;
+
+    LevelCompaction2D* compaction = (LevelCompaction2D*) malloc(sizeof(LevelCompaction2D));
+    compaction->level = level;
+    compaction->path = __copyString(path);
+    compaction->journalLength = __journalLength(path, level->journal);
+    compaction->snapshot = Level2D_snapshot(level);
+    compaction->written = 0;
+    compaction->done = 0;
+
+    if (!__Thread_create(&compaction->thread, __LevelCompaction2D_run, compaction)) {
+        LevelSnapshot2D_release(compaction->snapshot);
+        free(compaction->path);
+        free(compaction);
+        return 0;
+    }
+
+    return compaction;
+}
+
+/**
+ * Checks whether a LevelCompaction2D has written the level file, so finishing it
+ * will not block.
+ * @param compaction The LevelCompaction2D.
+ * @return 1 if the background thread is done, 0 otherwise.
+ */
+int LevelCompaction2D_isDone(LevelCompaction2D* compaction) {
+    if (compaction == 0) return 1;
+
+    return __atomicLoad(&compaction->done);
+}
+
+/**
+ * Waits for a LevelCompaction2D, then drops the journal entries the new level file
+ * already holds. The compaction is freed.
+ * @param compaction The LevelCompaction2D.
+ * @return 1 if the level was compacted, 0 otherwise.
+ */
+int LevelCompaction2D_finish(LevelCompaction2D* compaction) {
+    if (compaction == 0) return 0;
+
+    __Thread_join(compaction->thread);
+
+    int compacted = compaction->written;
+    if (compacted) __trimJournal(compaction->path, compaction->journalLength, &compaction->level->journal);
+
+    LevelSnapshot2D_release(compaction->snapshot);
+    free(compaction->path);
+    free(compaction);
+
+    return compacted;
+}
+
+/**
+ * Starts journaling a Level3D. From now on, every block and header mutation is
+ * appended to a journal next to the level file, and is replayed by parseFile3D.
+ * @param level The Level3D.
+ * @param path The path to the level file the journal belongs to.
+ * @return 1 if the journal was opened, 0 otherwise.
+ */
+int Level3D_openJournal(Level3D* level, const char* path) {
+    if (level == 0) return 0;
+    if (path == 0) return 0;
+
+    char* journalPath = __journalPath(path);
+    FILE* journal = fopen(journalPath, "ab");
+    free(journalPath);
+    if (journal == 0) return 0;
+
+    if (level->journal != 0) fclose(level->journal);
+    level->journal = journal;
+
+    return 1;
+}
+
+/**
+ * Stops journaling a Level3D. Recorded edits stay in the journal.
+ * @param level The Level3D.
+ */
+void Level3D_closeJournal(Level3D* level) {
+    if (level == 0) return;
+    if (level->journal == 0) return;
+
+    fclose(level->journal);
+    level->journal = 0;
+}
+
+/**
+ * Folds the journal of a Level3D into its level file. The level is written to a
+ * fresh file that atomically replaces the old one, after which the journal is
+ * emptied. If the process stops in between, replaying the journal over the new
+ * file yields the same level, since every entry only sets the final state of its
+ * cell or header. Level3D_compactInBackground does the same without blocking.
+ * @param level The Level3D.
+ * @param path The path to the level file.
+ * @return 1 if the level was compacted, 0 otherwise.
+ */
+int Level3D_compact(Level3D* level, const char* path) {
+    if (level == 0) return 0;
+    if (path == 0) return 0;
+
+    if (!writeFile3D(path, level)) return 0;
+
+    char* journalPath = __journalPath(path);
+    if (level->journal != 0) {
+        fclose(level->journal);
+        level->journal = fopen(journalPath, "wb");
+    } else {
+        remove(journalPath);
+    }
+
+    free(journalPath);
+    return 1;
+}
+
+/**
+ * A compaction of a Level3D running on a background thread.
+ */
+typedef struct LevelCompaction3D {
+    /**
+     * The level being compacted.
+     */
+    Level3D* level;
+
+    /**
+     * The path to the level file.
+     */
+    char* path;
+
+    /**
+     * The state of the level written to the file.
+     */
+    LevelSnapshot3D* snapshot;
+
+    /**
+     * The length of the journal when the snapshot was taken. Only entries past it
+     * are kept once the compaction finishes.
+     */
+    long journalLength;
+
+    /**
+     * 1 once the file has been written, 0 if writing it failed.
+     */
+    int written;
+
+    /**
+     * 1 once the background thread is done.
+     */
+    int done;
+
+    /**
+     * The background thread.
+     */
+    __Thread thread;
+} LevelCompaction3D;
+
+void* __LevelCompaction3D_run(void* arg) {
+    LevelCompaction3D* compaction = (LevelCompaction3D*) arg;
+
+    char* str = __LevelSnapshot3D_toString(compaction->snapshot);
+    compaction->written = __writeFileAtomic(compaction->path, str, strlen(str));
+    free(str);
+
+    __atomicIncrement(&compaction->done);
+    return 0;
+}
+
+/**
+ * Starts folding the journal of a Level3D into its level file on a background
+ * thread. The thread writes a snapshot of the level, so the level can keep being
+ * edited meanwhile; edits made after this call stay in the journal.
+ * LevelCompaction3D_finish must be called on the thread that edits the level
+ * before the level is freed.
+ * @param level The Level3D.
+ * @param path The path to the level file.
+ * @return The running compaction, or 0 if the thread could not be started.
+ */
+LevelCompaction3D* Level3D_compactInBackground(Level3D* level, const char* path) {
+    if (level == 0) return 0;
+    if (path == 0) return 0;
+
+    LevelCompaction3D* compaction = (LevelCompaction3D*) malloc(sizeof(LevelCompaction3D));
+    compaction->level = level;
+    compaction->path = __copyString(path);
+    compaction->journalLength = __journalLength(path, level->journal);
+    compaction->snapshot = Level3D_snapshot(level);
+    compaction->written = 0;
+    compaction->done = 0;
+
+    if (!__Thread_create(&compaction->thread, __LevelCompaction3D_run, compaction)) {
+        LevelSnapshot3D_release(compaction->snapshot);
+        free(compaction->path);
+        free(compaction);
+        return 0;
+    }
+
+    return compaction;
+}
+
+/**
+ * Checks whether a LevelCompaction3D has written the level file, so finishing it
+ * will not block.
+ * @param compaction The LevelCompaction3D.
+ * @return 1 if the background thread is done, 0 otherwise.
+ */
+int LevelCompaction3D_isDone(LevelCompaction3D* compaction) {
+    if (compaction == 0) return 1;
+
+    return __atomicLoad(&compaction->done);
+}
+
+/**
+ * Waits for a LevelCompaction3D, then drops the journal entries the new level file
+ * already holds. The compaction is freed.
+ * @param compaction The LevelCompaction3D.
+ * @return 1 if the level was compacted, 0 otherwise.
+ */
+int LevelCompaction3D_finish(LevelCompaction3D* compaction) {
+    if (compaction == 0) return 0;
+
+    __Thread_join(compaction->thread);
+
+    int compacted = compaction->written;
+    if (compacted) __trimJournal(compaction->path, compaction->journalLength, &compaction->level->journal);
+    if (compacted) __removeIndex(compaction->path);
+
+    LevelSnapshot3D_release(compaction->snapshot);
+    free(compaction->path);
+    free(compaction);
+
+    return compacted;
+}
+
+#endif
\ No newline at end of file
@@ -1,13 +1,22 @@
 #ifndef LEVELZ_LEVEL_H
 #define LEVELZ_LEVEL_H
 
+#define _LEVEL_BLOCKS_INIT_CAPACITY 16
+// the index stays twice the block capacity, so this keeps its size within an int
+#define _LEVEL_BLOCKS_MAX_CAPACITY (1 << 29)
+#define _LEVEL_DENSE_FILL (_LEVEL_CHUNK_SIZE * _LEVEL_CHUNK_SIZE / 2)
+#define _LEVEL_SPARSE_FILL (_LEVEL_CHUNK_SIZE * _LEVEL_CHUNK_SIZE / 4)
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 
 #include "block.h"
 #include "coordinate.h"
 #include "matrix.h"
+#include "chunk.h"
+#include "snapshot.h"
 
 /**
  * Represents a header in a level.
@@ -22,6 +31,11 @@ typedef struct LevelHeader {
      * Represents the value of a level header.
      */
     char* value;
+
+    /**
+     * The interned ID of the header name.
+     */
+    int nameId;
 } LevelHeader;
 
 /**
@@ -34,9 +48,24 @@ LevelHeader* createLevelHeader(char* name, char* value) {
     LevelHeader* h = (LevelHeader*) malloc(sizeof(LevelHeader));
     h->name = name;
     h->value = value;
+    h->nameId = internStringId(name);
     return h;
 }
 
+/**
+ * Writes a LevelHeader into a buffer, in the same form as LevelHeader_toString.
+ * Like snprintf, the output is truncated to fit and always terminated when size is not 0.
+ * @param header The LevelHeader.
+ * @param buffer The buffer to write to. It may be null if size is 0.
+ * @param size The size of the buffer.
+ * @return The length of the full string, excluding the terminator, or -1 if the header is null.
+ */
+int LevelHeader_toBuffer(LevelHeader* header, char* buffer, size_t size) {
+    if (header == 0) return -1;
+
+    return snprintf(buffer, size, "@%s %s", header->name, header->value);
+}
+
 /**
  * Converts a LevelHeader to a string.
  * @param header The LevelHeader.
@@ -45,29 +74,220 @@ LevelHeader* createLevelHeader(char* name, char* value) {
 char* LevelHeader_toString(LevelHeader* header) {
     if (header == 0) return 0;
 
-    char* str = (char*) malloc(strlen(header->name) + strlen(header->value) + 3);
-    sprintf(str, "@%s %s", header->name, header->value);
-
+    int length = LevelHeader_toBuffer(header, 0, 0);
+    char* str = (char*) malloc(length + 1);
+    LevelHeader_toBuffer(header, str, length + 1);
     return str;
 }
 
 /**
- * Converts a string to a LevelHeader.
+ * Converts a string to a LevelHeader. A header without a value, such as "@type",
+ * gets an empty value.
  * @param str The string representation of the LevelHeader.
- * @return The LevelHeader.
+ * @return The LevelHeader, or null if the string has no header name.
  */
 LevelHeader* LevelHeader_fromString(const char* str) {
     if (str == 0) return 0;
 
-    char* str0 = (char*) malloc(strlen(str) + 1);
+    size_t length = strlen(str);
+    char* str0 = (char*) malloc(length + 1);
     strcpy(str0, str);
 
-    char* name = strtok(str0, " ") + 1;
-    char* value = name + strlen(name) + 1;
+    char* name = strtok(str0, " ");
+    if (name == 0 || name[1] == '\0') {
+        free(str0);
+        return 0;
+    }
+
+    name++;
+
+    // the value starts after the space ending the name, if there is one
+    char* value = name + strlen(name);
+    if (value < str0 + length) value++;
+
+    // the header owns its name and value separately
+    char* name0 = (char*) malloc(strlen(name) + 1);
+    strcpy(name0, name);
+    char* value0 = (char*) malloc(strlen(value) + 1);
+    strcpy(value0, value);
+
+    free(str0);
+    return createLevelHeader(name0, value0);
+}
+
+/**
+ * Represents a 128-bit content hash of a level.
+ */
+typedef struct LevelHash {
+    /**
+     * The low 64 bits of the hash.
+     */
+    uint64_t low;
+
+    /**
+     * The high 64 bits of the hash.
+     */
+    uint64_t high;
+} LevelHash;
+
+/**
+ * Represents the memory used by a level, in bytes, broken down by category.
+ */
+typedef struct LevelMemoryUsage {
+    /**
+     * The level objects and the used part of the block array.
+     */
+    size_t cells;
+
+    /**
+     * The coordinates of the level objects and the spawnpoint.
+     */
+    size_t coordinates;
+
+    /**
+     * The distinct blocks and their names. Blocks shared between objects are counted once.
+     */
+    size_t blocks;
+
+    /**
+     * The properties of the distinct blocks, with their names and values.
+     */
+    size_t properties;
+
+    /**
+     * The headers, with their names and values.
+     */
+    size_t headers;
+
+    /**
+     * The coordinate index, the chunk map and the property indexes of blocks.
+     */
+    size_t indexes;
+
+    /**
+     * Capacity that is allocated but unused, in the block array, spilled property arrays and chunks.
+     */
+    size_t slack;
+
+    /**
+     * The sum of all categories.
+     */
+    size_t total;
+} LevelMemoryUsage;
+
+// Internal
+
+#define _LEVEL_HASH_SEED_LOW 0x243f6a8885a308d3ULL
+#define _LEVEL_HASH_SEED_HIGH 0x13198a2e03707344ULL
+
+// Entries are combined by addition, so the hash of a level does not depend on
+// the order its headers and blocks were added in, and an entry can be taken out
+// again by subtraction.
+
+void __LevelHash_update(LevelHash* hash, uint64_t key, uint64_t low, uint64_t high, int sign) {
+    uint64_t l = __mix64(key ^ low);
+    uint64_t h = __mix64((key * 0x9e3779b97f4a7c15ULL) ^ high);
+
+    if (sign > 0) {
+        hash->low += l;
+        hash->high += h;
+    } else {
+        hash->low -= l;
+        hash->high -= h;
+    }
+}
+
+void __LevelHash_header(LevelHash* hash, const char* name, const char* value, int sign) {
+    uint64_t key = __hashString(name, 0x3c6ef372fe94f82bULL);
+    uint64_t low = __hashString(value, _LEVEL_HASH_SEED_LOW);
+    uint64_t high = __hashString(value, _LEVEL_HASH_SEED_HIGH);
+
+    __LevelHash_update(hash, key, low, high, sign);
+}
+
+void __LevelHash_block2D(LevelHash* hash, LevelObject2D* object, int sign) {
+    uint64_t key = Coordinate2D_hash(object->coordinate->x, object->coordinate->y);
+    uint64_t low = __Block_hash(object->block, _LEVEL_HASH_SEED_LOW);
+    uint64_t high = __Block_hash(object->block, _LEVEL_HASH_SEED_HIGH);
 
-    return createLevelHeader(name, value);
+    __LevelHash_update(hash, key, low, high, sign);
 }
 
+void __LevelHash_block3D(LevelHash* hash, LevelObject3D* object, int sign) {
+    uint64_t key = Coordinate3D_hash(object->coordinate->x, object->coordinate->y, object->coordinate->z);
+    uint64_t low = __Block_hash(object->block, _LEVEL_HASH_SEED_LOW);
+    uint64_t high = __Block_hash(object->block, _LEVEL_HASH_SEED_HIGH);
+
+    __LevelHash_update(hash, key, low, high, sign);
+}
+
+
+int __comparePointers(const void* a, const void* b) {
+    uintptr_t x = (uintptr_t) *(void**) a;
+    uintptr_t y = (uintptr_t) *(void**) b;
+    return (x > y) - (x < y);
+}
+
+// Accounts for each distinct block once, however many objects share it.
+void __LevelMemoryUsage_blocks(LevelMemoryUsage* usage, Block** blocks, int count) {
+    qsort(blocks, count, sizeof(Block*), __comparePointers);
+
+    for (int i = 0; i < count; i++) {
+        if (i > 0 && blocks[i] == blocks[i - 1]) continue;
+
+        Block* b = blocks[i];
+        // names are interned and shared by every level, so they are not counted here
+        usage->blocks += sizeof(Block);
+
+        // inline property slots are part of the block itself
+        if (b->properties != b->inlineProperties) {
+            usage->properties += b->propertyCount * sizeof(BlockProperty);
+            usage->slack += (b->propertyCapacity - b->propertyCount) * sizeof(BlockProperty);
+        }
+
+        usage->indexes += b->propertyIndexCapacity * sizeof(int);
+        for (int j = 0; j < b->propertyCount; j++)
+            usage->properties += strlen(b->properties[j].value) + 1;
+    }
+}
+
+void __LevelMemoryUsage_headers(LevelMemoryUsage* usage, LevelHeader** headers, int count) {
+    if (headers == 0) return;
+
+    usage->headers += (count + 1) * sizeof(LevelHeader*);
+    for (int i = 0; i < count; i++)
+        usage->headers += sizeof(LevelHeader) + strlen(headers[i]->name) + strlen(headers[i]->value) + 2;
+}
+
+void __LevelMemoryUsage_total(LevelMemoryUsage* usage) {
+    usage->total = usage->cells + usage->coordinates + usage->blocks + usage->properties
+        + usage->headers + usage->indexes + usage->slack;
+}
+
+// Whether a coordinate value is a whole number well inside the range of an int, so
+// boxes can grow past it without overflowing.
+int __isCell(double d) {
+    return __inChunkRange(d) && d == (int) d;
+}
+
+/**
+ * A chunk-sized region of a Level2D, tracking how many of its whole-number cells hold
+ * blocks. Sparse regions are looked up through the hashed block index; once a region
+ * is filled past _LEVEL_DENSE_FILL cells its lookups go through a grid addressed by
+ * cell instead, until it empties below _LEVEL_SPARSE_FILL. The grid is only a lookup
+ * index: blocks are still stored as objects in level->blocks, and a grid costs an
+ * extra int per cell.
+ */
+typedef struct __LevelTile2D {
+    int x, y;
+    int count;
+
+    // the position of the block in each cell plus one, or 0 while the region is sparse
+    int* cells;
+} __LevelTile2D;
+
+// Implementation
+
 /**
  * Represents a 2D Level.
  */
@@ -82,6 +302,64 @@ typedef struct Level2D {
      */
     LevelObject2D** blocks;
 
+    /**
+     * The number of blocks in the level.
+     */
+    int blockCount;
+
+    /**
+     * The capacity of the blocks array, including its terminating slot.
+     */
+    int blockCapacity;
+
+    /**
+     * Open-addressed index of block positions keyed by coordinate.
+     * Each entry is a position in the blocks array plus one, or 0 if empty.
+     */
+    int* blockIndex;
+
+    /**
+     * The capacity of the block index. Always zero or a power of two.
+     */
+    int blockIndexCapacity;
+
+    /**
+     * Open-addressed table of the chunk-sized regions holding blocks on whole-number
+     * cells. Filled regions are looked up through a grid instead of the block index.
+     */
+    __LevelTile2D** tiles;
+
+    /**
+     * The number of regions in the tile table.
+     */
+    int tileCount;
+
+    /**
+     * The capacity of the tile table. Always zero or a power of two.
+     */
+    int tileCapacity;
+
+    /**
+     * The edit journal mutations are appended to, or 0 if journaling is off.
+     */
+    FILE* journal;
+
+    /**
+     * The chunks of the level, kept up to date on every edit so that queries
+     * can read them without building them first.
+     */
+    LevelChunkMap2D chunks;
+
+    /**
+     * The latest snapshot taken of the level, or 0 if none was taken.
+     */
+    LevelSnapshot2D* snapshot;
+
+    /**
+     * The content hash of the headers and blocks of the level, kept up to date on every edit.
+     */
+    LevelHash hash;
+
     /**
      * The spawnpoint of the level.
      */
@@ -124,6 +402,20 @@ Level2D* createLevel2D(Coordinate2D* spawn) {
     Level2D* l = (Level2D*) malloc(sizeof(Level2D));
     l->headers = 0;
     l->blocks = 0;
+    l->blockCount = 0;
+    l->blockCapacity = 0;
+    l->blockIndex = 0;
+    l->blockIndexCapacity = 0;
+    l->tiles = 0;
+    l->tileCount = 0;
+    l->tileCapacity = 0;
+    l->journal = 0;
+    l->chunks.chunks = 0;
+    l->chunks.count = 0;
+    l->chunks.capacity = 0;
+    l->snapshot = 0;
+    l->hash.low = 0;
+    l->hash.high = 0;
     l->spawn = spawn;
 
     return l;
@@ -154,19 +446,19 @@ int Level2D_getHeaderCount(Level2D* level) {
 }
 
 /**
- * Gets a header from a Level2D.
+ * Gets a header from a Level2D by the interned ID of its name.
  * @param level The Level2D.
- * @param name The name of the header.
+ * @param id The interned ID of the header name.
  * @return The value of the header.
  */
-char* Level2D_getHeader(Level2D* level, char* name) {
+char* Level2D_getHeaderById(Level2D* level, int id) {
     if (level == 0) return 0;
-    if (name == 0) return 0;
+    if (id == 0) return 0;
     if (level->headers == 0) return 0;
 
     int i = 0;
     while (level->headers[i] != 0) {
-        if (strcmp(level->headers[i]->name, name) == 0) {
+        if (level->headers[i]->nameId == id) {
             return level->headers[i]->value;
         }
         i++;
@@ -175,6 +467,38 @@ char* Level2D_getHeader(Level2D* level, char* name) {
     return 0;
 }
 
+/**
+ * Gets a header from a Level2D.
+ * @param level The Level2D.
+ * @param name The name of the header.
+ * @return The value of the header.
+ */
+char* Level2D_getHeader(Level2D* level, char* name) {
+    if (level == 0) return 0;
+    if (name == 0) return 0;
+    if (level->headers == 0) return 0;
+
+    return Level2D_getHeaderById(level, getInternedId(name));
+}
+
+/**
+ * Gets the scroll direction of a Level2D from its `scroll` header, which is one
+ * of `none`, `horizontal-left`, `horizontal-right`, `vertical-up` or `vertical-down`.
+ * @param level The Level2D.
+ * @return The scroll direction, or NONE if the header is missing or unknown.
+ */
+enum Scroll Level2D_getScroll(Level2D* level) {
+    char* value = Level2D_getHeader(level, "scroll");
+    if (value == 0) return NONE;
+
+    if (strcmp(value, "horizontal-left") == 0) return HORIZONTAL_LEFT;
+    if (strcmp(value, "horizontal-right") == 0) return HORIZONTAL_RIGHT;
+    if (strcmp(value, "vertical-up") == 0) return VERTICAL_UP;
+    if (strcmp(value, "vertical-down") == 0) return VERTICAL_DOWN;
+
+    return NONE;
+}
+
 /**
  * Adds a header to a Level2D.
  * @param level Level to add the header to.
@@ -184,6 +508,14 @@ void Level2D_setHeader(Level2D* level, LevelHeader* h) {
     if (level == 0) return;
     if (h == 0) return;
 
+    if (level->journal != 0) {
+        fprintf(level->journal, "@%s %s\n", h->name, h->value);
+        fflush(level->journal);
+    }
+
+    __LevelHash_header(&level->hash, h->name, h->value, 1);
+    h->nameId = internStringId(h->name);
+
     if (level->headers == 0) {
         level->headers = (LevelHeader**) malloc(2 * sizeof(LevelHeader*));
         level->headers[0] = h;
@@ -192,15 +524,16 @@ void Level2D_setHeader(Level2D* level, LevelHeader* h) {
         int headerCount = Level2D_getHeaderCount(level);
         for (int i = 0; i < headerCount; i++) {
             LevelHeader* header = level->headers[i];
-            if (strcmp(header->name, h->name) == 0) {
+            if (header->nameId == h->nameId) {
+                __LevelHash_header(&level->hash, header->name, header->value, -1);
                 header->value = h->value;
                 return;
-            } else {
-                level->headers = (LevelHeader**) realloc(level->headers, (headerCount + 2) * sizeof(LevelHeader*));
-                level->headers[headerCount] = h;
-                level->headers[headerCount + 1] = 0;
             }
         }
+
+        level->headers = (LevelHeader**) realloc(level->headers, (headerCount + 2) * sizeof(LevelHeader*));
+        level->headers[headerCount] = h;
+        level->headers[headerCount + 1] = 0;
     }
 }
 
@@ -232,168 +565,785 @@ void Level2D_removeHeader(Level2D* level, char* name) {
     if (name == 0) return;
     if (level->headers == 0) return;
 
-    int i = 0;
-    while (level->headers[i] != 0) {
-        if (strcmp(level->headers[i]->name, name) == 0) {
+    int id = getInternedId(name);
+    if (id == 0) return;
+
+    int headerCount = Level2D_getHeaderCount(level);
+    for (int i = 0; i < headerCount; i++) {
+        if (level->headers[i]->nameId == id) {
+            if (level->journal != 0) {
+                fprintf(level->journal, "-@%s\n", name);
+                fflush(level->journal);
+            }
+
+            __LevelHash_header(&level->hash, level->headers[i]->name, level->headers[i]->value, -1);
             free(level->headers[i]);
-            
-            for (int j = i; j < sizeof(level->headers) - 1; j++) {
+
+            for (int j = i; j < headerCount; j++) {
                 level->headers[j] = level->headers[j + 1];
             }
-            level->headers[sizeof(level->headers) - 1] = 0;
             return;
         }
-        i++;
     }
 }
 
-/**
- * Gets the number of blocks in a Level2D.
- * @param level The Level2D.
- * @return The number of blocks in the Level2D.
- */
-int Level2D_getBlockCount(Level2D* level) {
-    if (level == 0) return 0;
-    
-    if (level->blocks == 0) {
-        level->blocks = (LevelObject2D**) malloc(2 * sizeof(LevelObject2D*));
-        level->blocks[0] = 0;
-        return 0;
-    }
+// Internal
 
-    int blockCount = 0;
-    while (level->blocks[blockCount] != 0) {
-        blockCount++;
-    }
+void __Level2D_journalBlock(Level2D* level, LevelObject2D* block, int removed) {
+    Coordinate2D* c = block->coordinate;
+    char x[32];
+    char y[32];
+    __formatDouble(x, sizeof(x), c->x);
+    __formatDouble(y, sizeof(y), c->y);
+
+    if (removed) {
+        fprintf(level->journal, "-[%s, %s]\n", x, y);
+    } else {
+        // most blocks fit on the stack, so journaling does not allocate
+        char buffer[256];
+        int length = Block_toBuffer(block->block, buffer, sizeof(buffer));
+        char* str = length < (int) sizeof(buffer) ? buffer : Block_toString(block->block);
+
+        // a null block has no text form to record
+        if (length < 0 || str == 0) return;
 
-    return blockCount;
+        fprintf(level->journal, "+%s: [%s, %s]\n", str, x, y);
+        if (str != buffer) free(str);
+    }
 }
 
-/**
- * Gets a block from a Level2D.
- * @param level The Level2D.
- * @param coordinate The coordinate of the block.
- * @return The block at the coordinate, or 0 if no block is found.
- */
-Block* Level2D_getBlock(Level2D* level, Coordinate2D* coordinate) {
-    if (level == 0) return 0;
-    if (coordinate == 0) return 0;
-    if (level->blocks == 0) return 0;
+__LevelTile2D* __Level2D_getTile(Level2D* level, int x, int y) {
+    if (level->tileCapacity == 0) return 0;
 
-    int i = 0;
-    while (level->blocks[i] != 0) {
-        if (level->blocks[i]->coordinate->x == coordinate->x && level->blocks[i]->coordinate->y == coordinate->y) {
-            return level->blocks[i]->block;
-        }
-        i++;
+    int mask = level->tileCapacity - 1;
+    int i = (int) (__hashChunk2D(x, y) & mask);
+    while (level->tiles[i] != 0) {
+        if (level->tiles[i]->x == x && level->tiles[i]->y == y) return level->tiles[i];
+
+        i = (i + 1) & mask;
     }
 
     return 0;
 }
 
-/**
- * Adds a block to a Level2D.
- * @param level The Level2D.
- * @param block The block to add.
- */
-void Level2D_addBlock(Level2D* level, LevelObject2D* block) {
-    if (level == 0) return;
-    if (block == 0) return;
+void __Level2D_putTile(Level2D* level, __LevelTile2D* tile) {
+    int mask = level->tileCapacity - 1;
+    int i = (int) (__hashChunk2D(tile->x, tile->y) & mask);
+    while (level->tiles[i] != 0) i = (i + 1) & mask;
 
-    if (level->blocks == 0) {
-        level->blocks = (LevelObject2D**) malloc(16 * sizeof(LevelObject2D*));
-        level->blocks[0] = block;
-        level->blocks[1] = 0;
-    } else {
-        int size = Level2D_getBlockCount(level);
-        for (int i = 0; i < size; i++) {
-            Coordinate2D* c = level->blocks[i]->coordinate;
-            if (c->x == block->coordinate->x && c->y == block->coordinate->y) {
-                level->blocks[i] = block;
-                return;
-            }
+    level->tiles[i] = tile;
+}
+
+__LevelTile2D* __Level2D_getOrCreateTile(Level2D* level, int x, int y) {
+    __LevelTile2D* tile = __Level2D_getTile(level, x, y);
+    if (tile != 0) return tile;
+
+    if (2 * (level->tileCount + 1) > level->tileCapacity) {
+        __LevelTile2D** old = level->tiles;
+        int oldCapacity = level->tileCapacity;
+
+        level->tileCapacity = oldCapacity == 0 ? 16 : 2 * oldCapacity;
+        level->tiles = (__LevelTile2D**) calloc(level->tileCapacity, sizeof(__LevelTile2D*));
+        for (int i = 0; i < oldCapacity; i++) {
+            if (old[i] != 0) __Level2D_putTile(level, old[i]);
         }
 
-        level->blocks = (LevelObject2D**) realloc(level->blocks, (size + 2) * sizeof(LevelObject2D*));
-        level->blocks[size] = block;
-        level->blocks[size + 1] = 0;
+        free(old);
     }
+
+    tile = (__LevelTile2D*) malloc(sizeof(__LevelTile2D));
+    tile->x = x;
+    tile->y = y;
+    tile->count = 0;
+    tile->cells = 0;
+
+    __Level2D_putTile(level, tile);
+    level->tileCount++;
+
+    return tile;
 }
 
-/**
- * Adds a block to a Level2D on a matrix of coordinates.
- * @param level The Level2D.
- * @param block The block to add.
- * @param matrix The matrix of coordinates to add the block to.
- */
-void Level2D_addMatrix(Level2D* level, Block* block, CoordinateMatrix2D* matrix) {
-    int size = CoordinateMatrix2D_size(matrix);
-    Coordinate2D** coordinates = CoordinateMatrix2D_coordinates(matrix);
+// Gets the dense region indexing a coordinate, or 0 if the coordinate is in the block index.
+__LevelTile2D* __Level2D_denseTile(Level2D* level, double x, double y) {
+    if (level->tileCount == 0) return 0;
+    if (!__isCell(x) || !__isCell(y)) return 0;
+
+    __LevelTile2D* tile = __Level2D_getTile(level, __chunkOf(x), __chunkOf(y));
+    return tile != 0 && tile->cells != 0 ? tile : 0;
+}
+
+int __Level2D_findHashed(Level2D* level, double x, double y) {
+    if (level->blockIndex == 0) return -1;
+
+    int mask = level->blockIndexCapacity - 1;
+    int i = (int) (Coordinate2D_hash(x, y) & mask);
+    while (level->blockIndex[i] != 0) {
+        int position = level->blockIndex[i] - 1;
+        Coordinate2D* c = level->blocks[position]->coordinate;
+        if (c->x == x && c->y == y) return position;
 
-    for (int i = 0; i < size; i++) {
-        Coordinate2D* coordinate = coordinates[i];
-        Level2D_addBlock(level, createLevelObject2D(block, coordinate));
+        i = (i + 1) & mask;
     }
 
+    return -1;
 }
 
-/**
- * Removes a block from a Level2D.
- * @param level The Level2D.
- * @param block The block to remove.
- */
-void Level2D_removeBlock(Level2D* level, LevelObject2D* block) {
-    if (level->blocks == 0) return;
+void __Level2D_hashBlock(Level2D* level, int position) {
+    Coordinate2D* c = level->blocks[position]->coordinate;
 
-    int i = 0;
-    while (level->blocks[i] != 0) {
-        if (level->blocks[i] == block) {
-            free(level->blocks[i]);
-            
-            for (int j = i; j < sizeof(level->blocks) - 1; j++) {
-                level->blocks[j] = level->blocks[j + 1];
-            }
-            level->blocks[sizeof(level->blocks) - 1] = 0;
-            return;
-        }
-        i++;
-    }
+    int mask = level->blockIndexCapacity - 1;
+    int i = (int) (Coordinate2D_hash(c->x, c->y) & mask);
+    while (level->blockIndex[i] != 0) i = (i + 1) & mask;
+
+    level->blockIndex[i] = position + 1;
 }
 
-/**
- * Gets the number of blocks in a Level2D with a specific name.
- * @param level The Level2D.
- * @param name The name of the block.
- * @return The number of blocks in the Level2D with the name.
- */
-int Level2D_blockCount(Level2D* level, const char* name) {
-    if (level == 0) return 0;
-    if (level->blocks == 0) return 0;
-    if (name == 0) return 0;
+void __Level2D_unhashBlock(Level2D* level, int position) {
+    Coordinate2D* c = level->blocks[position]->coordinate;
 
-    int count = 0;
-    for (int i = 0; i < Level2D_getBlockCount(level); i++) {
-        if (strcmp(level->blocks[i]->block->name, name) == 0) {
-            count++;
+    int mask = level->blockIndexCapacity - 1;
+    int i = (int) (Coordinate2D_hash(c->x, c->y) & mask);
+    while (level->blockIndex[i] != position + 1) i = (i + 1) & mask;
+
+    // backward-shift deletion keeps probe sequences intact without tombstones
+    int j = i;
+    while (1) {
+        j = (j + 1) & mask;
+        if (level->blockIndex[j] == 0) break;
+
+        Coordinate2D* o = level->blocks[level->blockIndex[j] - 1]->coordinate;
+        int home = (int) (Coordinate2D_hash(o->x, o->y) & mask);
+        if ((j > i && (home <= i || home > j)) || (j < i && home <= i && home > j)) {
+            level->blockIndex[i] = level->blockIndex[j];
+            i = j;
         }
     }
 
-    return count;
+    level->blockIndex[i] = 0;
 }
 
-/**
- * Represents a 3D Level.
- */
-typedef struct Level3D {
-    /**
-     * The headers of the level.
-     */
-    LevelHeader** headers;
+// Moves the lookups of a region from the block index into a grid.
+void __Level2D_densify(Level2D* level, __LevelTile2D* tile) {
+    tile->cells = (int*) calloc(_LEVEL_CHUNK_SIZE * _LEVEL_CHUNK_SIZE, sizeof(int));
 
-    /**
-     * The blocks in the level.
-     */
-    LevelObject3D** blocks;
+    for (int key = 0; key < _LEVEL_CHUNK_SIZE * _LEVEL_CHUNK_SIZE; key++) {
+        double x = tile->x * _LEVEL_CHUNK_SIZE + (key & (_LEVEL_CHUNK_SIZE - 1));
+        double y = tile->y * _LEVEL_CHUNK_SIZE + (key >> 4);
+
+        int position = __Level2D_findHashed(level, x, y);
+        if (position < 0) continue;
+
+        __Level2D_unhashBlock(level, position);
+        tile->cells[key] = position + 1;
+    }
+}
+
+// Moves the lookups of a region from its grid back into the block index.
+void __Level2D_sparsify(Level2D* level, __LevelTile2D* tile) {
+    int* cells = tile->cells;
+    tile->cells = 0;
+
+    for (int key = 0; key < _LEVEL_CHUNK_SIZE * _LEVEL_CHUNK_SIZE; key++)
+        if (cells[key] != 0) __Level2D_hashBlock(level, cells[key] - 1);
+
+    free(cells);
+}
+
+int __Level2D_findBlock(Level2D* level, double x, double y) {
+    __LevelTile2D* tile = __Level2D_denseTile(level, x, y);
+    if (tile != 0) {
+        Coordinate2D c = makeCoordinate2D(x, y);
+        return tile->cells[__cellKey2D(&c)] - 1;
+    }
+
+    return __Level2D_findHashed(level, x, y);
+}
+
+void __Level2D_indexBlock(Level2D* level, int position) {
+    Coordinate2D* c = level->blocks[position]->coordinate;
+    if (!__isCell(c->x) || !__isCell(c->y)) {
+        __Level2D_hashBlock(level, position);
+        return;
+    }
+
+    __LevelTile2D* tile = __Level2D_getOrCreateTile(level, __chunkOf(c->x), __chunkOf(c->y));
+    tile->count++;
+    if (tile->cells != 0) {
+        tile->cells[__cellKey2D(c)] = position + 1;
+        return;
+    }
+
+    __Level2D_hashBlock(level, position);
+    if (tile->count >= _LEVEL_DENSE_FILL) __Level2D_densify(level, tile);
+}
+
+void __Level2D_unindexBlock(Level2D* level, int position) {
+    Coordinate2D* c = level->blocks[position]->coordinate;
+    if (!__isCell(c->x) || !__isCell(c->y)) {
+        __Level2D_unhashBlock(level, position);
+        return;
+    }
+
+    __LevelTile2D* tile = __Level2D_getTile(level, __chunkOf(c->x), __chunkOf(c->y));
+    tile->count--;
+    if (tile->cells == 0) {
+        __Level2D_unhashBlock(level, position);
+        return;
+    }
+
+    tile->cells[__cellKey2D(c)] = 0;
+    if (tile->count < _LEVEL_SPARSE_FILL) __Level2D_sparsify(level, tile);
+}
+
+// Moves a block to another position without counting it out of its region.
+void __Level2D_moveBlock(Level2D* level, int from, int to) {
+    Coordinate2D* c = level->blocks[from]->coordinate;
+    __LevelTile2D* tile = __Level2D_denseTile(level, c->x, c->y);
+    if (tile != 0) {
+        level->blocks[to] = level->blocks[from];
+        tile->cells[__cellKey2D(c)] = to + 1;
+        return;
+    }
+
+    __Level2D_unhashBlock(level, from);
+    level->blocks[to] = level->blocks[from];
+    __Level2D_hashBlock(level, to);
+}
+
+void __Level2D_rebuildIndex(Level2D* level, int capacity) {
+    free(level->blockIndex);
+    level->blockIndex = (int*) calloc(capacity, sizeof(int));
+    level->blockIndexCapacity = capacity;
+
+    // blocks in dense regions stay in their grids
+    for (int i = 0; i < level->blockCount; i++) {
+        Coordinate2D* c = level->blocks[i]->coordinate;
+        if (__Level2D_denseTile(level, c->x, c->y) == 0)
+            __Level2D_hashBlock(level, i);
+    }
+}
+
+// Implementation
+
+/**
+ * Gets the number of blocks in a Level2D.
+ * @param level The Level2D.
+ * @return The number of blocks in the Level2D.
+ */
+int Level2D_getBlockCount(Level2D* level) {
+    if (level == 0) return 0;
+
+    return level->blockCount;
+}
+
+/**
+ * Reserves space for at least a number of blocks in a Level2D, so that
+ * adding up to that many blocks does not reallocate.
+ * @param level The Level2D.
+ * @param capacity The number of blocks to reserve space for.
+ * @return 1 if the space is reserved, 0 if the capacity is over _LEVEL_BLOCKS_MAX_CAPACITY or could not be allocated.
+ */
+int Level2D_reserve(Level2D* level, int capacity) {
+    if (level == 0) return 0;
+    if (capacity < _LEVEL_BLOCKS_INIT_CAPACITY) capacity = _LEVEL_BLOCKS_INIT_CAPACITY;
+    if (capacity > _LEVEL_BLOCKS_MAX_CAPACITY) return 0;
+
+    // the index can grow to four times the capacity while rounding up to a power of two
+    if ((size_t) capacity + 1 > SIZE_MAX / sizeof(LevelObject2D*)) return 0;
+    if ((size_t) capacity > SIZE_MAX / (4 * sizeof(int))) return 0;
+
+    if (capacity + 1 > level->blockCapacity) {
+        LevelObject2D** blocks = (LevelObject2D**) realloc(level->blocks, (capacity + 1) * sizeof(LevelObject2D*));
+        if (blocks == 0) return 0;
+
+        level->blocks = blocks;
+        level->blockCapacity = capacity + 1;
+        level->blocks[level->blockCount] = 0;
+    }
+
+    // keep the index at most half full
+    int indexCapacity = level->blockIndexCapacity == 0 ? 2 * _LEVEL_BLOCKS_INIT_CAPACITY : level->blockIndexCapacity;
+    while (indexCapacity < 2 * capacity) indexCapacity *= 2;
+
+    if (indexCapacity != level->blockIndexCapacity)
+        __Level2D_rebuildIndex(level, indexCapacity);
+
+    return 1;
+}
+
+/**
+ * Gets a block from a Level2D.
+ * @param level The Level2D.
+ * @param coordinate The coordinate of the block.
+ * @return The block at the coordinate, or 0 if no block is found.
+ */
+Block* Level2D_getBlock(Level2D* level, Coordinate2D* coordinate) {
+    if (level == 0) return 0;
+    if (coordinate == 0) return 0;
+    if (level->blocks == 0) return 0;
+
+    int position = __Level2D_findBlock(level, coordinate->x, coordinate->y);
+    if (position < 0) return 0;
+
+    return level->blocks[position]->block;
+}
+
+/**
+ * Checks whether any block lies in the whole-number cell containing a coordinate of a
+ * Level2D. For levels on whole-number coordinates, this matches Level2D_getBlock != 0.
+ * @param level The Level2D.
+ * @param coordinate The coordinate.
+ * @return 1 if the cell is occupied, 0 otherwise.
+ */
+int Level2D_isOccupied(Level2D* level, Coordinate2D* coordinate) {
+    if (level == 0) return 0;
+    if (coordinate == 0) return 0;
+
+    if (!__inChunkRange(coordinate->x) || !__inChunkRange(coordinate->y))
+        return __Level2D_findBlock(level, coordinate->x, coordinate->y) >= 0;
+
+    LevelChunk2D* chunk = LevelChunkMap2D_get(&level->chunks, __chunkOf(coordinate->x), __chunkOf(coordinate->y));
+    if (chunk == 0 || chunk->filled == 0) return 0;
+
+    int key = __cellKey2D(coordinate);
+    return (chunk->occupancy[key >> 6] >> (key & 63)) & 1;
+}
+
+/**
+ * Counts the occupied cells of a Level2D inside a region. Chunks entirely inside the
+ * region are counted in constant time, and empty chunks are skipped.
+ * @param level The Level2D.
+ * @param region The region, including its start offset.
+ * @return The number of occupied whole-number cells in the region.
+ */
+int Level2D_countOccupied(Level2D* level, CoordinateMatrix2D* region) {
+    if (level == 0) return 0;
+    if (region == 0) return 0;
+
+    double min[2] = {region->minX + region->start->x, region->minY + region->start->y};
+    double max[2] = {region->maxX + region->start->x, region->maxY + region->start->y};
+    if (!(min[0] <= max[0]) || !(min[1] <= max[1])) return 0;
+
+    int lo[2] = {__cellFloor(min[0]), __cellFloor(min[1])};
+    int hi[2] = {__cellFloor(max[0]), __cellFloor(max[1])};
+
+    int cx0 = __chunkOf(lo[0]), cx1 = __chunkOf(hi[0]);
+    int cy0 = __chunkOf(lo[1]), cy1 = __chunkOf(hi[1]);
+
+    // walk whichever is smaller, the chunks of the region or the chunks of the level
+    int count = 0;
+    if ((int64_t) (cx1 - cx0 + 1) * (cy1 - cy0 + 1) <= level->chunks.count) {
+        for (int cx = cx0; cx <= cx1; cx++)
+            for (int cy = cy0; cy <= cy1; cy++)
+                count += __LevelChunk2D_count(LevelChunkMap2D_get(&level->chunks, cx, cy), lo, hi);
+    } else {
+        for (int i = 0; i < level->chunks.capacity; i++) {
+            LevelChunk2D* chunk = level->chunks.chunks[i];
+            if (chunk == 0) continue;
+            if (chunk->x < cx0 || chunk->x > cx1 || chunk->y < cy0 || chunk->y > cy1) continue;
+
+            count += __LevelChunk2D_count(chunk, lo, hi);
+        }
+    }
+
+    return count;
+}
+
+/**
+ * Adds a block to a Level2D. A block already at the same coordinate is replaced.
+ * New blocks are ignored once the level holds _LEVEL_BLOCKS_MAX_CAPACITY blocks.
+ * @param level The Level2D.
+ * @param block The block to add.
+ */
+void Level2D_addBlock(Level2D* level, LevelObject2D* block) {
+    if (level == 0) return;
+    if (block == 0) return;
+
+    if (level->journal != 0) {
+        __Level2D_journalBlock(level, block, 0);
+        fflush(level->journal);
+    }
+
+    int position = __Level2D_findBlock(level, block->coordinate->x, block->coordinate->y);
+    if (position >= 0) {
+        __LevelChunk2D_replace(LevelChunkMap2D_chunkAt(&level->chunks, block->coordinate), level->blocks[position], block);
+
+        __LevelHash_block2D(&level->hash, level->blocks[position], -1);
+        __LevelHash_block2D(&level->hash, block, 1);
+        level->blocks[position] = block;
+        return;
+    }
+
+    if (level->blockCount + 1 >= level->blockCapacity) {
+        int capacity = level->blockCount < _LEVEL_BLOCKS_MAX_CAPACITY / 2 ? 2 * level->blockCount : _LEVEL_BLOCKS_MAX_CAPACITY;
+        Level2D_reserve(level, capacity);
+        if (level->blockCount + 1 >= level->blockCapacity) return;
+    }
+
+    __LevelChunk2D_add(LevelChunkMap2D_chunkAt(&level->chunks, block->coordinate), block);
+
+    __LevelHash_block2D(&level->hash, block, 1);
+    level->blocks[level->blockCount] = block;
+    __Level2D_indexBlock(level, level->blockCount);
+    level->blockCount++;
+    level->blocks[level->blockCount] = 0;
+}
+
+/**
+ * Adds multiple blocks to a Level2D in a single pass. Blocks sharing a coordinate,
+ * either with the level or with each other, replace the earlier block. Batches
+ * that could take the level past _LEVEL_BLOCKS_MAX_CAPACITY blocks are ignored.
+ * @param level The Level2D.
+ * @param blocks The blocks to add.
+ * @param count The number of blocks to add.
+ */
+void Level2D_addBlocks(Level2D* level, LevelObject2D** blocks, int count) {
+    if (level == 0) return;
+    if (blocks == 0) return;
+    if (count <= 0) return;
+    if (count > _LEVEL_BLOCKS_MAX_CAPACITY - level->blockCount) return;
+
+    if (level->blockCount + count >= level->blockCapacity) {
+        int capacity = level->blockCount < _LEVEL_BLOCKS_MAX_CAPACITY / 2 ? 2 * level->blockCount : _LEVEL_BLOCKS_MAX_CAPACITY;
+        if (capacity < level->blockCount + count) capacity = level->blockCount + count;
+
+        if (!Level2D_reserve(level, capacity)) return;
+    }
+
+    for (int i = 0; i < count; i++) {
+        LevelObject2D* block = blocks[i];
+        if (block == 0) continue;
+
+        if (level->journal != 0)
+            __Level2D_journalBlock(level, block, 0);
+
+        int position = __Level2D_findBlock(level, block->coordinate->x, block->coordinate->y);
+        if (position >= 0) {
+            __LevelChunk2D_replace(LevelChunkMap2D_chunkAt(&level->chunks, block->coordinate), level->blocks[position], block);
+
+            __LevelHash_block2D(&level->hash, level->blocks[position], -1);
+            __LevelHash_block2D(&level->hash, block, 1);
+            level->blocks[position] = block;
+            continue;
+        }
+
+        __LevelChunk2D_add(LevelChunkMap2D_chunkAt(&level->chunks, block->coordinate), block);
+
+        __LevelHash_block2D(&level->hash, block, 1);
+
+        level->blocks[level->blockCount] = block;
+        __Level2D_indexBlock(level, level->blockCount);
+        level->blockCount++;
+    }
+
+    level->blocks[level->blockCount] = 0;
+
+    if (level->journal != 0)
+        fflush(level->journal);
+}
+
+/**
+ * Adds a block to a Level2D on a matrix of coordinates. Matrices with more cells
+ * than fit in an int are ignored.
+ * @param level The Level2D.
+ * @param block The block to add.
+ * @param matrix The matrix of coordinates to add the block to.
+ */
+void Level2D_addMatrix(Level2D* level, Block* block, CoordinateMatrix2D* matrix) {
+    if (level == 0) return;
+    if (block == 0) return;
+    if (matrix == 0) return;
+
+    int size = CoordinateMatrix2D_size(matrix);
+    if (size <= 0) return;
+
+    LevelObject2D** blocks = (LevelObject2D**) malloc(size * sizeof(LevelObject2D*));
+    CoordinateMatrix2DCursor cursor = CoordinateMatrix2D_cursor(matrix, COORDINATE_MATRIX_ROW_MAJOR);
+    for (int i = 0; CoordinateMatrix2DCursor_next(&cursor); i++)
+        blocks[i] = createLevelObject2DAt(block, cursor.coordinate);
+
+    Level2D_addBlocks(level, blocks, size);
+
+    free(blocks);
+}
+
+/**
+ * Removes a block from a Level2D. The last block in the level takes its place.
+ * @param level The Level2D.
+ * @param block The block to remove.
+ */
+void Level2D_removeBlock(Level2D* level, LevelObject2D* block) {
+    if (level == 0) return;
+    if (block == 0) return;
+    if (level->blocks == 0) return;
+
+    int position = __Level2D_findBlock(level, block->coordinate->x, block->coordinate->y);
+    if (position < 0 || level->blocks[position] != block) return;
+
+    if (level->journal != 0) {
+        __Level2D_journalBlock(level, block, 1);
+        fflush(level->journal);
+    }
+
+    __LevelHash_block2D(&level->hash, block, -1);
+
+    int last = level->blockCount - 1;
+    __Level2D_unindexBlock(level, position);
+    if (position != last) __Level2D_moveBlock(level, last, position);
+
+    level->blockCount--;
+    level->blocks[level->blockCount] = 0;
+
+    __LevelChunk2D_remove(LevelChunkMap2D_chunkAt(&level->chunks, block->coordinate), block);
+
+    // older snapshots may still be reading the block
+    if (level->snapshot != 0 && __atomicLoad(&level->snapshot->refs) > 1)
+        __LevelSnapshot2D_retire(level->snapshot, block);
+    else
+        free(block);
+}
+
+/**
+ * Gets the number of blocks in a Level2D with the interned ID of a name.
+ * @param level The Level2D.
+ * @param id The interned ID of the block name.
+ * @return The number of blocks in the Level2D with the name.
+ */
+int Level2D_blockCountById(Level2D* level, int id) {
+    if (level == 0) return 0;
+    if (level->blocks == 0) return 0;
+    if (id == 0) return 0;
+
+    int count = 0;
+    int blockCount = Level2D_getBlockCount(level);
+    for (int i = 0; i < blockCount; i++) {
+        if (level->blocks[i]->block->nameId == id) {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+/**
+ * Gets the number of blocks in a Level2D with a specific name.
+ * @param level The Level2D.
+ * @param name The name of the block.
+ * @return The number of blocks in the Level2D with the name.
+ */
+int Level2D_blockCount(Level2D* level, const char* name) {
+    if (level == 0) return 0;
+    if (level->blocks == 0) return 0;
+    if (name == 0) return 0;
+
+    return Level2D_blockCountById(level, getInternedId(name));
+}
+
+/**
+ * Gets the content hash of a Level2D. The hash covers the headers and blocks
+ * of the level, does not depend on the order they were added in, and is kept up
+ * to date in constant time by every edit made through the Level2D functions.
+ * Blocks must not be modified in place after they are added to the level.
+ * @param level The Level2D.
+ * @return The hash of the level, or a zero hash if the level is null.
+ */
+LevelHash Level2D_hash(Level2D* level) {
+    if (level == 0) {
+        LevelHash empty = {0, 0};
+        return empty;
+    }
+
+    return level->hash;
+}
+
+/**
+ * Checks if two Level2Ds have the same headers and blocks by comparing their
+ * counts and content hashes. The check runs in constant time, and two levels with
+ * different contents compare equal only on a 128-bit hash collision.
+ * @param a The first Level2D.
+ * @param b The second Level2D.
+ * @return 1 if the levels are equal, 0 otherwise.
+ */
+int Level2D_equals(Level2D* a, Level2D* b) {
+    if (a == b) return 1;
+    if (a == 0 || b == 0) return 0;
+    if (a->blockCount != b->blockCount) return 0;
+    if (Level2D_getHeaderCount(a) != Level2D_getHeaderCount(b)) return 0;
+
+    return a->hash.low == b->hash.low && a->hash.high == b->hash.high;
+}
+
+/**
+ * Measures the memory used by a Level2D, broken down by category. Sizes are the
+ * requested sizes of the allocations, without allocator overhead. The journal and
+ * snapshots are not included.
+ * @param level The Level2D.
+ * @return The memory usage of the level.
+ */
+LevelMemoryUsage Level2D_memoryUsage(Level2D* level) {
+    LevelMemoryUsage usage;
+    memset(&usage, 0, sizeof(LevelMemoryUsage));
+    if (level == 0) return usage;
+
+    usage.cells = sizeof(Level2D) + level->blockCount * (sizeof(LevelObject2D) - sizeof(Coordinate2D) + sizeof(LevelObject2D*));
+    usage.coordinates = level->blockCount * sizeof(Coordinate2D);
+    if (level->spawn != 0) usage.coordinates += sizeof(Coordinate2D);
+
+    if (level->blockCapacity > 0)
+        usage.slack += (level->blockCapacity - level->blockCount) * sizeof(LevelObject2D*);
+
+    Block** blocks = (Block**) malloc((level->blockCount + 1) * sizeof(Block*));
+    for (int i = 0; i < level->blockCount; i++) {
+        blocks[i] = level->blocks[i]->block;
+
+        // objects that point to a separate coordinate leave their embedded one unused
+        if (level->blocks[i]->coordinate != &level->blocks[i]->position)
+            usage.slack += sizeof(Coordinate2D);
+    }
+
+    __LevelMemoryUsage_blocks(&usage, blocks, level->blockCount);
+    free(blocks);
+
+    __LevelMemoryUsage_headers(&usage, level->headers, Level2D_getHeaderCount(level));
+
+    usage.indexes = level->blockIndexCapacity * sizeof(int) + level->tileCapacity * sizeof(__LevelTile2D*);
+    for (int i = 0; i < level->tileCapacity; i++) {
+        __LevelTile2D* tile = level->tiles[i];
+        if (tile == 0) continue;
+
+        usage.indexes += sizeof(__LevelTile2D);
+        if (tile->cells != 0) usage.indexes += _LEVEL_CHUNK_SIZE * _LEVEL_CHUNK_SIZE * sizeof(int);
+    }
+
+    if (level->chunks.capacity != 0) {
+        usage.indexes += level->chunks.capacity * sizeof(LevelChunk2D*);
+        for (int i = 0; i < level->chunks.capacity; i++) {
+            LevelChunk2D* chunk = level->chunks.chunks[i];
+            if (chunk == 0) continue;
+
+            usage.indexes += sizeof(LevelChunk2D) + chunk->count * sizeof(LevelObject2D*);
+            usage.slack += (chunk->capacity - chunk->count) * sizeof(LevelObject2D*);
+        }
+    }
+
+    __LevelMemoryUsage_total(&usage);
+    return usage;
+}
+
+/**
+ * Takes an immutable snapshot of a Level2D. Taking a snapshot only copies the
+ * chunks that changed since the previous one, and the snapshot can be read from
+ * other threads without locking while this thread keeps editing the level.
+ * The caller owns a reference and must release it with LevelSnapshot2D_release.
+ * @param level The Level2D.
+ * @return A new snapshot of the level.
+ */
+LevelSnapshot2D* Level2D_snapshot(Level2D* level) {
+    if (level == 0) return 0;
+
+    int headerCount = Level2D_getHeaderCount(level);
+    LevelSnapshot2D* snapshot = __LevelSnapshot2D_create(headerCount, level->chunks.count);
+    for (int i = 0; i < headerCount; i++) {
+        snapshot->headerNames[i] = level->headers[i]->name;
+        snapshot->headerValues[i] = level->headers[i]->value;
+    }
+
+    if (level->spawn != 0) {
+        snapshot->spawn = (Coordinate2D*) malloc(sizeof(Coordinate2D));
+        *snapshot->spawn = *level->spawn;
+    }
+
+    snapshot->blockCount = level->blockCount;
+    int chunked = 0;
+    for (int i = 0; i < level->chunks.capacity; i++) {
+        LevelChunk2D* chunk = level->chunks.chunks[i];
+        if (chunk == 0 || chunk->count == 0) continue;
+
+        if (chunk->snapshot == 0)
+            chunk->snapshot = __LevelChunkSnapshot2D_create(chunk);
+
+        __atomicIncrement(&chunk->snapshot->refs);
+        __LevelSnapshot2D_putChunk(snapshot, chunk->snapshot);
+        chunked += chunk->count;
+    }
+
+    // blocks too far out for a chunk are only found by walking the level
+    if (chunked < level->blockCount) {
+        snapshot->outlying = (LevelObject2D**) malloc((level->blockCount - chunked) * sizeof(LevelObject2D*));
+        for (int i = 0; i < level->blockCount; i++) {
+            Coordinate2D* c = level->blocks[i]->coordinate;
+            if (!__inChunkRange(c->x) || !__inChunkRange(c->y))
+                snapshot->outlying[snapshot->outlyingCount++] = level->blocks[i];
+        }
+    }
+
+    // one reference for the caller, one for the level
+    snapshot->refs = 2;
+    if (level->snapshot != 0) {
+        level->snapshot->next = snapshot;
+        __atomicIncrement(&snapshot->refs);
+        LevelSnapshot2D_release(level->snapshot);
+    }
+
+    level->snapshot = snapshot;
+    return snapshot;
+}
+
+/**
+ * Represents a 3D Level.
+ */
+typedef struct Level3D {
+    /**
+     * The headers of the level.
+     */
+    LevelHeader** headers;
+
+    /**
+     * The blocks in the level.
+     */
+    LevelObject3D** blocks;
+
+    /**
+     * The number of blocks in the level.
+     */
+    int blockCount;
+
+    /**
+     * The capacity of the blocks array, including its terminating slot.
+     */
+    int blockCapacity;
+
+    /**
+     * Open-addressed index of block positions keyed by coordinate.
+     * Each entry is a position in the blocks array plus one, or 0 if empty.
+     */
+    int* blockIndex;
+
+    /**
+     * The capacity of the block index. Always zero or a power of two.
+     */
+    int blockIndexCapacity;
+
+    /**
+     * The edit journal mutations are appended to, or 0 if journaling is off.
+     */
+    FILE* journal;
+
+    /**
+     * The chunks of the level, kept up to date on every edit so that queries
+     * can read them without building them first.
+     */
+    LevelChunkMap3D chunks;
+
+    /**
+     * The latest snapshot taken of the level, or 0 if none was taken.
+     */
+    LevelSnapshot3D* snapshot;
+
+    /**
+     * The content hash of the headers and blocks of the level, kept up to date on every edit.
+     */
+    LevelHash hash;
 
     /**
      * The spawnpoint of the level.
@@ -410,6 +1360,17 @@ Level3D* createLevel3D(Coordinate3D* spawn) {
     Level3D* l = (Level3D*) malloc(sizeof(Level3D));
     l->headers = 0;
     l->blocks = 0;
+    l->blockCount = 0;
+    l->blockCapacity = 0;
+    l->blockIndex = 0;
+    l->blockIndexCapacity = 0;
+    l->journal = 0;
+    l->chunks.chunks = 0;
+    l->chunks.count = 0;
+    l->chunks.capacity = 0;
+    l->snapshot = 0;
+    l->hash.low = 0;
+    l->hash.high = 0;
     l->spawn = spawn;
 
     return l;
@@ -440,19 +1401,19 @@ int Level3D_getHeaderCount(Level3D* level) {
 }
 
 /**
- * Gets a header from a Level3D.
+ * Gets a header from a Level3D by the interned ID of its name.
  * @param level The Level3D.
- * @param name The name of the header.
+ * @param id The interned ID of the header name.
  * @return The value of the header.
  */
-char* Level3D_getHeader(Level3D* level, char* name) {
+char* Level3D_getHeaderById(Level3D* level, int id) {
     if (level == 0) return 0;
-    if (name == 0) return 0;
+    if (id == 0) return 0;
     if (level->headers == 0) return 0;
 
     int i = 0;
     while (level->headers[i] != 0) {
-        if (strcmp(level->headers[i]->name, name) == 0) {
+        if (level->headers[i]->nameId == id) {
             return level->headers[i]->value;
         }
         i++;
@@ -461,6 +1422,20 @@ char* Level3D_getHeader(Level3D* level, char* name) {
     return 0;
 }
 
+/**
+ * Gets a header from a Level3D.
+ * @param level The Level3D.
+ * @param name The name of the header.
+ * @return The value of the header.
+ */
+char* Level3D_getHeader(Level3D* level, char* name) {
+    if (level == 0) return 0;
+    if (name == 0) return 0;
+    if (level->headers == 0) return 0;
+
+    return Level3D_getHeaderById(level, getInternedId(name));
+}
+
 /**
  * Adds a header to a Level3D.
  * @param level Level to add the header to.
@@ -470,6 +1445,14 @@ void Level3D_setHeader(Level3D* level, LevelHeader* h) {
     if (level == 0) return;
     if (h == 0) return;
 
+    if (level->journal != 0) {
+        fprintf(level->journal, "@%s %s\n", h->name, h->value);
+        fflush(level->journal);
+    }
+
+    __LevelHash_header(&level->hash, h->name, h->value, 1);
+    h->nameId = internStringId(h->name);
+
     if (level->headers == 0) {
         level->headers = (LevelHeader**) malloc(2 * sizeof(LevelHeader*));
         level->headers[0] = h;
@@ -478,15 +1461,16 @@ void Level3D_setHeader(Level3D* level, LevelHeader* h) {
         int headerCount = Level3D_getHeaderCount(level);
         for (int i = 0; i < headerCount; i++) {
             LevelHeader* header = level->headers[i];
-            if (strcmp(header->name, h->name) == 0) {
+            if (header->nameId == h->nameId) {
+                __LevelHash_header(&level->hash, header->name, header->value, -1);
                 header->value = h->value;
                 return;
-            } else {
-                level->headers = (LevelHeader**) realloc(level->headers, (headerCount + 1) * sizeof(LevelHeader*));
-                level->headers[headerCount] = h;
-                level->headers[headerCount + 1] = 0;
             }
         }
+
+        level->headers = (LevelHeader**) realloc(level->headers, (headerCount + 2) * sizeof(LevelHeader*));
+        level->headers[headerCount] = h;
+        level->headers[headerCount + 1] = 0;
     }
 }
 
@@ -518,21 +1502,162 @@ void Level3D_removeHeader(Level3D* level, char* name) {
     if (name == 0) return;
     if (level->headers == 0) return;
 
-    int i = 0;
-    while (level->headers[i] != 0) {
-        if (strcmp(level->headers[i]->name, name) == 0) {
+    int id = getInternedId(name);
+    if (id == 0) return;
+
+    int headerCount = Level3D_getHeaderCount(level);
+    for (int i = 0; i < headerCount; i++) {
+        if (level->headers[i]->nameId == id) {
+            if (level->journal != 0) {
+                fprintf(level->journal, "-@%s\n", name);
+                fflush(level->journal);
+            }
+
+            __LevelHash_header(&level->hash, level->headers[i]->name, level->headers[i]->value, -1);
             free(level->headers[i]);
-            
-            for (int j = i; j < sizeof(level->headers) - 1; j++) {
+
+            for (int j = i; j < headerCount; j++) {
                 level->headers[j] = level->headers[j + 1];
             }
-            level->headers[sizeof(level->headers) - 1] = 0;
             return;
         }
-        i++;
     }
 }
 
+// Internal
+
+void __Level3D_journalBlock(Level3D* level, LevelObject3D* block, int removed) {
+    Coordinate3D* c = block->coordinate;
+    char x[32];
+    char y[32];
+    char z[32];
+    __formatDouble(x, sizeof(x), c->x);
+    __formatDouble(y, sizeof(y), c->y);
+    __formatDouble(z, sizeof(z), c->z);
+
+    if (removed) {
+        fprintf(level->journal, "-[%s, %s, %s]\n", x, y, z);
+    } else {
+        // most blocks fit on the stack, so journaling does not allocate
+        char buffer[256];
+        int length = Block_toBuffer(block->block, buffer, sizeof(buffer));
+        char* str = length < (int) sizeof(buffer) ? buffer : Block_toString(block->block);
+
+        // a null block has no text form to record
+        if (length < 0 || str == 0) return;
+
+        fprintf(level->journal, "+%s: [%s, %s, %s]\n", str, x, y, z);
+        if (str != buffer) free(str);
+    }
+}
+
+int __Level3D_findBlock(Level3D* level, double x, double y, double z) {
+    if (level->blockIndex == 0) return -1;
+
+    int mask = level->blockIndexCapacity - 1;
+    int i = (int) (Coordinate3D_hash(x, y, z) & mask);
+    while (level->blockIndex[i] != 0) {
+        int position = level->blockIndex[i] - 1;
+        Coordinate3D* c = level->blocks[position]->coordinate;
+        if (c->x == x && c->y == y && c->z == z) return position;
+
+        i = (i + 1) & mask;
+    }
+
+    return -1;
+}
+
+void __Level3D_indexBlock(Level3D* level, int position) {
+    Coordinate3D* c = level->blocks[position]->coordinate;
+
+    int mask = level->blockIndexCapacity - 1;
+    int i = (int) (Coordinate3D_hash(c->x, c->y, c->z) & mask);
+    while (level->blockIndex[i] != 0) i = (i + 1) & mask;
+
+    level->blockIndex[i] = position + 1;
+}
+
+void __Level3D_unindexBlock(Level3D* level, int position) {
+    Coordinate3D* c = level->blocks[position]->coordinate;
+
+    int mask = level->blockIndexCapacity - 1;
+    int i = (int) (Coordinate3D_hash(c->x, c->y, c->z) & mask);
+    while (level->blockIndex[i] != position + 1) i = (i + 1) & mask;
+
+    // backward-shift deletion keeps probe sequences intact without tombstones
+    int j = i;
+    while (1) {
+        j = (j + 1) & mask;
+        if (level->blockIndex[j] == 0) break;
+
+        Coordinate3D* o = level->blocks[level->blockIndex[j] - 1]->coordinate;
+        int home = (int) (Coordinate3D_hash(o->x, o->y, o->z) & mask);
+        if ((j > i && (home <= i || home > j)) || (j < i && home <= i && home > j)) {
+            level->blockIndex[i] = level->blockIndex[j];
+            i = j;
+        }
+    }
+
+    level->blockIndex[i] = 0;
+}
+
+void __Level3D_rebuildIndex(Level3D* level, int capacity) {
+    free(level->blockIndex);
+    level->blockIndex = (int*) calloc(capacity, sizeof(int));
+    level->blockIndexCapacity = capacity;
+
+    for (int i = 0; i < level->blockCount; i++)
+        __Level3D_indexBlock(level, i);
+}
+
+// Implementation
+
+/**
+ * Gets the number of blocks in a Level3D.
+ * @param level The Level3D.
+ * @return The number of blocks in the Level3D.
+ */
+int Level3D_getBlockCount(Level3D* level) {
+    if (level == 0) return 0;
+
+    return level->blockCount;
+}
+
+/**
+ * Reserves space for at least a number of blocks in a Level3D, so that
+ * adding up to that many blocks does not reallocate.
+ * @param level The Level3D.
+ * @param capacity The number of blocks to reserve space for.
+ * @return 1 if the space is reserved, 0 if the capacity is over _LEVEL_BLOCKS_MAX_CAPACITY or could not be allocated.
+ */
+int Level3D_reserve(Level3D* level, int capacity) {
+    if (level == 0) return 0;
+    if (capacity < _LEVEL_BLOCKS_INIT_CAPACITY) capacity = _LEVEL_BLOCKS_INIT_CAPACITY;
+    if (capacity > _LEVEL_BLOCKS_MAX_CAPACITY) return 0;
+
+    // the index can grow to four times the capacity while rounding up to a power of two
+    if ((size_t) capacity + 1 > SIZE_MAX / sizeof(LevelObject3D*)) return 0;
+    if ((size_t) capacity > SIZE_MAX / (4 * sizeof(int))) return 0;
+
+    if (capacity + 1 > level->blockCapacity) {
+        LevelObject3D** blocks = (LevelObject3D**) realloc(level->blocks, (capacity + 1) * sizeof(LevelObject3D*));
+        if (blocks == 0) return 0;
+
+        level->blocks = blocks;
+        level->blockCapacity = capacity + 1;
+        level->blocks[level->blockCount] = 0;
+    }
+
+    // keep the index at most half full
+    int indexCapacity = level->blockIndexCapacity == 0 ? 2 * _LEVEL_BLOCKS_INIT_CAPACITY : level->blockIndexCapacity;
+    while (indexCapacity < 2 * capacity) indexCapacity *= 2;
+
+    if (indexCapacity != level->blockIndexCapacity)
+        __Level3D_rebuildIndex(level, indexCapacity);
+
+    return 1;
+}
+
 /**
  * Gets a block from a Level3D.
  * @param level The Level3D.
@@ -540,96 +1665,257 @@ void Level3D_removeHeader(Level3D* level, char* name) {
  * @return The block at the coordinate, or 0 if no block is found.
  */
 Block* Level3D_getBlock(Level3D* level, Coordinate3D* coordinate) {
+    if (level == 0) return 0;
+    if (coordinate == 0) return 0;
     if (level->blocks == 0) return 0;
 
-    int i = 0;
-    while (level->blocks[i] != 0) {
-        if (level->blocks[i]->coordinate->x == coordinate->x && level->blocks[i]->coordinate->y == coordinate->y && level->blocks[i]->coordinate->z == coordinate->z) {
-            return level->blocks[i]->block;
-        }
-        i++;
-    }
+    int position = __Level3D_findBlock(level, coordinate->x, coordinate->y, coordinate->z);
+    if (position < 0) return 0;
 
-    return 0;
+    return level->blocks[position]->block;
 }
 
 /**
- * Gets the number of blocks in a Level3D.
+ * Checks whether any block lies in the whole-number cell containing a coordinate of a
+ * Level3D. For levels on whole-number coordinates, this matches Level3D_getBlock != 0.
  * @param level The Level3D.
- * @return The number of blocks in the Level3D.
+ * @param coordinate The coordinate.
+ * @return 1 if the cell is occupied, 0 otherwise.
  */
-int Level3D_getBlockCount(Level3D* level) {
-    int blockCount = 0;
-    while (level->blocks[blockCount] != 0) {
-        blockCount++;
+int Level3D_isOccupied(Level3D* level, Coordinate3D* coordinate) {
+    if (level == 0) return 0;
+    if (coordinate == 0) return 0;
+
+    if (!__inChunkRange(coordinate->x) || !__inChunkRange(coordinate->y) || !__inChunkRange(coordinate->z))
+        return __Level3D_findBlock(level, coordinate->x, coordinate->y, coordinate->z) >= 0;
+
+    LevelChunk3D* chunk = LevelChunkMap3D_get(&level->chunks, __chunkOf(coordinate->x), __chunkOf(coordinate->y), __chunkOf(coordinate->z));
+    if (chunk == 0 || chunk->filled == 0) return 0;
+
+    int key = __cellKey3D(coordinate);
+    return (chunk->occupancy[key >> 6] >> (key & 63)) & 1;
+}
+
+/**
+ * Counts the occupied cells of a Level3D inside a region. Chunks entirely inside the
+ * region are counted in constant time, and empty chunks are skipped.
+ * @param level The Level3D.
+ * @param region The region, including its start offset.
+ * @return The number of occupied whole-number cells in the region.
+ */
+int Level3D_countOccupied(Level3D* level, CoordinateMatrix3D* region) {
+    if (level == 0) return 0;
+    if (region == 0) return 0;
+
+    double min[3] = {region->minX + region->start->x, region->minY + region->start->y, region->minZ + region->start->z};
+    double max[3] = {region->maxX + region->start->x, region->maxY + region->start->y, region->maxZ + region->start->z};
+    if (!(min[0] <= max[0]) || !(min[1] <= max[1]) || !(min[2] <= max[2])) return 0;
+
+    int lo[3] = {__cellFloor(min[0]), __cellFloor(min[1]), __cellFloor(min[2])};
+    int hi[3] = {__cellFloor(max[0]), __cellFloor(max[1]), __cellFloor(max[2])};
+
+    int cx0 = __chunkOf(lo[0]), cx1 = __chunkOf(hi[0]);
+    int cy0 = __chunkOf(lo[1]), cy1 = __chunkOf(hi[1]);
+    int cz0 = __chunkOf(lo[2]), cz1 = __chunkOf(hi[2]);
+
+    // walk whichever is smaller, the chunks of the region or the chunks of the level
+    int count = 0;
+    if ((int64_t) (cx1 - cx0 + 1) * (cy1 - cy0 + 1) * (cz1 - cz0 + 1) <= level->chunks.count) {
+        for (int cx = cx0; cx <= cx1; cx++)
+            for (int cy = cy0; cy <= cy1; cy++)
+                for (int cz = cz0; cz <= cz1; cz++)
+                    count += __LevelChunk3D_count(LevelChunkMap3D_get(&level->chunks, cx, cy, cz), lo, hi);
+    } else {
+        for (int i = 0; i < level->chunks.capacity; i++) {
+            LevelChunk3D* chunk = level->chunks.chunks[i];
+            if (chunk == 0) continue;
+            if (chunk->x < cx0 || chunk->x > cx1 || chunk->y < cy0 || chunk->y > cy1 || chunk->z < cz0 || chunk->z > cz1) continue;
+
+            count += __LevelChunk3D_count(chunk, lo, hi);
+        }
     }
 
-    return blockCount;
+    return count;
 }
 
 /**
- * Adds a block to a Level3D.
+ * Adds a block to a Level3D. A block already at the same coordinate is replaced.
+ * New blocks are ignored once the level holds _LEVEL_BLOCKS_MAX_CAPACITY blocks.
  * @param level The Level3D.
  * @param block The block to add.
  */
 void Level3D_addBlock(Level3D* level, LevelObject3D* block) {
-    if (level->blocks == 0) {
-        level->blocks = (LevelObject3D**) malloc(16 * sizeof(LevelObject3D*));
-        level->blocks[0] = block;
-        level->blocks[1] = 0;
-    } else {
-        int size = Level3D_getBlockCount(level);
+    if (level == 0) return;
+    if (block == 0) return;
 
-        for (int i = 0; i < size; i++) {
-            Coordinate3D* c = level->blocks[i]->coordinate;
-            if (c->x == block->coordinate->x && c->y == block->coordinate->y && c->z == block->coordinate->z) {
-                level->blocks[i] = block;
-                return;
-            }
+    if (level->journal != 0) {
+        __Level3D_journalBlock(level, block, 0);
+        fflush(level->journal);
+    }
+
+    int position = __Level3D_findBlock(level, block->coordinate->x, block->coordinate->y, block->coordinate->z);
+    if (position >= 0) {
+        __LevelChunk3D_replace(LevelChunkMap3D_chunkAt(&level->chunks, block->coordinate), level->blocks[position], block);
+
+        __LevelHash_block3D(&level->hash, level->blocks[position], -1);
+        __LevelHash_block3D(&level->hash, block, 1);
+        level->blocks[position] = block;
+        return;
+    }
+
+    if (level->blockCount + 1 >= level->blockCapacity) {
+        int capacity = level->blockCount < _LEVEL_BLOCKS_MAX_CAPACITY / 2 ? 2 * level->blockCount : _LEVEL_BLOCKS_MAX_CAPACITY;
+        Level3D_reserve(level, capacity);
+        if (level->blockCount + 1 >= level->blockCapacity) return;
+    }
+
+    __LevelChunk3D_add(LevelChunkMap3D_chunkAt(&level->chunks, block->coordinate), block);
+
+    __LevelHash_block3D(&level->hash, block, 1);
+    level->blocks[level->blockCount] = block;
+    __Level3D_indexBlock(level, level->blockCount);
+    level->blockCount++;
+    level->blocks[level->blockCount] = 0;
+}
+
+/**
+ * Adds multiple blocks to a Level3D in a single pass. Blocks sharing a coordinate,
+ * either with the level or with each other, replace the earlier block. Batches
+ * that could take the level past _LEVEL_BLOCKS_MAX_CAPACITY blocks are ignored.
+ * @param level The Level3D.
+ * @param blocks The blocks to add.
+ * @param count The number of blocks to add.
+ */
+void Level3D_addBlocks(Level3D* level, LevelObject3D** blocks, int count) {
+    if (level == 0) return;
+    if (blocks == 0) return;
+    if (count <= 0) return;
+    if (count > _LEVEL_BLOCKS_MAX_CAPACITY - level->blockCount) return;
+
+    if (level->blockCount + count >= level->blockCapacity) {
+        int capacity = level->blockCount < _LEVEL_BLOCKS_MAX_CAPACITY / 2 ? 2 * level->blockCount : _LEVEL_BLOCKS_MAX_CAPACITY;
+        if (capacity < level->blockCount + count) capacity = level->blockCount + count;
+
+        if (!Level3D_reserve(level, capacity)) return;
+    }
+
+    for (int i = 0; i < count; i++) {
+        LevelObject3D* block = blocks[i];
+        if (block == 0) continue;
+
+        if (level->journal != 0)
+            __Level3D_journalBlock(level, block, 0);
+
+        int position = __Level3D_findBlock(level, block->coordinate->x, block->coordinate->y, block->coordinate->z);
+        if (position >= 0) {
+            __LevelChunk3D_replace(LevelChunkMap3D_chunkAt(&level->chunks, block->coordinate), level->blocks[position], block);
+
+            __LevelHash_block3D(&level->hash, level->blocks[position], -1);
+            __LevelHash_block3D(&level->hash, block, 1);
+            level->blocks[position] = block;
+            continue;
         }
 
-        level->blocks = (LevelObject3D**) realloc(level->blocks, (size + 2) * sizeof(LevelObject3D*));
-        level->blocks[size] = block;
-        level->blocks[size + 1] = 0;
+        __LevelChunk3D_add(LevelChunkMap3D_chunkAt(&level->chunks, block->coordinate), block);
+
+        __LevelHash_block3D(&level->hash, block, 1);
+
+        level->blocks[level->blockCount] = block;
+        __Level3D_indexBlock(level, level->blockCount);
+        level->blockCount++;
     }
+
+    level->blocks[level->blockCount] = 0;
+
+    if (level->journal != 0)
+        fflush(level->journal);
 }
 
 /**
- * Adds a block to a Level3D on a matrix of coordinates.
+ * Adds a block to a Level3D on a matrix of coordinates. Matrices with more cells
+ * than fit in an int are ignored.
  * @param level The Level3D.
  * @param block The block to add.
  * @param matrix The matrix of coordinates to add the block to.
  */
 void Level3D_addMatrix(Level3D* level, Block* block, CoordinateMatrix3D* matrix) {
+    if (level == 0) return;
+    if (block == 0) return;
+    if (matrix == 0) return;
+
     int size = CoordinateMatrix3D_size(matrix);
-    Coordinate3D** coordinates = CoordinateMatrix3D_coordinates(matrix);
-    for (int i = 0; i < size; i++) {
-        Coordinate3D* coordinate = coordinates[i];
-        Level3D_addBlock(level, createLevelObject3D(block, coordinate));
-    }
+    if (size <= 0) return;
+
+    LevelObject3D** blocks = (LevelObject3D**) malloc(size * sizeof(LevelObject3D*));
+    CoordinateMatrix3DCursor cursor = CoordinateMatrix3D_cursor(matrix, COORDINATE_MATRIX_ROW_MAJOR);
+    for (int i = 0; CoordinateMatrix3DCursor_next(&cursor); i++)
+        blocks[i] = createLevelObject3DAt(block, cursor.coordinate);
+
+    Level3D_addBlocks(level, blocks, size);
+
+    free(blocks);
 }
 
 /**
- * Removes a block from a Level3D.
+ * Removes a block from a Level3D. The last block in the level takes its place.
  * @param level The Level3D.
  * @param block The block to remove.
  */
 void Level3D_removeBlock(Level3D* level, LevelObject3D* block) {
+    if (level == 0) return;
+    if (block == 0) return;
     if (level->blocks == 0) return;
 
-    int i = 0;
-    while (level->blocks[i] != 0) {
-        if (level->blocks[i] == block) {
-            free(level->blocks[i]);
-            
-            for (int j = i; j < sizeof(level->blocks) - 1; j++) {
-                level->blocks[j] = level->blocks[j + 1];
-            }
-            level->blocks[sizeof(level->blocks) - 1] = 0;
-            return;
+    int position = __Level3D_findBlock(level, block->coordinate->x, block->coordinate->y, block->coordinate->z);
+    if (position < 0 || level->blocks[position] != block) return;
+
+    if (level->journal != 0) {
+        __Level3D_journalBlock(level, block, 1);
+        fflush(level->journal);
+    }
+
+    __LevelHash_block3D(&level->hash, block, -1);
+
+    int last = level->blockCount - 1;
+    __Level3D_unindexBlock(level, position);
+    if (position != last) {
+        __Level3D_unindexBlock(level, last);
+        level->blocks[position] = level->blocks[last];
+        __Level3D_indexBlock(level, position);
+    }
+
+    level->blockCount--;
+    level->blocks[level->blockCount] = 0;
+
+    __LevelChunk3D_remove(LevelChunkMap3D_chunkAt(&level->chunks, block->coordinate), block);
+
+    // older snapshots may still be reading the block
+    if (level->snapshot != 0 && __atomicLoad(&level->snapshot->refs) > 1)
+        __LevelSnapshot3D_retire(level->snapshot, block);
+    else
+        free(block);
+}
+
+/**
+ * Gets the number of blocks in a Level3D with the interned ID of a name.
+ * @param level The Level3D.
+ * @param id The interned ID of the block name.
+ * @return The number of blocks in the Level3D with the name.
+ */
+int Level3D_blockCountById(Level3D* level, int id) {
+    if (level == 0) return 0;
+    if (level->blocks == 0) return 0;
+    if (id == 0) return 0;
+
+    int count = 0;
+    int blockCount = Level3D_getBlockCount(level);
+    for (int i = 0; i < blockCount; i++) {
+        if (level->blocks[i]->block->nameId == id) {
+            count++;
         }
-        i++;
     }
+
+    return count;
 }
 
 /**
@@ -643,14 +1929,149 @@ int Level3D_blockCount(Level3D* level, const char* name) {
     if (level->blocks == 0) return 0;
     if (name == 0) return 0;
 
-    int count = 0;
-    for (int i = 0; i < Level3D_getBlockCount(level); i++) {
-        if (strcmp(level->blocks[i]->block->name, name) == 0) {
-            count++;
+    return Level3D_blockCountById(level, getInternedId(name));
+}
+
+/**
+ * Gets the content hash of a Level3D. The hash covers the headers and blocks
+ * of the level, does not depend on the order they were added in, and is kept up
+ * to date in constant time by every edit made through the Level3D functions.
+ * Blocks must not be modified in place after they are added to the level.
+ * @param level The Level3D.
+ * @return The hash of the level, or a zero hash if the level is null.
+ */
+LevelHash Level3D_hash(Level3D* level) {
+    if (level == 0) {
+        LevelHash empty = {0, 0};
+        return empty;
+    }
+
+    return level->hash;
+}
+
+/**
+ * Checks if two Level3Ds have the same headers and blocks by comparing their
+ * counts and content hashes. The check runs in constant time, and two levels with
+ * different contents compare equal only on a 128-bit hash collision.
+ * @param a The first Level3D.
+ * @param b The second Level3D.
+ * @return 1 if the levels are equal, 0 otherwise.
+ */
+int Level3D_equals(Level3D* a, Level3D* b) {
+    if (a == b) return 1;
+    if (a == 0 || b == 0) return 0;
+    if (a->blockCount != b->blockCount) return 0;
+    if (Level3D_getHeaderCount(a) != Level3D_getHeaderCount(b)) return 0;
+
+    return a->hash.low == b->hash.low && a->hash.high == b->hash.high;
+}
+
+/**
+ * Measures the memory used by a Level3D, broken down by category. Sizes are the
+ * requested sizes of the allocations, without allocator overhead. The journal and
+ * snapshots are not included.
+ * @param level The Level3D.
+ * @return The memory usage of the level.
+ */
+LevelMemoryUsage Level3D_memoryUsage(Level3D* level) {
+    LevelMemoryUsage usage;
+    memset(&usage, 0, sizeof(LevelMemoryUsage));
+    if (level == 0) return usage;
+
+    usage.cells = sizeof(Level3D) + level->blockCount * (sizeof(LevelObject3D) - sizeof(Coordinate3D) + sizeof(LevelObject3D*));
+    usage.coordinates = level->blockCount * sizeof(Coordinate3D);
+    if (level->spawn != 0) usage.coordinates += sizeof(Coordinate3D);
+
+    if (level->blockCapacity > 0)
+        usage.slack += (level->blockCapacity - level->blockCount) * sizeof(LevelObject3D*);
+
+    Block** blocks = (Block**) malloc((level->blockCount + 1) * sizeof(Block*));
+    for (int i = 0; i < level->blockCount; i++) {
+        blocks[i] = level->blocks[i]->block;
+
+        // objects that point to a separate coordinate leave their embedded one unused
+        if (level->blocks[i]->coordinate != &level->blocks[i]->position)
+            usage.slack += sizeof(Coordinate3D);
+    }
+
+    __LevelMemoryUsage_blocks(&usage, blocks, level->blockCount);
+    free(blocks);
+
+    __LevelMemoryUsage_headers(&usage, level->headers, Level3D_getHeaderCount(level));
+
+    usage.indexes = level->blockIndexCapacity * sizeof(int);
+    if (level->chunks.capacity != 0) {
+        usage.indexes += level->chunks.capacity * sizeof(LevelChunk3D*);
+        for (int i = 0; i < level->chunks.capacity; i++) {
+            LevelChunk3D* chunk = level->chunks.chunks[i];
+            if (chunk == 0) continue;
+
+            usage.indexes += sizeof(LevelChunk3D) + chunk->count * sizeof(LevelObject3D*);
+            usage.slack += (chunk->capacity - chunk->count) * sizeof(LevelObject3D*);
         }
     }
 
-    return count;
+    __LevelMemoryUsage_total(&usage);
+    return usage;
+}
+
+/**
+ * Takes an immutable snapshot of a Level3D. Taking a snapshot only copies the
+ * chunks that changed since the previous one, and the snapshot can be read from
+ * other threads without locking while this thread keeps editing the level.
+ * The caller owns a reference and must release it with LevelSnapshot3D_release.
+ * @param level The Level3D.
+ * @return A new snapshot of the level.
+ */
+LevelSnapshot3D* Level3D_snapshot(Level3D* level) {
+    if (level == 0) return 0;
+
+    int headerCount = Level3D_getHeaderCount(level);
+    LevelSnapshot3D* snapshot = __LevelSnapshot3D_create(headerCount, level->chunks.count);
+    for (int i = 0; i < headerCount; i++) {
+        snapshot->headerNames[i] = level->headers[i]->name;
+        snapshot->headerValues[i] = level->headers[i]->value;
+    }
+
+    if (level->spawn != 0) {
+        snapshot->spawn = (Coordinate3D*) malloc(sizeof(Coordinate3D));
+        *snapshot->spawn = *level->spawn;
+    }
+
+    snapshot->blockCount = level->blockCount;
+    int chunked = 0;
+    for (int i = 0; i < level->chunks.capacity; i++) {
+        LevelChunk3D* chunk = level->chunks.chunks[i];
+        if (chunk == 0 || chunk->count == 0) continue;
+
+        if (chunk->snapshot == 0)
+            chunk->snapshot = __LevelChunkSnapshot3D_create(chunk);
+
+        __atomicIncrement(&chunk->snapshot->refs);
+        __LevelSnapshot3D_putChunk(snapshot, chunk->snapshot);
+        chunked += chunk->count;
+    }
+
+    // blocks too far out for a chunk are only found by walking the level
+    if (chunked < level->blockCount) {
+        snapshot->outlying = (LevelObject3D**) malloc((level->blockCount - chunked) * sizeof(LevelObject3D*));
+        for (int i = 0; i < level->blockCount; i++) {
+            Coordinate3D* c = level->blocks[i]->coordinate;
+            if (!__inChunkRange(c->x) || !__inChunkRange(c->y) || !__inChunkRange(c->z))
+                snapshot->outlying[snapshot->outlyingCount++] = level->blocks[i];
+        }
+    }
+
+    // one reference for the caller, one for the level
+    snapshot->refs = 2;
+    if (level->snapshot != 0) {
+        level->snapshot->next = snapshot;
+        __atomicIncrement(&snapshot->refs);
+        LevelSnapshot3D_release(level->snapshot);
+    }
+
+    level->snapshot = snapshot;
+    return snapshot;
 }
 
 #endif
\ No newline at end of file
@@ -4,9 +4,76 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <limits.h>
 
 #include "coordinate.h"
 
+/**
+ * The order in which the cells of a coordinate matrix are visited.
+ */
+typedef enum CoordinateMatrixOrder {
+    /**
+     * Index order, as used by the coordinates and coordinateAt functions: the x axis
+     * changes slowest and the last axis fastest.
+     */
+    COORDINATE_MATRIX_ROW_MAJOR,
+
+    /**
+     * Morton (Z-order) curve order, which visits nearby cells close together.
+     */
+    COORDINATE_MATRIX_MORTON
+} CoordinateMatrixOrder;
+
+// Internal
+
+uint64_t __compactBits2(uint64_t v) {
+    v &= 0x5555555555555555ULL;
+    v = (v | (v >> 1)) & 0x3333333333333333ULL;
+    v = (v | (v >> 2)) & 0x0f0f0f0f0f0f0f0fULL;
+    v = (v | (v >> 4)) & 0x00ff00ff00ff00ffULL;
+    v = (v | (v >> 8)) & 0x0000ffff0000ffffULL;
+    v = (v | (v >> 16)) & 0x00000000ffffffffULL;
+    return v;
+}
+
+uint64_t __compactBits3(uint64_t v) {
+    v &= 0x1249249249249249ULL;
+    v = (v ^ (v >> 2)) & 0x10c30c30c30c30c3ULL;
+    v = (v ^ (v >> 4)) & 0x100f00f00f00f00fULL;
+    v = (v ^ (v >> 8)) & 0x001f0000ff0000ffULL;
+    v = (v ^ (v >> 16)) & 0x001f00000000ffffULL;
+    v = (v ^ (v >> 32)) & 0x00000000001fffffULL;
+    return v;
+}
+
+// The number of values from min to max, or 0 if the range is empty. Computed in 64 bits,
+// so ranges wider than an int do not overflow.
+int64_t __extent(int min, int max) {
+    return max < min ? 0 : (int64_t) max - min + 1;
+}
+
+// Multiplies two non-negative counts, saturating at INT64_MAX.
+int64_t __multiplyCounts(int64_t a, int64_t b) {
+    if (a != 0 && b > INT64_MAX / a) return INT64_MAX;
+    return a * b;
+}
+
+int __trailingZeros64(uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(v);
+#else
+    int count = 0;
+    while ((v & 1) == 0) {
+        v >>= 1;
+        count++;
+    }
+    return count;
+#endif
+}
+
+// Implementation
+
 /**
  * Represents a matrix of coordinates in a 2D space.
  */
@@ -53,23 +120,35 @@ CoordinateMatrix2D* create2DCoordinateMatrix(int minX, int maxX, int minY, int m
     return matrix;
 }
 
+/**
+ * Gets the number of cells of a CoordinateMatrix2D, without overflowing.
+ * @param matrix The matrix.
+ * @return The number of cells, 0 if the matrix is empty, or INT64_MAX if the count does not fit.
+ */
+int64_t CoordinateMatrix2D_volume(CoordinateMatrix2D* matrix) {
+    return __multiplyCounts(__extent(matrix->minX, matrix->maxX), __extent(matrix->minY, matrix->maxY));
+}
+
 /**
  * Gets the size of a CoordinateMatrix2D.
  * @param matrix The matrix.
- * @return The size of the matrix.
+ * @return The size of the matrix, or -1 if it has more cells than fit in an int.
  */
 int CoordinateMatrix2D_size(CoordinateMatrix2D* matrix) {
-    return ((matrix->maxX + 1) - matrix->minX) * ((matrix->maxY + 1) - matrix->minY);
+    int64_t volume = CoordinateMatrix2D_volume(matrix);
+    return volume > INT_MAX ? -1 : (int) volume;
 }
 
 /**
  * Gets the coordinates of a CoordinateMatrix2D.
  * @param matrix The matrix.
- * @return A list of coordinates in the matrix.
+ * @return A list of coordinates in the matrix, or null if it has more cells than fit in an int.
  */
 Coordinate2D** CoordinateMatrix2D_coordinates(CoordinateMatrix2D* matrix) {
     int size = CoordinateMatrix2D_size(matrix);
-    Coordinate2D** coordinates = (Coordinate2D**) malloc(size * sizeof(Coordinate2D));
+    if (size < 0) return 0;
+
+    Coordinate2D** coordinates = (Coordinate2D**) malloc(size * sizeof(Coordinate2D*));
 
     int minX = matrix->minX + matrix->start->x;
     int minY = matrix->minY + matrix->start->y;
@@ -88,15 +167,192 @@ Coordinate2D** CoordinateMatrix2D_coordinates(CoordinateMatrix2D* matrix) {
 }
 
 /**
- * Gets the coordinate at a specific index.
+ * Gets the coordinate value at a specific index, without allocating. Indices follow
+ * the same order as CoordinateMatrix2D_coordinates.
+ * @param matrix The matrix.
+ * @param index The index, from 0 to the size of the matrix.
+ * @return The coordinate at the index.
+ */
+Coordinate2D CoordinateMatrix2D_coordinateAtValue(CoordinateMatrix2D* matrix, int index) {
+    int height = matrix->maxY - matrix->minY + 1;
+    int x = (int) (matrix->minX + matrix->start->x) + index / height;
+    int y = (int) (matrix->minY + matrix->start->y) + index % height;
+    return makeCoordinate2D(x, y);
+}
+
+/**
+ * Gets the coordinate at a specific index. Indices follow the same order as
+ * CoordinateMatrix2D_coordinates.
  * @param matrix The matrix.
  * @param index The index.
  * @return The coordinate at the index.
  */
 Coordinate2D* CoordinateMatrix2D_coordinateAt(CoordinateMatrix2D* matrix, int index) {
-    int x = matrix->minX + (index % (matrix->maxX - matrix->minX));
-    int y = matrix->minY + (index / (matrix->maxX - matrix->minX));
-    return createCoordinate2D(x, y);
+    Coordinate2D* c = (Coordinate2D*) malloc(sizeof(Coordinate2D));
+    *c = CoordinateMatrix2D_coordinateAtValue(matrix, index);
+    return c;
+}
+
+/**
+ * Gets the index of a coordinate in a CoordinateMatrix2D, in constant time.
+ * @param matrix The matrix.
+ * @param coordinate The coordinate.
+ * @return The index of the coordinate, or -1 if it is not a cell of the matrix.
+ */
+int CoordinateMatrix2D_indexOf(CoordinateMatrix2D* matrix, Coordinate2D coordinate) {
+    if (matrix == 0) return -1;
+
+    int width = matrix->maxX - matrix->minX + 1;
+    int height = matrix->maxY - matrix->minY + 1;
+    double x = coordinate.x - (int) (matrix->minX + matrix->start->x);
+    double y = coordinate.y - (int) (matrix->minY + matrix->start->y);
+
+    if (x < 0 || y < 0 || x >= width || y >= height) return -1;
+    if (x != (int) x || y != (int) y) return -1;
+
+    return (int) x * height + (int) y;
+}
+
+/**
+ * Walks the cells of a CoordinateMatrix2D one at a time, without allocating.
+ */
+typedef struct CoordinateMatrix2DCursor {
+    /**
+     * The current coordinate, valid after CoordinateMatrix2DCursor_next returns 1.
+     */
+    Coordinate2D coordinate;
+
+    /**
+     * The index of the current coordinate, in the order of CoordinateMatrix2D_coordinates.
+     */
+    int index;
+
+    /**
+     * The order of the walk.
+     */
+    CoordinateMatrixOrder order;
+
+    /**
+     * The extent of the matrix along each axis.
+     */
+    int width, height;
+
+    /**
+     * The first cell of the matrix.
+     */
+    int originX, originY;
+
+    /**
+     * The offsets of the next cell, for row-major walks.
+     */
+    int x, y;
+
+    /**
+     * The next and the last Morton code, for Morton walks.
+     */
+    uint64_t code, end;
+} CoordinateMatrix2DCursor;
+
+/**
+ * Creates a cursor over the cells of a CoordinateMatrix2D.
+ * @param matrix The matrix.
+ * @param order The order to visit the cells in.
+ * @return A cursor positioned before the first cell.
+ */
+CoordinateMatrix2DCursor CoordinateMatrix2D_cursor(CoordinateMatrix2D* matrix, CoordinateMatrixOrder order) {
+    CoordinateMatrix2DCursor cursor;
+    memset(&cursor, 0, sizeof(CoordinateMatrix2DCursor));
+    cursor.index = -1;
+    cursor.order = order;
+    if (matrix == 0) return cursor;
+
+    cursor.width = matrix->maxX - matrix->minX + 1;
+    cursor.height = matrix->maxY - matrix->minY + 1;
+    cursor.originX = (int) (matrix->minX + matrix->start->x);
+    cursor.originY = (int) (matrix->minY + matrix->start->y);
+
+    uint64_t side = 1;
+    while (side < (uint64_t) cursor.width || side < (uint64_t) cursor.height) side *= 2;
+    cursor.end = side * side;
+
+    return cursor;
+}
+
+/**
+ * Advances a cursor to the next cell.
+ * @param cursor The cursor.
+ * @return 1 if the cursor moved to a cell, 0 if the walk is over.
+ */
+int CoordinateMatrix2DCursor_next(CoordinateMatrix2DCursor* cursor) {
+    if (cursor->width <= 0 || cursor->height <= 0) return 0;
+
+    int x, y;
+    if (cursor->order == COORDINATE_MATRIX_MORTON) {
+        while (1) {
+            if (cursor->code >= cursor->end) return 0;
+
+            x = (int) __compactBits2(cursor->code);
+            y = (int) __compactBits2(cursor->code >> 1);
+            if (x < cursor->width && y < cursor->height) break;
+
+            // the largest aligned block starting at this code has its lowest corner here,
+            // so the whole block is outside the matrix and can be skipped
+            cursor->code += (uint64_t) 1 << (2 * (__trailingZeros64(cursor->code) / 2));
+        }
+        cursor->code++;
+    } else {
+        if (cursor->x >= cursor->width) return 0;
+
+        x = cursor->x;
+        y = cursor->y;
+        if (++cursor->y == cursor->height) {
+            cursor->y = 0;
+            cursor->x++;
+        }
+    }
+
+    cursor->index = x * cursor->height + y;
+    cursor->coordinate = makeCoordinate2D(cursor->originX + x, cursor->originY + y);
+    return 1;
+}
+
+/**
+ * A function called for each cell of a CoordinateMatrix2D.
+ * @param coordinate The coordinate of the cell.
+ * @param index The index of the cell, in the order of CoordinateMatrix2D_coordinates.
+ * @param data The data passed to CoordinateMatrix2D_forEach.
+ */
+typedef void (*CoordinateMatrix2DCallback)(Coordinate2D coordinate, int index, void* data);
+
+/**
+ * Calls a function for each cell of a CoordinateMatrix2D, without allocating.
+ * @param matrix The matrix.
+ * @param order The order to visit the cells in.
+ * @param callback The function to call.
+ * @param data Data passed to the function.
+ */
+void CoordinateMatrix2D_forEach(CoordinateMatrix2D* matrix, CoordinateMatrixOrder order, CoordinateMatrix2DCallback callback, void* data) {
+    if (matrix == 0) return;
+    if (callback == 0) return;
+
+    CoordinateMatrix2DCursor cursor = CoordinateMatrix2D_cursor(matrix, order);
+    while (CoordinateMatrix2DCursor_next(&cursor))
+        callback(cursor.coordinate, cursor.index, data);
+}
+
+/**
+ * Writes a CoordinateMatrix2D into a buffer, in the same form as CoordinateMatrix2D_toString.
+ * Like snprintf, the output is truncated to fit and always terminated when size is not 0.
+ * @param matrix The matrix.
+ * @param buffer The buffer to write to. It may be null if size is 0.
+ * @param size The size of the buffer.
+ * @return The length of the full string, excluding the terminator, or -1 if the matrix is null.
+ */
+int CoordinateMatrix2D_toBuffer(CoordinateMatrix2D* matrix, char* buffer, size_t size) {
+    if (matrix == 0) return -1;
+
+    int length = snprintf(buffer, size, "(%d, %d, %d, %d)^", matrix->minX, matrix->maxX, matrix->minY, matrix->maxY);
+    return length + Coordinate2D_toBuffer(matrix->start, __bufferAt(buffer, size, length), __sizeAt(size, length));
 }
 
 /**
@@ -107,16 +363,16 @@ Coordinate2D* CoordinateMatrix2D_coordinateAt(CoordinateMatrix2D* matrix, int in
 char* CoordinateMatrix2D_toString(CoordinateMatrix2D* matrix) {
     if (matrix == 0) return 0;
 
-    int size = snprintf(0, 0, "(%d, %d, %d, %d)^%s", matrix->minX, matrix->maxX, matrix->minY, matrix->maxY, Coordinate2D_toString(matrix->start));
-    char* str = (char*) malloc(size);
-    sprintf(str, "(%d, %d, %d, %d)^%s", matrix->minX, matrix->maxX, matrix->minY, matrix->maxY, Coordinate2D_toString(matrix->start));
+    int length = CoordinateMatrix2D_toBuffer(matrix, 0, 0);
+    char* str = (char*) malloc(length + 1);
+    CoordinateMatrix2D_toBuffer(matrix, str, length + 1);
     return str;
 }
 
 /**
  * Converts a string to a CoordinateMatrix2D.
  * @param str The string representation of the matrix.
- * @return The CoordinateMatrix2D.
+ * @return The CoordinateMatrix2D, or null if the string is missing a value.
  */
 CoordinateMatrix2D* CoordinateMatrix2D_fromString(const char* str) {
     if (str == 0) return 0;
@@ -124,8 +380,8 @@ CoordinateMatrix2D* CoordinateMatrix2D_fromString(const char* str) {
     char* str0 = (char*) malloc(strlen(str) + 1);
     strcpy(str0, str);
 
-    int minX, minY, maxX, maxY;
-    double x, y;
+    int minX = 0, minY = 0, maxX = 0, maxY = 0;
+    double x = 0, y = 0;
 
     char* token = strtok(str0, "()[]^, \t");
     int i = 0;
@@ -144,6 +400,10 @@ CoordinateMatrix2D* CoordinateMatrix2D_fromString(const char* str) {
     }
 
     free(str0);
+
+    // a matrix missing any of its values cannot be read
+    if (i < 6) return 0;
+
     Coordinate2D* start = createCoordinate2D(x, y);
     return create2DCoordinateMatrix(minX, maxX, minY, maxY, start);
 }
@@ -206,23 +466,36 @@ CoordinateMatrix3D* create3DCoordinateMatrix(int minX, int maxX, int minY, int m
     return matrix;
 }
 
+/**
+ * Gets the number of cells of a CoordinateMatrix3D, without overflowing.
+ * @param matrix The matrix.
+ * @return The number of cells, 0 if the matrix is empty, or INT64_MAX if the count does not fit.
+ */
+int64_t CoordinateMatrix3D_volume(CoordinateMatrix3D* matrix) {
+    int64_t area = __multiplyCounts(__extent(matrix->minX, matrix->maxX), __extent(matrix->minY, matrix->maxY));
+    return __multiplyCounts(area, __extent(matrix->minZ, matrix->maxZ));
+}
+
 /**
  * Gets the size of a CoordinateMatrix3D.
  * @param matrix The matrix.
- * @return The size of the matrix.
+ * @return The size of the matrix, or -1 if it has more cells than fit in an int.
  */
 int CoordinateMatrix3D_size(CoordinateMatrix3D* matrix) {
-    return ((matrix->maxX + 1) - matrix->minX) * ((matrix->maxY + 1) - matrix->minY) * ((matrix->maxZ + 1) - matrix->minZ);
+    int64_t volume = CoordinateMatrix3D_volume(matrix);
+    return volume > INT_MAX ? -1 : (int) volume;
 }
 
 /**
  * Gets the coordinates of a CoordinateMatrix3D.
  * @param matrix The matrix.
- * @return A list of coordinates in the matrix.
+ * @return A list of coordinates in the matrix, or null if it has more cells than fit in an int.
  */
 Coordinate3D** CoordinateMatrix3D_coordinates(CoordinateMatrix3D* matrix) {
     int size = CoordinateMatrix3D_size(matrix);
-    Coordinate3D** coordinates = (Coordinate3D**) malloc(size * sizeof(Coordinate3D));
+    if (size < 0) return 0;
+
+    Coordinate3D** coordinates = (Coordinate3D**) malloc(size * sizeof(Coordinate3D*));
 
     int minX = matrix->minX + matrix->start->x;
     int minY = matrix->minY + matrix->start->y;
@@ -245,16 +518,208 @@ Coordinate3D** CoordinateMatrix3D_coordinates(CoordinateMatrix3D* matrix) {
 }
 
 /**
- * Gets the coordinate at a specific index.
+ * Gets the coordinate value at a specific index, without allocating. Indices follow
+ * the same order as CoordinateMatrix3D_coordinates.
+ * @param matrix The matrix.
+ * @param index The index, from 0 to the size of the matrix.
+ * @return The coordinate at the index.
+ */
+Coordinate3D CoordinateMatrix3D_coordinateAtValue(CoordinateMatrix3D* matrix, int index) {
+    int height = matrix->maxY - matrix->minY + 1;
+    int depth = matrix->maxZ - matrix->minZ + 1;
+    int x = (int) (matrix->minX + matrix->start->x) + index / (height * depth);
+    int y = (int) (matrix->minY + matrix->start->y) + (index / depth) % height;
+    int z = (int) (matrix->minZ + matrix->start->z) + index % depth;
+    return makeCoordinate3D(x, y, z);
+}
+
+/**
+ * Gets the coordinate at a specific index. Indices follow the same order as
+ * CoordinateMatrix3D_coordinates.
  * @param matrix The matrix.
  * @param index The index.
  * @return The coordinate at the index.
  */
 Coordinate3D* CoordinateMatrix3D_coordinateAt(CoordinateMatrix3D* matrix, int index) {
-    int x = matrix->minX + (index % (matrix->maxX - matrix->minX));
-    int y = matrix->minY + ((index / (matrix->maxX - matrix->minX)) % (matrix->maxY - matrix->minY));
-    int z = matrix->minZ + (index / ((matrix->maxX - matrix->minX) * (matrix->maxY - matrix->minY)));
-    return createCoordinate3D(x, y, z);
+    Coordinate3D* c = (Coordinate3D*) malloc(sizeof(Coordinate3D));
+    *c = CoordinateMatrix3D_coordinateAtValue(matrix, index);
+    return c;
+}
+
+/**
+ * Gets the index of a coordinate in a CoordinateMatrix3D, in constant time.
+ * @param matrix The matrix.
+ * @param coordinate The coordinate.
+ * @return The index of the coordinate, or -1 if it is not a cell of the matrix.
+ */
+int CoordinateMatrix3D_indexOf(CoordinateMatrix3D* matrix, Coordinate3D coordinate) {
+    if (matrix == 0) return -1;
+
+    int width = matrix->maxX - matrix->minX + 1;
+    int height = matrix->maxY - matrix->minY + 1;
+    int depth = matrix->maxZ - matrix->minZ + 1;
+    double x = coordinate.x - (int) (matrix->minX + matrix->start->x);
+    double y = coordinate.y - (int) (matrix->minY + matrix->start->y);
+    double z = coordinate.z - (int) (matrix->minZ + matrix->start->z);
+
+    if (x < 0 || y < 0 || z < 0 || x >= width || y >= height || z >= depth) return -1;
+    if (x != (int) x || y != (int) y || z != (int) z) return -1;
+
+    return ((int) x * height + (int) y) * depth + (int) z;
+}
+
+/**
+ * Walks the cells of a CoordinateMatrix3D one at a time, without allocating.
+ */
+typedef struct CoordinateMatrix3DCursor {
+    /**
+     * The current coordinate, valid after CoordinateMatrix3DCursor_next returns 1.
+     */
+    Coordinate3D coordinate;
+
+    /**
+     * The index of the current coordinate, in the order of CoordinateMatrix3D_coordinates.
+     */
+    int index;
+
+    /**
+     * The order of the walk.
+     */
+    CoordinateMatrixOrder order;
+
+    /**
+     * The extent of the matrix along each axis.
+     */
+    int width, height, depth;
+
+    /**
+     * The first cell of the matrix.
+     */
+    int originX, originY, originZ;
+
+    /**
+     * The offsets of the next cell, for row-major walks.
+     */
+    int x, y, z;
+
+    /**
+     * The next and the last Morton code, for Morton walks.
+     */
+    uint64_t code, end;
+} CoordinateMatrix3DCursor;
+
+/**
+ * Creates a cursor over the cells of a CoordinateMatrix3D. Morton order needs every
+ * extent to be at most 2^21 cells, and falls back to row-major order otherwise.
+ * @param matrix The matrix.
+ * @param order The order to visit the cells in.
+ * @return A cursor positioned before the first cell.
+ */
+CoordinateMatrix3DCursor CoordinateMatrix3D_cursor(CoordinateMatrix3D* matrix, CoordinateMatrixOrder order) {
+    CoordinateMatrix3DCursor cursor;
+    memset(&cursor, 0, sizeof(CoordinateMatrix3DCursor));
+    cursor.index = -1;
+    cursor.order = order;
+    if (matrix == 0) return cursor;
+
+    cursor.width = matrix->maxX - matrix->minX + 1;
+    cursor.height = matrix->maxY - matrix->minY + 1;
+    cursor.depth = matrix->maxZ - matrix->minZ + 1;
+    cursor.originX = (int) (matrix->minX + matrix->start->x);
+    cursor.originY = (int) (matrix->minY + matrix->start->y);
+    cursor.originZ = (int) (matrix->minZ + matrix->start->z);
+
+    uint64_t side = 1;
+    while (side < (uint64_t) cursor.width || side < (uint64_t) cursor.height || side < (uint64_t) cursor.depth) side *= 2;
+
+    if (side > ((uint64_t) 1 << 21))
+        cursor.order = COORDINATE_MATRIX_ROW_MAJOR;
+    else
+        cursor.end = side * side * side;
+
+    return cursor;
+}
+
+/**
+ * Advances a cursor to the next cell.
+ * @param cursor The cursor.
+ * @return 1 if the cursor moved to a cell, 0 if the walk is over.
+ */
+int CoordinateMatrix3DCursor_next(CoordinateMatrix3DCursor* cursor) {
+    if (cursor->width <= 0 || cursor->height <= 0 || cursor->depth <= 0) return 0;
+
+    int x, y, z;
+    if (cursor->order == COORDINATE_MATRIX_MORTON) {
+        while (1) {
+            if (cursor->code >= cursor->end) return 0;
+
+            x = (int) __compactBits3(cursor->code);
+            y = (int) __compactBits3(cursor->code >> 1);
+            z = (int) __compactBits3(cursor->code >> 2);
+            if (x < cursor->width && y < cursor->height && z < cursor->depth) break;
+
+            // the largest aligned block starting at this code has its lowest corner here,
+            // so the whole block is outside the matrix and can be skipped
+            cursor->code += (uint64_t) 1 << (3 * (__trailingZeros64(cursor->code) / 3));
+        }
+        cursor->code++;
+    } else {
+        if (cursor->x >= cursor->width) return 0;
+
+        x = cursor->x;
+        y = cursor->y;
+        z = cursor->z;
+        if (++cursor->z == cursor->depth) {
+            cursor->z = 0;
+            if (++cursor->y == cursor->height) {
+                cursor->y = 0;
+                cursor->x++;
+            }
+        }
+    }
+
+    cursor->index = (x * cursor->height + y) * cursor->depth + z;
+    cursor->coordinate = makeCoordinate3D(cursor->originX + x, cursor->originY + y, cursor->originZ + z);
+    return 1;
+}
+
+/**
+ * A function called for each cell of a CoordinateMatrix3D.
+ * @param coordinate The coordinate of the cell.
+ * @param index The index of the cell, in the order of CoordinateMatrix3D_coordinates.
+ * @param data The data passed to CoordinateMatrix3D_forEach.
+ */
+typedef void (*CoordinateMatrix3DCallback)(Coordinate3D coordinate, int index, void* data);
+
+/**
+ * Calls a function for each cell of a CoordinateMatrix3D, without allocating.
+ * @param matrix The matrix.
+ * @param order The order to visit the cells in.
+ * @param callback The function to call.
+ * @param data Data passed to the function.
+ */
+void CoordinateMatrix3D_forEach(CoordinateMatrix3D* matrix, CoordinateMatrixOrder order, CoordinateMatrix3DCallback callback, void* data) {
+    if (matrix == 0) return;
+    if (callback == 0) return;
+
+    CoordinateMatrix3DCursor cursor = CoordinateMatrix3D_cursor(matrix, order);
+    while (CoordinateMatrix3DCursor_next(&cursor))
+        callback(cursor.coordinate, cursor.index, data);
+}
+
+/**
+ * Writes a CoordinateMatrix3D into a buffer, in the same form as CoordinateMatrix3D_toString.
+ * Like snprintf, the output is truncated to fit and always terminated when size is not 0.
+ * @param matrix The matrix.
+ * @param buffer The buffer to write to. It may be null if size is 0.
+ * @param size The size of the buffer.
+ * @return The length of the full string, excluding the terminator, or -1 if the matrix is null.
+ */
+int CoordinateMatrix3D_toBuffer(CoordinateMatrix3D* matrix, char* buffer, size_t size) {
+    if (matrix == 0) return -1;
+
+    int length = snprintf(buffer, size, "(%d, %d, %d, %d, %d, %d)^", matrix->minX, matrix->maxX, matrix->minY, matrix->maxY, matrix->minZ, matrix->maxZ);
+    return length + Coordinate3D_toBuffer(matrix->start, __bufferAt(buffer, size, length), __sizeAt(size, length));
 }
 
 /**
@@ -265,16 +730,16 @@ Coordinate3D* CoordinateMatrix3D_coordinateAt(CoordinateMatrix3D* matrix, int in
 char* CoordinateMatrix3D_toString(CoordinateMatrix3D* matrix) {
     if (matrix == 0) return 0;
 
-    int size = snprintf(0, 0, "(%d, %d, %d, %d, %d, %d)^%s", matrix->minX, matrix->maxX, matrix->minY, matrix->maxY, matrix->minZ, matrix->maxZ, Coordinate3D_toString(matrix->start));
-    char* str = (char*) malloc(size);
-    sprintf(str, "(%d, %d, %d, %d, %d, %d)^%s", matrix->minX, matrix->maxX, matrix->minY, matrix->maxY, matrix->minZ, matrix->maxZ, Coordinate3D_toString(matrix->start));
+    int length = CoordinateMatrix3D_toBuffer(matrix, 0, 0);
+    char* str = (char*) malloc(length + 1);
+    CoordinateMatrix3D_toBuffer(matrix, str, length + 1);
     return str;
 }
 
 /**
  * Converts a string to a CoordinateMatrix3D.
  * @param str The string representation of the matrix.
- * @return The CoordinateMatrix3D.
+ * @return The CoordinateMatrix3D, or null if the string is missing a value.
  */
 CoordinateMatrix3D* CoordinateMatrix3D_fromString(char* str) {
     if (str == 0) return 0;
@@ -282,8 +747,8 @@ CoordinateMatrix3D* CoordinateMatrix3D_fromString(char* str) {
     char* str0 = (char*) malloc(strlen(str) + 1);
     strcpy(str0, str);
 
-    int minX, minY, maxX, maxY, minZ, maxZ;
-    double x, y, z;
+    int minX = 0, minY = 0, maxX = 0, maxY = 0, minZ = 0, maxZ = 0;
+    double x = 0, y = 0, z = 0;
 
     char* token = strtok(str0, "()[]^, \t");
     int i = 0;
@@ -305,6 +770,10 @@ CoordinateMatrix3D* CoordinateMatrix3D_fromString(char* str) {
     }
 
     free(str0);
+
+    // a matrix missing any of its values cannot be read
+    if (i < 9) return 0;
+
     Coordinate3D* start = createCoordinate3D(x, y, z);
     return create3DCoordinateMatrix(minX, maxX, minY, maxY, minZ, maxZ, start);
 }
@@ -0,0 +1,336 @@
+#ifndef LEVELZ_MERGE_H
+#define LEVELZ_MERGE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "block.h"
+#include "coordinate.h"
+#include "level.h"
+#include "matrix.h"
+
+// Internal
+
+typedef struct __Box2D {
+    int minX, maxX, minY, maxY;
+} __Box2D;
+
+typedef struct __Cell2D {
+    int x, y;
+} __Cell2D;
+
+typedef struct __CellSet2D {
+    __Cell2D* cells;
+    char* used;
+    int* slots;
+    int mask;
+} __CellSet2D;
+
+int __compareMergeCells2D(const void* a, const void* b) {
+    const __Cell2D* c = (const __Cell2D*) a;
+    const __Cell2D* d = (const __Cell2D*) b;
+    if (c->x != d->x) return c->x < d->x ? -1 : 1;
+    if (c->y != d->y) return c->y < d->y ? -1 : 1;
+    return 0;
+}
+
+int __CellSet2D_find(__CellSet2D* set, int x, int y) {
+    int slot = (int) (Coordinate2D_hash(x, y) & set->mask);
+    while (set->slots[slot] != -1) {
+        __Cell2D* c = &set->cells[set->slots[slot]];
+        if (c->x == x && c->y == y) return set->slots[slot];
+
+        slot = (slot + 1) & set->mask;
+    }
+
+    return -1;
+}
+
+// Whether a cell exists and is not yet part of a box.
+int __CellSet2D_free(__CellSet2D* set, int x, int y) {
+    int i = __CellSet2D_find(set, x, y);
+    return i >= 0 && !set->used[i];
+}
+
+void __appendBox2D(__Box2D** boxes, int* count, int* capacity, __Box2D box) {
+    if (*count == *capacity) {
+        *capacity = *capacity == 0 ? 16 : *capacity * 2;
+        *boxes = (__Box2D*) realloc(*boxes, *capacity * sizeof(__Box2D));
+    }
+
+    (*boxes)[(*count)++] = box;
+}
+
+// Greedily covers the cells with boxes: each box grows along y from its lowest
+// unused cell, then along x while whole columns are free. The cells are sorted and
+// deduplicated in place.
+int __mergeCells2D(__Cell2D* cells, int count, __Box2D** boxes) {
+    *boxes = 0;
+    if (count == 0) return 0;
+
+    qsort(cells, count, sizeof(__Cell2D), __compareMergeCells2D);
+
+    int unique = 1;
+    for (int i = 1; i < count; i++)
+        if (__compareMergeCells2D(&cells[i], &cells[unique - 1]) != 0)
+            cells[unique++] = cells[i];
+
+    int capacity = 16;
+    while (capacity < unique * 2) capacity *= 2;
+
+    __CellSet2D set;
+    set.cells = cells;
+    set.used = (char*) calloc(unique, 1);
+    set.slots = (int*) malloc(capacity * sizeof(int));
+    set.mask = capacity - 1;
+    memset(set.slots, -1, capacity * sizeof(int));
+
+    for (int i = 0; i < unique; i++) {
+        int slot = (int) (Coordinate2D_hash(cells[i].x, cells[i].y) & set.mask);
+        while (set.slots[slot] != -1) slot = (slot + 1) & set.mask;
+        set.slots[slot] = i;
+    }
+
+    int boxCount = 0;
+    int boxCapacity = 0;
+    for (int i = 0; i < unique; i++) {
+        if (set.used[i]) continue;
+
+        int x = cells[i].x;
+        int y = cells[i].y;
+
+        int height = 1;
+        while (__CellSet2D_free(&set, x, y + height)) height++;
+
+        int width = 1;
+        while (1) {
+            int dy = 0;
+            while (dy < height && __CellSet2D_free(&set, x + width, y + dy)) dy++;
+            if (dy < height) break;
+
+            width++;
+        }
+
+        for (int dx = 0; dx < width; dx++)
+            for (int dy = 0; dy < height; dy++)
+                set.used[__CellSet2D_find(&set, x + dx, y + dy)] = 1;
+
+        __Box2D box = {x, x + width - 1, y, y + height - 1};
+        __appendBox2D(boxes, &boxCount, &boxCapacity, box);
+    }
+
+    free(set.used);
+    free(set.slots);
+    return boxCount;
+}
+
+typedef struct __Box3D {
+    int minX, maxX, minY, maxY, minZ, maxZ;
+} __Box3D;
+
+typedef struct __Cell3D {
+    int x, y, z;
+} __Cell3D;
+
+typedef struct __CellSet3D {
+    __Cell3D* cells;
+    char* used;
+    int* slots;
+    int mask;
+} __CellSet3D;
+
+int __compareMergeCells3D(const void* a, const void* b) {
+    const __Cell3D* c = (const __Cell3D*) a;
+    const __Cell3D* d = (const __Cell3D*) b;
+    if (c->x != d->x) return c->x < d->x ? -1 : 1;
+    if (c->y != d->y) return c->y < d->y ? -1 : 1;
+    if (c->z != d->z) return c->z < d->z ? -1 : 1;
+    return 0;
+}
+
+int __CellSet3D_find(__CellSet3D* set, int x, int y, int z) {
+    int slot = (int) (Coordinate3D_hash(x, y, z) & set->mask);
+    while (set->slots[slot] != -1) {
+        __Cell3D* c = &set->cells[set->slots[slot]];
+        if (c->x == x && c->y == y && c->z == z) return set->slots[slot];
+
+        slot = (slot + 1) & set->mask;
+    }
+
+    return -1;
+}
+
+// Whether a cell exists and is not yet part of a box.
+int __CellSet3D_free(__CellSet3D* set, int x, int y, int z) {
+    int i = __CellSet3D_find(set, x, y, z);
+    return i >= 0 && !set->used[i];
+}
+
+void __appendBox3D(__Box3D** boxes, int* count, int* capacity, __Box3D box) {
+    if (*count == *capacity) {
+        *capacity = *capacity == 0 ? 16 : *capacity * 2;
+        *boxes = (__Box3D*) realloc(*boxes, *capacity * sizeof(__Box3D));
+    }
+
+    (*boxes)[(*count)++] = box;
+}
+
+// Greedily covers the cells with boxes: each box grows along z from its lowest
+// unused cell, then along y while whole rows are free, then along x while whole
+// slices are free. The cells are sorted and deduplicated in place.
+int __mergeCells3D(__Cell3D* cells, int count, __Box3D** boxes) {
+    *boxes = 0;
+    if (count == 0) return 0;
+
+    qsort(cells, count, sizeof(__Cell3D), __compareMergeCells3D);
+
+    int unique = 1;
+    for (int i = 1; i < count; i++)
+        if (__compareMergeCells3D(&cells[i], &cells[unique - 1]) != 0)
+            cells[unique++] = cells[i];
+
+    int capacity = 16;
+    while (capacity < unique * 2) capacity *= 2;
+
+    __CellSet3D set;
+    set.cells = cells;
+    set.used = (char*) calloc(unique, 1);
+    set.slots = (int*) malloc(capacity * sizeof(int));
+    set.mask = capacity - 1;
+    memset(set.slots, -1, capacity * sizeof(int));
+
+    for (int i = 0; i < unique; i++) {
+        int slot = (int) (Coordinate3D_hash(cells[i].x, cells[i].y, cells[i].z) & set.mask);
+        while (set.slots[slot] != -1) slot = (slot + 1) & set.mask;
+        set.slots[slot] = i;
+    }
+
+    int boxCount = 0;
+    int boxCapacity = 0;
+    for (int i = 0; i < unique; i++) {
+        if (set.used[i]) continue;
+
+        int x = cells[i].x;
+        int y = cells[i].y;
+        int z = cells[i].z;
+
+        int depth = 1;
+        while (__CellSet3D_free(&set, x, y, z + depth)) depth++;
+
+        int height = 1;
+        while (1) {
+            int dz = 0;
+            while (dz < depth && __CellSet3D_free(&set, x, y + height, z + dz)) dz++;
+            if (dz < depth) break;
+
+            height++;
+        }
+
+        int width = 1;
+        while (1) {
+            int full = 1;
+            for (int dy = 0; dy < height && full; dy++)
+                for (int dz = 0; dz < depth && full; dz++)
+                    full = __CellSet3D_free(&set, x + width, y + dy, z + dz);
+            if (!full) break;
+
+            width++;
+        }
+
+        for (int dx = 0; dx < width; dx++)
+            for (int dy = 0; dy < height; dy++)
+                for (int dz = 0; dz < depth; dz++)
+                    set.used[__CellSet3D_find(&set, x + dx, y + dy, z + dz)] = 1;
+
+        __Box3D box = {x, x + width - 1, y, y + height - 1, z, z + depth - 1};
+        __appendBox3D(boxes, &boxCount, &boxCapacity, box);
+    }
+
+    free(set.used);
+    free(set.slots);
+    return boxCount;
+}
+
+// Implementation
+
+/**
+ * Merges the cells of a block type in a Level2D into a near-minimal set of boxes,
+ * using greedy meshing. Only blocks on whole-number coordinates are merged.
+ * @param level The Level2D.
+ * @param block The block type. Blocks equal to it, by Block_equals, are merged.
+ * @param count Set to the number of boxes.
+ * @return A new array of boxes, each starting at [0, 0], or null if there are none.
+ */
+CoordinateMatrix2D** Level2D_mergeBlocks(Level2D* level, Block* block, int* count) {
+    *count = 0;
+    if (level == 0) return 0;
+    if (block == 0) return 0;
+
+    __Cell2D* cells = (__Cell2D*) malloc((level->blockCount + 1) * sizeof(__Cell2D));
+    int cellCount = 0;
+    for (int i = 0; i < level->blockCount; i++) {
+        LevelObject2D* o = level->blocks[i];
+        if (!Block_equals(o->block, block)) continue;
+        if (!__isCell(o->coordinate->x) || !__isCell(o->coordinate->y)) continue;
+
+        cells[cellCount].x = (int) o->coordinate->x;
+        cells[cellCount].y = (int) o->coordinate->y;
+        cellCount++;
+    }
+
+    __Box2D* boxes;
+    int boxCount = __mergeCells2D(cells, cellCount, &boxes);
+    free(cells);
+    if (boxCount == 0) return 0;
+
+    CoordinateMatrix2D** matrices = (CoordinateMatrix2D**) malloc(boxCount * sizeof(CoordinateMatrix2D*));
+    for (int i = 0; i < boxCount; i++)
+        matrices[i] = create2DCoordinateMatrix(boxes[i].minX, boxes[i].maxX, boxes[i].minY, boxes[i].maxY, createCoordinate2D(0, 0));
+
+    free(boxes);
+    *count = boxCount;
+    return matrices;
+}
+
+/**
+ * Merges the cells of a block type in a Level3D into a near-minimal set of boxes,
+ * using greedy meshing. Only blocks on whole-number coordinates are merged.
+ * @param level The Level3D.
+ * @param block The block type. Blocks equal to it, by Block_equals, are merged.
+ * @param count Set to the number of boxes.
+ * @return A new array of boxes, each starting at [0, 0, 0], or null if there are none.
+ */
+CoordinateMatrix3D** Level3D_mergeBlocks(Level3D* level, Block* block, int* count) {
+    *count = 0;
+    if (level == 0) return 0;
+    if (block == 0) return 0;
+
+    __Cell3D* cells = (__Cell3D*) malloc((level->blockCount + 1) * sizeof(__Cell3D));
+    int cellCount = 0;
+    for (int i = 0; i < level->blockCount; i++) {
+        LevelObject3D* o = level->blocks[i];
+        if (!Block_equals(o->block, block)) continue;
+        if (!__isCell(o->coordinate->x) || !__isCell(o->coordinate->y) || !__isCell(o->coordinate->z)) continue;
+
+        cells[cellCount].x = (int) o->coordinate->x;
+        cells[cellCount].y = (int) o->coordinate->y;
+        cells[cellCount].z = (int) o->coordinate->z;
+        cellCount++;
+    }
+
+    __Box3D* boxes;
+    int boxCount = __mergeCells3D(cells, cellCount, &boxes);
+    free(cells);
+    if (boxCount == 0) return 0;
+
+    CoordinateMatrix3D** matrices = (CoordinateMatrix3D**) malloc(boxCount * sizeof(CoordinateMatrix3D*));
+    for (int i = 0; i < boxCount; i++)
+        matrices[i] = create3DCoordinateMatrix(boxes[i].minX, boxes[i].maxX, boxes[i].minY, boxes[i].maxY, boxes[i].minZ, boxes[i].maxZ, createCoordinate3D(0, 0, 0));
+
+    free(boxes);
+    *count = boxCount;
+    return matrices;
+}
+
+#endif
@@ -0,0 +1,462 @@
+#ifndef LEVELZ_MESH_H
+#define LEVELZ_MESH_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tgmath.h>
+
+#include "block.h"
+#include "chunk.h"
+#include "level.h"
+
+/**
+ * The faces of a block, in the order of their normals.
+ */
+typedef enum LevelMeshFace {
+    LEVEL_MESH_FACE_NEGATIVE_X,
+    LEVEL_MESH_FACE_POSITIVE_X,
+    LEVEL_MESH_FACE_NEGATIVE_Y,
+    LEVEL_MESH_FACE_POSITIVE_Y,
+    LEVEL_MESH_FACE_NEGATIVE_Z,
+    LEVEL_MESH_FACE_POSITIVE_Z
+} LevelMeshFace;
+
+/**
+ * Represents a vertex of a chunk mesh.
+ */
+typedef struct LevelMeshVertex {
+    /**
+     * The position of the vertex, in level coordinates.
+     */
+    float x, y, z;
+
+    /**
+     * The texture coordinates of the vertex, in blocks, so textures repeat across merged quads.
+     */
+    float u, v;
+
+    /**
+     * The index of the block of the quad in the materials of the mesh.
+     */
+    unsigned short material;
+
+    /**
+     * The face of the quad, as a LevelMeshFace.
+     */
+    unsigned char face;
+} LevelMeshVertex;
+
+/**
+ * Represents the visible faces of a LevelChunk3D, merged into quads.
+ * Each quad has four vertices and six indices, forming two counter-clockwise triangles
+ * when seen from outside the block.
+ */
+typedef struct LevelChunkMesh3D {
+    /**
+     * The x coordinate of the chunk, in chunks.
+     */
+    int x;
+
+    /**
+     * The y coordinate of the chunk, in chunks.
+     */
+    int y;
+
+    /**
+     * The z coordinate of the chunk, in chunks.
+     */
+    int z;
+
+    /**
+     * The vertices of the mesh.
+     */
+    LevelMeshVertex* vertices;
+
+    /**
+     * The number of vertices.
+     */
+    int vertexCount;
+
+    /**
+     * The indices of the mesh, into its vertices.
+     */
+    unsigned int* indices;
+
+    /**
+     * The number of indices.
+     */
+    int indexCount;
+
+    /**
+     * The distinct blocks of the mesh. The blocks belong to the level and are only valid
+     * until the chunk changes.
+     */
+    Block** materials;
+
+    /**
+     * The number of distinct blocks.
+     */
+    int materialCount;
+
+    /**
+     * The versions of the chunk and its six neighbours when the mesh was built.
+     */
+    int versions[7];
+} LevelChunkMesh3D;
+
+/**
+ * Represents the meshes of every chunk of a Level3D, rebuilt only where the level changed.
+ */
+typedef struct LevelMesh3D {
+    /**
+     * The level the meshes are built from.
+     */
+    Level3D* level;
+
+    /**
+     * Open-addressed table of chunk meshes, with 0 for empty entries.
+     */
+    LevelChunkMesh3D** meshes;
+
+    /**
+     * The number of chunk meshes.
+     */
+    int count;
+
+    /**
+     * The capacity of the table. Always zero or a power of two.
+     */
+    int capacity;
+} LevelMesh3D;
+
+// Internal
+
+#define _MESH_PADDED (_LEVEL_CHUNK_SIZE + 2)
+#define _MESH_FOREIGN 0xFFFF
+
+const int __meshNeighbours[6][3] = {{-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1}};
+
+int __meshCell(int x, int y, int z) {
+    return (x * _MESH_PADDED + y) * _MESH_PADDED + z;
+}
+
+void __LevelMesh3D_versions(Level3D* level, int x, int y, int z, int* versions) {
+    LevelChunk3D* chunk = LevelChunkMap3D_get(&level->chunks, x, y, z);
+    versions[0] = chunk == 0 ? 0 : chunk->version;
+
+    for (int i = 0; i < 6; i++) {
+        LevelChunk3D* n = LevelChunkMap3D_get(&level->chunks, x + __meshNeighbours[i][0], y + __meshNeighbours[i][1], z + __meshNeighbours[i][2]);
+        versions[i + 1] = n == 0 ? 0 : n->version;
+    }
+}
+
+int __LevelChunkMesh3D_material(LevelChunkMesh3D* mesh, Block* block) {
+    for (int i = 0; i < mesh->materialCount; i++)
+        if (Block_equals(mesh->materials[i], block)) return i + 1;
+
+    mesh->materials[mesh->materialCount++] = block;
+    return mesh->materialCount;
+}
+
+// Marks the cells of a chunk in a padded grid, offset by a number of chunks. Cells that
+// fall outside the grid are skipped, so neighbours only fill the border.
+void __fillMeshCells(unsigned short* cells, LevelChunk3D* chunk, const int* offset, LevelChunkMesh3D* mesh) {
+    for (int i = 0; i < chunk->count; i++) {
+        Coordinate3D* c = chunk->objects[i]->coordinate;
+        int x = __cellOf(c->x) + 1 + offset[0] * _LEVEL_CHUNK_SIZE;
+        int y = __cellOf(c->y) + 1 + offset[1] * _LEVEL_CHUNK_SIZE;
+        int z = __cellOf(c->z) + 1 + offset[2] * _LEVEL_CHUNK_SIZE;
+        if (x < 0 || x >= _MESH_PADDED || y < 0 || y >= _MESH_PADDED || z < 0 || z >= _MESH_PADDED) continue;
+
+        cells[__meshCell(x, y, z)] = mesh == 0 ? _MESH_FOREIGN : (unsigned short) __LevelChunkMesh3D_material(mesh, chunk->objects[i]->block);
+    }
+}
+
+void __LevelChunkMesh3D_addQuad(LevelChunkMesh3D* mesh, int* capacity, float* corner, float* du, float* dv, int width, int height, int material, int face) {
+    if (mesh->vertexCount + 4 > *capacity) {
+        *capacity = *capacity == 0 ? 64 : *capacity * 2;
+        mesh->vertices = (LevelMeshVertex*) realloc(mesh->vertices, *capacity * sizeof(LevelMeshVertex));
+        mesh->indices = (unsigned int*) realloc(mesh->indices, (*capacity / 4) * 6 * sizeof(unsigned int));
+    }
+
+    // positive faces wind u then v, negative faces v then u, so both face outwards
+    float us[4] = {0, 1, 1, 0};
+    float vs[4] = {0, 0, 1, 1};
+    if ((face & 1) == 0) {
+        us[1] = 0; us[3] = 1;
+        vs[1] = 1; vs[3] = 0;
+    }
+
+    int base = mesh->vertexCount;
+    for (int i = 0; i < 4; i++) {
+        LevelMeshVertex* vertex = &mesh->vertices[base + i];
+        vertex->x = corner[0] + us[i] * du[0] + vs[i] * dv[0];
+        vertex->y = corner[1] + us[i] * du[1] + vs[i] * dv[1];
+        vertex->z = corner[2] + us[i] * du[2] + vs[i] * dv[2];
+        vertex->u = us[i] * width;
+        vertex->v = vs[i] * height;
+        vertex->material = (unsigned short) (material - 1);
+        vertex->face = (unsigned char) face;
+    }
+    mesh->vertexCount += 4;
+
+    unsigned int order[6] = {0, 1, 2, 0, 2, 3};
+    for (int i = 0; i < 6; i++)
+        mesh->indices[mesh->indexCount++] = base + order[i];
+}
+
+void __LevelChunkMesh3D_build(LevelChunkMesh3D* mesh, Level3D* level) {
+    free(mesh->vertices);
+    free(mesh->indices);
+    free(mesh->materials);
+    mesh->vertices = 0;
+    mesh->vertexCount = 0;
+    mesh->indices = 0;
+    mesh->indexCount = 0;
+    mesh->materials = 0;
+    mesh->materialCount = 0;
+    __LevelMesh3D_versions(level, mesh->x, mesh->y, mesh->z, mesh->versions);
+
+    LevelChunk3D* chunk = LevelChunkMap3D_get(&level->chunks, mesh->x, mesh->y, mesh->z);
+    if (chunk == 0 || chunk->count == 0) return;
+
+    unsigned short* cells = (unsigned short*) calloc(_MESH_PADDED * _MESH_PADDED * _MESH_PADDED, sizeof(unsigned short));
+    mesh->materials = (Block**) malloc(chunk->count * sizeof(Block*));
+
+    int self[3] = {0, 0, 0};
+    __fillMeshCells(cells, chunk, self, mesh);
+    for (int i = 0; i < 6; i++) {
+        LevelChunk3D* n = LevelChunkMap3D_get(&level->chunks, mesh->x + __meshNeighbours[i][0], mesh->y + __meshNeighbours[i][1], mesh->z + __meshNeighbours[i][2]);
+        if (n != 0) __fillMeshCells(cells, n, __meshNeighbours[i], 0);
+    }
+
+    float origin[3] = {(float) mesh->x * _LEVEL_CHUNK_SIZE, (float) mesh->y * _LEVEL_CHUNK_SIZE, (float) mesh->z * _LEVEL_CHUNK_SIZE};
+    unsigned short mask[_LEVEL_CHUNK_SIZE * _LEVEL_CHUNK_SIZE];
+    int capacity = 0;
+
+    for (int face = 0; face < 6; face++) {
+        int d = face / 2;
+        int u = (d + 1) % 3;
+        int v = (d + 2) % 3;
+        int sign = (face & 1) ? 1 : -1;
+
+        for (int s = 0; s < _LEVEL_CHUNK_SIZE; s++) {
+            // a face is visible where a block of the chunk has no block in front of it
+            for (int j = 0; j < _LEVEL_CHUNK_SIZE; j++) {
+                for (int i = 0; i < _LEVEL_CHUNK_SIZE; i++) {
+                    int p[3];
+                    p[d] = s + 1;
+                    p[u] = i + 1;
+                    p[v] = j + 1;
+
+                    unsigned short m = cells[__meshCell(p[0], p[1], p[2])];
+                    p[d] += sign;
+                    mask[j * _LEVEL_CHUNK_SIZE + i] = cells[__meshCell(p[0], p[1], p[2])] == 0 ? m : 0;
+                }
+            }
+
+            // merge runs of the same block along u, then grow them along v
+            for (int j = 0; j < _LEVEL_CHUNK_SIZE; j++) {
+                for (int i = 0; i < _LEVEL_CHUNK_SIZE;) {
+                    unsigned short m = mask[j * _LEVEL_CHUNK_SIZE + i];
+                    if (m == 0) {
+                        i++;
+                        continue;
+                    }
+
+                    int width = 1;
+                    while (i + width < _LEVEL_CHUNK_SIZE && mask[j * _LEVEL_CHUNK_SIZE + i + width] == m) width++;
+
+                    int height = 1;
+                    while (j + height < _LEVEL_CHUNK_SIZE) {
+                        int k = 0;
+                        while (k < width && mask[(j + height) * _LEVEL_CHUNK_SIZE + i + k] == m) k++;
+                        if (k < width) break;
+
+                        height++;
+                    }
+
+                    for (int dv = 0; dv < height; dv++)
+                        for (int du = 0; du < width; du++)
+                            mask[(j + dv) * _LEVEL_CHUNK_SIZE + i + du] = 0;
+
+                    float corner[3] = {origin[0], origin[1], origin[2]};
+                    corner[d] += s + (sign > 0 ? 1 : 0);
+                    corner[u] += i;
+                    corner[v] += j;
+
+                    float du[3] = {0, 0, 0};
+                    float dv[3] = {0, 0, 0};
+                    du[u] = (float) width;
+                    dv[v] = (float) height;
+
+                    __LevelChunkMesh3D_addQuad(mesh, &capacity, corner, du, dv, width, height, m, face);
+                    i += width;
+                }
+            }
+        }
+    }
+
+    free(cells);
+}
+
+LevelChunkMesh3D* __createLevelChunkMesh3D(int x, int y, int z) {
+    LevelChunkMesh3D* mesh = (LevelChunkMesh3D*) malloc(sizeof(LevelChunkMesh3D));
+    mesh->x = x;
+    mesh->y = y;
+    mesh->z = z;
+    mesh->vertices = 0;
+    mesh->vertexCount = 0;
+    mesh->indices = 0;
+    mesh->indexCount = 0;
+    mesh->materials = 0;
+    mesh->materialCount = 0;
+
+    return mesh;
+}
+
+void __LevelMesh3D_put(LevelMesh3D* mesh, LevelChunkMesh3D* chunk) {
+    int mask = mesh->capacity - 1;
+    int i = (int) (__hashChunk3D(chunk->x, chunk->y, chunk->z) & mask);
+    while (mesh->meshes[i] != 0) i = (i + 1) & mask;
+
+    mesh->meshes[i] = chunk;
+}
+
+// Implementation
+
+/**
+ * Builds the mesh of a chunk of a Level3D. Faces between two blocks are culled, including
+ * faces against blocks of neighbouring chunks, and the remaining faces of the same block
+ * are merged into quads. Blocks fill the whole-number cell containing their coordinate.
+ * @param level The Level3D.
+ * @param x The x coordinate of the chunk, in chunks.
+ * @param y The y coordinate of the chunk, in chunks.
+ * @param z The z coordinate of the chunk, in chunks.
+ * @return A new mesh, which is empty if the chunk has no blocks.
+ */
+LevelChunkMesh3D* Level3D_meshChunk(Level3D* level, int x, int y, int z) {
+    if (level == 0) return 0;
+
+    LevelChunkMesh3D* mesh = __createLevelChunkMesh3D(x, y, z);
+    __LevelChunkMesh3D_build(mesh, level);
+    return mesh;
+}
+
+/**
+ * Frees a LevelChunkMesh3D. The blocks of the mesh are not freed.
+ * @param mesh The LevelChunkMesh3D.
+ */
+void LevelChunkMesh3D_free(LevelChunkMesh3D* mesh) {
+    if (mesh == 0) return;
+
+    free(mesh->vertices);
+    free(mesh->indices);
+    free(mesh->materials);
+    free(mesh);
+}
+
+/**
+ * Creates the meshes of a Level3D. The meshes are empty until LevelMesh3D_update is called.
+ * @param level The Level3D.
+ * @return A new LevelMesh3D.
+ */
+LevelMesh3D* createLevelMesh3D(Level3D* level) {
+    if (level == 0) return 0;
+
+    LevelMesh3D* mesh = (LevelMesh3D*) malloc(sizeof(LevelMesh3D));
+    mesh->level = level;
+    mesh->meshes = 0;
+    mesh->count = 0;
+    mesh->capacity = 0;
+
+    return mesh;
+}
+
+/**
+ * Gets the mesh of a chunk from a LevelMesh3D.
+ * @param mesh The LevelMesh3D.
+ * @param x The x coordinate of the chunk, in chunks.
+ * @param y The y coordinate of the chunk, in chunks.
+ * @param z The z coordinate of the chunk, in chunks.
+ * @return The mesh of the chunk, or 0 if it has not been built.
+ */
+LevelChunkMesh3D* LevelMesh3D_getChunk(LevelMesh3D* mesh, int x, int y, int z) {
+    if (mesh == 0) return 0;
+    if (mesh->capacity == 0) return 0;
+
+    int mask = mesh->capacity - 1;
+    int i = (int) (__hashChunk3D(x, y, z) & mask);
+    while (mesh->meshes[i] != 0) {
+        LevelChunkMesh3D* chunk = mesh->meshes[i];
+        if (chunk->x == x && chunk->y == y && chunk->z == z) return chunk;
+
+        i = (i + 1) & mask;
+    }
+
+    return 0;
+}
+
+/**
+ * Rebuilds the meshes of the chunks that changed since the last update. A chunk is
+ * dirty when its version, or the version of one of its six neighbours, changed.
+ * @param mesh The LevelMesh3D.
+ * @return The number of chunk meshes that were rebuilt.
+ */
+int LevelMesh3D_update(LevelMesh3D* mesh) {
+    if (mesh == 0) return 0;
+
+    LevelChunkMap3D* chunks = &mesh->level->chunks;
+    int rebuilt = 0;
+
+    for (int i = 0; i < chunks->capacity; i++) {
+        LevelChunk3D* chunk = chunks->chunks[i];
+        if (chunk == 0) continue;
+
+        LevelChunkMesh3D* m = LevelMesh3D_getChunk(mesh, chunk->x, chunk->y, chunk->z);
+        if (m != 0) {
+            int versions[7];
+            __LevelMesh3D_versions(mesh->level, chunk->x, chunk->y, chunk->z, versions);
+            if (memcmp(versions, m->versions, sizeof(versions)) == 0) continue;
+        } else {
+            if (2 * (mesh->count + 1) > mesh->capacity) {
+                LevelChunkMesh3D** old = mesh->meshes;
+                int oldCapacity = mesh->capacity;
+
+                mesh->capacity = oldCapacity == 0 ? 16 : 2 * oldCapacity;
+                mesh->meshes = (LevelChunkMesh3D**) calloc(mesh->capacity, sizeof(LevelChunkMesh3D*));
+                for (int j = 0; j < oldCapacity; j++) {
+                    if (old[j] != 0) __LevelMesh3D_put(mesh, old[j]);
+                }
+
+                free(old);
+            }
+
+            m = __createLevelChunkMesh3D(chunk->x, chunk->y, chunk->z);
+            __LevelMesh3D_put(mesh, m);
+            mesh->count++;
+        }
+
+        __LevelChunkMesh3D_build(m, mesh->level);
+        rebuilt++;
+    }
+
+    return rebuilt;
+}
+
+/**
+ * Frees a LevelMesh3D and the meshes of its chunks. The level is not freed.
+ * @param mesh The LevelMesh3D.
+ */
+void LevelMesh3D_free(LevelMesh3D* mesh) {
+    if (mesh == 0) return;
+
+    for (int i = 0; i < mesh->capacity; i++)
+        LevelChunkMesh3D_free(mesh->meshes[i]);
+
+    free(mesh->meshes);
+    free(mesh);
+}
+
+#endif
@@ -0,0 +1,771 @@
+#ifndef LEVELZ_PATCH_H
+#define LEVELZ_PATCH_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../levelz.h"
+
+// Internal
+
+void* __growArray(void* array, int count, size_t size) {
+    if (count == 0) return malloc(4 * size);
+    if (count < 4 || (count & (count - 1)) != 0) return array;
+
+    return realloc(array, 2 * count * size);
+}
+
+// Implementation
+
+/**
+ * Represents the changes that turn one Level2D into another.
+ *
+ * A patch serializes to a compact line-based text form that mirrors the LevelZ format:
+ * `@name value` sets a header, `-@name` removes a header, `-[x, ...]*[x, ...]` removes
+ * blocks and `+block: [x, ...]*[x, ...]` adds or replaces blocks.
+ */
+typedef struct LevelPatch2D {
+    /**
+     * The headers added or changed by the patch.
+     */
+    LevelHeader** headers;
+
+    /**
+     * The number of headers added or changed by the patch.
+     */
+    int headerCount;
+
+    /**
+     * The names of the headers removed by the patch.
+     */
+    char** removedHeaders;
+
+    /**
+     * The number of headers removed by the patch.
+     */
+    int removedHeaderCount;
+
+    /**
+     * The blocks added or replaced by the patch.
+     */
+    LevelObject2D** blocks;
+
+    /**
+     * The number of blocks added or replaced by the patch.
+     */
+    int blockCount;
+
+    /**
+     * The coordinates of the blocks removed by the patch.
+     */
+    Coordinate2D** removed;
+
+    /**
+     * The number of blocks removed by the patch.
+     */
+    int removedCount;
+} LevelPatch2D;
+
+/**
+ * Creates a new, empty LevelPatch2D.
+ * @return A new LevelPatch2D.
+ */
+LevelPatch2D* createLevelPatch2D() {
+    LevelPatch2D* p = (LevelPatch2D*) malloc(sizeof(LevelPatch2D));
+    p->headers = 0;
+    p->headerCount = 0;
+    p->removedHeaders = 0;
+    p->removedHeaderCount = 0;
+    p->blocks = 0;
+    p->blockCount = 0;
+    p->removed = 0;
+    p->removedCount = 0;
+
+    return p;
+}
+
+/**
+ * Frees a LevelPatch2D, together with the headers, coordinates, objects and blocks
+ * it owns.
+ * @param patch The LevelPatch2D.
+ */
+void LevelPatch2D_free(LevelPatch2D* patch) {
+    if (patch == 0) return;
+
+    for (int i = 0; i < patch->headerCount; i++) {
+        free(patch->headers[i]->name);
+        free(patch->headers[i]->value);
+        free(patch->headers[i]);
+    }
+
+    for (int i = 0; i < patch->removedHeaderCount; i++)
+        free(patch->removedHeaders[i]);
+
+    for (int i = 0; i < patch->removedCount; i++)
+        free(patch->removed[i]);
+
+    // objects share blocks, so each distinct block is freed once
+    Block** blocks = (Block**) malloc((patch->blockCount + 1) * sizeof(Block*));
+    for (int i = 0; i < patch->blockCount; i++) {
+        blocks[i] = patch->blocks[i]->block;
+        free(patch->blocks[i]);
+    }
+
+    qsort(blocks, patch->blockCount, sizeof(Block*), __comparePointers);
+    for (int i = 0; i < patch->blockCount; i++)
+        if (i == 0 || blocks[i] != blocks[i - 1]) __Block_free(blocks[i]);
+
+    free(blocks);
+    free(patch->headers);
+    free(patch->removedHeaders);
+    free(patch->removed);
+    free(patch->blocks);
+    free(patch);
+}
+
+/**
+ * Records a header being added or changed in a LevelPatch2D.
+ * @param patch The LevelPatch2D.
+ * @param name The name of the header.
+ * @param value The new value of the header.
+ */
+void LevelPatch2D_setHeader(LevelPatch2D* patch, const char* name, const char* value) {
+    if (patch == 0) return;
+    if (name == 0) return;
+    if (value == 0) return;
+
+    patch->headers = (LevelHeader**) __growArray(patch->headers, patch->headerCount, sizeof(LevelHeader*));
+    patch->headers[patch->headerCount++] = createLevelHeader(__copyString(name), __copyString(value));
+}
+
+/**
+ * Records a header being removed in a LevelPatch2D.
+ * @param patch The LevelPatch2D.
+ * @param name The name of the header.
+ */
+void LevelPatch2D_removeHeader(LevelPatch2D* patch, const char* name) {
+    if (patch == 0) return;
+    if (name == 0) return;
+
+    patch->removedHeaders = (char**) __growArray(patch->removedHeaders, patch->removedHeaderCount, sizeof(char*));
+    patch->removedHeaders[patch->removedHeaderCount++] = __copyString(name);
+}
+
+/**
+ * Records a block being added or replaced in a LevelPatch2D. The patch takes
+ * ownership of the object and its block.
+ * @param patch The LevelPatch2D.
+ * @param block The block and its coordinate.
+ */
+void LevelPatch2D_addBlock(LevelPatch2D* patch, LevelObject2D* block) {
+    if (patch == 0) return;
+    if (block == 0) return;
+
+    patch->blocks = (LevelObject2D**) __growArray(patch->blocks, patch->blockCount, sizeof(LevelObject2D*));
+    patch->blocks[patch->blockCount++] = block;
+}
+
+/**
+ * Records a block being removed in a LevelPatch2D. The patch takes ownership of
+ * the coordinate.
+ * @param patch The LevelPatch2D.
+ * @param coordinate The coordinate of the removed block.
+ */
+void LevelPatch2D_removeBlock(LevelPatch2D* patch, Coordinate2D* coordinate) {
+    if (patch == 0) return;
+    if (coordinate == 0) return;
+
+    patch->removed = (Coordinate2D**) __growArray(patch->removed, patch->removedCount, sizeof(Coordinate2D*));
+    patch->removed[patch->removedCount++] = coordinate;
+}
+
+/**
+ * Computes the patch that turns one Level2D into another. Runs in time linear
+ * in the number of blocks, using the coordinate index of both levels.
+ * @param from The original level.
+ * @param to The updated level.
+ * @return The patch that turns `from` into `to`.
+ */
+LevelPatch2D* Level2D_diff(Level2D* from, Level2D* to) {
+    if (from == 0 || to == 0) return 0;
+
+    LevelPatch2D* patch = createLevelPatch2D();
+
+    int fromHeaders = Level2D_getHeaderCount(from);
+    int toHeaders = Level2D_getHeaderCount(to);
+    for (int i = 0; i < fromHeaders; i++) {
+        if (Level2D_getHeader(to, from->headers[i]->name) == 0)
+            LevelPatch2D_removeHeader(patch, from->headers[i]->name);
+    }
+
+    for (int i = 0; i < toHeaders; i++) {
+        char* value = Level2D_getHeader(from, to->headers[i]->name);
+        if (value == 0 || strcmp(value, to->headers[i]->value) != 0)
+            LevelPatch2D_setHeader(patch, to->headers[i]->name, to->headers[i]->value);
+    }
+
+    for (int i = 0; i < from->blockCount; i++) {
+        Coordinate2D* c = from->blocks[i]->coordinate;
+        // copied, since the object embedding the coordinate may be removed by applying the patch
+        if (__Level2D_findBlock(to, c->x, c->y) < 0)
+            LevelPatch2D_removeBlock(patch, createCoordinate2D(c->x, c->y));
+    }
+
+    // the patch owns copies of the blocks, made once for each run of objects sharing one
+    Block* source = 0;
+    Block* copy = 0;
+    for (int i = 0; i < to->blockCount; i++) {
+        Coordinate2D* c = to->blocks[i]->coordinate;
+        int position = __Level2D_findBlock(from, c->x, c->y);
+        if (position >= 0 && Block_equals(from->blocks[position]->block, to->blocks[i]->block)) continue;
+
+        if (to->blocks[i]->block != source) {
+            source = to->blocks[i]->block;
+            copy = __Block_copy(source);
+        }
+
+        LevelPatch2D_addBlock(patch, createLevelObject2DAt(copy, *c));
+    }
+
+    return patch;
+}
+
+/**
+ * Applies a patch to a Level2D in place. The level gets its own copies of the
+ * blocks, so the patch can be freed afterwards.
+ * @param level The Level2D.
+ * @param patch The patch to apply.
+ */
+void Level2D_applyPatch(Level2D* level, LevelPatch2D* patch) {
+    if (level == 0) return;
+    if (patch == 0) return;
+
+    for (int i = 0; i < patch->removedHeaderCount; i++)
+        Level2D_removeHeader(level, patch->removedHeaders[i]);
+
+    for (int i = 0; i < patch->headerCount; i++) {
+        LevelHeader* h = patch->headers[i];
+        Level2D_addHeader(level, __copyString(h->name), __copyString(h->value));
+
+        if (strcmp(h->name, "spawn") == 0) {
+            Coordinate2D* spawn = Coordinate2D_fromString(h->value);
+            if (spawn != 0) {
+                free(level->spawn);
+                level->spawn = spawn;
+            }
+        }
+    }
+
+    for (int i = 0; i < patch->removedCount; i++) {
+        Coordinate2D* c = patch->removed[i];
+        int position = __Level2D_findBlock(level, c->x, c->y);
+        if (position >= 0)
+            Level2D_removeBlock(level, level->blocks[position]);
+    }
+
+    if (patch->blockCount == 0) return;
+
+    Block* source = 0;
+    Block* copy = 0;
+    LevelObject2D** blocks = (LevelObject2D**) malloc(patch->blockCount * sizeof(LevelObject2D*));
+    for (int i = 0; i < patch->blockCount; i++) {
+        LevelObject2D* o = patch->blocks[i];
+        if (o->block != source) {
+            source = o->block;
+            copy = __Block_copy(source);
+        }
+
+        blocks[i] = createLevelObject2DAt(copy, *o->coordinate);
+    }
+
+    Level2D_addBlocks(level, blocks, patch->blockCount);
+    free(blocks);
+}
+
+/**
+ * Converts a LevelPatch2D to its compact text form. Added blocks are grouped
+ * by block, so each distinct block is written once.
+ * @param patch The LevelPatch2D.
+ * @return The string representation of the patch.
+ */
+char* LevelPatch2D_toString(LevelPatch2D* patch) {
+    if (patch == 0) return 0;
+
+    char* str = 0;
+    size_t length = 0;
+    size_t capacity = 0;
+    __appendf(&str, &length, &capacity, "");
+
+    for (int i = 0; i < patch->removedHeaderCount; i++)
+        __appendf(&str, &length, &capacity, "-@%s\n", patch->removedHeaders[i]);
+
+    for (int i = 0; i < patch->headerCount; i++)
+        __appendf(&str, &length, &capacity, "@%s %s\n", patch->headers[i]->name, patch->headers[i]->value);
+
+    if (patch->removedCount > 0) {
+        __appendf(&str, &length, &capacity, "-");
+        for (int i = 0; i < patch->removedCount; i++) {
+            if (i > 0) __appendf(&str, &length, &capacity, "*");
+            __appendCoordinate2D(&str, &length, &capacity, patch->removed[i]);
+        }
+        __appendf(&str, &length, &capacity, "\n");
+    }
+
+    __appendBlocks2D(&str, &length, &capacity, patch->blocks, patch->blockCount, "+");
+
+    return str;
+}
+
+/**
+ * Converts a string to a LevelPatch2D.
+ * @param str The string representation of the patch.
+ * @return The LevelPatch2D, or 0 if the string is malformed.
+ */
+LevelPatch2D* LevelPatch2D_fromString(const char* str) {
+    if (str == 0) return 0;
+
+    LevelPatch2D* patch = createLevelPatch2D();
+
+    char* str0 = __copyString(str);
+    char* cursor = str0;
+    char* token = __nextLine(&cursor);
+    while (token != 0) {
+        char* line = __trim(token);
+
+        if (line[0] == '-' && line[1] == '@') {
+            LevelPatch2D_removeHeader(patch, line + 2);
+        } else if (line[0] == '@') {
+            LevelHeader* h = LevelHeader_fromString(line);
+            if (h == 0) {
+                free(line);
+                free(str0);
+                LevelPatch2D_free(patch);
+                return 0;
+            }
+
+            LevelPatch2D_setHeader(patch, h->name, h->value);
+            free(h->name);
+            free(h->value);
+            free(h);
+        } else if (line[0] == '-') {
+            Coordinate2D** coordinates = __read2DPoints(line + 1);
+            if (coordinates == 0) {
+                free(line);
+                free(str0);
+                LevelPatch2D_free(patch);
+                return 0;
+            }
+
+            for (int i = 0; coordinates[i] != 0; i++)
+                LevelPatch2D_removeBlock(patch, coordinates[i]);
+            free(coordinates);
+        } else if (line[0] == '+') {
+            LevelZLine2D* l = __read2DLine(line + 1);
+            if (l->block == 0 || l->coordinates == 0) {
+                if (l->block != 0) __Block_free(l->block);
+                free(l);
+                free(line);
+                free(str0);
+                LevelPatch2D_free(patch);
+                return 0;
+            }
+
+            if (l->coordinates[0] == 0) __Block_free(l->block);
+            for (int i = 0; l->coordinates[i] != 0; i++) {
+                LevelPatch2D_addBlock(patch, createLevelObject2DAt(l->block, *l->coordinates[i]));
+                free(l->coordinates[i]);
+            }
+            free(l->coordinates);
+            free(l);
+        } else if (line[0] != '\0') {
+            free(line);
+            free(str0);
+            LevelPatch2D_free(patch);
+            return 0;
+        }
+
+        free(line);
+        token = __nextLine(&cursor);
+    }
+
+    free(str0);
+    return patch;
+}
+
+/**
+ * Represents the changes that turn one Level3D into another.
+ *
+ * A patch serializes to a compact line-based text form that mirrors the LevelZ format:
+ * `@name value` sets a header, `-@name` removes a header, `-[x, ...]*[x, ...]` removes
+ * blocks and `+block: [x, ...]*[x, ...]` adds or replaces blocks.
+ */
+typedef struct LevelPatch3D {
+    /**
+     * The headers added or changed by the patch.
+     */
+    LevelHeader** headers;
+
+    /**
+     * The number of headers added or changed by the patch.
+     */
+    int headerCount;
+
+    /**
+     * The names of the headers removed by the patch.
+     */
+    char** removedHeaders;
+
+    /**
+     * The number of headers removed by the patch.
+     */
+    int removedHeaderCount;
+
+    /**
+     * The blocks added or replaced by the patch.
+     */
+    LevelObject3D** blocks;
+
+    /**
+     * The number of blocks added or replaced by the patch.
+     */
+    int blockCount;
+
+    /**
+     * The coordinates of the blocks removed by the patch.
+     */
+    Coordinate3D** removed;
+
+    /**
+     * The number of blocks removed by the patch.
+     */
+    int removedCount;
+} LevelPatch3D;
+
+/**
+ * Creates a new, empty LevelPatch3D.
+ * @return A new LevelPatch3D.
+ */
+LevelPatch3D* createLevelPatch3D() {
+    LevelPatch3D* p = (LevelPatch3D*) malloc(sizeof(LevelPatch3D));
+    p->headers = 0;
+    p->headerCount = 0;
+    p->removedHeaders = 0;
+    p->removedHeaderCount = 0;
+    p->blocks = 0;
+    p->blockCount = 0;
+    p->removed = 0;
+    p->removedCount = 0;
+
+    return p;
+}
+
+/**
+ * Frees a LevelPatch3D, together with the headers, coordinates, objects and blocks
+ * it owns.
+ * @param patch The LevelPatch3D.
+ */
+void LevelPatch3D_free(LevelPatch3D* patch) {
+    if (patch == 0) return;
+
+    for (int i = 0; i < patch->headerCount; i++) {
+        free(patch->headers[i]->name);
+        free(patch->headers[i]->value);
+        free(patch->headers[i]);
+    }
+
+    for (int i = 0; i < patch->removedHeaderCount; i++)
+        free(patch->removedHeaders[i]);
+
+    for (int i = 0; i < patch->removedCount; i++)
+        free(patch->removed[i]);
+
+    // objects share blocks, so each distinct block is freed once
+    Block** blocks = (Block**) malloc((patch->blockCount + 1) * sizeof(Block*));
+    for (int i = 0; i < patch->blockCount; i++) {
+        blocks[i] = patch->blocks[i]->block;
+        free(patch->blocks[i]);
+    }
+
+    qsort(blocks, patch->blockCount, sizeof(Block*), __comparePointers);
+    for (int i = 0; i < patch->blockCount; i++)
+        if (i == 0 || blocks[i] != blocks[i - 1]) __Block_free(blocks[i]);
+
+    free(blocks);
+    free(patch->headers);
+    free(patch->removedHeaders);
+    free(patch->removed);
+    free(patch->blocks);
+    free(patch);
+}
+
+/**
+ * Records a header being added or changed in a LevelPatch3D.
+ * @param patch The LevelPatch3D.
+ * @param name The name of the header.
+ * @param value The new value of the header.
+ */
+void LevelPatch3D_setHeader(LevelPatch3D* patch, const char* name, const char* value) {
+    if (patch == 0) return;
+    if (name == 0) return;
+    if (value == 0) return;
+
+    patch->headers = (LevelHeader**) __growArray(patch->headers, patch->headerCount, sizeof(LevelHeader*));
+    patch->headers[patch->headerCount++] = createLevelHeader(__copyString(name), __copyString(value));
+}
+
+/**
+ * Records a header being removed in a LevelPatch3D.
+ * @param patch The LevelPatch3D.
+ * @param name The name of the header.
+ */
+void LevelPatch3D_removeHeader(LevelPatch3D* patch, const char* name) {
+    if (patch == 0) return;
+    if (name == 0) return;
+
+    patch->removedHeaders = (char**) __growArray(patch->removedHeaders, patch->removedHeaderCount, sizeof(char*));
+    patch->removedHeaders[patch->removedHeaderCount++] = __copyString(name);
+}
+
+/**
+ * Records a block being added or replaced in a LevelPatch3D. The patch takes
+ * ownership of the object and its block.
+ * @param patch The LevelPatch3D.
+ * @param block The block and its coordinate.
+ */
+void LevelPatch3D_addBlock(LevelPatch3D* patch, LevelObject3D* block) {
+    if (patch == 0) return;
+    if (block == 0) return;
+
+    patch->blocks = (LevelObject3D**) __growArray(patch->blocks, patch->blockCount, sizeof(LevelObject3D*));
+    patch->blocks[patch->blockCount++] = block;
+}
+
+/**
+ * Records a block being removed in a LevelPatch3D. The patch takes ownership of
+ * the coordinate.
+ * @param patch The LevelPatch3D.
+ * @param coordinate The coordinate of the removed block.
+ */
+void LevelPatch3D_removeBlock(LevelPatch3D* patch, Coordinate3D* coordinate) {
+    if (patch == 0) return;
+    if (coordinate == 0) return;
+
+    patch->removed = (Coordinate3D**) __growArray(patch->removed, patch->removedCount, sizeof(Coordinate3D*));
+    patch->removed[patch->removedCount++] = coordinate;
+}
+
+/**
+ * Computes the patch that turns one Level3D into another. Runs in time linear
+ * in the number of blocks, using the coordinate index of both levels.
+ * @param from The original level.
+ * @param to The updated level.
+ * @return The patch that turns `from` into `to`.
+ */
+LevelPatch3D* Level3D_diff(Level3D* from, Level3D* to) {
+    if (from == 0 || to == 0) return 0;
+
+    LevelPatch3D* patch = createLevelPatch3D();
+
+    int fromHeaders = Level3D_getHeaderCount(from);
+    int toHeaders = Level3D_getHeaderCount(to);
+    for (int i = 0; i < fromHeaders; i++) {
+        if (Level3D_getHeader(to, from->headers[i]->name) == 0)
+            LevelPatch3D_removeHeader(patch, from->headers[i]->name);
+    }
+
+    for (int i = 0; i < toHeaders; i++) {
+        char* value = Level3D_getHeader(from, to->headers[i]->name);
+        if (value == 0 || strcmp(value, to->headers[i]->value) != 0)
+            LevelPatch3D_setHeader(patch, to->headers[i]->name, to->headers[i]->value);
+    }
+
+    for (int i = 0; i < from->blockCount; i++) {
+        Coordinate3D* c = from->blocks[i]->coordinate;
+        // copied, since the object embedding the coordinate may be removed by applying the patch
+        if (__Level3D_findBlock(to, c->x, c->y, c->z) < 0)
+            LevelPatch3D_removeBlock(patch, createCoordinate3D(c->x, c->y, c->z));
+    }
+
+    // the patch owns copies of the blocks, made once for each run of objects sharing one
+    Block* source = 0;
+    Block* copy = 0;
+    for (int i = 0; i < to->blockCount; i++) {
+        Coordinate3D* c = to->blocks[i]->coordinate;
+        int position = __Level3D_findBlock(from, c->x, c->y, c->z);
+        if (position >= 0 && Block_equals(from->blocks[position]->block, to->blocks[i]->block)) continue;
+
+        if (to->blocks[i]->block != source) {
+            source = to->blocks[i]->block;
+            copy = __Block_copy(source);
+        }
+
+        LevelPatch3D_addBlock(patch, createLevelObject3DAt(copy, *c));
+    }
+
+    return patch;
+}
+
+/**
+ * Applies a patch to a Level3D in place. The level gets its own copies of the
+ * blocks, so the patch can be freed afterwards.
+ * @param level The Level3D.
+ * @param patch The patch to apply.
+ */
+void Level3D_applyPatch(Level3D* level, LevelPatch3D* patch) {
+    if (level == 0) return;
+    if (patch == 0) return;
+
+    for (int i = 0; i < patch->removedHeaderCount; i++)
+        Level3D_removeHeader(level, patch->removedHeaders[i]);
+
+    for (int i = 0; i < patch->headerCount; i++) {
+        LevelHeader* h = patch->headers[i];
+        Level3D_addHeader(level, __copyString(h->name), __copyString(h->value));
+
+        if (strcmp(h->name, "spawn") == 0) {
+            Coordinate3D* spawn = Coordinate3D_fromString(h->value);
+            if (spawn != 0) {
+                free(level->spawn);
+                level->spawn = spawn;
+            }
+        }
+    }
+
+    for (int i = 0; i < patch->removedCount; i++) {
+        Coordinate3D* c = patch->removed[i];
+        int position = __Level3D_findBlock(level, c->x, c->y, c->z);
+        if (position >= 0)
+            Level3D_removeBlock(level, level->blocks[position]);
+    }
+
+    if (patch->blockCount == 0) return;
+
+    Block* source = 0;
+    Block* copy = 0;
+    LevelObject3D** blocks = (LevelObject3D**) malloc(patch->blockCount * sizeof(LevelObject3D*));
+    for (int i = 0; i < patch->blockCount; i++) {
+        LevelObject3D* o = patch->blocks[i];
+        if (o->block != source) {
+            source = o->block;
+            copy = __Block_copy(source);
+        }
+
+        blocks[i] = createLevelObject3DAt(copy, *o->coordinate);
+    }
+
+    Level3D_addBlocks(level, blocks, patch->blockCount);
+    free(blocks);
+}
+
+/**
+ * Converts a LevelPatch3D to its compact text form. Added blocks are grouped
+ * by block, so each distinct block is written once.
+ * @param patch The LevelPatch3D.
+ * @return The string representation of the patch.
+ */
+char* LevelPatch3D_toString(LevelPatch3D* patch) {
+    if (patch == 0) return 0;
+
+    char* str = 0;
+    size_t length = 0;
+    size_t capacity = 0;
+    __appendf(&str, &length, &capacity, "");
+
+    for (int i = 0; i < patch->removedHeaderCount; i++)
+        __appendf(&str, &length, &capacity, "-@%s\n", patch->removedHeaders[i]);
+
+    for (int i = 0; i < patch->headerCount; i++)
+        __appendf(&str, &length, &capacity, "@%s %s\n", patch->headers[i]->name, patch->headers[i]->value);
+
+    if (patch->removedCount > 0) {
+        __appendf(&str, &length, &capacity, "-");
+        for (int i = 0; i < patch->removedCount; i++) {
+            if (i > 0) __appendf(&str, &length, &capacity, "*");
+            __appendCoordinate3D(&str, &length, &capacity, patch->removed[i]);
+        }
+        __appendf(&str, &length, &capacity, "\n");
+    }
+
+    __appendBlocks3D(&str, &length, &capacity, patch->blocks, patch->blockCount, "+");
+
+    return str;
+}
+
+/**
+ * Converts a string to a LevelPatch3D.
+ * @param str The string representation of the patch.
+ * @return The LevelPatch3D, or 0 if the string is malformed.
+ */
+LevelPatch3D* LevelPatch3D_fromString(const char* str) {
+    if (str == 0) return 0;
+
+    LevelPatch3D* patch = createLevelPatch3D();
+
+    char* str0 = __copyString(str);
+    char* cursor = str0;
+    char* token = __nextLine(&cursor);
+    while (token != 0) {
+        char* line = __trim(token);
+
+        if (line[0] == '-' && line[1] == '@') {
+            LevelPatch3D_removeHeader(patch, line + 2);
+        } else if (line[0] == '@') {
+            LevelHeader* h = LevelHeader_fromString(line);
+            if (h == 0) {
+                free(line);
+                free(str0);
+                LevelPatch3D_free(patch);
+                return 0;
+            }
+
+            LevelPatch3D_setHeader(patch, h->name, h->value);
+            free(h->name);
+            free(h->value);
+            free(h);
+        } else if (line[0] == '-') {
+            Coordinate3D** coordinates = __read3DPoints(line + 1);
+            if (coordinates == 0) {
+                free(line);
+                free(str0);
+                LevelPatch3D_free(patch);
+                return 0;
+            }
+
+            for (int i = 0; coordinates[i] != 0; i++)
+                LevelPatch3D_removeBlock(patch, coordinates[i]);
+            free(coordinates);
+        } else if (line[0] == '+') {
+            LevelZLine3D* l = __read3DLine(line + 1);
+            if (l->block == 0 || l->coordinates == 0) {
+                if (l->block != 0) __Block_free(l->block);
+                free(l);
+                free(line);
+                free(str0);
+                LevelPatch3D_free(patch);
+                return 0;
+            }
+
+            if (l->coordinates[0] == 0) __Block_free(l->block);
+            for (int i = 0; l->coordinates[i] != 0; i++) {
+                LevelPatch3D_addBlock(patch, createLevelObject3DAt(l->block, *l->coordinates[i]));
+                free(l->coordinates[i]);
+            }
+            free(l->coordinates);
+            free(l);
+        } else if (line[0] != '\0') {
+            free(line);
+            free(str0);
+            LevelPatch3D_free(patch);
+            return 0;
+        }
+
+        free(line);
+        token = __nextLine(&cursor);
+    }
+
+    free(str0);
+    return patch;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,603 @@
+#ifndef LEVELZ_PATH_H
+#define LEVELZ_PATH_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tgmath.h>
+
+#include "block.h"
+#include "chunk.h"
+#include "coordinate.h"
+#include "level.h"
+
+/**
+ * Represents the walkable cells of a Level2D as a dense grid, used for pathfinding.
+ * The grid covers the chunks of the level and is rebuilt one chunk at a time as the
+ * level changes. Blocks fill the whole-number cell containing their coordinate.
+ */
+typedef struct LevelNavGrid2D {
+    /**
+     * The level the grid is built from.
+     */
+    Level2D* level;
+
+    /**
+     * Selects the blocks that can be walked through, or 0 if every block can be.
+     */
+    BlockPredicate walkable;
+
+    /**
+     * The data passed to the predicate.
+     */
+    void* data;
+
+    /**
+     * Whether cells without blocks can be walked through.
+     */
+    int emptyWalkable;
+
+    /**
+     * The first chunk covered by the grid.
+     */
+    int chunkX, chunkY;
+
+    /**
+     * The number of chunks covered by the grid along each axis.
+     */
+    int chunkWidth, chunkHeight;
+
+    /**
+     * The size of the grid in cells.
+     */
+    int width, height;
+
+    /**
+     * One byte per cell, 1 if the cell can be walked through.
+     */
+    unsigned char* cells;
+
+    /**
+     * The version of each covered chunk when it was last built, or -1 if it did not exist.
+     */
+    int* versions;
+} LevelNavGrid2D;
+
+/**
+ * The buffers of a path search on a LevelNavGrid2D. Each thread searching the same grid
+ * needs its own search. Searches only allocate when the grid grows.
+ */
+typedef struct LevelPathSearch2D {
+    /**
+     * The grid the search runs on.
+     */
+    LevelNavGrid2D* grid;
+
+    /**
+     * The number of cells the buffers are sized for.
+     */
+    int size;
+
+    /**
+     * The cost of the best known path to each cell.
+     */
+    float* costs;
+
+    /**
+     * The previous jump point on the best known path to each cell.
+     */
+    int* parents;
+
+    /**
+     * The search generation that last reached each cell, so buffers need no clearing.
+     */
+    unsigned int* seen;
+
+    /**
+     * The search generation that last closed each cell.
+     */
+    unsigned int* closed;
+
+    /**
+     * The current search generation.
+     */
+    unsigned int generation;
+
+    /**
+     * The open set, as a binary heap of cells ordered by estimated cost.
+     */
+    struct __PathNode* heap;
+
+    /**
+     * The number of entries in the heap.
+     */
+    int heapCount;
+
+    /**
+     * The capacity of the heap.
+     */
+    int heapCapacity;
+
+    /**
+     * The jump points of the last path, from the goal back to the start.
+     */
+    int* points;
+
+    /**
+     * The capacity of the jump point buffer.
+     */
+    int pointCapacity;
+
+    /**
+     * The cost of the last path found, with straight steps costing 1 and diagonal steps sqrt(2).
+     */
+    double cost;
+} LevelPathSearch2D;
+
+// Internal
+
+typedef struct __PathNode {
+    float f;
+    int cell;
+} __PathNode;
+
+int __LevelNavGrid2D_walkable(LevelNavGrid2D* grid, int x, int y) {
+    if (x < 0 || y < 0 || x >= grid->width || y >= grid->height) return 0;
+    return grid->cells[y * grid->width + x];
+}
+
+void __LevelNavGrid2D_buildChunk(LevelNavGrid2D* grid, int i, int j) {
+    LevelChunk2D* chunk = LevelChunkMap2D_get(&grid->level->chunks, grid->chunkX + i, grid->chunkY + j);
+    grid->versions[j * grid->chunkWidth + i] = chunk == 0 ? -1 : chunk->version;
+
+    int x0 = i * _LEVEL_CHUNK_SIZE;
+    int y0 = j * _LEVEL_CHUNK_SIZE;
+    for (int y = 0; y < _LEVEL_CHUNK_SIZE; y++)
+        memset(grid->cells + (y0 + y) * grid->width + x0, grid->emptyWalkable ? 1 : 0, _LEVEL_CHUNK_SIZE);
+
+    if (chunk == 0) return;
+
+    // a cell is walkable when every block in it is
+    for (int k = 0; k < chunk->count; k++) {
+        int key = __cellKey2D(chunk->objects[k]->coordinate);
+        grid->cells[(y0 + (key >> 4)) * grid->width + x0 + (key & 0xF)] = 1;
+    }
+
+    for (int k = 0; k < chunk->count; k++) {
+        LevelObject2D* o = chunk->objects[k];
+        if (grid->walkable == 0 || grid->walkable(o->block, grid->data)) continue;
+
+        int key = __cellKey2D(o->coordinate);
+        grid->cells[(y0 + (key >> 4)) * grid->width + x0 + (key & 0xF)] = 0;
+    }
+}
+
+void __LevelPathSearch2D_push(LevelPathSearch2D* search, int cell, float f) {
+    if (search->heapCount == search->heapCapacity) {
+        search->heapCapacity = search->heapCapacity == 0 ? 64 : search->heapCapacity * 2;
+        search->heap = (__PathNode*) realloc(search->heap, search->heapCapacity * sizeof(__PathNode));
+    }
+
+    int i = search->heapCount++;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (search->heap[parent].f <= f) break;
+
+        search->heap[i] = search->heap[parent];
+        i = parent;
+    }
+
+    search->heap[i].f = f;
+    search->heap[i].cell = cell;
+}
+
+int __LevelPathSearch2D_pop(LevelPathSearch2D* search) {
+    int cell = search->heap[0].cell;
+    __PathNode last = search->heap[--search->heapCount];
+
+    int i = 0;
+    while (1) {
+        int child = 2 * i + 1;
+        if (child >= search->heapCount) break;
+        if (child + 1 < search->heapCount && search->heap[child + 1].f < search->heap[child].f) child++;
+        if (last.f <= search->heap[child].f) break;
+
+        search->heap[i] = search->heap[child];
+        i = child;
+    }
+
+    if (search->heapCount > 0) search->heap[i] = last;
+    return cell;
+}
+
+float __octile(int dx, int dy) {
+    if (dx < 0) dx = -dx;
+    if (dy < 0) dy = -dy;
+
+    int lo = dx < dy ? dx : dy;
+    int hi = dx < dy ? dy : dx;
+    return (float) (hi - lo) + 1.41421356f * lo;
+}
+
+int __sign(int value) {
+    return (value > 0) - (value < 0);
+}
+
+// Moves from a cell in a direction until reaching the goal or a cell with a forced
+// neighbour. Diagonal moves need both adjacent straight cells to be walkable, so paths
+// never cut corners. Returns the cell index of the jump point, or -1.
+int __LevelNavGrid2D_jump(LevelNavGrid2D* grid, int x, int y, int dx, int dy, int goal) {
+    while (1) {
+        if (!__LevelNavGrid2D_walkable(grid, x, y)) return -1;
+
+        int cell = y * grid->width + x;
+        if (cell == goal) return cell;
+
+        if (dx != 0 && dy != 0) {
+            if (__LevelNavGrid2D_jump(grid, x + dx, y, dx, 0, goal) >= 0) return cell;
+            if (__LevelNavGrid2D_jump(grid, x, y + dy, 0, dy, goal) >= 0) return cell;
+        } else if (dx != 0) {
+            if (__LevelNavGrid2D_walkable(grid, x, y - 1) && !__LevelNavGrid2D_walkable(grid, x - dx, y - 1)) return cell;
+            if (__LevelNavGrid2D_walkable(grid, x, y + 1) && !__LevelNavGrid2D_walkable(grid, x - dx, y + 1)) return cell;
+        } else {
+            if (__LevelNavGrid2D_walkable(grid, x - 1, y) && !__LevelNavGrid2D_walkable(grid, x - 1, y - dy)) return cell;
+            if (__LevelNavGrid2D_walkable(grid, x + 1, y) && !__LevelNavGrid2D_walkable(grid, x + 1, y - dy)) return cell;
+        }
+
+        if (!__LevelNavGrid2D_walkable(grid, x + dx, y) || !__LevelNavGrid2D_walkable(grid, x, y + dy)) return -1;
+
+        x += dx;
+        y += dy;
+    }
+}
+
+// Collects the directions to search from a cell, pruned by the direction it was reached from.
+int __LevelNavGrid2D_directions(LevelNavGrid2D* grid, int x, int y, int dx, int dy, int* directions) {
+    int count = 0;
+
+    if (dx == 0 && dy == 0) {
+        for (int i = -1; i <= 1; i++) {
+            for (int j = -1; j <= 1; j++) {
+                if (i == 0 && j == 0) continue;
+                if (!__LevelNavGrid2D_walkable(grid, x + i, y + j)) continue;
+                if (i != 0 && j != 0 && (!__LevelNavGrid2D_walkable(grid, x + i, y) || !__LevelNavGrid2D_walkable(grid, x, y + j))) continue;
+
+                directions[count++] = i;
+                directions[count++] = j;
+            }
+        }
+
+        return count / 2;
+    }
+
+    if (dx != 0 && dy != 0) {
+        int vertical = __LevelNavGrid2D_walkable(grid, x, y + dy);
+        int horizontal = __LevelNavGrid2D_walkable(grid, x + dx, y);
+        if (vertical) { directions[count++] = 0; directions[count++] = dy; }
+        if (horizontal) { directions[count++] = dx; directions[count++] = 0; }
+        if (vertical && horizontal) { directions[count++] = dx; directions[count++] = dy; }
+    } else if (dx != 0) {
+        int next = __LevelNavGrid2D_walkable(grid, x + dx, y);
+        int up = __LevelNavGrid2D_walkable(grid, x, y + 1);
+        int down = __LevelNavGrid2D_walkable(grid, x, y - 1);
+        if (next) {
+            directions[count++] = dx; directions[count++] = 0;
+            if (up) { directions[count++] = dx; directions[count++] = 1; }
+            if (down) { directions[count++] = dx; directions[count++] = -1; }
+        }
+        if (up) { directions[count++] = 0; directions[count++] = 1; }
+        if (down) { directions[count++] = 0; directions[count++] = -1; }
+    } else {
+        int next = __LevelNavGrid2D_walkable(grid, x, y + dy);
+        int right = __LevelNavGrid2D_walkable(grid, x + 1, y);
+        int left = __LevelNavGrid2D_walkable(grid, x - 1, y);
+        if (next) {
+            directions[count++] = 0; directions[count++] = dy;
+            if (right) { directions[count++] = 1; directions[count++] = dy; }
+            if (left) { directions[count++] = -1; directions[count++] = dy; }
+        }
+        if (right) { directions[count++] = 1; directions[count++] = 0; }
+        if (left) { directions[count++] = -1; directions[count++] = 0; }
+    }
+
+    return count / 2;
+}
+
+void __LevelPathSearch2D_fit(LevelPathSearch2D* search) {
+    int size = search->grid->width * search->grid->height;
+    if (size == search->size) return;
+
+    free(search->costs);
+    free(search->parents);
+    free(search->seen);
+    free(search->closed);
+    search->costs = (float*) malloc((size + 1) * sizeof(float));
+    search->parents = (int*) malloc((size + 1) * sizeof(int));
+    search->seen = (unsigned int*) calloc(size + 1, sizeof(unsigned int));
+    search->closed = (unsigned int*) calloc(size + 1, sizeof(unsigned int));
+    search->generation = 0;
+    search->size = size;
+}
+
+// Implementation
+
+/**
+ * Creates a navigation grid for a Level2D. The grid is empty until LevelNavGrid2D_update is called.
+ * @param level The Level2D.
+ * @param walkable Selects the blocks that can be walked through, or 0 if every block can be.
+ * @param data The data passed to the predicate.
+ * @param emptyWalkable Whether cells without blocks can be walked through.
+ * @return A new LevelNavGrid2D.
+ */
+LevelNavGrid2D* createLevelNavGrid2D(Level2D* level, BlockPredicate walkable, void* data, int emptyWalkable) {
+    if (level == 0) return 0;
+
+    LevelNavGrid2D* grid = (LevelNavGrid2D*) malloc(sizeof(LevelNavGrid2D));
+    grid->level = level;
+    grid->walkable = walkable;
+    grid->data = data;
+    grid->emptyWalkable = emptyWalkable;
+    grid->chunkX = 0;
+    grid->chunkY = 0;
+    grid->chunkWidth = 0;
+    grid->chunkHeight = 0;
+    grid->width = 0;
+    grid->height = 0;
+    grid->cells = 0;
+    grid->versions = 0;
+
+    return grid;
+}
+
+/**
+ * Brings a LevelNavGrid2D up to date with its level, rebuilding only the chunks that
+ * changed. The whole grid is rebuilt when the level grows past it. This must not be
+ * called while searches are running on the grid.
+ * @param grid The LevelNavGrid2D.
+ * @return The number of chunks that were rebuilt.
+ */
+int LevelNavGrid2D_update(LevelNavGrid2D* grid) {
+    if (grid == 0) return 0;
+
+    LevelChunkMap2D* chunks = &grid->level->chunks;
+    int minX = 0, minY = 0, maxX = -1, maxY = -1;
+    for (int i = 0; i < chunks->capacity; i++) {
+        LevelChunk2D* chunk = chunks->chunks[i];
+        if (chunk == 0 || chunk->count == 0) continue;
+
+        if (maxX < minX) {
+            minX = maxX = chunk->x;
+            minY = maxY = chunk->y;
+            continue;
+        }
+
+        if (chunk->x < minX) minX = chunk->x;
+        if (chunk->x > maxX) maxX = chunk->x;
+        if (chunk->y < minY) minY = chunk->y;
+        if (chunk->y > maxY) maxY = chunk->y;
+    }
+
+    // leave a border of chunks around the level, so paths can walk around its edges
+    if (grid->emptyWalkable && maxX >= minX) {
+        minX--;
+        minY--;
+        maxX++;
+        maxY++;
+    }
+
+    int rebuilt = 0;
+    int inside = minX >= grid->chunkX && minY >= grid->chunkY
+        && maxX < grid->chunkX + grid->chunkWidth && maxY < grid->chunkY + grid->chunkHeight;
+
+    if (!inside) {
+        grid->chunkX = minX;
+        grid->chunkY = minY;
+        grid->chunkWidth = maxX - minX + 1;
+        grid->chunkHeight = maxY - minY + 1;
+        grid->width = grid->chunkWidth * _LEVEL_CHUNK_SIZE;
+        grid->height = grid->chunkHeight * _LEVEL_CHUNK_SIZE;
+
+        free(grid->cells);
+        free(grid->versions);
+        grid->cells = (unsigned char*) malloc((size_t) grid->width * grid->height + 1);
+        grid->versions = (int*) malloc((grid->chunkWidth * grid->chunkHeight + 1) * sizeof(int));
+
+        for (int j = 0; j < grid->chunkHeight; j++)
+            for (int i = 0; i < grid->chunkWidth; i++, rebuilt++)
+                __LevelNavGrid2D_buildChunk(grid, i, j);
+
+        return rebuilt;
+    }
+
+    for (int k = 0; k < chunks->capacity; k++) {
+        LevelChunk2D* chunk = chunks->chunks[k];
+        if (chunk == 0) continue;
+
+        int i = chunk->x - grid->chunkX;
+        int j = chunk->y - grid->chunkY;
+        if (i < 0 || j < 0 || i >= grid->chunkWidth || j >= grid->chunkHeight) continue;
+        if (grid->versions[j * grid->chunkWidth + i] == chunk->version) continue;
+
+        __LevelNavGrid2D_buildChunk(grid, i, j);
+        rebuilt++;
+    }
+
+    return rebuilt;
+}
+
+/**
+ * Checks whether a cell of a LevelNavGrid2D can be walked through.
+ * @param grid The LevelNavGrid2D.
+ * @param cell The cell.
+ * @return 1 if the cell is walkable, 0 if it is blocked or outside the grid.
+ */
+int LevelNavGrid2D_isWalkable(LevelNavGrid2D* grid, Coordinate2D cell) {
+    if (grid == 0) return 0;
+
+    if (!__inChunkRange(cell.x) || !__inChunkRange(cell.y)) return 0;
+
+    return __LevelNavGrid2D_walkable(grid, (int) floor(cell.x) - grid->chunkX * _LEVEL_CHUNK_SIZE, (int) floor(cell.y) - grid->chunkY * _LEVEL_CHUNK_SIZE);
+}
+
+/**
+ * Frees a LevelNavGrid2D. The level is not freed.
+ * @param grid The LevelNavGrid2D.
+ */
+void LevelNavGrid2D_free(LevelNavGrid2D* grid) {
+    if (grid == 0) return;
+
+    free(grid->cells);
+    free(grid->versions);
+    free(grid);
+}
+
+/**
+ * Creates the buffers for searching paths on a LevelNavGrid2D.
+ * @param grid The LevelNavGrid2D.
+ * @return A new LevelPathSearch2D.
+ */
+LevelPathSearch2D* createLevelPathSearch2D(LevelNavGrid2D* grid) {
+    if (grid == 0) return 0;
+
+    LevelPathSearch2D* search = (LevelPathSearch2D*) calloc(1, sizeof(LevelPathSearch2D));
+    search->grid = grid;
+    search->size = -1;
+
+    return search;
+}
+
+/**
+ * Finds a shortest path between two cells with jump point search. Paths move in eight
+ * directions, but never diagonally past a blocked cell.
+ * @param search The LevelPathSearch2D.
+ * @param start The starting cell.
+ * @param goal The goal cell.
+ * @param path The array to write the cells of the path to, from start to goal, or 0 to
+ * only measure the path.
+ * @param capacity The capacity of the array. At most this many cells are written.
+ * @return The number of cells in the path, which may exceed the capacity, or 0 if the
+ * goal cannot be reached.
+ */
+int LevelPathSearch2D_find(LevelPathSearch2D* search, Coordinate2D start, Coordinate2D goal, Coordinate2D* path, int capacity) {
+    if (search == 0) return 0;
+
+    if (!__inChunkRange(start.x) || !__inChunkRange(start.y)) return 0;
+    if (!__inChunkRange(goal.x) || !__inChunkRange(goal.y)) return 0;
+
+    LevelNavGrid2D* grid = search->grid;
+    __LevelPathSearch2D_fit(search);
+    search->cost = 0;
+
+    int originX = grid->chunkX * _LEVEL_CHUNK_SIZE;
+    int originY = grid->chunkY * _LEVEL_CHUNK_SIZE;
+    int sx = (int) floor(start.x) - originX;
+    int sy = (int) floor(start.y) - originY;
+    int gx = (int) floor(goal.x) - originX;
+    int gy = (int) floor(goal.y) - originY;
+    if (!__LevelNavGrid2D_walkable(grid, sx, sy) || !__LevelNavGrid2D_walkable(grid, gx, gy)) return 0;
+
+    if (++search->generation == 0) {
+        memset(search->seen, 0, search->size * sizeof(unsigned int));
+        memset(search->closed, 0, search->size * sizeof(unsigned int));
+        search->generation = 1;
+    }
+    unsigned int generation = search->generation;
+
+    int startCell = sy * grid->width + sx;
+    int goalCell = gy * grid->width + gx;
+    search->costs[startCell] = 0;
+    search->parents[startCell] = -1;
+    search->seen[startCell] = generation;
+    search->heapCount = 0;
+    __LevelPathSearch2D_push(search, startCell, __octile(gx - sx, gy - sy));
+
+    int found = 0;
+    int directions[16];
+    while (search->heapCount > 0) {
+        int cell = __LevelPathSearch2D_pop(search);
+        if (search->closed[cell] == generation) continue;
+        search->closed[cell] = generation;
+
+        if (cell == goalCell) {
+            found = 1;
+            break;
+        }
+
+        int x = cell % grid->width;
+        int y = cell / grid->width;
+        int dx = 0, dy = 0;
+        if (search->parents[cell] >= 0) {
+            dx = __sign(x - search->parents[cell] % grid->width);
+            dy = __sign(y - search->parents[cell] / grid->width);
+        }
+
+        int count = __LevelNavGrid2D_directions(grid, x, y, dx, dy, directions);
+        for (int i = 0; i < count; i++) {
+            int next = __LevelNavGrid2D_jump(grid, x + directions[2 * i], y + directions[2 * i + 1], directions[2 * i], directions[2 * i + 1], goalCell);
+            if (next < 0 || search->closed[next] == generation) continue;
+
+            int nx = next % grid->width;
+            int ny = next / grid->width;
+            float cost = search->costs[cell] + __octile(nx - x, ny - y);
+            if (search->seen[next] == generation && search->costs[next] <= cost) continue;
+
+            search->seen[next] = generation;
+            search->costs[next] = cost;
+            search->parents[next] = cell;
+            __LevelPathSearch2D_push(search, next, cost + __octile(gx - nx, gy - ny));
+        }
+    }
+
+    if (!found) return 0;
+    search->cost = search->costs[goalCell];
+
+    int pointCount = 0;
+    for (int cell = goalCell; cell >= 0; cell = search->parents[cell]) {
+        if (pointCount == search->pointCapacity) {
+            search->pointCapacity = search->pointCapacity == 0 ? 64 : search->pointCapacity * 2;
+            search->points = (int*) realloc(search->points, search->pointCapacity * sizeof(int));
+        }
+
+        search->points[pointCount++] = cell;
+    }
+
+    // expand the jump points into every cell along the way
+    int length = 1;
+    if (path != 0 && capacity > 0) path[0] = makeCoordinate2D(sx + originX, sy + originY);
+
+    for (int i = pointCount - 1; i > 0; i--) {
+        int x = search->points[i] % grid->width;
+        int y = search->points[i] / grid->width;
+        int tx = search->points[i - 1] % grid->width;
+        int ty = search->points[i - 1] / grid->width;
+        int dx = __sign(tx - x);
+        int dy = __sign(ty - y);
+
+        while (x != tx || y != ty) {
+            x += dx;
+            y += dy;
+            if (path != 0 && length < capacity) path[length] = makeCoordinate2D(x + originX, y + originY);
+            length++;
+        }
+    }
+
+    return length;
+}
+
+/**
+ * Frees a LevelPathSearch2D. The grid is not freed.
+ * @param search The LevelPathSearch2D.
+ */
+void LevelPathSearch2D_free(LevelPathSearch2D* search) {
+    if (search == 0) return;
+
+    free(search->costs);
+    free(search->parents);
+    free(search->seen);
+    free(search->closed);
+    free(search->heap);
+    free(search->points);
+    free(search);
+}
+
+#endif
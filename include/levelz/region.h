@@ -0,0 +1,463 @@
+#ifndef LEVELZ_REGION_H
+#define LEVELZ_REGION_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <sys/stat.h>
+
+#include "../levelz.h"
+
+/**
+ * The suffix appended to a level file's path to form the path of its region index.
+ */
+const char* LEVELZ_INDEX_SUFFIX = ".index";
+
+/**
+ * The magic number at the start of every region index.
+ */
+const char* LEVELZ_INDEX_MAGIC = "LVZI";
+
+/**
+ * The version of the region index format. Indexes with a different version are rebuilt.
+ */
+const uint32_t LEVELZ_INDEX_VERSION = 2;
+
+// Internal
+
+// An entry covers a run of coordinates on one block line that fall in the same
+// chunk, so a query only parses the runs whose bounding box it intersects.
+typedef struct __RegionEntry3D {
+    int64_t line;
+    uint32_t prefix;
+    uint32_t start;
+    uint32_t length;
+    uint32_t reserved;
+    double min[3];
+    double max[3];
+} __RegionEntry3D;
+
+// An index is only used while the file still has the size, modification time and
+// inode it was built from. The modification time is in nanoseconds where the platform
+// records them, and replacing a file by renaming another over it changes its inode.
+typedef struct __RegionIndex3D {
+    uint64_t size;
+    int64_t mtime;
+    uint64_t inode;
+    uint64_t body;
+    __RegionEntry3D* entries;
+    uint32_t count;
+} __RegionIndex3D;
+
+char* __indexPath(const char* path) {
+    char* indexPath = (char*) malloc(strlen(path) + strlen(LEVELZ_INDEX_SUFFIX) + 1);
+    sprintf(indexPath, "%s%s", path, LEVELZ_INDEX_SUFFIX);
+    return indexPath;
+}
+
+int64_t __modifiedTime(struct stat* info) {
+#if defined(__APPLE__)
+    return (int64_t) info->st_mtimespec.tv_sec * 1000000000 + info->st_mtimespec.tv_nsec;
+#elif !defined(_WIN32) && defined(st_mtime)
+    // st_mtime is defined as st_mtim.tv_sec where the nanosecond field is available
+    return (int64_t) info->st_mtim.tv_sec * 1000000000 + info->st_mtim.tv_nsec;
+#else
+    return (int64_t) info->st_mtime * 1000000000;
+#endif
+}
+
+void __removeIndex(const char* path) {
+    char* indexPath = __indexPath(path);
+    remove(indexPath);
+    free(indexPath);
+}
+
+int __RegionEntry3D_bounds(char* token, double* min, double* max) {
+    while (*token == ' ' || *token == '\t') token++;
+    if (*token == 0) return 0;
+
+    if (*token == '(') {
+        CoordinateMatrix3D* matrix = CoordinateMatrix3D_fromString(token);
+        if (matrix == 0) return 0;
+
+        min[0] = matrix->minX + (int) matrix->start->x;
+        min[1] = matrix->minY + (int) matrix->start->y;
+        min[2] = matrix->minZ + (int) matrix->start->z;
+        max[0] = matrix->maxX + (int) matrix->start->x;
+        max[1] = matrix->maxY + (int) matrix->start->y;
+        max[2] = matrix->maxZ + (int) matrix->start->z;
+
+        free(matrix->start);
+        free(matrix);
+        return 2;
+    }
+
+    Coordinate3D* point = Coordinate3D_fromString(token);
+    if (point == 0) return 0;
+
+    min[0] = max[0] = point->x;
+    min[1] = max[1] = point->y;
+    min[2] = max[2] = point->z;
+
+    free(point);
+    return 1;
+}
+
+void __RegionIndex3D_add(__RegionIndex3D* index, __RegionEntry3D* entry) {
+    if (entry->length == 0) return;
+
+    index->entries = (__RegionEntry3D*) __growArray(index->entries, (int) index->count, sizeof(__RegionEntry3D));
+    index->entries[index->count++] = *entry;
+}
+
+void __RegionIndex3D_scanLine(__RegionIndex3D* index, const char* buffer, size_t offset, size_t end) {
+    const char* line = buffer + offset;
+    const char* colon = memchr(line, ':', end - offset);
+    if (colon == 0) return;
+
+    __RegionEntry3D entry;
+    memset(&entry, 0, sizeof(__RegionEntry3D));
+    entry.line = (int64_t) offset;
+    entry.prefix = (uint32_t) (colon - line);
+
+    char* token = (char*) malloc(end - offset + 1);
+    int chunk[3] = {0, 0, 0};
+
+    // only runs of single points are extended, matrices get their own entry
+    int extendable = 0;
+
+    size_t start = (colon - line) + 1;
+    while (start < end - offset) {
+        size_t stop = start;
+        while (stop < end - offset && line[stop] != '*') stop++;
+
+        memcpy(token, line + start, stop - start);
+        token[stop - start] = '\0';
+
+        double min[3], max[3];
+        int kind = __RegionEntry3D_bounds(token, min, max);
+        if (kind != 0) {
+            int tokenChunk[3] = {__chunkOf(min[0]), __chunkOf(min[1]), __chunkOf(min[2])};
+            int sameChunk = kind == 1 && extendable
+                && chunk[0] == tokenChunk[0] && chunk[1] == tokenChunk[1] && chunk[2] == tokenChunk[2];
+
+            if (sameChunk) {
+                entry.length = (uint32_t) (stop - entry.start);
+                for (int i = 0; i < 3; i++) {
+                    if (min[i] < entry.min[i]) entry.min[i] = min[i];
+                    if (max[i] > entry.max[i]) entry.max[i] = max[i];
+                }
+            } else {
+                __RegionIndex3D_add(index, &entry);
+
+                entry.start = (uint32_t) start;
+                entry.length = (uint32_t) (stop - start);
+                extendable = kind == 1;
+                memcpy(entry.min, min, sizeof(min));
+                memcpy(entry.max, max, sizeof(max));
+                memcpy(chunk, tokenChunk, sizeof(chunk));
+            }
+        }
+
+        start = stop + 1;
+    }
+
+    __RegionIndex3D_add(index, &entry);
+    free(token);
+}
+
+int __RegionIndex3D_build(__RegionIndex3D* index, const char* path) {
+    struct stat info;
+    if (stat(path, &info) != 0) return 0;
+
+    char* buffer = __readFile(path);
+    if (buffer == 0) return 0;
+
+    size_t length = strlen(buffer);
+    index->size = (uint64_t) length;
+    index->mtime = __modifiedTime(&info);
+    index->inode = (uint64_t) info.st_ino;
+    index->body = 0;
+    index->entries = 0;
+    index->count = 0;
+
+    int body = 0;
+    size_t offset = 0;
+    while (offset < length) {
+        const char* newline = memchr(buffer + offset, '\n', length - offset);
+        size_t end = newline == 0 ? length : (size_t) (newline - buffer);
+
+        char* line = (char*) malloc(end - offset + 1);
+        memcpy(line, buffer + offset, end - offset);
+        line[end - offset] = '\0';
+        char* trimmed = __trim(line);
+        free(line);
+
+        if (!body) {
+            if (strcmp(trimmed, LEVELZ_HEADER_END) == 0) {
+                body = 1;
+                index->body = (uint64_t) (newline == 0 ? length : end + 1);
+            }
+        } else if (strcmp(trimmed, LEVELZ_END) == 0) {
+            free(trimmed);
+            break;
+        } else if (*trimmed != 0) {
+            __RegionIndex3D_scanLine(index, buffer, offset, end);
+        }
+
+        free(trimmed);
+        offset = end + 1;
+    }
+
+    free(buffer);
+    return body;
+}
+
+int __RegionIndex3D_write(__RegionIndex3D* index, const char* path) {
+    size_t length = 0;
+    size_t capacity = 256;
+    char* str = (char*) malloc(capacity);
+
+    __appendBytes(&str, &length, &capacity, LEVELZ_INDEX_MAGIC, 4);
+    __appendUInt32(&str, &length, &capacity, LEVELZ_INDEX_VERSION);
+    __appendBytes(&str, &length, &capacity, &index->size, sizeof(uint64_t));
+    __appendBytes(&str, &length, &capacity, &index->mtime, sizeof(int64_t));
+    __appendBytes(&str, &length, &capacity, &index->inode, sizeof(uint64_t));
+    __appendBytes(&str, &length, &capacity, &index->body, sizeof(uint64_t));
+    __appendUInt32(&str, &length, &capacity, index->count);
+    if (index->count > 0)
+        __appendBytes(&str, &length, &capacity, index->entries, index->count * sizeof(__RegionEntry3D));
+
+    char* indexPath = __indexPath(path);
+    int written = __writeFileAtomic(indexPath, str, length);
+
+    free(indexPath);
+    free(str);
+    return written;
+}
+
+int __RegionIndex3D_read(__RegionIndex3D* index, const char* path) {
+    char* indexPath = __indexPath(path);
+    FILE* file = fopen(indexPath, "rb");
+    free(indexPath);
+    if (file == 0) return 0;
+
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    char* data = (char*) malloc(length > 0 ? length : 1);
+    size_t read = fread(data, 1, length, file);
+    fclose(file);
+
+    __CacheReader reader;
+    reader.cursor = data;
+    reader.end = data + read;
+
+    char magic[4];
+    uint32_t version;
+    int valid = __CacheReader_read(&reader, magic, 4) && memcmp(magic, LEVELZ_INDEX_MAGIC, 4) == 0
+        && __CacheReader_readUInt32(&reader, &version) && version == LEVELZ_INDEX_VERSION
+        && __CacheReader_read(&reader, &index->size, sizeof(uint64_t))
+        && __CacheReader_read(&reader, &index->mtime, sizeof(int64_t))
+        && __CacheReader_read(&reader, &index->inode, sizeof(uint64_t))
+        && __CacheReader_read(&reader, &index->body, sizeof(uint64_t))
+        && __CacheReader_readUInt32(&reader, &index->count)
+        && (size_t) (reader.end - reader.cursor) == index->count * sizeof(__RegionEntry3D);
+
+    if (!valid) {
+        free(data);
+        return 0;
+    }
+
+    index->entries = (__RegionEntry3D*) malloc((index->count + 1) * sizeof(__RegionEntry3D));
+    memcpy(index->entries, reader.cursor, index->count * sizeof(__RegionEntry3D));
+
+    free(data);
+    return 1;
+}
+
+// Reads the index next to a file, rebuilding it if it is missing or the file changed.
+int __RegionIndex3D_open(__RegionIndex3D* index, const char* path) {
+    struct stat info;
+    if (stat(path, &info) != 0) return 0;
+
+    if (__RegionIndex3D_read(index, path)) {
+        if (index->size == (uint64_t) info.st_size && index->mtime == __modifiedTime(&info)
+            && index->inode == (uint64_t) info.st_ino)
+            return 1;
+
+        free(index->entries);
+    }
+
+    if (!__RegionIndex3D_build(index, path)) return 0;
+
+    __RegionIndex3D_write(index, path);
+    return 1;
+}
+
+int __CoordinateMatrix3D_intersects(CoordinateMatrix3D* box, double* min, double* max) {
+    return max[0] >= box->minX + box->start->x && min[0] <= box->maxX + box->start->x
+        && max[1] >= box->minY + box->start->y && min[1] <= box->maxY + box->start->y
+        && max[2] >= box->minZ + box->start->z && min[2] <= box->maxZ + box->start->z;
+}
+
+int __CoordinateMatrix3D_contains(CoordinateMatrix3D* box, Coordinate3D* c) {
+    double point[3] = {c->x, c->y, c->z};
+    return __CoordinateMatrix3D_intersects(box, point, point);
+}
+
+int __CoordinateMatrix3D_accepts(Coordinate3D* c, void* box) {
+    return __CoordinateMatrix3D_contains((CoordinateMatrix3D*) box, c);
+}
+
+// Seeks to an offset from the start of a file. long is 32 bits on Windows, so
+// offsets past 2 GiB need the 64-bit variants of fseek.
+int __seekFile(FILE* file, int64_t offset) {
+#if defined(_WIN32)
+    return _fseeki64(file, offset, SEEK_SET);
+#elif defined(_POSIX_C_SOURCE) && _POSIX_C_SOURCE >= 200112L
+    return fseeko(file, (off_t) offset, SEEK_SET);
+#else
+    if (offset > LONG_MAX) return -1;
+    return fseek(file, (long) offset, SEEK_SET);
+#endif
+}
+
+char* __readRange(FILE* file, int64_t offset, size_t length) {
+    char* str = (char*) malloc(length + 1);
+    if (__seekFile(file, offset) != 0) {
+        free(str);
+        return 0;
+    }
+
+    size_t read = fread(str, 1, length, file);
+    str[read] = '\0';
+    return str;
+}
+
+// Reads the objects of every run intersecting [min, max] that the filter accepts.
+int __RegionIndex3D_collect(__RegionIndex3D* index, FILE* file, double* min, double* max, int (*accept)(Coordinate3D*, void*), void* data, LevelObject3D*** objects) {
+    int count = 0;
+
+    // entries of one line are adjacent, so each block is parsed once
+    int64_t line = -1;
+    Block* block = 0;
+
+    for (uint32_t i = 0; i < index->count; i++) {
+        __RegionEntry3D* entry = &index->entries[i];
+        int intersects = entry->max[0] >= min[0] && entry->min[0] <= max[0]
+            && entry->max[1] >= min[1] && entry->min[1] <= max[1]
+            && entry->max[2] >= min[2] && entry->min[2] <= max[2];
+        if (!intersects) continue;
+
+        if (entry->line != line) {
+            char* prefix = __readRange(file, entry->line, entry->prefix);
+            char* trimmed = __trim(prefix);
+            block = Block_fromString(trimmed);
+            line = entry->line;
+
+            free(trimmed);
+            free(prefix);
+        }
+
+        char* span = __readRange(file, entry->line + entry->start, entry->length);
+        Coordinate3D** points = __read3DPoints(span);
+        free(span);
+        if (points == 0) continue;
+
+        for (int j = 0; points[j] != 0; j++) {
+            if (!accept(points[j], data)) {
+                free(points[j]);
+                continue;
+            }
+
+            *objects = (LevelObject3D**) __growArray(*objects, count, sizeof(LevelObject3D*));
+            (*objects)[count++] = createLevelObject3DAt(block, *points[j]);
+            free(points[j]);
+        }
+
+        free(points);
+    }
+
+    return count;
+}
+
+// Implementation
+
+/**
+ * Builds the region index of a Level3D file and stores it next to the file. The
+ * index maps runs of coordinates on each block line to their byte ranges and
+ * bounding boxes. parseFile3DRegion builds the index on first use, so calling this
+ * ahead of time only moves that cost.
+ * @param path The path to the file.
+ * @return 1 if the index was written, 0 otherwise.
+ */
+int indexFile3D(const char* path) {
+    if (path == 0) return 0;
+
+    __RegionIndex3D index;
+    if (!__RegionIndex3D_build(&index, path)) return 0;
+
+    int written = __RegionIndex3D_write(&index, path);
+    free(index.entries);
+    return written;
+}
+
+/**
+ * Parses the part of a Level3D file that lies inside a box. Only the headers and
+ * the coordinate runs whose bounding boxes intersect the box are read from the
+ * file, using the region index stored next to it, which is built or rebuilt
+ * when missing or out of date. Edits recorded in the file's journal are replayed on top.
+ * @param path The path to the file.
+ * @param box The box to load, including its bounds.
+ * @return The Level3D holding the blocks inside the box, or null if the file could not be read.
+ */
+Level3D* parseFile3DRegion(const char* path, CoordinateMatrix3D* box) {
+    if (path == 0) return 0;
+    if (box == 0) return 0;
+
+    __RegionIndex3D index;
+    if (!__RegionIndex3D_open(&index, path)) return 0;
+
+    FILE* file = fopen(path, "rb");
+    if (file == 0) {
+        free(index.entries);
+        return 0;
+    }
+
+    char* headers = __readRange(file, 0, (size_t) index.body);
+    Level3D* level = headers == 0 ? 0 : readLevel3D(headers);
+    free(headers);
+
+    if (level == 0) {
+        free(index.entries);
+        fclose(file);
+        return 0;
+    }
+
+    double min[3] = {box->minX + box->start->x, box->minY + box->start->y, box->minZ + box->start->z};
+    double max[3] = {box->maxX + box->start->x, box->maxY + box->start->y, box->maxZ + box->start->z};
+
+    LevelObject3D** objects = 0;
+    int count = __RegionIndex3D_collect(&index, file, min, max, __CoordinateMatrix3D_accepts, box, &objects);
+    Level3D_addBlocks(level, objects, count);
+    free(objects);
+
+    free(index.entries);
+    fclose(file);
+
+    __Level3D_replayJournal(level, path);
+
+    // the journal may have added blocks anywhere
+    for (int i = level->blockCount - 1; i >= 0; i--) {
+        if (!__CoordinateMatrix3D_contains(box, level->blocks[i]->coordinate))
+            Level3D_removeBlock(level, level->blocks[i]);
+    }
+
+    return level;
+}
+
+#endif
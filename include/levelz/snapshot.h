@@ -0,0 +1,507 @@
+#ifndef LEVELZ_SNAPSHOT_H
+#define LEVELZ_SNAPSHOT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "block.h"
+#include "coordinate.h"
+#include "chunk.h"
+#include "thread.h"
+
+/**
+ * Represents an immutable view of a Level2D at a point in time.
+ *
+ * Snapshots share the chunks that did not change between them, and can be read
+ * from any number of threads without locking while the level keeps being edited.
+ */
+typedef struct LevelSnapshot2D {
+    /**
+     * The number of references to the snapshot.
+     */
+    int refs;
+
+    /**
+     * The names of the headers of the level.
+     */
+    char** headerNames;
+
+    /**
+     * The values of the headers of the level.
+     */
+    char** headerValues;
+
+    /**
+     * The number of headers of the level.
+     */
+    int headerCount;
+
+    /**
+     * The spawnpoint of the level, or 0 if it has none.
+     */
+    Coordinate2D* spawn;
+
+    /**
+     * The number of blocks in the level.
+     */
+    int blockCount;
+
+    /**
+     * Open-addressed table of the non-empty chunks of the level.
+     */
+    LevelChunkSnapshot2D** chunks;
+
+    /**
+     * The capacity of the chunk table. Always a power of two.
+     */
+    int chunkCapacity;
+
+    /**
+     * Blocks too far out to belong to a chunk.
+     */
+    LevelObject2D** outlying;
+
+    /**
+     * The number of outlying blocks.
+     */
+    int outlyingCount;
+
+    /**
+     * Blocks removed from the level while this was its latest snapshot. They are
+     * freed once this and every older snapshot is released.
+     */
+    LevelObject2D** retired;
+
+    /**
+     * The number of retired blocks.
+     */
+    int retiredCount;
+
+    /**
+     * The capacity of the retired array.
+     */
+    int retiredCapacity;
+
+    /**
+     * The next newer snapshot of the same level, kept alive by this one.
+     */
+    struct LevelSnapshot2D* next;
+} LevelSnapshot2D;
+
+// Internal
+
+LevelSnapshot2D* __LevelSnapshot2D_create(int headerCount, int chunkCount) {
+    LevelSnapshot2D* s = (LevelSnapshot2D*) malloc(sizeof(LevelSnapshot2D));
+    s->refs = 1;
+    s->headerNames = (char**) malloc((headerCount + 1) * sizeof(char*));
+    s->headerValues = (char**) malloc((headerCount + 1) * sizeof(char*));
+    s->headerCount = headerCount;
+    s->spawn = 0;
+    s->blockCount = 0;
+
+    s->chunkCapacity = 16;
+    while (s->chunkCapacity < 2 * chunkCount) s->chunkCapacity *= 2;
+    s->chunks = (LevelChunkSnapshot2D**) calloc(s->chunkCapacity, sizeof(LevelChunkSnapshot2D*));
+
+    s->outlying = 0;
+    s->outlyingCount = 0;
+    s->retired = 0;
+    s->retiredCount = 0;
+    s->retiredCapacity = 0;
+    s->next = 0;
+
+    return s;
+}
+
+void __LevelSnapshot2D_putChunk(LevelSnapshot2D* snapshot, LevelChunkSnapshot2D* chunk) {
+    int mask = snapshot->chunkCapacity - 1;
+    int i = (int) (__hashChunk2D(chunk->x, chunk->y) & mask);
+    while (snapshot->chunks[i] != 0) i = (i + 1) & mask;
+
+    snapshot->chunks[i] = chunk;
+}
+
+void __LevelSnapshot2D_retire(LevelSnapshot2D* snapshot, LevelObject2D* object) {
+    if (snapshot->retiredCount == snapshot->retiredCapacity) {
+        snapshot->retiredCapacity = snapshot->retiredCapacity == 0 ? 16 : 2 * snapshot->retiredCapacity;
+        snapshot->retired = (LevelObject2D**) realloc(snapshot->retired, snapshot->retiredCapacity * sizeof(LevelObject2D*));
+    }
+
+    snapshot->retired[snapshot->retiredCount++] = object;
+}
+
+// Implementation
+
+/**
+ * Adds a reference to a LevelSnapshot2D, so it can be handed to another reader.
+ * @param snapshot The LevelSnapshot2D.
+ * @return The same snapshot.
+ */
+LevelSnapshot2D* LevelSnapshot2D_retain(LevelSnapshot2D* snapshot) {
+    if (snapshot == 0) return 0;
+
+    __atomicIncrement(&snapshot->refs);
+    return snapshot;
+}
+
+/**
+ * Releases a reference to a LevelSnapshot2D. The snapshot is freed together with
+ * the storage only it still uses once its last reference is released.
+ * @param snapshot The LevelSnapshot2D.
+ */
+void LevelSnapshot2D_release(LevelSnapshot2D* snapshot) {
+    while (snapshot != 0 && __atomicDecrement(&snapshot->refs) == 0) {
+        LevelSnapshot2D* next = snapshot->next;
+
+        for (int i = 0; i < snapshot->chunkCapacity; i++)
+            __LevelChunkSnapshot2D_release(snapshot->chunks[i]);
+
+        for (int i = 0; i < snapshot->retiredCount; i++)
+            free(snapshot->retired[i]);
+
+        free(snapshot->chunks);
+        free(snapshot->outlying);
+        free(snapshot->retired);
+        free(snapshot->headerNames);
+        free(snapshot->headerValues);
+        free(snapshot->spawn);
+        free(snapshot);
+
+        snapshot = next;
+    }
+}
+
+/**
+ * Gets the number of blocks in a LevelSnapshot2D.
+ * @param snapshot The LevelSnapshot2D.
+ * @return The number of blocks in the snapshot.
+ */
+int LevelSnapshot2D_getBlockCount(LevelSnapshot2D* snapshot) {
+    if (snapshot == 0) return 0;
+
+    return snapshot->blockCount;
+}
+
+/**
+ * Gets a header from a LevelSnapshot2D.
+ * @param snapshot The LevelSnapshot2D.
+ * @param name The name of the header.
+ * @return The value of the header, or 0 if the header does not exist.
+ */
+char* LevelSnapshot2D_getHeader(LevelSnapshot2D* snapshot, const char* name) {
+    if (snapshot == 0) return 0;
+    if (name == 0) return 0;
+
+    for (int i = 0; i < snapshot->headerCount; i++) {
+        if (strcmp(snapshot->headerNames[i], name) == 0)
+            return snapshot->headerValues[i];
+    }
+
+    return 0;
+}
+
+/**
+ * Gets a block from a LevelSnapshot2D.
+ * @param snapshot The LevelSnapshot2D.
+ * @param coordinate The coordinate of the block.
+ * @return The block at the coordinate, or 0 if no block is found.
+ */
+Block* LevelSnapshot2D_getBlock(LevelSnapshot2D* snapshot, Coordinate2D* coordinate) {
+    if (snapshot == 0) return 0;
+    if (coordinate == 0) return 0;
+
+    if (!__inChunkRange(coordinate->x) || !__inChunkRange(coordinate->y)) {
+        for (int i = 0; i < snapshot->outlyingCount; i++) {
+            Coordinate2D* c = snapshot->outlying[i]->coordinate;
+            if (c->x == coordinate->x && c->y == coordinate->y) return snapshot->outlying[i]->block;
+        }
+
+        return 0;
+    }
+
+    int mask = snapshot->chunkCapacity - 1;
+    int i = (int) (__hashChunk2D(__chunkOf(coordinate->x), __chunkOf(coordinate->y)) & mask);
+    while (snapshot->chunks[i] != 0) {
+        LevelChunkSnapshot2D* chunk = snapshot->chunks[i];
+        if (chunk->x == __chunkOf(coordinate->x) && chunk->y == __chunkOf(coordinate->y)) {
+            LevelObject2D* object = __LevelChunkSnapshot2D_find(chunk, coordinate);
+            return object == 0 ? 0 : object->block;
+        }
+
+        i = (i + 1) & mask;
+    }
+
+    return 0;
+}
+
+/**
+ * Calls a function for every block in a LevelSnapshot2D.
+ * @param snapshot The LevelSnapshot2D.
+ * @param callback The function to call with each block and `data`.
+ * @param data Caller data passed through to the callback.
+ */
+void LevelSnapshot2D_forEach(LevelSnapshot2D* snapshot, void (*callback)(LevelObject2D*, void*), void* data) {
+    if (snapshot == 0) return;
+    if (callback == 0) return;
+
+    for (int i = 0; i < snapshot->chunkCapacity; i++) {
+        LevelChunkSnapshot2D* chunk = snapshot->chunks[i];
+        if (chunk == 0) continue;
+
+        for (int j = 0; j < chunk->count; j++)
+            callback(chunk->objects[j], data);
+    }
+
+    for (int i = 0; i < snapshot->outlyingCount; i++)
+        callback(snapshot->outlying[i], data);
+}
+
+/**
+ * Represents an immutable view of a Level3D at a point in time.
+ *
+ * Snapshots share the chunks that did not change between them, and can be read
+ * from any number of threads without locking while the level keeps being edited.
+ */
+typedef struct LevelSnapshot3D {
+    /**
+     * The number of references to the snapshot.
+     */
+    int refs;
+
+    /**
+     * The names of the headers of the level.
+     */
+    char** headerNames;
+
+    /**
+     * The values of the headers of the level.
+     */
+    char** headerValues;
+
+    /**
+     * The number of headers of the level.
+     */
+    int headerCount;
+
+    /**
+     * The spawnpoint of the level, or 0 if it has none.
+     */
+    Coordinate3D* spawn;
+
+    /**
+     * The number of blocks in the level.
+     */
+    int blockCount;
+
+    /**
+     * Open-addressed table of the non-empty chunks of the level.
+     */
+    LevelChunkSnapshot3D** chunks;
+
+    /**
+     * The capacity of the chunk table. Always a power of two.
+     */
+    int chunkCapacity;
+
+    /**
+     * Blocks too far out to belong to a chunk.
+     */
+    LevelObject3D** outlying;
+
+    /**
+     * The number of outlying blocks.
+     */
+    int outlyingCount;
+
+    /**
+     * Blocks removed from the level while this was its latest snapshot. They are
+     * freed once this and every older snapshot is released.
+     */
+    LevelObject3D** retired;
+
+    /**
+     * The number of retired blocks.
+     */
+    int retiredCount;
+
+    /**
+     * The capacity of the retired array.
+     */
+    int retiredCapacity;
+
+    /**
+     * The next newer snapshot of the same level, kept alive by this one.
+     */
+    struct LevelSnapshot3D* next;
+} LevelSnapshot3D;
+
+// Internal
+
+LevelSnapshot3D* __LevelSnapshot3D_create(int headerCount, int chunkCount) {
+    LevelSnapshot3D* s = (LevelSnapshot3D*) malloc(sizeof(LevelSnapshot3D));
+    s->refs = 1;
+    s->headerNames = (char**) malloc((headerCount + 1) * sizeof(char*));
+    s->headerValues = (char**) malloc((headerCount + 1) * sizeof(char*));
+    s->headerCount = headerCount;
+    s->spawn = 0;
+    s->blockCount = 0;
+
+    s->chunkCapacity = 16;
+    while (s->chunkCapacity < 2 * chunkCount) s->chunkCapacity *= 2;
+    s->chunks = (LevelChunkSnapshot3D**) calloc(s->chunkCapacity, sizeof(LevelChunkSnapshot3D*));
+
+    s->outlying = 0;
+    s->outlyingCount = 0;
+    s->retired = 0;
+    s->retiredCount = 0;
+    s->retiredCapacity = 0;
+    s->next = 0;
+
+    return s;
+}
+
+void __LevelSnapshot3D_putChunk(LevelSnapshot3D* snapshot, LevelChunkSnapshot3D* chunk) {
+    int mask = snapshot->chunkCapacity - 1;
+    int i = (int) (__hashChunk3D(chunk->x, chunk->y, chunk->z) & mask);
+    while (snapshot->chunks[i] != 0) i = (i + 1) & mask;
+
+    snapshot->chunks[i] = chunk;
+}
+
+void __LevelSnapshot3D_retire(LevelSnapshot3D* snapshot, LevelObject3D* object) {
+    if (snapshot->retiredCount == snapshot->retiredCapacity) {
+        snapshot->retiredCapacity = snapshot->retiredCapacity == 0 ? 16 : 2 * snapshot->retiredCapacity;
+        snapshot->retired = (LevelObject3D**) realloc(snapshot->retired, snapshot->retiredCapacity * sizeof(LevelObject3D*));
+    }
+
+    snapshot->retired[snapshot->retiredCount++] = object;
+}
+
+// Implementation
+
+/**
+ * Adds a reference to a LevelSnapshot3D, so it can be handed to another reader.
+ * @param snapshot The LevelSnapshot3D.
+ * @return The same snapshot.
+ */
+LevelSnapshot3D* LevelSnapshot3D_retain(LevelSnapshot3D* snapshot) {
+    if (snapshot == 0) return 0;
+
+    __atomicIncrement(&snapshot->refs);
+    return snapshot;
+}
+
+/**
+ * Releases a reference to a LevelSnapshot3D. The snapshot is freed together with
+ * the storage only it still uses once its last reference is released.
+ * @param snapshot The LevelSnapshot3D.
+ */
+void LevelSnapshot3D_release(LevelSnapshot3D* snapshot) {
+    while (snapshot != 0 && __atomicDecrement(&snapshot->refs) == 0) {
+        LevelSnapshot3D* next = snapshot->next;
+
+        for (int i = 0; i < snapshot->chunkCapacity; i++)
+            __LevelChunkSnapshot3D_release(snapshot->chunks[i]);
+
+        for (int i = 0; i < snapshot->retiredCount; i++)
+            free(snapshot->retired[i]);
+
+        free(snapshot->chunks);
+        free(snapshot->outlying);
+        free(snapshot->retired);
+        free(snapshot->headerNames);
+        free(snapshot->headerValues);
+        free(snapshot->spawn);
+        free(snapshot);
+
+        snapshot = next;
+    }
+}
+
+/**
+ * Gets the number of blocks in a LevelSnapshot3D.
+ * @param snapshot The LevelSnapshot3D.
+ * @return The number of blocks in the snapshot.
+ */
+int LevelSnapshot3D_getBlockCount(LevelSnapshot3D* snapshot) {
+    if (snapshot == 0) return 0;
+
+    return snapshot->blockCount;
+}
+
+/**
+ * Gets a header from a LevelSnapshot3D.
+ * @param snapshot The LevelSnapshot3D.
+ * @param name The name of the header.
+ * @return The value of the header, or 0 if the header does not exist.
+ */
+char* LevelSnapshot3D_getHeader(LevelSnapshot3D* snapshot, const char* name) {
+    if (snapshot == 0) return 0;
+    if (name == 0) return 0;
+
+    for (int i = 0; i < snapshot->headerCount; i++) {
+        if (strcmp(snapshot->headerNames[i], name) == 0)
+            return snapshot->headerValues[i];
+    }
+
+    return 0;
+}
+
+/**
+ * Gets a block from a LevelSnapshot3D.
+ * @param snapshot The LevelSnapshot3D.
+ * @param coordinate The coordinate of the block.
+ * @return The block at the coordinate, or 0 if no block is found.
+ */
+Block* LevelSnapshot3D_getBlock(LevelSnapshot3D* snapshot, Coordinate3D* coordinate) {
+    if (snapshot == 0) return 0;
+    if (coordinate == 0) return 0;
+
+    if (!__inChunkRange(coordinate->x) || !__inChunkRange(coordinate->y) || !__inChunkRange(coordinate->z)) {
+        for (int i = 0; i < snapshot->outlyingCount; i++) {
+            Coordinate3D* c = snapshot->outlying[i]->coordinate;
+            if (c->x == coordinate->x && c->y == coordinate->y && c->z == coordinate->z) return snapshot->outlying[i]->block;
+        }
+
+        return 0;
+    }
+
+    int mask = snapshot->chunkCapacity - 1;
+    int i = (int) (__hashChunk3D(__chunkOf(coordinate->x), __chunkOf(coordinate->y), __chunkOf(coordinate->z)) & mask);
+    while (snapshot->chunks[i] != 0) {
+        LevelChunkSnapshot3D* chunk = snapshot->chunks[i];
+        if (chunk->x == __chunkOf(coordinate->x) && chunk->y == __chunkOf(coordinate->y) && chunk->z == __chunkOf(coordinate->z)) {
+            LevelObject3D* object = __LevelChunkSnapshot3D_find(chunk, coordinate);
+            return object == 0 ? 0 : object->block;
+        }
+
+        i = (i + 1) & mask;
+    }
+
+    return 0;
+}
+
+/**
+ * Calls a function for every block in a LevelSnapshot3D.
+ * @param snapshot The LevelSnapshot3D.
+ * @param callback The function to call with each block and `data`.
+ * @param data Caller data passed through to the callback.
+ */
+void LevelSnapshot3D_forEach(LevelSnapshot3D* snapshot, void (*callback)(LevelObject3D*, void*), void* data) {
+    if (snapshot == 0) return;
+    if (callback == 0) return;
+
+    for (int i = 0; i < snapshot->chunkCapacity; i++) {
+        LevelChunkSnapshot3D* chunk = snapshot->chunks[i];
+        if (chunk == 0) continue;
+
+        for (int j = 0; j < chunk->count; j++)
+            callback(chunk->objects[j], data);
+    }
+
+    for (int i = 0; i < snapshot->outlyingCount; i++)
+        callback(snapshot->outlying[i], data);
+}
+
+#endif
\ No newline at end of file
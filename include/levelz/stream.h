@@ -0,0 +1,1013 @@
+#ifndef LEVELZ_STREAM_H
+#define LEVELZ_STREAM_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "../levelz.h"
+#include "thread.h"
+
+#define _LEVEL_STREAM_QUEUE_SIZE 256
+#define _LEVEL_STREAM_BUCKET_CHUNKS 4096
+
+/**
+ * Represents the streaming state of a chunk in a LevelStream3D.
+ */
+typedef struct LevelStreamChunk3D {
+    /**
+     * The chunk x coordinate.
+     */
+    int x;
+
+    /**
+     * The chunk y coordinate.
+     */
+    int y;
+
+    /**
+     * The chunk z coordinate.
+     */
+    int z;
+
+    /**
+     * Whether this slot of the chunk table is in use.
+     */
+    int used;
+
+    /**
+     * Whether the blocks of the chunk are loaded into the level.
+     */
+    int resident;
+
+    /**
+     * Whether the chunk was edited since it was loaded.
+     */
+    int dirty;
+
+    /**
+     * Whether a background read of the chunk is queued or in flight.
+     */
+    int pending;
+
+    /**
+     * Incremented whenever the chunk is loaded or evicted, so stale background reads are dropped.
+     */
+    int generation;
+
+    /**
+     * The tick the chunk was last used at.
+     */
+    uint64_t lastUsed;
+
+    /**
+     * The estimated number of bytes the chunk occupies while resident.
+     */
+    size_t bytes;
+
+    /**
+     * The offset of the chunk's latest record in the backing file, or -1 if it has none.
+     */
+    int64_t offset;
+
+    /**
+     * The length of the chunk's latest record in the backing file.
+     */
+    uint32_t length;
+
+    /**
+     * The indices of the source region entries that intersect the chunk, in file order.
+     */
+    uint32_t* sources;
+
+    /**
+     * The number of source region entries that intersect the chunk.
+     */
+    int sourceCount;
+} LevelStreamChunk3D;
+
+/**
+ * Represents a point that chunks are kept loaded around.
+ */
+typedef struct LevelStreamFocus3D {
+    /**
+     * The position of the focus.
+     */
+    double x, y, z;
+
+    /**
+     * The last movement of the focus, used to prefetch ahead of it.
+     */
+    double dx, dy, dz;
+} LevelStreamFocus3D;
+
+// Internal
+
+typedef struct __StreamRequest3D {
+    int x, y, z;
+    int generation;
+    int64_t offset;
+    uint32_t length;
+    uint32_t* sources;
+    int sourceCount;
+} __StreamRequest3D;
+
+// Results only hold the bytes that were read, since the parsers are not thread-safe.
+typedef struct __StreamResult3D {
+    int x, y, z;
+    int generation;
+    int binary;
+    char* data;
+    size_t length;
+    struct __StreamResult3D* next;
+} __StreamResult3D;
+
+// Implementation
+
+/**
+ * Represents a Level3D whose chunks are streamed in and out of memory. Chunks are
+ * loaded on demand and around focus points, and the least recently used chunks are
+ * evicted to a backing file whenever the resident blocks exceed a memory budget.
+ */
+typedef struct LevelStream3D {
+    /**
+     * The level holding the resident chunks.
+     */
+    Level3D* level;
+
+    /**
+     * The memory budget for resident blocks, in bytes.
+     */
+    size_t budget;
+
+    /**
+     * The estimated number of bytes used by resident blocks.
+     */
+    size_t bytes;
+
+    /**
+     * The number of chunks kept loaded around each focus point in every direction.
+     */
+    int radius;
+
+    /**
+     * The current tick, incremented on every access.
+     */
+    uint64_t tick;
+
+    /**
+     * The chunk table, open-addressed by chunk coordinate.
+     */
+    LevelStreamChunk3D* chunks;
+
+    /**
+     * The number of chunks in the table.
+     */
+    int chunkCount;
+
+    /**
+     * The capacity of the chunk table.
+     */
+    int chunkCapacity;
+
+    /**
+     * The focus points.
+     */
+    LevelStreamFocus3D* focus;
+
+    /**
+     * The number of focus points.
+     */
+    int focusCount;
+
+    /**
+     * The interned blocks, open-addressed by block hash.
+     */
+    Block** blocks;
+
+    /**
+     * The number of interned blocks.
+     */
+    int blockCount;
+
+    /**
+     * The capacity of the interned block table.
+     */
+    int blockCapacity;
+
+    /**
+     * The file that evicted chunks are written to.
+     */
+    FILE* backing;
+
+    /**
+     * The level file chunks are first loaded from, or null.
+     */
+    FILE* source;
+
+    /**
+     * The region index of the source file.
+     */
+    __RegionIndex3D sourceIndex;
+
+    /**
+     * The indices of the source region entries spanning too many chunks to be
+     * listed in each, checked whenever a chunk is loaded from the source file.
+     */
+    uint32_t* wideSources;
+
+    /**
+     * The number of wide source region entries.
+     */
+    int wideSourceCount;
+
+    /**
+     * Guards the request queue and results.
+     */
+    __Mutex lock;
+
+    /**
+     * Guards reads and writes of the backing and source files.
+     */
+    __Mutex io;
+
+    /**
+     * Signalled when a request is queued or the stream is freed.
+     */
+    __Cond wake;
+
+    /**
+     * The background thread that prefetches chunks.
+     */
+    __Thread worker;
+
+    /**
+     * Whether the background thread should keep running.
+     */
+    int running;
+
+    /**
+     * The queued prefetch requests.
+     */
+    __StreamRequest3D queue[_LEVEL_STREAM_QUEUE_SIZE];
+
+    /**
+     * The index of the first queued request.
+     */
+    int queueHead;
+
+    /**
+     * The number of queued requests.
+     */
+    int queueCount;
+
+    /**
+     * The completed prefetches waiting to be installed.
+     */
+    __StreamResult3D* results;
+} LevelStream3D;
+
+// Internal
+
+size_t __LevelStream3D_objectBytes() {
+    // the object with its embedded coordinate, its slots in the block array, index and chunk
+    return sizeof(LevelObject3D) + 2 * sizeof(LevelObject3D*) + 2 * sizeof(int);
+}
+
+LevelStreamChunk3D* __LevelStream3D_chunk(LevelStream3D* stream, int x, int y, int z) {
+    if (stream->chunkCount * 2 >= stream->chunkCapacity) {
+        LevelStreamChunk3D* old = stream->chunks;
+        int oldCapacity = stream->chunkCapacity;
+
+        stream->chunkCapacity = oldCapacity == 0 ? 64 : oldCapacity * 2;
+        stream->chunks = (LevelStreamChunk3D*) calloc(stream->chunkCapacity, sizeof(LevelStreamChunk3D));
+
+        for (int i = 0; i < oldCapacity; i++) {
+            if (!old[i].used) continue;
+
+            int slot = (int) (__hashChunk3D(old[i].x, old[i].y, old[i].z) & (stream->chunkCapacity - 1));
+            while (stream->chunks[slot].used) slot = (slot + 1) & (stream->chunkCapacity - 1);
+            stream->chunks[slot] = old[i];
+        }
+
+        free(old);
+    }
+
+    int slot = (int) (__hashChunk3D(x, y, z) & (stream->chunkCapacity - 1));
+    while (stream->chunks[slot].used) {
+        LevelStreamChunk3D* chunk = &stream->chunks[slot];
+        if (chunk->x == x && chunk->y == y && chunk->z == z) return chunk;
+
+        slot = (slot + 1) & (stream->chunkCapacity - 1);
+    }
+
+    LevelStreamChunk3D* chunk = &stream->chunks[slot];
+    memset(chunk, 0, sizeof(LevelStreamChunk3D));
+    chunk->x = x;
+    chunk->y = y;
+    chunk->z = z;
+    chunk->used = 1;
+    chunk->offset = -1;
+    stream->chunkCount++;
+
+    return chunk;
+}
+
+Block* __LevelStream3D_intern(LevelStream3D* stream, Block* block) {
+    if (stream->blockCount * 2 >= stream->blockCapacity) {
+        Block** old = stream->blocks;
+        int oldCapacity = stream->blockCapacity;
+
+        stream->blockCapacity = oldCapacity == 0 ? 64 : oldCapacity * 2;
+        stream->blocks = (Block**) calloc(stream->blockCapacity, sizeof(Block*));
+
+        for (int i = 0; i < oldCapacity; i++) {
+            if (old[i] == 0) continue;
+
+            int slot = (int) (Block_hash(old[i]) & (stream->blockCapacity - 1));
+            while (stream->blocks[slot] != 0) slot = (slot + 1) & (stream->blockCapacity - 1);
+            stream->blocks[slot] = old[i];
+        }
+
+        free(old);
+    }
+
+    int slot = (int) (Block_hash(block) & (stream->blockCapacity - 1));
+    while (stream->blocks[slot] != 0) {
+        if (stream->blocks[slot] == block || Block_equals(stream->blocks[slot], block))
+            return stream->blocks[slot];
+
+        slot = (slot + 1) & (stream->blockCapacity - 1);
+    }
+
+    stream->blocks[slot] = block;
+    stream->blockCount++;
+    return block;
+}
+
+int __LevelStream3D_inChunk(Coordinate3D* c, void* chunk) {
+    LevelStreamChunk3D* target = (LevelStreamChunk3D*) chunk;
+    return __chunkOf(c->x) == target->x && __chunkOf(c->y) == target->y && __chunkOf(c->z) == target->z;
+}
+
+int __LevelStream3D_entryInChunk(__RegionEntry3D* entry, int x, int y, int z) {
+    return __chunkOf(entry->min[0]) <= x && __chunkOf(entry->max[0]) >= x
+        && __chunkOf(entry->min[1]) <= y && __chunkOf(entry->max[1]) >= y
+        && __chunkOf(entry->min[2]) <= z && __chunkOf(entry->max[2]) >= z;
+}
+
+// Lists every source region entry in the chunks it intersects, so loading a chunk
+// only reads its own entries instead of scanning the whole index.
+void __LevelStream3D_bucketSources(LevelStream3D* stream) {
+    for (uint32_t i = 0; i < stream->sourceIndex.count; i++) {
+        __RegionEntry3D* entry = &stream->sourceIndex.entries[i];
+
+        int min[3], max[3];
+        double span = 1;
+        for (int k = 0; k < 3; k++) {
+            min[k] = __chunkOf(entry->min[k]);
+            max[k] = __chunkOf(entry->max[k]);
+            span *= (double) max[k] - min[k] + 1;
+        }
+
+        if (span > _LEVEL_STREAM_BUCKET_CHUNKS) {
+            stream->wideSources = (uint32_t*) __growArray(stream->wideSources, stream->wideSourceCount, sizeof(uint32_t));
+            stream->wideSources[stream->wideSourceCount++] = i;
+            continue;
+        }
+
+        for (int x = min[0]; x <= max[0]; x++)
+            for (int y = min[1]; y <= max[1]; y++)
+                for (int z = min[2]; z <= max[2]; z++) {
+                    LevelStreamChunk3D* chunk = __LevelStream3D_chunk(stream, x, y, z);
+                    chunk->sources = (uint32_t*) __growArray(chunk->sources, chunk->sourceCount, sizeof(uint32_t));
+                    chunk->sources[chunk->sourceCount++] = i;
+                }
+    }
+}
+
+// Reads the bytes of a chunk, either its record in the backing file or the
+// lines of the source file that intersect it. Called from both threads.
+__StreamResult3D* __LevelStream3D_fetch(LevelStream3D* stream, __StreamRequest3D* request) {
+    __StreamResult3D* result = (__StreamResult3D*) malloc(sizeof(__StreamResult3D));
+    result->x = request->x;
+    result->y = request->y;
+    result->z = request->z;
+    result->generation = request->generation;
+    result->binary = request->offset >= 0;
+    result->data = 0;
+    result->length = 0;
+    result->next = 0;
+
+    __Mutex_lock(&stream->io);
+
+    if (request->offset >= 0) {
+        result->data = __readRange(stream->backing, request->offset, request->length);
+        result->length = request->length;
+    } else if (stream->source != 0) {
+        size_t capacity = 256;
+        result->data = (char*) malloc(capacity);
+        result->data[0] = '\0';
+
+        // merges the chunk's own entries with the wide ones, keeping file order
+        int i = 0, j = 0;
+        while (i < request->sourceCount || j < stream->wideSourceCount) {
+            int own = j == stream->wideSourceCount || (i < request->sourceCount && request->sources[i] < stream->wideSources[j]);
+            __RegionEntry3D* entry = &stream->sourceIndex.entries[own ? request->sources[i++] : stream->wideSources[j++]];
+            if (!own && !__LevelStream3D_entryInChunk(entry, request->x, request->y, request->z)) continue;
+
+            char* prefix = __readRange(stream->source, entry->line, entry->prefix);
+            char* span = __readRange(stream->source, entry->line + entry->start, entry->length);
+            __appendf(&result->data, &result->length, &capacity, "%s:%s\n", prefix, span);
+
+            free(prefix);
+            free(span);
+        }
+    }
+
+    __Mutex_unlock(&stream->io);
+    return result;
+}
+
+int __LevelStream3D_decode(__StreamResult3D* result, LevelStreamChunk3D* chunk, LevelObject3D*** objects) {
+    int count = 0;
+    if (result->data == 0) return 0;
+
+    if (result->binary) {
+        __CacheReader reader;
+        reader.cursor = result->data;
+        reader.end = result->data + result->length;
+
+        uint32_t blockCount;
+        Block** blocks = __CacheReader_readBlocks(&reader, &blockCount);
+        if (blocks == 0) return 0;
+
+        uint32_t objectCount = 0;
+        __CacheReader_readUInt32(&reader, &objectCount);
+        for (uint32_t i = 0; i < objectCount; i++) {
+            uint32_t index;
+            double x, y, z;
+            int complete = __CacheReader_readUInt32(&reader, &index)
+                && __CacheReader_read(&reader, &x, sizeof(double))
+                && __CacheReader_read(&reader, &y, sizeof(double))
+                && __CacheReader_read(&reader, &z, sizeof(double));
+            if (!complete || index >= blockCount) break;
+
+            *objects = (LevelObject3D**) __growArray(*objects, count, sizeof(LevelObject3D*));
+            (*objects)[count++] = createLevelObject3DAt(blocks[index], makeCoordinate3D(x, y, z));
+        }
+
+        free(blocks);
+        return count;
+    }
+
+    char* cursor = result->data;
+    char* token = __nextLine(&cursor);
+    while (token != 0) {
+        LevelZLine3D* line = __read3DLine(token);
+        int used = 0;
+        if (line->coordinates != 0) {
+            for (int i = 0; line->coordinates[i] != 0; i++) {
+                if (!__LevelStream3D_inChunk(line->coordinates[i], chunk)) {
+                    free(line->coordinates[i]);
+                    continue;
+                }
+
+                *objects = (LevelObject3D**) __growArray(*objects, count, sizeof(LevelObject3D*));
+                (*objects)[count++] = createLevelObject3DAt(line->block, *line->coordinates[i]);
+                free(line->coordinates[i]);
+                used = 1;
+            }
+        }
+
+        if (!used && line->block != 0) __Block_free(line->block);
+        free(line->coordinates);
+        free(line);
+        token = __nextLine(&cursor);
+    }
+
+    return count;
+}
+
+// Replaces the blocks of decoded objects with interned ones and frees the duplicates.
+void __LevelStream3D_internObjects(LevelStream3D* stream, LevelObject3D** objects, int count) {
+    __BlockTable table;
+    table.blocks = (Block**) malloc((count + 1) * sizeof(Block*));
+    table.count = 0;
+    table.slotCapacity = 16;
+    while (table.slotCapacity < count * 2) table.slotCapacity *= 2;
+    table.slots = (int*) calloc(table.slotCapacity, sizeof(int));
+
+    uint32_t* indices = (uint32_t*) malloc((count + 1) * sizeof(uint32_t));
+    for (int i = 0; i < count; i++)
+        indices[i] = __BlockTable_indexOf(&table, objects[i]->block);
+
+    Block** interned = (Block**) malloc((table.count + 1) * sizeof(Block*));
+    for (int i = 0; i < table.count; i++)
+        interned[i] = __LevelStream3D_intern(stream, table.blocks[i]);
+
+    for (int i = 0; i < count; i++)
+        objects[i]->block = interned[indices[i]];
+
+    for (int i = 0; i < table.count; i++)
+        if (interned[i] != table.blocks[i]) __Block_free(table.blocks[i]);
+
+    free(interned);
+    free(indices);
+    free(table.slots);
+    free(table.blocks);
+}
+
+void __LevelStream3D_install(LevelStream3D* stream, LevelStreamChunk3D* chunk, __StreamResult3D* result) {
+    LevelObject3D** objects = 0;
+    int count = __LevelStream3D_decode(result, chunk, &objects);
+
+    __LevelStream3D_internObjects(stream, objects, count);
+    Level3D_addBlocks(stream->level, objects, count);
+    free(objects);
+
+    chunk->resident = 1;
+    chunk->dirty = 0;
+    chunk->generation++;
+    chunk->lastUsed = ++stream->tick;
+
+    LevelChunk3D* levelChunk = LevelChunkMap3D_get(&stream->level->chunks, chunk->x, chunk->y, chunk->z);
+    chunk->bytes = (levelChunk == 0 ? 0 : levelChunk->count) * __LevelStream3D_objectBytes();
+    stream->bytes += chunk->bytes;
+}
+
+void __LevelStream3D_freeResult(__StreamResult3D* result) {
+    free(result->data);
+    free(result);
+}
+
+void __LevelStream3D_evict(LevelStream3D* stream, LevelStreamChunk3D* chunk) {
+    Level3D* level = stream->level;
+    LevelChunk3D* levelChunk = LevelChunkMap3D_get(&level->chunks, chunk->x, chunk->y, chunk->z);
+    int count = levelChunk == 0 ? 0 : levelChunk->count;
+
+    LevelObject3D** objects = (LevelObject3D**) malloc((count + 1) * sizeof(LevelObject3D*));
+    if (count > 0)
+        memcpy(objects, levelChunk->objects, count * sizeof(LevelObject3D*));
+
+    // unedited chunks can be read again from where they came from
+    if (chunk->dirty) {
+        size_t length = 0;
+        size_t capacity = 256;
+        char* str = (char*) malloc(capacity);
+
+        __BlockTable table;
+        table.blocks = (Block**) malloc((count + 1) * sizeof(Block*));
+        table.count = 0;
+        table.slotCapacity = 16;
+        while (table.slotCapacity < count * 2) table.slotCapacity *= 2;
+        table.slots = (int*) calloc(table.slotCapacity, sizeof(int));
+
+        uint32_t* indices = (uint32_t*) malloc((count + 1) * sizeof(uint32_t));
+        for (int i = 0; i < count; i++)
+            indices[i] = __BlockTable_indexOf(&table, objects[i]->block);
+
+        __appendCacheBlocks(&str, &length, &capacity, table.blocks, table.count);
+        __appendUInt32(&str, &length, &capacity, (uint32_t) count);
+        for (int i = 0; i < count; i++) {
+            Coordinate3D* c = objects[i]->coordinate;
+            __appendUInt32(&str, &length, &capacity, indices[i]);
+            __appendBytes(&str, &length, &capacity, &c->x, sizeof(double));
+            __appendBytes(&str, &length, &capacity, &c->y, sizeof(double));
+            __appendBytes(&str, &length, &capacity, &c->z, sizeof(double));
+        }
+
+        __Mutex_lock(&stream->io);
+        fseek(stream->backing, 0, SEEK_END);
+        chunk->offset = (int64_t) ftell(stream->backing);
+        chunk->length = (uint32_t) length;
+        fwrite(str, 1, length, stream->backing);
+        fflush(stream->backing);
+        __Mutex_unlock(&stream->io);
+
+        free(indices);
+        free(table.slots);
+        free(table.blocks);
+        free(str);
+    }
+
+    for (int i = 0; i < count; i++) {
+        Coordinate3D* coordinate = objects[i]->coordinate;
+        int embedded = coordinate == &objects[i]->position;
+        int shared = level->snapshot != 0 && __atomicLoad(&level->snapshot->refs) > 1;
+
+        Level3D_removeBlock(level, objects[i]);
+        if (!shared && !embedded) free(coordinate);
+    }
+
+    free(objects);
+
+    stream->bytes -= chunk->bytes;
+    chunk->bytes = 0;
+    chunk->resident = 0;
+    chunk->dirty = 0;
+    chunk->generation++;
+}
+
+int __LevelStream3D_pinned(LevelStream3D* stream, LevelStreamChunk3D* chunk) {
+    for (int i = 0; i < stream->focusCount; i++) {
+        LevelStreamFocus3D* focus = &stream->focus[i];
+        int dx = abs(chunk->x - __chunkOf(focus->x));
+        int dy = abs(chunk->y - __chunkOf(focus->y));
+        int dz = abs(chunk->z - __chunkOf(focus->z));
+
+        if (dx <= stream->radius && dy <= stream->radius && dz <= stream->radius) return 1;
+    }
+
+    return 0;
+}
+
+int __compareLastUsed(const void* a, const void* b) {
+    uint64_t x = (*(LevelStreamChunk3D**) a)->lastUsed;
+    uint64_t y = (*(LevelStreamChunk3D**) b)->lastUsed;
+    return (x > y) - (x < y);
+}
+
+void __LevelStream3D_enforceBudget(LevelStream3D* stream) {
+    if (stream->bytes <= stream->budget) return;
+
+    LevelStreamChunk3D** candidates = (LevelStreamChunk3D**) malloc((stream->chunkCount + 1) * sizeof(LevelStreamChunk3D*));
+    int count = 0;
+    for (int i = 0; i < stream->chunkCapacity; i++) {
+        LevelStreamChunk3D* chunk = &stream->chunks[i];
+        if (chunk->used && chunk->resident && !__LevelStream3D_pinned(stream, chunk))
+            candidates[count++] = chunk;
+    }
+
+    // the most recently used chunk is the one being accessed, so it is kept
+    qsort(candidates, count, sizeof(LevelStreamChunk3D*), __compareLastUsed);
+    for (int i = 0; i < count - 1 && stream->bytes > stream->budget; i++)
+        __LevelStream3D_evict(stream, candidates[i]);
+
+    free(candidates);
+}
+
+LevelStreamChunk3D* __LevelStream3D_load(LevelStream3D* stream, int x, int y, int z) {
+    LevelStreamChunk3D* chunk = __LevelStream3D_chunk(stream, x, y, z);
+    if (chunk->resident) {
+        chunk->lastUsed = ++stream->tick;
+        return chunk;
+    }
+
+    __StreamRequest3D request;
+    request.x = x;
+    request.y = y;
+    request.z = z;
+    request.generation = chunk->generation;
+    request.offset = chunk->offset;
+    request.length = chunk->length;
+    request.sources = chunk->sources;
+    request.sourceCount = chunk->sourceCount;
+
+    __StreamResult3D* result = __LevelStream3D_fetch(stream, &request);
+    __LevelStream3D_install(stream, chunk, result);
+    __LevelStream3D_freeResult(result);
+
+    return chunk;
+}
+
+void __LevelStream3D_request(LevelStream3D* stream, int x, int y, int z) {
+    LevelStreamChunk3D* chunk = __LevelStream3D_chunk(stream, x, y, z);
+    if (chunk->resident || chunk->pending) return;
+    if (chunk->offset < 0 && stream->source == 0) return;
+
+    __Mutex_lock(&stream->lock);
+    if (stream->queueCount < _LEVEL_STREAM_QUEUE_SIZE) {
+        __StreamRequest3D* request = &stream->queue[(stream->queueHead + stream->queueCount) % _LEVEL_STREAM_QUEUE_SIZE];
+        request->x = x;
+        request->y = y;
+        request->z = z;
+        request->generation = chunk->generation;
+        request->offset = chunk->offset;
+        request->length = chunk->length;
+        request->sources = chunk->sources;
+        request->sourceCount = chunk->sourceCount;
+
+        stream->queueCount++;
+        chunk->pending = 1;
+        __Cond_signal(&stream->wake);
+    }
+    __Mutex_unlock(&stream->lock);
+}
+
+void* __LevelStream3D_work(void* arg) {
+    LevelStream3D* stream = (LevelStream3D*) arg;
+
+    __Mutex_lock(&stream->lock);
+    while (1) {
+        while (stream->running && stream->queueCount == 0)
+            __Cond_wait(&stream->wake, &stream->lock);
+
+        if (!stream->running) break;
+
+        __StreamRequest3D request = stream->queue[stream->queueHead];
+        stream->queueHead = (stream->queueHead + 1) % _LEVEL_STREAM_QUEUE_SIZE;
+        stream->queueCount--;
+        __Mutex_unlock(&stream->lock);
+
+        __StreamResult3D* result = __LevelStream3D_fetch(stream, &request);
+
+        __Mutex_lock(&stream->lock);
+        result->next = stream->results;
+        stream->results = result;
+    }
+    __Mutex_unlock(&stream->lock);
+
+    return 0;
+}
+
+// Implementation
+
+/**
+ * Creates a new LevelStream3D. Chunks are first loaded from the source level file,
+ * using its region index, and from the backing file once they have been evicted.
+ * A background thread reads chunks ahead of moving focus points.
+ * @param source The path to the level file to stream, or null to start with an empty level.
+ * @param backing The path to the file evicted chunks are written to, or null to use a temporary file.
+ * @param budget The memory budget for resident blocks, in bytes.
+ * @param radius The number of chunks kept loaded around each focus point in every direction.
+ * @return A new LevelStream3D, or null if a file could not be opened.
+ */
+LevelStream3D* createLevelStream3D(const char* source, const char* backing, size_t budget, int radius) {
+    LevelStream3D* stream = (LevelStream3D*) calloc(1, sizeof(LevelStream3D));
+    stream->budget = budget;
+    stream->radius = radius < 0 ? 0 : radius;
+
+    if (source != 0) {
+        if (!__RegionIndex3D_open(&stream->sourceIndex, source)) {
+            free(stream);
+            return 0;
+        }
+
+        stream->source = fopen(source, "rb");
+        char* headers = stream->source == 0 ? 0 : __readRange(stream->source, 0, (size_t) stream->sourceIndex.body);
+        stream->level = headers == 0 ? 0 : readLevel3D(headers);
+        free(headers);
+
+        if (stream->level == 0) {
+            if (stream->source != 0) fclose(stream->source);
+            free(stream->sourceIndex.entries);
+            free(stream);
+            return 0;
+        }
+    } else {
+        stream->level = createLevel3D(createCoordinate3D(0, 0, 0));
+    }
+
+    stream->backing = backing == 0 ? tmpfile() : fopen(backing, "w+b");
+    if (stream->backing == 0) {
+        if (stream->source != 0) fclose(stream->source);
+        free(stream->sourceIndex.entries);
+        free(stream);
+        return 0;
+    }
+
+    __LevelStream3D_bucketSources(stream);
+
+    __Mutex_init(&stream->lock);
+    __Mutex_init(&stream->io);
+    __Cond_init(&stream->wake);
+    stream->running = 1;
+    if (!__Thread_create(&stream->worker, __LevelStream3D_work, stream))
+        stream->running = 0;
+
+    return stream;
+}
+
+/**
+ * Stops the background thread of a LevelStream3D and frees it, along with its
+ * backing file. The resident level is left to the caller.
+ * @param stream The LevelStream3D.
+ */
+void LevelStream3D_free(LevelStream3D* stream) {
+    if (stream == 0) return;
+
+    __Mutex_lock(&stream->lock);
+    int running = stream->running;
+    stream->running = 0;
+    __Cond_broadcast(&stream->wake);
+    __Mutex_unlock(&stream->lock);
+
+    if (running) __Thread_join(stream->worker);
+
+    while (stream->results != 0) {
+        __StreamResult3D* next = stream->results->next;
+        __LevelStream3D_freeResult(stream->results);
+        stream->results = next;
+    }
+
+    fclose(stream->backing);
+    if (stream->source != 0) fclose(stream->source);
+
+    __Cond_destroy(&stream->wake);
+    __Mutex_destroy(&stream->io);
+    __Mutex_destroy(&stream->lock);
+
+    for (int i = 0; i < stream->chunkCapacity; i++)
+        if (stream->chunks[i].used) free(stream->chunks[i].sources);
+
+    free(stream->sourceIndex.entries);
+    free(stream->wideSources);
+    free(stream->chunks);
+    free(stream->focus);
+    free(stream->blocks);
+    free(stream);
+}
+
+/**
+ * Adds a focus point to a LevelStream3D. Chunks within the stream's radius of a
+ * focus point are loaded by LevelStream3D_update and never evicted.
+ * @param stream The LevelStream3D.
+ * @param position The position of the focus point.
+ * @return The index of the focus point.
+ */
+int LevelStream3D_addFocus(LevelStream3D* stream, Coordinate3D* position) {
+    if (stream == 0) return -1;
+    if (position == 0) return -1;
+
+    stream->focus = (LevelStreamFocus3D*) __growArray(stream->focus, stream->focusCount, sizeof(LevelStreamFocus3D));
+
+    LevelStreamFocus3D* focus = &stream->focus[stream->focusCount];
+    memset(focus, 0, sizeof(LevelStreamFocus3D));
+    focus->x = position->x;
+    focus->y = position->y;
+    focus->z = position->z;
+
+    return stream->focusCount++;
+}
+
+/**
+ * Moves a focus point of a LevelStream3D. The movement is used to prefetch the
+ * chunks ahead of the focus point on the next LevelStream3D_update.
+ * @param stream The LevelStream3D.
+ * @param focus The index of the focus point.
+ * @param position The new position of the focus point.
+ */
+void LevelStream3D_moveFocus(LevelStream3D* stream, int focus, Coordinate3D* position) {
+    if (stream == 0) return;
+    if (position == 0) return;
+    if (focus < 0 || focus >= stream->focusCount) return;
+
+    LevelStreamFocus3D* f = &stream->focus[focus];
+    f->dx = position->x - f->x;
+    f->dy = position->y - f->y;
+    f->dz = position->z - f->z;
+    f->x = position->x;
+    f->y = position->y;
+    f->z = position->z;
+}
+
+/**
+ * Updates a LevelStream3D. Installs chunks read in the background, loads the chunks
+ * around every focus point, queues the chunks ahead of moving focus points for the
+ * background thread, and evicts the least recently used chunks over the budget.
+ * @param stream The LevelStream3D.
+ */
+void LevelStream3D_update(LevelStream3D* stream) {
+    if (stream == 0) return;
+
+    __Mutex_lock(&stream->lock);
+    __StreamResult3D* results = stream->results;
+    stream->results = 0;
+    __Mutex_unlock(&stream->lock);
+
+    while (results != 0) {
+        __StreamResult3D* next = results->next;
+
+        LevelStreamChunk3D* chunk = __LevelStream3D_chunk(stream, results->x, results->y, results->z);
+        chunk->pending = 0;
+        if (!chunk->resident && chunk->generation == results->generation)
+            __LevelStream3D_install(stream, chunk, results);
+
+        __LevelStream3D_freeResult(results);
+        results = next;
+    }
+
+    int r = stream->radius;
+    for (int i = 0; i < stream->focusCount; i++) {
+        LevelStreamFocus3D* focus = &stream->focus[i];
+        int cx = __chunkOf(focus->x), cy = __chunkOf(focus->y), cz = __chunkOf(focus->z);
+
+        for (int x = cx - r; x <= cx + r; x++)
+            for (int y = cy - r; y <= cy + r; y++)
+                for (int z = cz - r; z <= cz + r; z++)
+                    __LevelStream3D_load(stream, x, y, z);
+
+        // the chunks that come into range after moving one more chunk the same way
+        int sx = (focus->dx > 0) - (focus->dx < 0);
+        int sy = (focus->dy > 0) - (focus->dy < 0);
+        int sz = (focus->dz > 0) - (focus->dz < 0);
+        if (sx == 0 && sy == 0 && sz == 0) continue;
+
+        for (int x = cx + sx - r; x <= cx + sx + r; x++)
+            for (int y = cy + sy - r; y <= cy + sy + r; y++)
+                for (int z = cz + sz - r; z <= cz + sz + r; z++)
+                    __LevelStream3D_request(stream, x, y, z);
+    }
+
+    __LevelStream3D_enforceBudget(stream);
+}
+
+/**
+ * Gets the block at a coordinate of a LevelStream3D, loading its chunk if needed.
+ * Blocks are interned by the stream, so the returned block outlives its chunk.
+ * @param stream The LevelStream3D.
+ * @param coordinate The coordinate of the block.
+ * @return The block, or null if there is none.
+ */
+Block* LevelStream3D_getBlock(LevelStream3D* stream, Coordinate3D* coordinate) {
+    if (stream == 0) return 0;
+    if (coordinate == 0) return 0;
+
+    __LevelStream3D_load(stream, __chunkOf(coordinate->x), __chunkOf(coordinate->y), __chunkOf(coordinate->z));
+    Block* block = Level3D_getBlock(stream->level, coordinate);
+    __LevelStream3D_enforceBudget(stream);
+
+    return block;
+}
+
+/**
+ * Adds a block to a LevelStream3D, loading its chunk if needed. The stream takes
+ * ownership of the object, its coordinate and its block, which is freed when the
+ * stream already holds an equal one. Edits to a stream must go through the
+ * LevelStream3D functions so that evicted chunks are written back.
+ * @param stream The LevelStream3D.
+ * @param block The block to add.
+ */
+void LevelStream3D_addBlock(LevelStream3D* stream, LevelObject3D* block) {
+    if (stream == 0) return;
+    if (block == 0) return;
+
+    Coordinate3D* c = block->coordinate;
+    LevelStreamChunk3D* chunk = __LevelStream3D_load(stream, __chunkOf(c->x), __chunkOf(c->y), __chunkOf(c->z));
+
+    Block* interned = __LevelStream3D_intern(stream, block->block);
+    if (interned != block->block) __Block_free(block->block);
+
+    block->block = interned;
+    Level3D_addBlock(stream->level, block);
+
+    LevelChunk3D* levelChunk = LevelChunkMap3D_get(&stream->level->chunks, chunk->x, chunk->y, chunk->z);
+    stream->bytes -= chunk->bytes;
+    chunk->bytes = (levelChunk == 0 ? 0 : levelChunk->count) * __LevelStream3D_objectBytes();
+    stream->bytes += chunk->bytes;
+    chunk->dirty = 1;
+
+    __LevelStream3D_enforceBudget(stream);
+}
+
+/**
+ * Removes the block at a coordinate of a LevelStream3D, loading its chunk if needed.
+ * @param stream The LevelStream3D.
+ * @param coordinate The coordinate of the block.
+ */
+void LevelStream3D_removeBlock(LevelStream3D* stream, Coordinate3D* coordinate) {
+    if (stream == 0) return;
+    if (coordinate == 0) return;
+
+    LevelStreamChunk3D* chunk = __LevelStream3D_load(stream, __chunkOf(coordinate->x), __chunkOf(coordinate->y), __chunkOf(coordinate->z));
+
+    int position = __Level3D_findBlock(stream->level, coordinate->x, coordinate->y, coordinate->z);
+    if (position >= 0) {
+        Level3D_removeBlock(stream->level, stream->level->blocks[position]);
+
+        LevelChunk3D* levelChunk = LevelChunkMap3D_get(&stream->level->chunks, chunk->x, chunk->y, chunk->z);
+        stream->bytes -= chunk->bytes;
+        chunk->bytes = (levelChunk == 0 ? 0 : levelChunk->count) * __LevelStream3D_objectBytes();
+        stream->bytes += chunk->bytes;
+        chunk->dirty = 1;
+    }
+
+    __LevelStream3D_enforceBudget(stream);
+}
+
+/**
+ * Checks if the chunk containing a coordinate is loaded in a LevelStream3D.
+ * @param stream The LevelStream3D.
+ * @param coordinate The coordinate.
+ * @return 1 if the chunk is resident, 0 otherwise.
+ */
+int LevelStream3D_isLoaded(LevelStream3D* stream, Coordinate3D* coordinate) {
+    if (stream == 0) return 0;
+    if (coordinate == 0) return 0;
+    if (stream->chunkCapacity == 0) return 0;
+
+    int x = __chunkOf(coordinate->x), y = __chunkOf(coordinate->y), z = __chunkOf(coordinate->z);
+    int slot = (int) (__hashChunk3D(x, y, z) & (stream->chunkCapacity - 1));
+    while (stream->chunks[slot].used) {
+        LevelStreamChunk3D* chunk = &stream->chunks[slot];
+        if (chunk->x == x && chunk->y == y && chunk->z == z) return chunk->resident;
+
+        slot = (slot + 1) & (stream->chunkCapacity - 1);
+    }
+
+    return 0;
+}
+
+#endif
@@ -0,0 +1,194 @@
+#ifndef LEVELZ_THREAD_H
+#define LEVELZ_THREAD_H
+
+#include <stdlib.h>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+// Internal
+
+#if defined(_MSC_VER) && !defined(__clang__)
+
+int __atomicIncrement(int* value) {
+    return (int) _InterlockedIncrement((volatile long*) value);
+}
+
+int __atomicDecrement(int* value) {
+    return (int) _InterlockedDecrement((volatile long*) value);
+}
+
+int __atomicLoad(int* value) {
+    return (int) _InterlockedOr((volatile long*) value, 0);
+}
+
+#else
+
+int __atomicIncrement(int* value) {
+    return __atomic_add_fetch(value, 1, __ATOMIC_ACQ_REL);
+}
+
+int __atomicDecrement(int* value) {
+    return __atomic_sub_fetch(value, 1, __ATOMIC_ACQ_REL);
+}
+
+int __atomicLoad(int* value) {
+    return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+}
+
+#endif
+
+#ifdef _WIN32
+
+#define __MUTEX_INITIALIZER SRWLOCK_INIT
+
+typedef SRWLOCK __Mutex;
+typedef CONDITION_VARIABLE __Cond;
+typedef HANDLE __Thread;
+
+typedef struct __ThreadStart {
+    void* (*function)(void*);
+    void* arg;
+} __ThreadStart;
+
+DWORD WINAPI __threadMain(LPVOID arg) {
+    __ThreadStart start = *(__ThreadStart*) arg;
+    free(arg);
+
+    start.function(start.arg);
+    return 0;
+}
+
+void __Mutex_init(__Mutex* mutex) {
+    InitializeSRWLock(mutex);
+}
+
+void __Mutex_lock(__Mutex* mutex) {
+    AcquireSRWLockExclusive(mutex);
+}
+
+void __Mutex_unlock(__Mutex* mutex) {
+    ReleaseSRWLockExclusive(mutex);
+}
+
+void __Mutex_destroy(__Mutex* mutex) {}
+
+void __Cond_init(__Cond* cond) {
+    InitializeConditionVariable(cond);
+}
+
+void __Cond_wait(__Cond* cond, __Mutex* mutex) {
+    SleepConditionVariableSRW(cond, mutex, INFINITE, 0);
+}
+
+void __Cond_signal(__Cond* cond) {
+    WakeConditionVariable(cond);
+}
+
+void __Cond_broadcast(__Cond* cond) {
+    WakeAllConditionVariable(cond);
+}
+
+void __Cond_destroy(__Cond* cond) {}
+
+int __Thread_create(__Thread* thread, void* (*function)(void*), void* arg) {
+    __ThreadStart* start = (__ThreadStart*) malloc(sizeof(__ThreadStart));
+    start->function = function;
+    start->arg = arg;
+
+    *thread = CreateThread(0, 0, __threadMain, start, 0, 0);
+    if (*thread == 0) {
+        free(start);
+        return 0;
+    }
+
+    return 1;
+}
+
+void __Thread_join(__Thread thread) {
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+}
+
+int __cpuCount() {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int) info.dwNumberOfProcessors;
+}
+
+int __processId() {
+    return (int) GetCurrentProcessId();
+}
+
+#else
+
+#define __MUTEX_INITIALIZER PTHREAD_MUTEX_INITIALIZER
+
+typedef pthread_mutex_t __Mutex;
+typedef pthread_cond_t __Cond;
+typedef pthread_t __Thread;
+
+void __Mutex_init(__Mutex* mutex) {
+    pthread_mutex_init(mutex, 0);
+}
+
+void __Mutex_lock(__Mutex* mutex) {
+    pthread_mutex_lock(mutex);
+}
+
+void __Mutex_unlock(__Mutex* mutex) {
+    pthread_mutex_unlock(mutex);
+}
+
+void __Mutex_destroy(__Mutex* mutex) {
+    pthread_mutex_destroy(mutex);
+}
+
+void __Cond_init(__Cond* cond) {
+    pthread_cond_init(cond, 0);
+}
+
+void __Cond_wait(__Cond* cond, __Mutex* mutex) {
+    pthread_cond_wait(cond, mutex);
+}
+
+void __Cond_signal(__Cond* cond) {
+    pthread_cond_signal(cond);
+}
+
+void __Cond_broadcast(__Cond* cond) {
+    pthread_cond_broadcast(cond);
+}
+
+void __Cond_destroy(__Cond* cond) {
+    pthread_cond_destroy(cond);
+}
+
+int __Thread_create(__Thread* thread, void* (*function)(void*), void* arg) {
+    return pthread_create(thread, 0, function, arg) == 0;
+}
+
+void __Thread_join(__Thread thread) {
+    pthread_join(thread, 0);
+}
+
+int __cpuCount() {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count < 1 ? 1 : (int) count;
+}
+
+int __processId() {
+    return (int) getpid();
+}
+
+#endif
+
+#endif
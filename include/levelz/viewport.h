@@ -0,0 +1,522 @@
+#ifndef LEVELZ_VIEWPORT_H
+#define LEVELZ_VIEWPORT_H
+
+#define _LEVEL_VIEWPORT_QUEUE_SIZE 64
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "block.h"
+#include "chunk.h"
+#include "coordinate.h"
+#include "level.h"
+#include "snapshot.h"
+#include "thread.h"
+
+// Internal
+
+typedef struct __StripChunk2D {
+    int strip;
+    LevelChunkSnapshot2D* chunk;
+} __StripChunk2D;
+
+// A snapshot of the level together with its chunks ordered by strip. Shared by the
+// viewport, its worker and every strip decoded from it.
+typedef struct __StripSource2D {
+    int refs;
+    int vertical;
+    LevelSnapshot2D* snapshot;
+    __StripChunk2D* chunks;
+    int chunkCount;
+} __StripSource2D;
+
+typedef struct __Strip2D {
+    int index;
+    LevelObject2D** objects;
+    int count;
+    __StripSource2D* source;
+} __Strip2D;
+
+int __compareStripChunks2D(const void* a, const void* b) {
+    const __StripChunk2D* c = (const __StripChunk2D*) a;
+    const __StripChunk2D* d = (const __StripChunk2D*) b;
+    if (c->strip != d->strip) return c->strip < d->strip ? -1 : 1;
+    return 0;
+}
+
+int __compareColumns2D(const void* a, const void* b) {
+    const LevelObject2D* c = *(LevelObject2D* const*) a;
+    const LevelObject2D* d = *(LevelObject2D* const*) b;
+    if (c->coordinate->x != d->coordinate->x) return c->coordinate->x < d->coordinate->x ? -1 : 1;
+    if (c->coordinate->y != d->coordinate->y) return c->coordinate->y < d->coordinate->y ? -1 : 1;
+    return 0;
+}
+
+int __compareRows2D(const void* a, const void* b) {
+    const LevelObject2D* c = *(LevelObject2D* const*) a;
+    const LevelObject2D* d = *(LevelObject2D* const*) b;
+    if (c->coordinate->y != d->coordinate->y) return c->coordinate->y < d->coordinate->y ? -1 : 1;
+    if (c->coordinate->x != d->coordinate->x) return c->coordinate->x < d->coordinate->x ? -1 : 1;
+    return 0;
+}
+
+__StripSource2D* __StripSource2D_create(Level2D* level, int vertical) {
+    __StripSource2D* source = (__StripSource2D*) malloc(sizeof(__StripSource2D));
+    source->refs = 1;
+    source->vertical = vertical;
+    source->snapshot = Level2D_snapshot(level);
+
+    LevelSnapshot2D* snapshot = source->snapshot;
+    source->chunks = (__StripChunk2D*) malloc((snapshot->chunkCapacity + 1) * sizeof(__StripChunk2D));
+    source->chunkCount = 0;
+    for (int i = 0; i < snapshot->chunkCapacity; i++) {
+        LevelChunkSnapshot2D* chunk = snapshot->chunks[i];
+        if (chunk == 0) continue;
+
+        source->chunks[source->chunkCount].strip = vertical ? chunk->y : chunk->x;
+        source->chunks[source->chunkCount].chunk = chunk;
+        source->chunkCount++;
+    }
+
+    qsort(source->chunks, source->chunkCount, sizeof(__StripChunk2D), __compareStripChunks2D);
+    return source;
+}
+
+void __StripSource2D_release(__StripSource2D* source) {
+    if (source == 0) return;
+    if (__atomicDecrement(&source->refs) != 0) return;
+
+    LevelSnapshot2D_release(source->snapshot);
+    free(source->chunks);
+    free(source);
+}
+
+// Gathers the blocks of every chunk in a strip and orders them along the strip, so
+// columns (or rows) of the strip are contiguous. Only reads the immutable source.
+__Strip2D* __StripSource2D_decode(__StripSource2D* source, int index) {
+    int lo = 0, hi = source->chunkCount;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (source->chunks[mid].strip < index) lo = mid + 1;
+        else hi = mid;
+    }
+
+    int count = 0;
+    for (int i = lo; i < source->chunkCount && source->chunks[i].strip == index; i++)
+        count += source->chunks[i].chunk->count;
+
+    __Strip2D* strip = (__Strip2D*) malloc(sizeof(__Strip2D));
+    strip->index = index;
+    strip->objects = (LevelObject2D**) malloc((count + 1) * sizeof(LevelObject2D*));
+    strip->count = 0;
+    for (int i = lo; i < source->chunkCount && source->chunks[i].strip == index; i++) {
+        LevelChunkSnapshot2D* chunk = source->chunks[i].chunk;
+        memcpy(strip->objects + strip->count, chunk->objects, chunk->count * sizeof(LevelObject2D*));
+        strip->count += chunk->count;
+    }
+
+    qsort(strip->objects, strip->count, sizeof(LevelObject2D*), source->vertical ? __compareRows2D : __compareColumns2D);
+
+    __atomicIncrement(&source->refs);
+    strip->source = source;
+    return strip;
+}
+
+void __Strip2D_free(__Strip2D* strip) {
+    free(strip->objects);
+    __StripSource2D_release(strip->source);
+    free(strip);
+}
+
+// Implementation
+
+/**
+ * Represents a window onto a scrolling Level2D. Blocks are kept in strips one chunk
+ * thick across the scroll direction: columns for horizontal scrolling and rows for
+ * vertical scrolling, each ordered along the strip. Strips ahead of the window are
+ * decoded by a background thread from a snapshot of the level, and strips far behind
+ * it are dropped, so the cost of a frame does not depend on the length of the level.
+ */
+typedef struct LevelViewport2D {
+    /**
+     * The level the viewport shows.
+     */
+    Level2D* level;
+
+    /**
+     * The scroll direction of the level. VERTICAL_UP scrolls towards increasing y.
+     */
+    enum Scroll scroll;
+
+    /**
+     * The number of strips decoded ahead of the window in the scroll direction.
+     */
+    int prefetch;
+
+    /**
+     * The source strips are decoded from, replaced by LevelViewport2D_refresh.
+     */
+    __StripSource2D* source;
+
+    /**
+     * The decoded strips.
+     */
+    __Strip2D** strips;
+
+    /**
+     * The number of decoded strips.
+     */
+    int stripCount;
+
+    /**
+     * The capacity of the strips array.
+     */
+    int stripCapacity;
+
+    /**
+     * The first and last strip kept decoded around the last window.
+     */
+    int keepFirst, keepLast;
+
+    /**
+     * The strips waiting to be decoded by the background thread.
+     */
+    int queue[_LEVEL_VIEWPORT_QUEUE_SIZE];
+
+    /**
+     * The number of queued strips.
+     */
+    int queueCount;
+
+    /**
+     * Whether the background thread is decoding a strip.
+     */
+    int busy;
+
+    /**
+     * Whether the background thread is running.
+     */
+    int running;
+
+    /**
+     * The background thread decoding queued strips.
+     */
+    __Thread worker;
+
+    /**
+     * Guards the source, strips and queue.
+     */
+    __Mutex lock;
+
+    /**
+     * Signalled when strips are queued or the viewport is freed.
+     */
+    __Cond wake;
+
+    /**
+     * Signalled when the queue runs empty.
+     */
+    __Cond idle;
+} LevelViewport2D;
+
+// Internal
+
+__Strip2D* __LevelViewport2D_find(LevelViewport2D* viewport, int index) {
+    for (int i = 0; i < viewport->stripCount; i++)
+        if (viewport->strips[i]->index == index) return viewport->strips[i];
+
+    return 0;
+}
+
+int __LevelViewport2D_isQueued(LevelViewport2D* viewport, int index) {
+    for (int i = 0; i < viewport->queueCount; i++)
+        if (viewport->queue[i] == index) return 1;
+
+    return 0;
+}
+
+// Adds a decoded strip unless it is stale or already present, in which case it is
+// freed instead. Called with the lock held.
+__Strip2D* __LevelViewport2D_insert(LevelViewport2D* viewport, __Strip2D* strip) {
+    __Strip2D* existing = __LevelViewport2D_find(viewport, strip->index);
+    if (existing != 0 || strip->source != viewport->source) {
+        __Strip2D_free(strip);
+        return existing;
+    }
+
+    if (viewport->stripCount == viewport->stripCapacity) {
+        viewport->stripCapacity = viewport->stripCapacity == 0 ? 16 : viewport->stripCapacity * 2;
+        viewport->strips = (__Strip2D**) realloc(viewport->strips, viewport->stripCapacity * sizeof(__Strip2D*));
+    }
+
+    viewport->strips[viewport->stripCount++] = strip;
+    return strip;
+}
+
+// Gets a strip, decoding it on the calling thread when it was not prefetched.
+__Strip2D* __LevelViewport2D_strip(LevelViewport2D* viewport, int index) {
+    __Mutex_lock(&viewport->lock);
+    __Strip2D* strip = __LevelViewport2D_find(viewport, index);
+    __StripSource2D* source = viewport->source;
+    __Mutex_unlock(&viewport->lock);
+
+    if (strip != 0) return strip;
+
+    strip = __StripSource2D_decode(source, index);
+
+    __Mutex_lock(&viewport->lock);
+    strip = __LevelViewport2D_insert(viewport, strip);
+    __Mutex_unlock(&viewport->lock);
+
+    return strip;
+}
+
+void* __LevelViewport2D_work(void* arg) {
+    LevelViewport2D* viewport = (LevelViewport2D*) arg;
+
+    __Mutex_lock(&viewport->lock);
+    while (1) {
+        while (viewport->running && viewport->queueCount == 0)
+            __Cond_wait(&viewport->wake, &viewport->lock);
+
+        if (!viewport->running) break;
+
+        int index = viewport->queue[0];
+        viewport->queueCount--;
+        memmove(viewport->queue, viewport->queue + 1, viewport->queueCount * sizeof(int));
+
+        __StripSource2D* source = viewport->source;
+        __atomicIncrement(&source->refs);
+        viewport->busy = 1;
+        __Mutex_unlock(&viewport->lock);
+
+        __Strip2D* strip = __StripSource2D_decode(source, index);
+
+        __Mutex_lock(&viewport->lock);
+        if (index < viewport->keepFirst || index > viewport->keepLast)
+            __Strip2D_free(strip);
+        else
+            __LevelViewport2D_insert(viewport, strip);
+
+        __StripSource2D_release(source);
+        viewport->busy = 0;
+        if (viewport->queueCount == 0) __Cond_broadcast(&viewport->idle);
+    }
+    __Mutex_unlock(&viewport->lock);
+
+    return 0;
+}
+
+// Drops the strips outside the kept range and queues the strips ahead of the window.
+void __LevelViewport2D_schedule(LevelViewport2D* viewport, int first, int last) {
+    int step = 0;
+    if (viewport->scroll == HORIZONTAL_RIGHT || viewport->scroll == VERTICAL_UP) step = 1;
+    if (viewport->scroll == HORIZONTAL_LEFT || viewport->scroll == VERTICAL_DOWN) step = -1;
+
+    __Mutex_lock(&viewport->lock);
+    viewport->keepFirst = first - viewport->prefetch;
+    viewport->keepLast = last + viewport->prefetch;
+
+    int kept = 0;
+    for (int i = 0; i < viewport->stripCount; i++) {
+        __Strip2D* strip = viewport->strips[i];
+        if (strip->index < viewport->keepFirst || strip->index > viewport->keepLast)
+            __Strip2D_free(strip);
+        else
+            viewport->strips[kept++] = strip;
+    }
+    viewport->stripCount = kept;
+
+    // requests for strips the window has moved past are dropped with the old queue
+    viewport->queueCount = 0;
+    for (int i = 1; step != 0 && i <= viewport->prefetch; i++) {
+        int index = step > 0 ? last + i : first - i;
+        if (__LevelViewport2D_find(viewport, index) != 0) continue;
+        if (__LevelViewport2D_isQueued(viewport, index)) continue;
+
+        viewport->queue[viewport->queueCount++] = index;
+    }
+
+    if (viewport->queueCount > 0) __Cond_signal(&viewport->wake);
+    __Mutex_unlock(&viewport->lock);
+
+    // without a background thread, prefetching happens on the calling thread
+    if (!viewport->running) {
+        for (int i = 0; i < viewport->queueCount; i++)
+            __LevelViewport2D_strip(viewport, viewport->queue[i]);
+
+        viewport->queueCount = 0;
+    }
+}
+
+// Implementation
+
+/**
+ * Creates a new LevelViewport2D over a Level2D, using the scroll direction from its
+ * `scroll` header. The viewport reads from a snapshot of the level: call
+ * LevelViewport2D_refresh after editing the level to show the changes.
+ * @param level The Level2D.
+ * @param prefetch The number of strips, each one chunk thick, decoded ahead of the window.
+ * @return A new LevelViewport2D, or null if the level is null.
+ */
+LevelViewport2D* createLevelViewport2D(Level2D* level, int prefetch) {
+    if (level == 0) return 0;
+
+    LevelViewport2D* viewport = (LevelViewport2D*) calloc(1, sizeof(LevelViewport2D));
+    viewport->level = level;
+    viewport->scroll = Level2D_getScroll(level);
+    viewport->prefetch = prefetch < 0 ? 0 : prefetch > _LEVEL_VIEWPORT_QUEUE_SIZE ? _LEVEL_VIEWPORT_QUEUE_SIZE : prefetch;
+
+    int vertical = viewport->scroll == VERTICAL_UP || viewport->scroll == VERTICAL_DOWN;
+    viewport->source = __StripSource2D_create(level, vertical);
+
+    __Mutex_init(&viewport->lock);
+    __Cond_init(&viewport->wake);
+    __Cond_init(&viewport->idle);
+
+    viewport->running = 1;
+    if (!__Thread_create(&viewport->worker, __LevelViewport2D_work, viewport))
+        viewport->running = 0;
+
+    return viewport;
+}
+
+/**
+ * Gets the blocks inside a window of a LevelViewport2D, ordered column by column for
+ * horizontal scrolling and row by row otherwise, and prefetches the strips ahead of it.
+ * @param viewport The LevelViewport2D.
+ * @param min The lowest corner of the window, inclusive.
+ * @param max The highest corner of the window, inclusive.
+ * @param objects The array to write the blocks to. Only valid until the next call or refresh.
+ * @param capacity The capacity of the array. Blocks past it are counted but not written.
+ * @return The number of blocks inside the window.
+ */
+int LevelViewport2D_view(LevelViewport2D* viewport, Coordinate2D min, Coordinate2D max, LevelObject2D** objects, int capacity) {
+    if (viewport == 0) return 0;
+    if (min.x > max.x || min.y > max.y) return 0;
+
+    int vertical = viewport->source->vertical;
+    double majorMin = vertical ? min.y : min.x;
+    double majorMax = vertical ? max.y : max.x;
+    double minorMin = vertical ? min.x : min.y;
+    double minorMax = vertical ? max.x : max.y;
+
+    int first = __chunkOf(majorMin);
+    int last = __chunkOf(majorMax);
+
+    int count = 0;
+    for (int index = first; index <= last; index++) {
+        __Strip2D* strip = __LevelViewport2D_strip(viewport, index);
+
+        int lo = 0, hi = strip->count;
+        while (lo < hi) {
+            int mid = (lo + hi) / 2;
+            Coordinate2D* c = strip->objects[mid]->coordinate;
+            if ((vertical ? c->y : c->x) < majorMin) lo = mid + 1;
+            else hi = mid;
+        }
+
+        for (int i = lo; i < strip->count; i++) {
+            Coordinate2D* c = strip->objects[i]->coordinate;
+            if ((vertical ? c->y : c->x) > majorMax) break;
+
+            double minor = vertical ? c->x : c->y;
+            if (minor < minorMin || minor > minorMax) continue;
+
+            if (count < capacity) objects[count] = strip->objects[i];
+            count++;
+        }
+    }
+
+    __LevelViewport2D_schedule(viewport, first, last);
+    return count;
+}
+
+/**
+ * Checks whether a strip of a LevelViewport2D is decoded.
+ * @param viewport The LevelViewport2D.
+ * @param strip The index of the strip: the chunk x coordinate for horizontal scrolling,
+ * and the chunk y coordinate for vertical scrolling.
+ * @return 1 if the strip is decoded, 0 otherwise.
+ */
+int LevelViewport2D_isDecoded(LevelViewport2D* viewport, int strip) {
+    if (viewport == 0) return 0;
+
+    __Mutex_lock(&viewport->lock);
+    int decoded = __LevelViewport2D_find(viewport, strip) != 0;
+    __Mutex_unlock(&viewport->lock);
+
+    return decoded;
+}
+
+/**
+ * Waits until the background thread of a LevelViewport2D has decoded every queued strip.
+ * @param viewport The LevelViewport2D.
+ */
+void LevelViewport2D_wait(LevelViewport2D* viewport) {
+    if (viewport == 0) return;
+
+    __Mutex_lock(&viewport->lock);
+    while (viewport->running && (viewport->queueCount > 0 || viewport->busy))
+        __Cond_wait(&viewport->idle, &viewport->lock);
+    __Mutex_unlock(&viewport->lock);
+}
+
+/**
+ * Takes a new snapshot of the level of a LevelViewport2D, including its scroll header,
+ * and drops the strips decoded from the previous one.
+ * @param viewport The LevelViewport2D.
+ */
+void LevelViewport2D_refresh(LevelViewport2D* viewport) {
+    if (viewport == 0) return;
+
+    enum Scroll scroll = Level2D_getScroll(viewport->level);
+    int vertical = scroll == VERTICAL_UP || scroll == VERTICAL_DOWN;
+    __StripSource2D* source = __StripSource2D_create(viewport->level, vertical);
+
+    __Mutex_lock(&viewport->lock);
+    __StripSource2D* old = viewport->source;
+    viewport->source = source;
+    viewport->scroll = scroll;
+
+    for (int i = 0; i < viewport->stripCount; i++)
+        __Strip2D_free(viewport->strips[i]);
+
+    viewport->stripCount = 0;
+    viewport->queueCount = 0;
+    __Mutex_unlock(&viewport->lock);
+
+    __StripSource2D_release(old);
+}
+
+/**
+ * Stops the background thread of a LevelViewport2D and frees it. The level is left
+ * to the caller.
+ * @param viewport The LevelViewport2D.
+ */
+void LevelViewport2D_free(LevelViewport2D* viewport) {
+    if (viewport == 0) return;
+
+    __Mutex_lock(&viewport->lock);
+    int running = viewport->running;
+    viewport->running = 0;
+    __Cond_broadcast(&viewport->wake);
+    __Mutex_unlock(&viewport->lock);
+
+    if (running) __Thread_join(viewport->worker);
+
+    for (int i = 0; i < viewport->stripCount; i++)
+        __Strip2D_free(viewport->strips[i]);
+
+    __StripSource2D_release(viewport->source);
+
+    __Cond_destroy(&viewport->idle);
+    __Cond_destroy(&viewport->wake);
+    __Mutex_destroy(&viewport->lock);
+
+    free(viewport->strips);
+    free(viewport);
+}
+
+#endif
@@ -0,0 +1,76 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "test.h"
+#include "levelz.h"
+
+int loaded = 0;
+int failed = 0;
+int blocks = 0;
+
+void countLoad(LevelLoad* load, void* data) {
+    if (load->error != 0) {
+        failed++;
+        return;
+    }
+
+    loaded++;
+    if (load->dimension == 2)
+        blocks += Level2D_getBlockCount(load->level2D);
+    else
+        blocks += Level3D_getBlockCount(load->level3D);
+
+    *(int*) data += 1;
+}
+
+int testLoader(LevelLoader* loader) {
+    int r = 0;
+    int calls = 0;
+
+    loaded = 0;
+    failed = 0;
+    blocks = 0;
+
+    r |= assert(LevelLoader_load2D(loader, "levelz-test-async-1.lvlz", countLoad, &calls) == 1);
+    r |= assert(LevelLoader_load3D(loader, "levelz-test-async-2.lvlz", countLoad, &calls) == 1);
+    r |= assert(LevelLoader_load2D(loader, "levelz-test-async-missing.lvlz", countLoad, &calls) == 1);
+    for (int i = 0; i < 100; i++)
+        LevelLoader_load3D(loader, "levelz-test-async-2.lvlz", countLoad, &calls);
+
+    r |= assert(LevelLoader_wait(loader) == 103);
+    r |= assert(LevelLoader_poll(loader) == 0);
+    r |= assert(loaded == 102);
+    r |= assert(failed == 1);
+    r |= assert(calls == 102);
+    r |= assert(blocks == 100 + 101 * 27);
+    r |= assert(loader->outstanding == 0);
+
+    return r;
+}
+
+int main() {
+    int r = 0;
+
+    Level2D* l1 = createLevel2D(createCoordinate2D(0, 0));
+    Level2D_addMatrix(l1, createBlock("grass"), create2DCoordinateMatrix(0, 9, 0, 9, createCoordinate2D(0, 0)));
+    Level3D* l2 = createLevel3D(createCoordinate3D(0, 0, 0));
+    Level3D_addMatrix(l2, createBlock("stone"), create3DCoordinateMatrix(0, 2, 0, 2, 0, 2, createCoordinate3D(0, 0, 0)));
+
+    r |= assert(writeFile2D("levelz-test-async-1.lvlz", l1) == 1);
+    r |= assert(writeFile3D("levelz-test-async-2.lvlz", l2) == 1);
+
+    LevelLoader* loader = createLevelLoader(0);
+    r |= testLoader(loader);
+    LevelLoader_free(loader);
+
+    // the reader threads are used where io_uring is unavailable
+    LevelLoader* threads = __createLevelLoader(2, 0);
+    r |= assert(threads->ioUring == 0);
+    r |= testLoader(threads);
+    LevelLoader_free(threads);
+
+    remove("levelz-test-async-1.lvlz");
+    remove("levelz-test-async-2.lvlz");
+
+    return r;
+}
@@ -42,5 +42,56 @@ int main() {
 
     r |= assert(strcmp(str, "block<property=1>") == 0);
 
+    char buffer[32];
+    Block_setProperty(b5, "facing", "north");
+    r |= assert(Block_toBuffer(b5, buffer, sizeof(buffer)) == 31);
+    r |= assert(strcmp(buffer, "block<property=1, facing=north>") == 0);
+    r |= assert(Block_toBuffer(b5, buffer, 16) == 31);
+    r |= assert(strcmp(buffer, "block<property=") == 0);
+
+    LevelObject2D* o1 = createLevelObject2D(b1, createCoordinate2D(1, -2));
+    r |= assert(LevelObject2D_toBuffer(o1, buffer, sizeof(buffer)) == 14);
+    r |= assert(strcmp(buffer, "block: [1, -2]") == 0);
+    r |= assert(strcmp(LevelObject2D_toString(o1), "block: [1, -2]") == 0);
+
+    LevelObject3D* o2 = createLevelObject3DAt(b1, makeCoordinate3D(1, 2, 3));
+    r |= assert(o2->coordinate == &o2->position);
+    r |= assert(o2->coordinate->z == 3);
+
+    char line[] = "block: [4, 5]";
+    LevelObject2D* o3 = LevelObject2D_fromString(line);
+    r |= assert(o3->coordinate == &o3->position);
+    r |= assert(o3->coordinate->x == 4 && o3->coordinate->y == 5);
+
+    Block* b6 = createBlock("block");
+
+    char key[16];
+    char value[16];
+    for (int i = 0; i < 40; i++) {
+        sprintf(key, "key%d", i);
+        sprintf(value, "%d", i * 2);
+        Block_setProperty(b6, key, value);
+    }
+
+    r |= assert(b6->propertyCount == 40);
+    r |= assert(b6->propertyIndex != 0);
+    r |= assert(strcmp(Block_getProperty(b6, "key0"), "0") == 0);
+    r |= assert(strcmp(Block_getProperty(b6, "key39"), "78") == 0);
+    r |= assert(strcmp(Block_getProperty(b6, "key40"), "") == 0);
+
+    Block_setProperty(b6, "key7", "seven");
+    Block_removeProperty(b6, "key3");
+    r |= assert(b6->propertyCount == 39);
+    r |= assert(strcmp(Block_getProperty(b6, "key7"), "seven") == 0);
+    r |= assert(strcmp(Block_getProperty(b6, "key3"), "") == 0);
+    r |= assert(strcmp(Block_getProperty(b6, "key38"), "76") == 0);
+
+    Block_removeProperty(b4, "key2");
+    r |= assert(b4->propertyCount == 2);
+    r |= assert(strcmp(Block_getProperty(b4, "key3"), "value3") == 0);
+    r |= assert(b4->properties == b4->inlineProperties);
+
+    __Block_free(b6);
+
     return r;
 }
\ No newline at end of file
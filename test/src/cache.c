@@ -0,0 +1,114 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "test.h"
+#include "levelz.h"
+
+int main() {
+    int r = 0;
+
+    const char* path = "levelz-test-cache.lvlz";
+    remove("levelz-test-cache.lvlz.journal");
+    setLevelCacheDirectory(".");
+
+    Level3D* l1 = createLevel3D(createCoordinate3D(1, 2, 3));
+    Level3D_addHeader(l1, "name", "cache");
+    Level3D_addMatrix(l1, createBlock("stone"), create3DCoordinateMatrix(0, 7, 0, 7, 0, 7, createCoordinate3D(0, 0, 0)));
+    Level3D_addBlock(l1, createLevelObject3D(Block_fromString("grass<snowy=true>"), createCoordinate3D(0, 8, 0)));
+
+    r |= assert(writeFile3D(path, l1) == 1);
+
+    char* cachePath = __cachePath(path, 3);
+    remove(cachePath);
+
+    Level3D* l2 = parseFile3D(path);
+    FILE* image = fopen(cachePath, "rb");
+
+    r |= assert(l2 != 0);
+    r |= assert(image != 0);
+    fclose(image);
+
+    Level3D* l3 = parseFile3D(path);
+
+    r |= assert(Level3D_equals(l2, l3));
+    r |= assert(Level3D_getBlockCount(l3) == 513);
+    r |= assert(l3->spawn->z == 3);
+    r |= assert(strcmp(Level3D_getHeader(l3, "name"), "cache") == 0);
+    r |= assert(strcmp(Block_getProperty(Level3D_getBlock(l3, createCoordinate3D(0, 8, 0)), "snowy"), "true") == 0);
+    r |= assert(Level3D_getBlock(l3, createCoordinate3D(1, 1, 1)) == Level3D_getBlock(l3, createCoordinate3D(7, 7, 7)));
+
+    // a changed file of the same size is reparsed, even within the same second
+    Level3D_addBlock(l1, createLevelObject3D(Block_fromString("grass<snowy=fals>"), createCoordinate3D(0, 8, 0)));
+    r |= assert(writeFile3D(path, l1) == 1);
+
+    Level3D* l4 = parseFile3D(path);
+
+    r |= assert(!Level3D_equals(l3, l4));
+    r |= assert(strcmp(Block_getProperty(Level3D_getBlock(l4, createCoordinate3D(0, 8, 0)), "snowy"), "fals") == 0);
+
+    // a corrupted image is ignored
+    image = fopen(cachePath, "r+b");
+    fseek(image, -1, SEEK_END);
+    fputc(0x7f, image);
+    fclose(image);
+
+    Level3D* l5 = parseFile3D(path);
+
+    r |= assert(Level3D_equals(l4, l5));
+
+    Level2D* l6 = createLevel2D(createCoordinate2D(0, 0));
+    Level2D_addMatrix(l6, createBlock("grass"), create2DCoordinateMatrix(-4, 4, -4, 4, createCoordinate2D(0, 0)));
+
+    r |= assert(writeFile2D("levelz-test-cache-2d.lvlz", l6) == 1);
+
+    Level2D* l7 = parseFile2D("levelz-test-cache-2d.lvlz");
+    Level2D* l8 = parseFile2D("levelz-test-cache-2d.lvlz");
+
+    r |= assert(Level2D_getBlockCount(l7) == 81);
+    r |= assert(Level2D_equals(l7, l8));
+
+    remove(cachePath);
+    free(cachePath);
+
+    // an image with a valid checksum but a bad block index or a short payload is ignored
+    cachePath = __cachePath("levelz-test-cache-2d.lvlz", 2);
+    image = fopen(cachePath, "rb");
+    fseek(image, 0, SEEK_END);
+    long length = ftell(image);
+    fseek(image, 0, SEEK_SET);
+    char* bytes = (char*) malloc(length);
+    r |= assert(fread(bytes, 1, length, image) == (size_t) length);
+    fclose(image);
+
+    size_t payload = 12 + sizeof(__CacheKey) + 4 + strlen("levelz-test-cache-2d.lvlz") + 8;
+    uint32_t index = 7;
+    memcpy(bytes + length - 20, &index, sizeof(uint32_t));
+
+    uint64_t checksum = __hashBytes(bytes + payload, length - payload, 0);
+    memcpy(bytes + payload - 8, &checksum, sizeof(uint64_t));
+    r |= assert(__writeFileAtomic(cachePath, bytes, length) == 1);
+
+    Level2D* l9 = parseFile2D("levelz-test-cache-2d.lvlz");
+
+    r |= assert(Level2D_equals(l7, l9));
+
+    checksum = __hashBytes(bytes + payload, length - payload - 4, 0);
+    memcpy(bytes + payload - 8, &checksum, sizeof(uint64_t));
+    r |= assert(__writeFileAtomic(cachePath, bytes, length - 4) == 1);
+
+    Level2D* l10 = parseFile2D("levelz-test-cache-2d.lvlz");
+
+    r |= assert(Level2D_equals(l7, l10));
+
+    free(bytes);
+    remove(cachePath);
+    free(cachePath);
+
+    setLevelCacheDirectory(0);
+    r |= assert(__cachePath(path, 3) == 0);
+
+    remove(path);
+    remove("levelz-test-cache-2d.lvlz");
+
+    return r;
+}
@@ -0,0 +1,78 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "test.h"
+#include "levelz.h"
+
+int isSolid(Block* block, void* data) {
+    return strcmp(block->name, (char*) data) != 0;
+}
+
+int main() {
+    int r = 0;
+
+    Block* stone = createBlock("stone");
+    Block* water = createBlock("water");
+
+    // floor of stone from x = -20 to 20 at y = 0, with water at x = 3
+    Level2D* l1 = createLevel2D(createCoordinate2D(0, 0));
+    for (int x = -20; x <= 20; x++)
+        Level2D_addBlock(l1, createLevelObject2DAt(x == 3 ? water : stone, makeCoordinate2D(x, 0)));
+    Level2D_addBlock(l1, createLevelObject2DAt(stone, makeCoordinate2D(5, 1)));
+
+    LevelCollider2D* c1 = createLevelCollider2D(l1, isSolid, "water");
+    r |= assert(LevelCollider2D_isSolid(c1, makeCoordinate2D(-17, 0)));
+    r |= assert(!LevelCollider2D_isSolid(c1, makeCoordinate2D(3, 0)));
+    r |= assert(!LevelCollider2D_isSolid(c1, makeCoordinate2D(0, 1)));
+
+    Coordinate2D cells[8];
+    r |= assert(LevelCollider2D_overlap(c1, makeCoordinate2D(1.5, -0.5), makeCoordinate2D(4.5, 0.5), cells, 8) == 3);
+    r |= assert(cells[0].x == 1);
+    r |= assert(LevelCollider2D_overlap(c1, makeCoordinate2D(0, 1), makeCoordinate2D(1, 2), 0, 0) == 0);
+    r |= assert(LevelCollider2D_overlap(c1, makeCoordinate2D(-20, -1), makeCoordinate2D(21, 1), cells, 2) == 40);
+
+    // falling box lands on the floor
+    LevelContact2D f1 = LevelCollider2D_sweep(c1, makeCoordinate2D(0.25, 3), makeCoordinate2D(0.75, 4), makeCoordinate2D(0, -4));
+    r |= assert(f1.hit);
+    r |= assert(f1.time == 0.5);
+    r |= assert(f1.cell.x == 0 && f1.cell.y == 0);
+    r |= assert(f1.normal.y == 1);
+
+    // resting box hits immediately, and can slide along the floor into a wall
+    LevelContact2D f2 = LevelCollider2D_sweep(c1, makeCoordinate2D(0, 1), makeCoordinate2D(1, 2), makeCoordinate2D(0, -1));
+    r |= assert(f2.hit && f2.time == 0);
+
+    LevelContact2D f3 = LevelCollider2D_sweep(c1, makeCoordinate2D(0, 1), makeCoordinate2D(1, 2), makeCoordinate2D(8, 0));
+    r |= assert(f3.hit);
+    r |= assert(f3.time == 0.5);
+    r |= assert(f3.cell.x == 5 && f3.normal.x == -1);
+
+    LevelContact2D f4 = LevelCollider2D_sweep(c1, makeCoordinate2D(0, 5), makeCoordinate2D(1, 6), makeCoordinate2D(3, 0));
+    r |= assert(!f4.hit && f4.time == 1);
+
+    // changes to the level are picked up
+    Level2D_addBlock(l1, createLevelObject2DAt(stone, makeCoordinate2D(0, 1)));
+    r |= assert(LevelCollider2D_isSolid(c1, makeCoordinate2D(0, 1)));
+    LevelCollider2D_free(c1);
+
+    Level3D* l2 = createLevel3D(createCoordinate3D(0, 0, 0));
+    for (int x = 0; x < 20; x++)
+        for (int z = 0; z < 20; z++)
+            Level3D_addBlock(l2, createLevelObject3DAt(stone, makeCoordinate3D(x, 0, z)));
+
+    LevelCollider3D* c2 = createLevelCollider3D(l2, 0, 0);
+    r |= assert(LevelCollider3D_isSolid(c2, makeCoordinate3D(19, 0, 19)));
+    r |= assert(!LevelCollider3D_isSolid(c2, makeCoordinate3D(20, 0, 19)));
+    r |= assert(LevelCollider3D_overlap(c2, makeCoordinate3D(14.5, -1, 14.5), makeCoordinate3D(16.5, 0.5, 16.5), 0, 0) == 9);
+
+    LevelContact3D f5 = LevelCollider3D_sweep(c2, makeCoordinate3D(15.5, 2, 15.5), makeCoordinate3D(16.5, 4, 16.5), makeCoordinate3D(0, -4, 0));
+    r |= assert(f5.hit);
+    r |= assert(f5.time == 0.25);
+    r |= assert(f5.normal.y == 1);
+
+    LevelContact3D f6 = LevelCollider3D_sweep(c2, makeCoordinate3D(25, 2, 0), makeCoordinate3D(26, 4, 1), makeCoordinate3D(0, -4, 0));
+    r |= assert(!f6.hit);
+    LevelCollider3D_free(c2);
+
+    return r;
+}
@@ -0,0 +1,74 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "test.h"
+#include "levelz.h"
+
+int isBlock(Block* block, void* data) {
+    return strcmp(block->name, (char*) data) == 0;
+}
+
+int main() {
+    int r = 0;
+
+    Block* water = createBlock("water");
+    Block* stone = createBlock("stone");
+
+    // three pools of water separated by stone walls, one spanning several chunks
+    Level2D* l1 = createLevel2D(createCoordinate2D(0, 0));
+    Level2D_addMatrix(l1, water, create2DCoordinateMatrix(0, 39, 0, 39, createCoordinate2D(0, 0)));
+    Level2D_addMatrix(l1, stone, create2DCoordinateMatrix(20, 20, 0, 39, createCoordinate2D(0, 0)));
+    Level2D_addMatrix(l1, stone, create2DCoordinateMatrix(21, 39, 10, 10, createCoordinate2D(0, 0)));
+
+    LevelComponents2D* c1 = Level2D_components(l1, isBlock, "water", 4);
+    r |= assert(c1->count == 3);
+
+    int a = LevelComponents2D_labelOf(c1, createCoordinate2D(0, 0));
+    int b = LevelComponents2D_labelOf(c1, createCoordinate2D(39, 0));
+    int c = LevelComponents2D_labelOf(c1, createCoordinate2D(39, 39));
+    r |= assert(a != 0 && b != 0 && c != 0);
+    r |= assert(a != b && b != c && a != c);
+    r |= assert(LevelComponents2D_labelOf(c1, createCoordinate2D(19, 39)) == a);
+    r |= assert(LevelComponents2D_labelOf(c1, createCoordinate2D(20, 5)) == 0);
+    r |= assert(LevelComponents2D_sizeOf(c1, a) == 800);
+    r |= assert(LevelComponents2D_sizeOf(c1, b) == 190);
+    r |= assert(LevelComponents2D_sizeOf(c1, c) == 551);
+    LevelComponents2D_free(c1);
+
+    Coordinate2D cells[4];
+    r |= assert(Level2D_floodFill(l1, createCoordinate2D(5, 5), isBlock, "water", cells, 4) == 800);
+    r |= assert(cells[0].x == 5 && cells[0].y == 5);
+    r |= assert(Level2D_floodFill(l1, createCoordinate2D(30.5, 20.5), isBlock, "water", 0, 0) == 551);
+    r |= assert(Level2D_floodFill(l1, createCoordinate2D(20, 20), isBlock, "water", 0, 0) == 0);
+    r |= assert(Level2D_floodFill(l1, createCoordinate2D(20, 20), 0, 0, 0, 0) == 1600);
+
+    // a hollow shell and a block floating inside it, across chunk borders
+    Level3D* l2 = createLevel3D(createCoordinate3D(0, 0, 0));
+    for (int x = 10; x <= 20; x++)
+        for (int y = 10; y <= 20; y++)
+            for (int z = 10; z <= 20; z++)
+                if (x == 10 || x == 20 || y == 10 || y == 20 || z == 10 || z == 20)
+                    Level3D_addBlock(l2, createLevelObject3DAt(stone, makeCoordinate3D(x, y, z)));
+    Level3D_addBlock(l2, createLevelObject3DAt(stone, makeCoordinate3D(15, 15, 15)));
+    Level3D_addBlock(l2, createLevelObject3DAt(water, makeCoordinate3D(15, 16, 15)));
+
+    LevelComponents3D* c2 = Level3D_components(l2, isBlock, "stone", 0);
+    r |= assert(c2->count == 2);
+
+    int shell = LevelComponents3D_labelOf(c2, createCoordinate3D(10, 10, 10));
+    r |= assert(LevelComponents3D_sizeOf(c2, shell) == 11 * 11 * 11 - 9 * 9 * 9);
+    r |= assert(LevelComponents3D_labelOf(c2, createCoordinate3D(20, 20, 20)) == shell);
+    r |= assert(LevelComponents3D_labelOf(c2, createCoordinate3D(15, 15, 15)) != shell);
+    r |= assert(LevelComponents3D_labelOf(c2, createCoordinate3D(15, 16, 15)) == 0);
+    LevelComponents3D_free(c2);
+
+    LevelComponents3D* c3 = Level3D_components(l2, 0, 0, 1);
+    r |= assert(c3->count == 2);
+    r |= assert(LevelComponents3D_sizeOf(c3, LevelComponents3D_labelOf(c3, createCoordinate3D(15, 16, 15))) == 2);
+    LevelComponents3D_free(c3);
+
+    r |= assert(Level3D_floodFill(l2, createCoordinate3D(16, 20, 12), isBlock, "stone", 0, 0) == 11 * 11 * 11 - 9 * 9 * 9);
+    r |= assert(Level3D_floodFill(l2, createCoordinate3D(15, 15, 15), 0, 0, 0, 0) == 2);
+
+    return r;
+}
@@ -0,0 +1,73 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "test.h"
+#include "levelz.h"
+
+typedef struct Worker {
+    ConcurrentLevel3D* level;
+    Block* block;
+    int offset;
+} Worker;
+
+void* fill(void* arg) {
+    Worker* w = (Worker*) arg;
+    for (int x = 0; x < 32; x++)
+        for (int y = 0; y < 32; y++)
+            for (int z = 0; z < 8; z++)
+                ConcurrentLevel3D_addBlock(w->level, createLevelObject3D(w->block, createCoordinate3D(x, y, w->offset + z)));
+
+    return 0;
+}
+
+int main() {
+    int r = 0;
+
+    ConcurrentLevel3D* c = createConcurrentLevel3D(0);
+
+    r |= assert(c->stripeCount >= _CONCURRENT_STRIPES_PER_CPU);
+    r |= assert((c->stripeCount & (c->stripeCount - 1)) == 0);
+    r |= assert(sizeof(ConcurrentStripe3D) % _CONCURRENT_CACHE_LINE == 0);
+    r |= assert(((uintptr_t) c->stripes) % _CONCURRENT_CACHE_LINE == 0);
+
+    __Thread threads[4];
+    Worker workers[4];
+    for (int i = 0; i < 4; i++) {
+        workers[i].level = c;
+        workers[i].block = createBlock(i % 2 == 0 ? "stone" : "dirt");
+        workers[i].offset = 8 * i;
+        __Thread_create(&threads[i], fill, &workers[i]);
+    }
+
+    for (int i = 0; i < 4; i++)
+        __Thread_join(threads[i]);
+
+    r |= assert(ConcurrentLevel3D_getBlockCount(c) == 32 * 32 * 32);
+    r |= assert(strcmp(ConcurrentLevel3D_getBlock(c, createCoordinate3D(0, 0, 0))->name, "stone") == 0);
+    r |= assert(strcmp(ConcurrentLevel3D_getBlock(c, createCoordinate3D(31, 31, 15))->name, "dirt") == 0);
+    r |= assert(ConcurrentLevel3D_getBlock(c, createCoordinate3D(0, 0, 32)) == 0);
+
+    LevelObject3D* replaced = ConcurrentLevel3D_addBlock(c, createLevelObject3D(createBlock("gold"), createCoordinate3D(1, 1, 1)));
+    r |= assert(replaced != 0);
+    r |= assert(replaced->block == workers[0].block);
+    r |= assert(ConcurrentLevel3D_addBlock(c, createLevelObject3D(createBlock("gold"), createCoordinate3D(0, 0, 32))) == 0);
+    free(ConcurrentLevel3D_removeBlock(c, createCoordinate3D(0, 0, 32)));
+    LevelObject3D* removed = ConcurrentLevel3D_removeBlock(c, createCoordinate3D(2, 2, 2));
+
+    r |= assert(ConcurrentLevel3D_getBlockCount(c) == 32 * 32 * 32 - 1);
+    r |= assert(removed != 0);
+    r |= assert(ConcurrentLevel3D_getBlock(c, createCoordinate3D(2, 2, 2)) == 0);
+    r |= assert(strcmp(ConcurrentLevel3D_getBlock(c, createCoordinate3D(1, 1, 1))->name, "gold") == 0);
+
+    Level3D* level = createLevel3D(createCoordinate3D(0, 0, 0));
+    ConcurrentLevel3D_toLevel(c, level);
+
+    r |= assert(Level3D_getBlockCount(level) == 32 * 32 * 32 - 1);
+    r |= assert(ConcurrentLevel3D_getBlockCount(c) == 0);
+    r |= assert(Level3D_blockCount(level, "dirt") == 32 * 32 * 16);
+    r |= assert(strcmp(Level3D_getBlock(level, createCoordinate3D(1, 1, 1))->name, "gold") == 0);
+
+    ConcurrentLevel3D_free(c);
+
+    return r;
+}
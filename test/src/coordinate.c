@@ -20,6 +20,15 @@ int main() {
     r |= assert(Coordinate3D_magnitude(c2) == 3.7416573867739413);
     r |= assert(strcmp(Coordinate3D_toString(c2), "[1, 2, 3]") == 0);
 
+    char buffer[8];
+    r |= assert(Coordinate3D_toBuffer(c2, buffer, sizeof(buffer)) == 9);
+    r |= assert(strcmp(buffer, "[1, 2, ") == 0);
+    r |= assert(Coordinate2D_toBuffer(c, 0, 0) == 6);
+    r |= assert(Coordinate2D_toBuffer(0, buffer, sizeof(buffer)) == -1);
+
+    Coordinate3D* wide = createCoordinate3D(-123456.5, 987654.25, -0.000123);
+    r |= assert(strcmp(Coordinate3D_toString(wide), "[-123456, 987654, -0.000123]") == 0);
+
     Coordinate2D* c3 = Coordinate2D_fromString("[1, 2]");
     r |= assert(c3->x == 1);
     r |= assert(c3->y == 2);
@@ -49,6 +58,20 @@ int main() {
     Coordinate3D* c8 = Coordinate3D_fromString("[1,2,3]");
     r |= assert(c8->x == 1);
     r |= assert(c8->y == 2);
+
+    Coordinate2D v1 = makeCoordinate2D(3, 4);
+    Coordinate2D v2 = Coordinate2D_addValue(v1, makeCoordinate2D(1, -1));
+    r |= assert(v2.x == 4 && v2.y == 3);
+    r |= assert(Coordinate2D_magnitudeValue(v1) == 5);
+    r |= assert(Coordinate2D_distanceValue(v1, v2) == Coordinate2D_distance(&v1, &v2));
+    r |= assert(Coordinate2D_subtractValue(v2, v1).y == -1);
+
+    Coordinate3D v3 = makeCoordinate3D(1, 2, 2);
+    Coordinate3D v4 = Coordinate3D_subtractValue(v3, makeCoordinate3D(1, 1, 1));
+    r |= assert(v4.x == 0 && v4.y == 1 && v4.z == 1);
+    r |= assert(Coordinate3D_magnitudeValue(v3) == 3);
+    r |= assert(Coordinate3D_distanceValue(v3, *c2) == Coordinate3D_distance(&v3, c2));
+    r |= assert(Coordinate3D_addValue(v3, v4).z == 3);
     r |= assert(c8->z == 3);
     r |= assert(Coordinate3D_subtract(c2, c4)->x == 0);
 
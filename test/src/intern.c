@@ -0,0 +1,83 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "test.h"
+#include "levelz.h"
+
+int ids[4][256];
+
+void* intern(void* arg) {
+    int* out = (int*) arg;
+    char name[16];
+    for (int i = 0; i < 256; i++) {
+        sprintf(name, "thread%d", i);
+        out[i] = internStringId(name);
+    }
+
+    return 0;
+}
+
+int main() {
+    int r = 0;
+
+    r |= assert(getInternedId("never interned") == 0);
+    r |= assert(internStringId(0) == 0);
+
+    int i1 = internStringId("grass");
+    char* s1 = internString("grass");
+
+    r |= assert(i1 > 0);
+    r |= assert(getInternedId("grass") == i1);
+    r |= assert(s1 == getInternedString(i1));
+    r |= assert(strcmp(s1, "grass") == 0);
+    r |= assert(internStringId("stone") != i1);
+    r |= assert(getInternedString(0) == 0);
+
+    char big[40000];
+    memset(big, 'a', sizeof(big) - 1);
+    big[sizeof(big) - 1] = '\0';
+    r |= assert(strcmp(internString(big), big) == 0);
+
+    Block* b1 = createBlock("grass");
+    Block* b2 = Block_fromString("grass<snowy=true>");
+
+    r |= assert(b1->name == s1);
+    r |= assert(b2->name == s1);
+    r |= assert(b1->nameId == i1);
+    r |= assert(strcmp(Block_getPropertyById(b2, getInternedId("snowy")), "true") == 0);
+    r |= assert(strcmp(Block_getPropertyById(b2, internStringId("facing")), "") == 0);
+
+    Block_setPropertyById(b1, internStringId("facing"), "north");
+    r |= assert(strcmp(Block_getProperty(b1, "facing"), "north") == 0);
+
+    Level2D* l1 = createLevel2D(createCoordinate2D(0, 0));
+    Level2D_addHeader(l1, "author", "levelz");
+    Level2D_addMatrix(l1, b1, create2DCoordinateMatrix(0, 3, 0, 3, createCoordinate2D(0, 0)));
+    Level2D_addBlock(l1, createLevelObject2D(b2, createCoordinate2D(9, 9)));
+
+    r |= assert(Level2D_blockCountById(l1, i1) == 17);
+    r |= assert(Level2D_blockCount(l1, "grass") == 17);
+    r |= assert(Level2D_blockCount(l1, "never a block") == 0);
+    r |= assert(strcmp(Level2D_getHeaderById(l1, getInternedId("author")), "levelz") == 0);
+    r |= assert(Level2D_getHeader(l1, "missing header") == 0);
+
+    int before = getInternedCount();
+
+    __Thread threads[4];
+    for (int i = 0; i < 4; i++)
+        __Thread_create(&threads[i], intern, ids[i]);
+
+    for (int i = 0; i < 4; i++)
+        __Thread_join(threads[i]);
+
+    int same = 1;
+    for (int i = 1; i < 4; i++)
+        for (int j = 0; j < 256; j++)
+            if (ids[i][j] != ids[0][j]) same = 0;
+
+    r |= assert(same);
+    r |= assert(getInternedCount() == before + 256);
+    r |= assert(strcmp(getInternedString(ids[2][100]), "thread100") == 0);
+
+    return r;
+}
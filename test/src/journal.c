@@ -0,0 +1,132 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "test.h"
+#include "levelz.h"
+
+int main() {
+    int r = 0;
+
+    const char* path = "levelz-test-journal.lvlz";
+    remove("levelz-test-journal.lvlz.journal");
+
+    Level2D* l1 = createLevel2D(createCoordinate2D(0, 0));
+    Level2D_addMatrix(l1, createBlock("grass"), create2DCoordinateMatrix(0, 9, 0, 9, createCoordinate2D(0, 0)));
+
+    r |= assert(writeFile2D(path, l1) == 1);
+
+    Level2D* l2 = parseFile2D(path);
+
+    r |= assert(l2 != 0);
+    r |= assert(Level2D_getBlockCount(l2) == 100);
+    r |= assert(Level2D_openJournal(l2, path) == 1);
+
+    Level2D_addBlock(l2, createLevelObject2D(Block_fromString("stone<key=value>"), createCoordinate2D(0.5, -1e9)));
+    Level2D_addBlock(l2, createLevelObject2D(createBlock("sand"), createCoordinate2D(3, 3)));
+    Level2D_removeBlock(l2, l2->blocks[__Level2D_findBlock(l2, 9, 9)]);
+    Level2D_addHeader(l2, "author", "me");
+    Level2D_closeJournal(l2);
+
+    Level2D* l3 = parseFile2D(path);
+
+    r |= assert(Level2D_getBlockCount(l3) == 100);
+    r |= assert(strcmp(Level2D_getBlock(l3, createCoordinate2D(3, 3))->name, "sand") == 0);
+    r |= assert(strcmp(Block_getProperty(Level2D_getBlock(l3, createCoordinate2D(0.5, -1e9)), "key"), "value") == 0);
+    r |= assert(Level2D_getBlock(l3, createCoordinate2D(9, 9)) == 0);
+    r |= assert(strcmp(Level2D_getHeader(l3, "author"), "me") == 0);
+
+    r |= assert(Level2D_openJournal(l3, path) == 1);
+    r |= assert(Level2D_compact(l3, path) == 1);
+
+    FILE* journal = fopen("levelz-test-journal.lvlz.journal", "rb");
+    fseek(journal, 0, SEEK_END);
+    r |= assert(ftell(journal) == 0);
+    fclose(journal);
+
+    Level2D_addBlock(l3, createLevelObject2D(createBlock("gold"), createCoordinate2D(9, 9)));
+    Level2D_closeJournal(l3);
+
+    Level2D* l4 = parseFile2D(path);
+
+    r |= assert(Level2D_getBlockCount(l4) == 101);
+    r |= assert(strcmp(Level2D_getBlock(l4, createCoordinate2D(9, 9))->name, "gold") == 0);
+    LevelPatch2D* p1 = Level2D_diff(l3, l4);
+    r |= assert(p1->blockCount == 0);
+    LevelPatch2D_free(p1);
+
+    // journals are not checked against limits, so they are not replayed with options
+    LevelParseOptions options;
+    memset(&options, 0, sizeof(LevelParseOptions));
+    options.maxCells = 1000;
+
+    Level2D* limited = parseFile2DWithOptions(path, &options, 0);
+    r |= assert(Level2D_getBlockCount(limited) == 100);
+    r |= assert(Level2D_getBlock(limited, createCoordinate2D(9, 9)) == 0);
+
+    // compacting in the background keeps the edits made while it runs
+    r |= assert(Level2D_openJournal(l4, path) == 1);
+    Level2D_addBlock(l4, createLevelObject2DAt(createBlock("stone"), makeCoordinate2D(20, 20)));
+
+    LevelCompaction2D* compaction = Level2D_compactInBackground(l4, path);
+    r |= assert(compaction != 0);
+
+    Level2D_addBlock(l4, createLevelObject2DAt(createBlock("dirt"), makeCoordinate2D(21, 21)));
+    Level2D_removeBlock(l4, l4->blocks[__Level2D_findBlock(l4, 0, 0)]);
+
+    r |= assert(LevelCompaction2D_finish(compaction) == 1);
+
+    Level2D_addBlock(l4, createLevelObject2DAt(createBlock("sand"), makeCoordinate2D(22, 22)));
+    Level2D_closeJournal(l4);
+
+    char* entries = __readFile("levelz-test-journal.lvlz.journal");
+    r |= assert(strcmp(entries, "+dirt: [21, 21]\n-[0, 0]\n+sand: [22, 22]\n") == 0);
+    free(entries);
+
+    Level2D* l10 = parseFile2D(path);
+    r |= assert(Level2D_getBlockCount(l10) == 103);
+    r |= assert(strcmp(Level2D_getBlock(l10, createCoordinate2D(20, 20))->name, "stone") == 0);
+    r |= assert(strcmp(Level2D_getBlock(l10, createCoordinate2D(21, 21))->name, "dirt") == 0);
+    r |= assert(Level2D_getBlock(l10, createCoordinate2D(0, 0)) == 0);
+
+    Level3D* l5 = createLevel3D(createCoordinate3D(1, 2, 3));
+    Level3D_addBlock(l5, createLevelObject3D(createBlock("stone"), createCoordinate3D(0, 0, 0)));
+
+    r |= assert(writeFile3D(path, l5) == 1);
+    remove("levelz-test-journal.lvlz.journal");
+
+    Level3D* l6 = parseFile3D(path);
+    r |= assert(Level3D_openJournal(l6, path) == 1);
+    Level3D_addBlock(l6, createLevelObject3D(createBlock("gold"), createCoordinate3D(1, 1, 1)));
+    Level3D_closeJournal(l6);
+
+    Level3D* l7 = parseFile3D(path);
+
+    r |= assert(l7->spawn->z == 3);
+    r |= assert(Level3D_getBlockCount(l7) == 2);
+    r |= assert(strcmp(Level3D_getBlock(l7, createCoordinate3D(1, 1, 1))->name, "gold") == 0);
+
+    // an entry that does not parse stops the replay, and a torn final entry is skipped
+    FILE* f = fopen("levelz-test-journal.lvlz.journal", "wb");
+    fputs("+gold: [2, 2, 2]\ngarbage\n+gold: [3, 3, 3]\n", f);
+    fclose(f);
+
+    Level3D* l8 = parseFile3D(path);
+    r |= assert(Level3D_getBlock(l8, createCoordinate3D(2, 2, 2)) != 0);
+    r |= assert(Level3D_getBlock(l8, createCoordinate3D(3, 3, 3)) == 0);
+    r |= assert(__Level3D_replayJournal(l8, path) == 0);
+
+    f = fopen("levelz-test-journal.lvlz.journal", "wb");
+    fputs("+gold: [2, 2, 2]\n+gold: [4, 4, 4]", f);
+    fclose(f);
+
+    Level3D* l9 = parseFile3D(path);
+    r |= assert(Level3D_getBlockCount(l9) == 2);
+    r |= assert(Level3D_getBlock(l9, createCoordinate3D(2, 2, 2)) != 0);
+    r |= assert(Level3D_getBlock(l9, createCoordinate3D(4, 4, 4)) == 0);
+    r |= assert(__Level3D_replayJournal(l9, path) == 1);
+
+    remove(path);
+    remove("levelz-test-journal.lvlz.journal");
+
+    return r;
+}
@@ -1,3 +1,4 @@
+#include <math.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -15,6 +16,10 @@ int main() {
     r |= assert(strcmp(h1->value, "value") == 0);
     r |= assert(strcmp(LevelHeader_toString(h1), "@header value") == 0);
 
+    char buffer[8];
+    r |= assert(LevelHeader_toBuffer(h1, buffer, sizeof(buffer)) == 13);
+    r |= assert(strcmp(buffer, "@header") == 0);
+
     LevelHeader* h2 = LevelHeader_fromString("@header value");
 
     r |= assert(strcmp(h2->name, "header") == 0);
@@ -62,5 +67,208 @@ int main() {
     r |= assert(strcmp(Level3D_getBlock(l4, createCoordinate3D(1, 2, 3))->name, "stone") == 0);
     r |= assert(Level3D_blockCount(l4, "cobble") == 27);
 
+    Level2D* l5 = createLevel2D(createCoordinate2D(0, 0));
+    r |= assert(Level2D_reserve(l5, 100) == 1);
+
+    r |= assert(l5->blockCapacity > 100);
+    r |= assert(Level2D_reserve(l5, 2147483647) == 0);
+    r |= assert(Level2D_reserve(l5, _LEVEL_BLOCKS_MAX_CAPACITY + 1) == 0);
+    r |= assert(l5->blockCapacity == 101);
+    r |= assert(Level2D_getBlockCount(l5) == 0);
+
+    LevelObject2D** o5 = (LevelObject2D**) malloc(4 * sizeof(LevelObject2D*));
+    o5[0] = createLevelObject2D(createBlock("grass"), createCoordinate2D(0, 0));
+    o5[1] = createLevelObject2D(createBlock("stone"), createCoordinate2D(1, 0));
+    o5[2] = createLevelObject2D(createBlock("dirt"), createCoordinate2D(0, 0));
+    o5[3] = createLevelObject2D(createBlock("sand"), createCoordinate2D(-1, 0));
+    Level2D_addBlocks(l5, o5, 4);
+
+    r |= assert(Level2D_getBlockCount(l5) == 3);
+    r |= assert(strcmp(Level2D_getBlock(l5, createCoordinate2D(0, 0))->name, "dirt") == 0);
+    r |= assert(strcmp(Level2D_getBlock(l5, createCoordinate2D(-1, 0))->name, "sand") == 0);
+    r |= assert(l5->blocks[3] == 0);
+
+    Level2D_removeBlock(l5, o5[2]);
+
+    r |= assert(Level2D_getBlockCount(l5) == 2);
+    r |= assert(Level2D_getBlock(l5, createCoordinate2D(0, 0)) == 0);
+    r |= assert(strcmp(Level2D_getBlock(l5, createCoordinate2D(1, 0))->name, "stone") == 0);
+    r |= assert(strcmp(Level2D_getBlock(l5, createCoordinate2D(-1, 0))->name, "sand") == 0);
+
+    free(o5);
+
+    Level3D* l6 = createLevel3D(createCoordinate3D(0, 0, 0));
+    Level3D_addMatrix(l6, createBlock("stone"), create3DCoordinateMatrix(0, 9, 0, 9, 0, 9, createCoordinate3D(0, 0, 0)));
+    Level3D_addMatrix(l6, createBlock("air"), create3DCoordinateMatrix(0, 4, 0, 4, 0, 4, createCoordinate3D(0, 0, 0)));
+
+    r |= assert(Level3D_getBlockCount(l6) == 1000);
+    r |= assert(Level3D_blockCount(l6, "air") == 125);
+    r |= assert(strcmp(Level3D_getBlock(l6, createCoordinate3D(9, 9, 9))->name, "stone") == 0);
+    r |= assert(strcmp(Level3D_getBlock(l6, createCoordinate3D(4, 4, 4))->name, "air") == 0);
+
+    Level2D* l7 = createLevel2D(createCoordinate2D(0, 0));
+    Level2D_setHeader(l7, createLevelHeader("name", "hash"));
+    Level2D_addBlock(l7, createLevelObject2D(createBlock("grass"), createCoordinate2D(0, 0)));
+    Level2D_addBlock(l7, createLevelObject2D(createBlock("stone"), createCoordinate2D(1, 0)));
+
+    Level2D* l8 = createLevel2D(createCoordinate2D(0, 0));
+    Level2D_addBlock(l8, createLevelObject2D(createBlock("stone"), createCoordinate2D(1, 0)));
+    Level2D_addBlock(l8, createLevelObject2D(createBlock("grass"), createCoordinate2D(0, 0)));
+    Level2D_setHeader(l8, createLevelHeader("name", "hash"));
+
+    r |= assert(Level2D_equals(l7, l8));
+
+    LevelObject2D* sand = createLevelObject2D(createBlock("sand"), createCoordinate2D(2, 0));
+    Level2D_addBlock(l8, sand);
+
+    r |= assert(!Level2D_equals(l7, l8));
+
+    Level2D_removeBlock(l8, sand);
+
+    r |= assert(Level2D_equals(l7, l8));
+
+    Level2D_setHeader(l8, createLevelHeader("name", "other"));
+    r |= assert(Level2D_hash(l7).low != Level2D_hash(l8).low);
+
+    Level2D_setHeader(l8, createLevelHeader("name", "hash"));
+    r |= assert(Level2D_equals(l7, l8));
+
+    Level3D* l9 = createLevel3D(createCoordinate3D(0, 0, 0));
+    Level3D_addMatrix(l9, createBlock("stone"), create3DCoordinateMatrix(0, 3, 0, 3, 0, 3, createCoordinate3D(0, 0, 0)));
+
+    Level3D* l10 = createLevel3D(createCoordinate3D(0, 0, 0));
+    Level3D_addMatrix(l10, createBlock("air"), create3DCoordinateMatrix(0, 3, 0, 3, 0, 3, createCoordinate3D(0, 0, 0)));
+    Level3D_addMatrix(l10, createBlock("stone"), create3DCoordinateMatrix(0, 3, 0, 3, 0, 3, createCoordinate3D(0, 0, 0)));
+
+    r |= assert(Level3D_equals(l9, l10));
+
+    Block* facing = createBlock("stone");
+    Block_setProperty(facing, "facing", "up");
+    Level3D_addBlock(l10, createLevelObject3D(facing, createCoordinate3D(1, 1, 1)));
+
+    r |= assert(!Level3D_equals(l9, l10));
+
+    Level2D* l11 = createLevel2D(createCoordinate2D(0, 0));
+    LevelMemoryUsage u1 = Level2D_memoryUsage(l11);
+
+    Block* shared = createBlock("grass");
+    Block_setProperty(shared, "snowy", "true");
+    Level2D_addMatrix(l11, shared, create2DCoordinateMatrix(0, 9, 0, 9, createCoordinate2D(0, 0)));
+    Level2D_addHeader(l11, "name", "memory");
+    LevelMemoryUsage u2 = Level2D_memoryUsage(l11);
+
+    r |= assert(u2.total > u1.total);
+    r |= assert(u2.total == u2.cells + u2.coordinates + u2.blocks + u2.properties + u2.headers + u2.indexes + u2.slack);
+    r |= assert(u2.coordinates == 101 * sizeof(Coordinate2D));
+    r |= assert(u2.blocks == sizeof(Block));
+    r |= assert(u2.properties == strlen("true") + 1);
+    r |= assert(u2.indexes >= 200 * sizeof(int));
+
+    Level2D* l12 = createLevel2D(createCoordinate2D(0, 0));
+    Level2D_addMatrix(l12, createBlock("stone"), create2DCoordinateMatrix(-10, 29, 0, 4, createCoordinate2D(0, 0)));
+    LevelObject2D* d1 = createLevelObject2D(createBlock("dirt"), createCoordinate2D(100.5, 100.5));
+    LevelObject2D* d2 = createLevelObject2D(createBlock("dirt"), createCoordinate2D(100.25, 100));
+    LevelObject2D* d3 = createLevelObject2D(createBlock("dirt"), createCoordinate2D(0, 0));
+    Level2D_addBlock(l12, d1);
+    Level2D_addBlock(l12, d2);
+
+    // queries only read the level, so they can run from several threads at once
+    LevelMemoryUsage u3 = Level2D_memoryUsage(l12);
+    r |= assert(Level2D_isOccupied(l12, createCoordinate2D(-10, 4)));
+    r |= assert(Level2D_memoryUsage(l12).total == u3.total);
+    r |= assert(!Level2D_isOccupied(l12, createCoordinate2D(-10, 5)));
+    r |= assert(Level2D_isOccupied(l12, createCoordinate2D(100, 100)));
+    r |= assert(Level2D_countOccupied(l12, create2DCoordinateMatrix(-100, 200, -100, 200, createCoordinate2D(0, 0))) == 201);
+    r |= assert(Level2D_countOccupied(l12, create2DCoordinateMatrix(-3, 3, 1, 2, createCoordinate2D(0, 0))) == 14);
+    r |= assert(Level2D_countOccupied(l12, create2DCoordinateMatrix(0, 0, 0, 0, createCoordinate2D(20, 4))) == 1);
+
+    Level2D_removeBlock(l12, d1);
+    r |= assert(Level2D_isOccupied(l12, createCoordinate2D(100, 100)));
+    Level2D_removeBlock(l12, d2);
+    r |= assert(!Level2D_isOccupied(l12, createCoordinate2D(100, 100)));
+    Level2D_addBlock(l12, d3);
+    r |= assert(Level2D_countOccupied(l12, create2DCoordinateMatrix(-100, 200, -100, 200, createCoordinate2D(0, 0))) == 200);
+    Level2D_removeBlock(l12, d3);
+    r |= assert(Level2D_countOccupied(l12, create2DCoordinateMatrix(-100, 200, -100, 200, createCoordinate2D(0, 0))) == 199);
+
+    Level3D* l13 = createLevel3D(createCoordinate3D(0, 0, 0));
+    Level3D_addMatrix(l13, createBlock("stone"), create3DCoordinateMatrix(0, 31, 0, 31, 0, 0, createCoordinate3D(0, 0, 0)));
+
+    LevelMemoryUsage u4 = Level3D_memoryUsage(l13);
+    r |= assert(Level3D_isOccupied(l13, createCoordinate3D(31, 31, 0)));
+    r |= assert(Level3D_memoryUsage(l13).total == u4.total);
+    r |= assert(!Level3D_isOccupied(l13, createCoordinate3D(31, 31, 1)));
+    r |= assert(Level3D_countOccupied(l13, create3DCoordinateMatrix(0, 31, 0, 31, 0, 31, createCoordinate3D(0, 0, 0))) == 1024);
+    r |= assert(Level3D_countOccupied(l13, create3DCoordinateMatrix(10, 20, 10, 20, -5, 5, createCoordinate3D(0, 0, 0))) == 121);
+    r |= assert(Level3D_countOccupied(l13, create3DCoordinateMatrix(0, 31, 0, 31, 1, 31, createCoordinate3D(0, 0, 0))) == 0);
+
+    // coordinates too large for a chunk stay out of the chunk map
+    Level3D* l15 = createLevel3D(createCoordinate3D(0, 0, 0));
+    LevelObject3D* far = createLevelObject3DAt(createBlock("stone"), makeCoordinate3D(1e20, 0, 0));
+    Level3D_addBlock(l15, far);
+    Level3D_addBlock(l15, createLevelObject3DAt(createBlock("stone"), makeCoordinate3D(-1e20, 0, 0)));
+    Level3D_addBlock(l15, createLevelObject3DAt(createBlock("stone"), makeCoordinate3D(NAN, 0, 0)));
+
+    r |= assert(Level3D_getBlockCount(l15) == 3);
+    r |= assert(l15->chunks.count == 0);
+    r |= assert(strcmp(Level3D_getBlock(l15, createCoordinate3D(1e20, 0, 0))->name, "stone") == 0);
+    r |= assert(Level3D_isOccupied(l15, createCoordinate3D(-1e20, 0, 0)));
+    r |= assert(!Level3D_isOccupied(l15, createCoordinate3D(2e20, 0, 0)));
+    r |= assert(Level3D_countOccupied(l15, create3DCoordinateMatrix(0, 0, 0, 0, 0, 0, createCoordinate3D(1e20, 0, 0))) == 0);
+
+    Level3D_removeBlock(l15, far);
+    r |= assert(Level3D_getBlockCount(l15) == 2);
+    r |= assert(Level3D_getBlock(l15, createCoordinate3D(1e20, 0, 0)) == 0);
+
+    // a filled region switches to a dense grid, a sparse one stays in the block index
+    Level2D* l14 = createLevel2D(createCoordinate2D(0, 0));
+    Level2D_reserve(l14, 512);
+    Level2D_addMatrix(l14, createBlock("stone"), create2DCoordinateMatrix(0, 15, 0, 5, createCoordinate2D(0, 0)));
+
+    size_t grid = _LEVEL_CHUNK_SIZE * _LEVEL_CHUNK_SIZE * sizeof(int);
+    size_t i1 = Level2D_memoryUsage(l14).indexes;
+    Level2D_addMatrix(l14, createBlock("stone"), create2DCoordinateMatrix(0, 15, 6, 6, createCoordinate2D(0, 0)));
+    size_t i2 = Level2D_memoryUsage(l14).indexes;
+    Level2D_addMatrix(l14, createBlock("stone"), create2DCoordinateMatrix(0, 15, 7, 7, createCoordinate2D(0, 0)));
+    size_t i3 = Level2D_memoryUsage(l14).indexes;
+    r |= assert(i3 - i2 == i2 - i1 + grid);
+
+    Level2D_addMatrix(l14, createBlock("stone"), create2DCoordinateMatrix(0, 15, 8, 15, createCoordinate2D(0, 0)));
+    Level2D_addBlock(l14, createLevelObject2DAt(createBlock("dirt"), makeCoordinate2D(100, 100)));
+    Level2D_addBlock(l14, createLevelObject2DAt(createBlock("grass"), makeCoordinate2D(4.5, 4.5)));
+
+    r |= assert(Level2D_getBlockCount(l14) == 258);
+    r |= assert(strcmp(Level2D_getBlock(l14, createCoordinate2D(15, 15))->name, "stone") == 0);
+    r |= assert(strcmp(Level2D_getBlock(l14, createCoordinate2D(100, 100))->name, "dirt") == 0);
+    r |= assert(strcmp(Level2D_getBlock(l14, createCoordinate2D(4.5, 4.5))->name, "grass") == 0);
+    r |= assert(Level2D_getBlock(l14, createCoordinate2D(16, 15)) == 0);
+
+    Level2D_addBlock(l14, createLevelObject2DAt(createBlock("dirt"), makeCoordinate2D(3, 3)));
+    r |= assert(Level2D_getBlockCount(l14) == 258);
+    r |= assert(strcmp(Level2D_getBlock(l14, createCoordinate2D(3, 3))->name, "dirt") == 0);
+
+    // emptying the region moves it back to the block index
+    size_t removed[13];
+    for (int y = 0; y < 13; y++) {
+        for (int i = Level2D_getBlockCount(l14) - 1; i >= 0; i--) {
+            Coordinate2D* c = l14->blocks[i]->coordinate;
+            if (c->y == y && c->x >= 0 && c->x < 16)
+                Level2D_removeBlock(l14, l14->blocks[i]);
+        }
+        removed[y] = Level2D_memoryUsage(l14).indexes;
+    }
+
+    // rows 0 to 11 leave 64 cells filled, row 12 drops the region below the sparse threshold
+    r |= assert(removed[11] - removed[12] == removed[10] - removed[11] + grid);
+    r |= assert(Level2D_getBlockCount(l14) == 50);
+    r |= assert(Level2D_getBlock(l14, createCoordinate2D(3, 3)) == 0);
+    r |= assert(strcmp(Level2D_getBlock(l14, createCoordinate2D(15, 15))->name, "stone") == 0);
+    r |= assert(strcmp(Level2D_getBlock(l14, createCoordinate2D(4.5, 4.5))->name, "grass") == 0);
+
+    int found = 0;
+    for (int i = 0; i < Level2D_getBlockCount(l14); i++)
+        found += Level2D_getBlock(l14, l14->blocks[i]->coordinate) == l14->blocks[i]->block;
+    r |= assert(found == 50);
+
     return r;
 }
\ No newline at end of file
@@ -120,5 +120,115 @@ int main() {
 
     free(line4);
 
+    // Levels
+
+    Level2D* level = readLevel2D("@type 2\n@spawn [1, 2]\n---\ngrass: [0, 0]*(0, 1, 0, 1)^[5, 5]\nstone<key=value>: [0, 0]\nend\n");
+
+    r |= assert(level != 0);
+    r |= assert(Level2D_getHeaderCount(level) == 2);
+    r |= assert(strcmp(Level2D_getHeader(level, "type"), "2") == 0);
+    r |= assert(level->spawn->x == 1);
+    r |= assert(level->spawn->y == 2);
+    r |= assert(Level2D_getBlockCount(level) == 5);
+    r |= assert(strcmp(Level2D_getBlock(level, createCoordinate2D(0, 0))->name, "stone") == 0);
+    r |= assert(strcmp(Level2D_getBlock(level, createCoordinate2D(6, 6))->name, "grass") == 0);
+
+    Level3D* level2 = readLevel3D("@type 3\n---\nstone: (0, 1, 0, 1, 0, 1)^[0, 0, 0]*[4, 4, 4]\nend");
+
+    r |= assert(level2 != 0);
+    r |= assert(Level3D_getBlockCount(level2) == 9);
+    r |= assert(strcmp(Level3D_getBlock(level2, createCoordinate3D(4, 4, 4))->name, "stone") == 0);
+
+    r |= assert(readLevel3D("@type 2\n---\nend") == 0);
+
+    // Limits
+    LevelParseError error;
+
+    r |= assert(readLevel2D("@type 2\n---\nx: (0, 2000000000, 0, 2000000000)^[0, 0]\nend") == 0);
+    r |= assert(readLevel2DWithOptions("@type 2\n---\nx: (0, 2000000000, 0, 2000000000)^[0, 0]\nend", 0, &error) == 0);
+    r |= assert(error.status == LEVEL_PARSE_MATRIX_TOO_LARGE);
+    r |= assert(error.line == 3);
+
+    LevelParseOptions options;
+    memset(&options, 0, sizeof(LevelParseOptions));
+    options.maxMatrixVolume = 1000;
+    options.maxCells = 1500;
+    options.maxLineLength = 64;
+    options.maxProperties = 2;
+    options.maxMemory = 1 << 20;
+
+    Level2D* limited = readLevel2DWithOptions("@type 2\n---\ngrass<a=1,b=2>: (0, 9, 0, 99)^[0, 0]*[200, 200]\nend", &options, &error);
+    r |= assert(limited != 0);
+    r |= assert(error.status == LEVEL_PARSE_OK);
+    r |= assert(Level2D_getBlockCount(limited) == 1001);
+
+    r |= assert(readLevel2DWithOptions("@type 2\n---\nstone: [0, 0]\ngrass: (0, 9, 0, 100)^[0, 0]\nend", &options, &error) == 0);
+    r |= assert(error.status == LEVEL_PARSE_MATRIX_TOO_LARGE);
+    r |= assert(error.line == 4);
+    r |= assert(error.value == 1010);
+    r |= assert(error.limit == 1000);
+
+    r |= assert(readLevel2DWithOptions("@type 2\n---\ngrass: (0, 9, 0, 99)^[0, 0]\nstone: (0, 9, 0, 99)^[0, 0]\nend", &options, &error) == 0);
+    r |= assert(error.status == LEVEL_PARSE_TOO_MANY_CELLS);
+    r |= assert(error.value == 2000);
+
+    r |= assert(readLevel2DWithOptions("@type 2\n---\nstone<a=1,b=2,c=3>: [0, 0]\nend", &options, &error) == 0);
+    r |= assert(error.status == LEVEL_PARSE_TOO_MANY_PROPERTIES);
+
+    r |= assert(readLevel2DWithOptions("@type 2\n@name aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa\n---\nend", &options, &error) == 0);
+    r |= assert(error.status == LEVEL_PARSE_LINE_TOO_LONG);
+    r |= assert(error.line == 2);
+
+    r |= assert(readLevel3DWithOptions("@type 2\n---\nend", &options, &error) == 0);
+    r |= assert(error.status == LEVEL_PARSE_WRONG_TYPE);
+
+    options.maxMemory = 4096;
+    r |= assert(readLevel3DWithOptions("@type 3\n---\nstone: (0, 9, 0, 9, 0, 9)^[0, 0, 0]\nend", &options, &error) == 0);
+    r |= assert(error.status == LEVEL_PARSE_OUT_OF_BUDGET);
+    r |= assert(error.limit == 4096);
+
+    // Malformed input
+    r |= assert(readLevel2D("@type 2\n---\ngrass: [5]\nend") == 0);
+    r |= assert(readLevel2DWithOptions("@type 2\n---\nstone: [0, 0]\ngrass: [5]\nend", &options, &error) == 0);
+    r |= assert(error.status == LEVEL_PARSE_MALFORMED);
+    r |= assert(error.line == 4);
+
+    r |= assert(readLevel2DWithOptions("@type\n---\nend", &options, &error) == 0);
+    r |= assert(error.status == LEVEL_PARSE_WRONG_TYPE);
+
+    r |= assert(readLevel2DWithOptions("@type 2\n@spawn\n---\nend", &options, &error) == 0);
+    r |= assert(error.status == LEVEL_PARSE_MALFORMED);
+    r |= assert(error.line == 2);
+
+    r |= assert(readLevel2DWithOptions("@type 2\n@\n---\nend", &options, &error) == 0);
+    r |= assert(error.status == LEVEL_PARSE_MALFORMED);
+
+    r |= assert(readLevel2DWithOptions("@type 2\n---\ngrass: (0, 9)^[0, 0]\nend", &options, &error) == 0);
+    r |= assert(error.status == LEVEL_PARSE_MALFORMED);
+
+    r |= assert(readLevel2DWithOptions("@type 2\n---\ngrass [0, 0]\nend", &options, &error) == 0);
+    r |= assert(error.status == LEVEL_PARSE_MALFORMED);
+
+    r |= assert(readLevel3D("@type 3\n---\nstone: [1, 2]\nend") == 0);
+    r |= assert(readLevel3DWithOptions("@type 3\n@spawn [1, 2]\n---\nend", &options, &error) == 0);
+    r |= assert(error.status == LEVEL_PARSE_MALFORMED);
+
+    r |= assert(readLevel3DWithOptions("@type 3\n---\nstone: (0, 1, 0, 1)^[0, 0, 0]\nend", &options, &error) == 0);
+    r |= assert(error.status == LEVEL_PARSE_MALFORMED);
+
+    r |= assert(parseFile2DWithOptions("levelz-test-missing.lvlz", &options, &error) == 0);
+    r |= assert(error.status == LEVEL_PARSE_UNREADABLE);
+
+    options.maxMemory = 16;
+    r |= assert(writeFile2D("levelz-test-limits.lvlz", limited) == 1);
+    r |= assert(parseFile2DWithOptions("levelz-test-limits.lvlz", &options, &error) == 0);
+    r |= assert(error.status == LEVEL_PARSE_OUT_OF_BUDGET);
+
+    options.maxMemory = 0;
+    Level2D* parsed = parseFile2DWithOptions("levelz-test-limits.lvlz", &options, &error);
+    r |= assert(parsed != 0);
+    r |= assert(Level2D_getBlockCount(parsed) == 1001);
+    remove("levelz-test-limits.lvlz");
+
     return r;
 }
\ No newline at end of file
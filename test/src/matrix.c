@@ -4,6 +4,11 @@
 #include "test.h"
 #include "levelz.h"
 
+void countCell(Coordinate3D coordinate, int index, void* data) {
+    int* seen = (int*) data;
+    seen[index]++;
+}
+
 int main() {
     int r = 0;
 
@@ -32,6 +37,12 @@ int main() {
     r |= assert(CoordinateMatrix3D_size(m2) == 64);
     r |= assert(strcmp(CoordinateMatrix3D_toString(m2), "(0, 3, 0, 3, 0, 3)^[0, 0, 0]") == 0);
 
+    char buffer[64];
+    r |= assert(CoordinateMatrix2D_toBuffer(m1, buffer, sizeof(buffer)) == 19);
+    r |= assert(strcmp(buffer, "(0, 3, 0, 3)^[0, 0]") == 0);
+    r |= assert(CoordinateMatrix3D_toBuffer(m2, buffer, 16) == 28);
+    r |= assert(strcmp(buffer, "(0, 3, 0, 3, 0,") == 0);
+
     CoordinateMatrix2D* m3 = CoordinateMatrix2D_fromString("(-1, 4, -1, 4)^[2, 3.5]");
 
     r |= assert(m3->minX == -1);
@@ -55,5 +66,73 @@ int main() {
     r |= assert(m4->start->z == 4.25);
     r |= assert(CoordinateMatrix3D_size(m4) == 216);
 
+    Coordinate2D** all2 = CoordinateMatrix2D_coordinates(m3);
+    int same2 = 1;
+    for (int i = 0; i < CoordinateMatrix2D_size(m3); i++) {
+        Coordinate2D c = CoordinateMatrix2D_coordinateAtValue(m3, i);
+        if (c.x != all2[i]->x || c.y != all2[i]->y) same2 = 0;
+    }
+    r |= assert(same2);
+
+    Coordinate3D** all3 = CoordinateMatrix3D_coordinates(m4);
+    int same3 = 1;
+    for (int i = 0; i < CoordinateMatrix3D_size(m4); i++) {
+        Coordinate3D c = CoordinateMatrix3D_coordinateAtValue(m4, i);
+        if (c.x != all3[i]->x || c.y != all3[i]->y || c.z != all3[i]->z) same3 = 0;
+    }
+    r |= assert(same3);
+
+    Coordinate2D* at = CoordinateMatrix2D_coordinateAt(m3, 7);
+    r |= assert(at->x == all2[7]->x && at->y == all2[7]->y);
+    r |= assert(CoordinateMatrix2D_indexOf(m3, *all2[7]) == 7);
+    r |= assert(CoordinateMatrix2D_indexOf(m3, makeCoordinate2D(100, 0)) == -1);
+    r |= assert(CoordinateMatrix3D_indexOf(m4, *all3[150]) == 150);
+
+    CoordinateMatrix2D* m5 = create2DCoordinateMatrix(0, 1, 0, 1, createCoordinate2D(10, 20));
+    CoordinateMatrix2DCursor c1 = CoordinateMatrix2D_cursor(m5, COORDINATE_MATRIX_MORTON);
+    int order[4];
+    int visited = 0;
+    while (CoordinateMatrix2DCursor_next(&c1) && visited < 4)
+        order[visited++] = c1.index;
+
+    r |= assert(visited == 4);
+    r |= assert(order[0] == 0 && order[1] == 2 && order[2] == 1 && order[3] == 3);
+    r |= assert(c1.coordinate.x == 11 && c1.coordinate.y == 21);
+
+    CoordinateMatrix3D* m6 = create3DCoordinateMatrix(0, 4, 0, 0, 0, 40, createCoordinate3D(-3, 2, 1));
+    int seen[5 * 41];
+    memset(seen, 0, sizeof(seen));
+    CoordinateMatrix3D_forEach(m6, COORDINATE_MATRIX_MORTON, countCell, seen);
+
+    int once = 1;
+    for (int i = 0; i < 5 * 41; i++)
+        if (seen[i] != 1) once = 0;
+    r |= assert(once);
+
+    CoordinateMatrix3DCursor c2 = CoordinateMatrix3D_cursor(m6, COORDINATE_MATRIX_ROW_MAJOR);
+    int inOrder = 1;
+    int steps = 0;
+    while (CoordinateMatrix3DCursor_next(&c2)) {
+        Coordinate3D expected = CoordinateMatrix3D_coordinateAtValue(m6, steps);
+        if (c2.index != steps || c2.coordinate.x != expected.x || c2.coordinate.z != expected.z) inOrder = 0;
+        steps++;
+    }
+    r |= assert(inOrder);
+    r |= assert(steps == CoordinateMatrix3D_size(m6));
+
+    // sizes that do not fit in an int
+    CoordinateMatrix2D* m7 = CoordinateMatrix2D_fromString("(0, 2000000000, 0, 2000000000)^[0, 0]");
+    r |= assert(CoordinateMatrix2D_volume(m7) == 2000000001LL * 2000000001LL);
+    r |= assert(CoordinateMatrix2D_size(m7) == -1);
+    r |= assert(CoordinateMatrix2D_coordinates(m7) == 0);
+
+    CoordinateMatrix3D* m8 = create3DCoordinateMatrix(-2000000000, 2000000000, -2000000000, 2000000000, -2000000000, 2000000000, createCoordinate3D(0, 0, 0));
+    r |= assert(CoordinateMatrix3D_volume(m8) == INT64_MAX);
+    r |= assert(CoordinateMatrix3D_size(m8) == -1);
+
+    CoordinateMatrix2D* m9 = create2DCoordinateMatrix(5, 4, 0, 3, createCoordinate2D(0, 0));
+    r |= assert(CoordinateMatrix2D_volume(m9) == 0);
+    r |= assert(CoordinateMatrix2D_size(m9) == 0);
+
     return r;
 }
\ No newline at end of file
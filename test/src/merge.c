@@ -0,0 +1,77 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "test.h"
+#include "levelz.h"
+
+int main() {
+    int r = 0;
+
+    // filled region merges into one box
+    Level2D* l1 = createLevel2D(createCoordinate2D(0, 0));
+    Block* stone = createBlock("stone");
+    for (int x = 0; x < 10; x++)
+        for (int y = 0; y < 10; y++)
+            Level2D_addBlock(l1, createLevelObject2DAt(stone, makeCoordinate2D(x, y)));
+
+    int count;
+    CoordinateMatrix2D** m1 = Level2D_mergeBlocks(l1, stone, &count);
+    r |= assert(count == 1);
+    r |= assert(m1[0]->minX == 0);
+    r |= assert(m1[0]->maxX == 9);
+    r |= assert(m1[0]->minY == 0);
+    r |= assert(m1[0]->maxY == 9);
+
+    char* s1 = Level2D_toString(l1);
+    r |= assert(strstr(s1, "stone: (0, 9, 0, 9)^[0, 0]") != 0);
+
+    Level2D* l2 = readLevel2D(s1);
+    r |= assert(Level2D_getBlockCount(l2) == 100);
+    r |= assert(Level2D_getBlock(l2, createCoordinate2D(9, 9)) != 0);
+    r |= assert(Level2D_getBlock(l2, createCoordinate2D(10, 9)) == 0);
+
+    // scattered and fractional cells stay separate
+    Level2D* l3 = createLevel2D(createCoordinate2D(0, 0));
+    Level2D_addBlock(l3, createLevelObject2DAt(stone, makeCoordinate2D(0, 0)));
+    Level2D_addBlock(l3, createLevelObject2DAt(stone, makeCoordinate2D(2, 2)));
+    Level2D_addBlock(l3, createLevelObject2DAt(stone, makeCoordinate2D(0.5, 1)));
+
+    CoordinateMatrix2D** m2 = Level2D_mergeBlocks(l3, stone, &count);
+    r |= assert(count == 2);
+
+    Level2D* l4 = readLevel2D(Level2D_toString(l3));
+    r |= assert(Level2D_getBlockCount(l4) == 3);
+    r |= assert(Level2D_getBlock(l4, createCoordinate2D(0.5, 1)) != 0);
+
+    // L-shaped solid covers the cells exactly
+    Level3D* l5 = createLevel3D(createCoordinate3D(0, 0, 0));
+    Block* dirt = createBlock("dirt");
+    int cells = 0;
+    for (int x = 0; x < 8; x++)
+        for (int y = 0; y < 8; y++)
+            for (int z = 0; z < 4; z++) {
+                if (x >= 4 && y >= 4) continue;
+                Level3D_addBlock(l5, createLevelObject3DAt(dirt, makeCoordinate3D(x, y, z)));
+                cells++;
+            }
+
+    CoordinateMatrix3D** m3 = Level3D_mergeBlocks(l5, dirt, &count);
+    r |= assert(count == 2);
+
+    int covered = 0;
+    for (int i = 0; i < count; i++)
+        covered += CoordinateMatrix3D_size(m3[i]);
+    r |= assert(covered == cells);
+
+    char* s5 = Level3D_toString(l5);
+    Level3D* l6 = readLevel3D(s5);
+    r |= assert(Level3D_getBlockCount(l6) == cells);
+    r |= assert(Level3D_getBlock(l6, createCoordinate3D(3, 7, 3)) != 0);
+    r |= assert(Level3D_getBlock(l6, createCoordinate3D(4, 4, 0)) == 0);
+    r |= assert(strlen(s5) < 200);
+
+    r |= assert(Level2D_mergeBlocks(l1, dirt, &count) == 0);
+    r |= assert(count == 0);
+
+    return r;
+}
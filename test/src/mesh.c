@@ -0,0 +1,100 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "test.h"
+#include "levelz.h"
+
+int main() {
+    int r = 0;
+
+    Block* stone = createBlock("stone");
+    Block* dirt = createBlock("dirt");
+
+    // single block has six faces
+    Level3D* l1 = createLevel3D(createCoordinate3D(0, 0, 0));
+    Level3D_addBlock(l1, createLevelObject3DAt(stone, makeCoordinate3D(0, 0, 0)));
+
+    LevelChunkMesh3D* m1 = Level3D_meshChunk(l1, 0, 0, 0);
+    r |= assert(m1->vertexCount == 24);
+    r |= assert(m1->indexCount == 36);
+    r |= assert(m1->materialCount == 1);
+    r |= assert(m1->materials[0] == stone);
+
+    // triangles face outwards
+    for (int q = 0; q < 6; q++) {
+        LevelMeshVertex* a = &m1->vertices[m1->indices[q * 6]];
+        LevelMeshVertex* b = &m1->vertices[m1->indices[q * 6 + 1]];
+        LevelMeshVertex* c = &m1->vertices[m1->indices[q * 6 + 2]];
+
+        float ux = b->x - a->x, uy = b->y - a->y, uz = b->z - a->z;
+        float vx = c->x - a->x, vy = c->y - a->y, vz = c->z - a->z;
+        float n[3] = {uy * vz - uz * vy, uz * vx - ux * vz, ux * vy - uy * vx};
+
+        int axis = a->face / 2;
+        float expected = (a->face & 1) ? 1 : -1;
+        r |= assert(n[axis] * expected > 0);
+    }
+    LevelChunkMesh3D_free(m1);
+
+    // filled cube merges into one quad per side
+    Level3D* l2 = createLevel3D(createCoordinate3D(0, 0, 0));
+    for (int x = 0; x < 4; x++)
+        for (int y = 0; y < 4; y++)
+            for (int z = 0; z < 4; z++)
+                Level3D_addBlock(l2, createLevelObject3DAt(createBlock("stone"), makeCoordinate3D(x, y, z)));
+
+    LevelChunkMesh3D* m2 = Level3D_meshChunk(l2, 0, 0, 0);
+    r |= assert(m2->vertexCount == 24);
+    r |= assert(m2->materialCount == 1);
+
+    float maxU = 0;
+    for (int i = 0; i < m2->vertexCount; i++)
+        if (m2->vertices[i].u > maxU) maxU = m2->vertices[i].u;
+    r |= assert(maxU == 4);
+    LevelChunkMesh3D_free(m2);
+
+    // different blocks are not merged, but their shared face is culled
+    Level3D* l3 = createLevel3D(createCoordinate3D(0, 0, 0));
+    Level3D_addBlock(l3, createLevelObject3DAt(stone, makeCoordinate3D(0, 0, 0)));
+    Level3D_addBlock(l3, createLevelObject3DAt(dirt, makeCoordinate3D(1, 0, 0)));
+
+    LevelChunkMesh3D* m3 = Level3D_meshChunk(l3, 0, 0, 0);
+    r |= assert(m3->vertexCount == 40);
+    r |= assert(m3->materialCount == 2);
+    LevelChunkMesh3D_free(m3);
+
+    // faces against a neighbouring chunk are culled
+    Level3D* l4 = createLevel3D(createCoordinate3D(0, 0, 0));
+    Level3D_addBlock(l4, createLevelObject3DAt(stone, makeCoordinate3D(15, 0, 0)));
+    Level3D_addBlock(l4, createLevelObject3DAt(stone, makeCoordinate3D(16, 0, 0)));
+
+    LevelChunkMesh3D* m4 = Level3D_meshChunk(l4, 0, 0, 0);
+    r |= assert(m4->vertexCount == 20);
+    LevelChunkMesh3D_free(m4);
+
+    LevelChunkMesh3D* m5 = Level3D_meshChunk(l4, 5, 5, 5);
+    r |= assert(m5->vertexCount == 0);
+    LevelChunkMesh3D_free(m5);
+
+    // only dirty chunks are remeshed
+    Level3D* l5 = createLevel3D(createCoordinate3D(0, 0, 0));
+    Level3D_addBlock(l5, createLevelObject3DAt(stone, makeCoordinate3D(0, 0, 0)));
+    Level3D_addBlock(l5, createLevelObject3DAt(stone, makeCoordinate3D(40, 0, 0)));
+
+    LevelMesh3D* mesh = createLevelMesh3D(l5);
+    r |= assert(LevelMesh3D_update(mesh) == 2);
+    r |= assert(LevelMesh3D_update(mesh) == 0);
+    r |= assert(LevelMesh3D_getChunk(mesh, 2, 0, 0)->vertexCount == 24);
+
+    Level3D_addBlock(l5, createLevelObject3DAt(dirt, makeCoordinate3D(41, 0, 0)));
+    r |= assert(LevelMesh3D_update(mesh) == 1);
+    r |= assert(LevelMesh3D_getChunk(mesh, 2, 0, 0)->vertexCount == 40);
+
+    Level3D_addBlock(l5, createLevelObject3DAt(stone, makeCoordinate3D(16, 0, 0)));
+    r |= assert(LevelMesh3D_update(mesh) == 3);
+    r |= assert(LevelMesh3D_getChunk(mesh, 1, 0, 0)->vertexCount == 24);
+    r |= assert(LevelMesh3D_getChunk(mesh, 9, 0, 0) == 0);
+    LevelMesh3D_free(mesh);
+
+    return r;
+}
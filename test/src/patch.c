@@ -0,0 +1,86 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "test.h"
+#include "levelz.h"
+
+int main() {
+    int r = 0;
+
+    Level2D* a = readLevel2D("@type 2\n@spawn [0, 0]\n@author me\n---\ngrass: (0, 9, 0, 9)^[0, 0]\nend");
+    Level2D* b = readLevel2D("@type 2\n@spawn [1, 1]\n---\ngrass: (0, 9, 0, 9)^[0, 0]\nend");
+
+    Level2D_addBlock(b, createLevelObject2DAt(Block_fromString("stone<key=value>"), makeCoordinate2D(3, 3)));
+    Level2D_addBlock(b, createLevelObject2DAt(createBlock("sand"), makeCoordinate2D(20, -1)));
+
+    int position = __Level2D_findBlock(b, 5, 5);
+    Level2D_removeBlock(b, b->blocks[position]);
+
+    LevelPatch2D* p1 = Level2D_diff(a, b);
+
+    r |= assert(p1->headerCount == 1);
+    r |= assert(p1->removedHeaderCount == 1);
+    r |= assert(p1->blockCount == 2);
+    r |= assert(p1->removedCount == 1);
+
+    char* str = LevelPatch2D_toString(p1);
+
+    r |= assert(strcmp(str, "-@author\n@spawn [1, 1]\n-[5, 5]\n+sand: [20, -1]\n+stone<key=value>: [3, 3]\n") == 0);
+
+    LevelPatch2D* p2 = LevelPatch2D_fromString(str);
+
+    r |= assert(p2 != 0);
+    r |= assert(p2->blockCount == 2);
+
+    Level2D_applyPatch(a, p2);
+
+    r |= assert(Level2D_getBlockCount(a) == 100);
+    r |= assert(Level2D_getHeader(a, "author") == 0);
+    r |= assert(a->spawn->x == 1);
+    r |= assert(Level2D_getBlock(a, createCoordinate2D(5, 5)) == 0);
+    r |= assert(strcmp(Block_getProperty(Level2D_getBlock(a, createCoordinate2D(3, 3)), "key"), "value") == 0);
+
+    LevelPatch2D* p3 = Level2D_diff(a, b);
+    char* str3 = LevelPatch2D_toString(p3);
+    r |= assert(p3->blockCount == 0);
+    r |= assert(strcmp(str3, "") == 0);
+
+    // patches own copies of their blocks, so they can be freed before the levels
+    LevelPatch2D_free(p1);
+    LevelPatch2D_free(p2);
+    LevelPatch2D_free(p3);
+    free(str);
+    free(str3);
+
+    r |= assert(strcmp(Block_getProperty(Level2D_getBlock(b, createCoordinate2D(3, 3)), "key"), "value") == 0);
+    r |= assert(LevelPatch2D_fromString("@spawn [0, 0]\n+stone: [1, 1]\n-[2, 2]\n+grass") == 0);
+
+    __Level2D_free(a);
+    __Level2D_free(b);
+
+    Level3D* c = createLevel3D(createCoordinate3D(0, 0, 0));
+    Level3D* d = createLevel3D(createCoordinate3D(0, 0, 0));
+    Level3D_addMatrix(c, createBlock("stone"), create3DCoordinateMatrix(0, 4, 0, 4, 0, 4, createCoordinate3D(0, 0, 0)));
+    Level3D_addMatrix(d, createBlock("stone"), create3DCoordinateMatrix(0, 4, 0, 4, 0, 4, createCoordinate3D(0, 0, 0)));
+    Level3D_addBlock(d, createLevelObject3DAt(createBlock("gold"), makeCoordinate3D(2, 2, 2)));
+
+    LevelPatch3D* p4 = Level3D_diff(c, d);
+    char* str2 = LevelPatch3D_toString(p4);
+
+    r |= assert(strcmp(str2, "+gold: [2, 2, 2]\n") == 0);
+
+    LevelPatch3D* p5 = LevelPatch3D_fromString(str2);
+    Level3D_applyPatch(c, p5);
+
+    r |= assert(strcmp(Level3D_getBlock(c, createCoordinate3D(2, 2, 2))->name, "gold") == 0);
+    r |= assert(Level3D_getBlockCount(c) == 125);
+    r |= assert(LevelPatch3D_fromString("garbage") == 0);
+
+    LevelPatch3D_free(p4);
+    LevelPatch3D_free(p5);
+    free(str2);
+    __Level3D_free(c);
+    __Level3D_free(d);
+
+    return r;
+}
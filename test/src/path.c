@@ -0,0 +1,97 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "test.h"
+#include "levelz.h"
+
+int isAir(Block* block, void* data) {
+    return strcmp(block->name, "air") == 0;
+}
+
+// Whether every step of a path moves to a walkable neighbour without cutting a corner.
+int isValidPath(LevelNavGrid2D* grid, Coordinate2D* path, int length) {
+    for (int i = 0; i < length; i++) {
+        if (!LevelNavGrid2D_isWalkable(grid, path[i])) return 0;
+        if (i == 0) continue;
+
+        double dx = path[i].x - path[i - 1].x;
+        double dy = path[i].y - path[i - 1].y;
+        if (fabs(dx) > 1 || fabs(dy) > 1 || (dx == 0 && dy == 0)) return 0;
+        if (dx != 0 && dy != 0) {
+            if (!LevelNavGrid2D_isWalkable(grid, makeCoordinate2D(path[i - 1].x + dx, path[i - 1].y))) return 0;
+            if (!LevelNavGrid2D_isWalkable(grid, makeCoordinate2D(path[i - 1].x, path[i - 1].y + dy))) return 0;
+        }
+    }
+
+    return 1;
+}
+
+int main() {
+    int r = 0;
+
+    // a wall at x = 5 between y = -5 and y = 5, with air blocks that can be walked through
+    Level2D* l1 = createLevel2D(createCoordinate2D(0, 0));
+    Level2D_addMatrix(l1, createBlock("stone"), create2DCoordinateMatrix(5, 5, -5, 5, createCoordinate2D(0, 0)));
+    Level2D_addBlock(l1, createLevelObject2DAt(createBlock("air"), makeCoordinate2D(2, 0)));
+
+    LevelNavGrid2D* grid = createLevelNavGrid2D(l1, isAir, 0, 1);
+    r |= assert(LevelNavGrid2D_update(grid) > 0);
+    r |= assert(LevelNavGrid2D_update(grid) == 0);
+    r |= assert(!LevelNavGrid2D_isWalkable(grid, makeCoordinate2D(5, 0)));
+    r |= assert(LevelNavGrid2D_isWalkable(grid, makeCoordinate2D(2, 0)));
+
+    LevelPathSearch2D* search = createLevelPathSearch2D(grid);
+    Coordinate2D path[64];
+    int length = LevelPathSearch2D_find(search, makeCoordinate2D(0, 0), makeCoordinate2D(10, 0), path, 64);
+    r |= assert(length == 15);
+    r |= assert(fabs(search->cost - (6 + 8 * sqrt(2))) < 1e-4);
+    r |= assert(path[0].x == 0 && path[0].y == 0);
+    r |= assert(path[14].x == 10 && path[14].y == 0);
+    r |= assert(isValidPath(grid, path, length));
+
+    Coordinate2D prefix[4];
+    r |= assert(LevelPathSearch2D_find(search, makeCoordinate2D(0, 0), makeCoordinate2D(10, 0), prefix, 4) == 15);
+    r |= assert(prefix[3].x == path[3].x && prefix[3].y == path[3].y);
+    r |= assert(LevelPathSearch2D_find(search, makeCoordinate2D(0, 0), makeCoordinate2D(0, 0), 0, 0) == 1);
+    r |= assert(LevelPathSearch2D_find(search, makeCoordinate2D(0, 0), makeCoordinate2D(5, 0), 0, 0) == 0);
+
+    // extending the wall only rebuilds the chunks that changed
+    Level2D_addBlock(l1, createLevelObject2DAt(createBlock("stone"), makeCoordinate2D(5, 6)));
+    Level2D_addBlock(l1, createLevelObject2DAt(createBlock("stone"), makeCoordinate2D(5, -6)));
+    r |= assert(LevelNavGrid2D_update(grid) == 2);
+
+    length = LevelPathSearch2D_find(search, makeCoordinate2D(0, 0), makeCoordinate2D(10, 0), path, 64);
+    r |= assert(length == 17);
+    r |= assert(fabs(search->cost - (8 + 8 * sqrt(2))) < 1e-4);
+    r |= assert(isValidPath(grid, path, length));
+
+    // walking on floor blocks, where empty cells are holes
+    Level2D* l2 = createLevel2D(createCoordinate2D(0, 0));
+    Level2D_addMatrix(l2, createBlock("grass"), create2DCoordinateMatrix(0, 40, 0, 2, createCoordinate2D(0, 0)));
+
+    LevelNavGrid2D* floor = createLevelNavGrid2D(l2, 0, 0, 0);
+    LevelNavGrid2D_update(floor);
+    LevelPathSearch2D* walk = createLevelPathSearch2D(floor);
+    r |= assert(LevelPathSearch2D_find(walk, makeCoordinate2D(0, 0), makeCoordinate2D(40, 2), 0, 0) == 41);
+    r |= assert(LevelPathSearch2D_find(walk, makeCoordinate2D(0, 0), makeCoordinate2D(0, 3), 0, 0) == 0);
+
+    LevelObject2D* gap[3];
+    for (int y = 0; y <= 2; y++) {
+        gap[y] = l2->blocks[0];
+        for (int i = 0; i < l2->blockCount; i++)
+            if (l2->blocks[i]->coordinate->x == 20 && l2->blocks[i]->coordinate->y == y) gap[y] = l2->blocks[i];
+        Level2D_removeBlock(l2, gap[y]);
+    }
+
+    LevelNavGrid2D_update(floor);
+    r |= assert(LevelPathSearch2D_find(walk, makeCoordinate2D(0, 0), makeCoordinate2D(40, 2), 0, 0) == 0);
+    r |= assert(LevelPathSearch2D_find(walk, makeCoordinate2D(0, 0), makeCoordinate2D(19, 1), 0, 0) == 20);
+
+    LevelPathSearch2D_free(search);
+    LevelPathSearch2D_free(walk);
+    LevelNavGrid2D_free(grid);
+    LevelNavGrid2D_free(floor);
+
+    return r;
+}
@@ -0,0 +1,87 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "test.h"
+#include "levelz.h"
+
+int main() {
+    int r = 0;
+
+    const char* path = "levelz-test-region.lvlz";
+    remove("levelz-test-region.lvlz.journal");
+    remove("levelz-test-region.lvlz.index");
+
+    Level3D* l1 = createLevel3D(createCoordinate3D(1, 2, 3));
+    Level3D_addHeader(l1, "name", "region");
+    Level3D_addMatrix(l1, createBlock("stone"), create3DCoordinateMatrix(0, 63, 0, 3, 0, 63, createCoordinate3D(0, 0, 0)));
+    Level3D_addBlock(l1, createLevelObject3D(Block_fromString("grass<snowy=true>"), createCoordinate3D(40, 4, 40)));
+    Level3D_addBlock(l1, createLevelObject3D(createBlock("sand"), createCoordinate3D(-100, 0, 0)));
+
+    r |= assert(writeFile3D(path, l1) == 1);
+    r |= assert(indexFile3D(path) == 1);
+
+    FILE* index = fopen("levelz-test-region.lvlz.index", "rb");
+    r |= assert(index != 0);
+    fclose(index);
+
+    CoordinateMatrix3D* box = create3DCoordinateMatrix(0, 7, 0, 7, 0, 7, createCoordinate3D(36, 0, 36));
+    Level3D* l2 = parseFile3DRegion(path, box);
+
+    r |= assert(l2 != 0);
+    r |= assert(Level3D_getBlockCount(l2) == 8 * 4 * 8 + 1);
+    r |= assert(l2->spawn->z == 3);
+    r |= assert(strcmp(Level3D_getHeader(l2, "name"), "region") == 0);
+    r |= assert(strcmp(Block_getProperty(Level3D_getBlock(l2, createCoordinate3D(40, 4, 40)), "snowy"), "true") == 0);
+    r |= assert(Level3D_getBlock(l2, createCoordinate3D(35, 0, 36)) == 0);
+    r |= assert(Level3D_getBlock(l2, createCoordinate3D(-100, 0, 0)) == 0);
+
+    Level3D* l3 = parseFile3DRegion(path, create3DCoordinateMatrix(-200, 200, -200, 200, -200, 200, createCoordinate3D(0, 0, 0)));
+    Level3D* l4 = parseFile3D(path);
+
+    r |= assert(Level3D_equals(l3, l4));
+
+    // edits in the journal are limited to the box too
+    r |= assert(Level3D_openJournal(l4, path) == 1);
+    Level3D_addBlock(l4, createLevelObject3D(createBlock("gold"), createCoordinate3D(37, 1, 37)));
+    Level3D_addBlock(l4, createLevelObject3D(createBlock("gold"), createCoordinate3D(0, 1, 0)));
+    Level3D_closeJournal(l4);
+
+    Level3D* l5 = parseFile3DRegion(path, box);
+
+    r |= assert(Level3D_getBlockCount(l5) == 8 * 4 * 8 + 1);
+    r |= assert(strcmp(Level3D_getBlock(l5, createCoordinate3D(37, 1, 37))->name, "gold") == 0);
+    r |= assert(Level3D_getBlock(l5, createCoordinate3D(0, 1, 0)) == 0);
+
+    // writing the file drops its index, which is rebuilt on the next query
+    r |= assert(Level3D_compact(l4, path) == 1);
+
+    index = fopen("levelz-test-region.lvlz.index", "rb");
+    r |= assert(index == 0);
+
+    Level3D* l6 = parseFile3DRegion(path, create3DCoordinateMatrix(0, 0, 0, 0, 0, 0, createCoordinate3D(0, 1, 0)));
+
+    r |= assert(Level3D_getBlockCount(l6) == 1);
+    r |= assert(strcmp(Level3D_getBlock(l6, createCoordinate3D(0, 1, 0))->name, "gold") == 0);
+
+    // a file replaced by another of the same size within the same second is reindexed
+    const char* other = "levelz-test-region-2.lvlz";
+    const char* before = "@type 3\n---\nstone: [0, 0, 0]\nend\n";
+    const char* after = "@type 3\n---\nstone: [5, 0, 0]\nend\n";
+
+    r |= assert(__writeFileAtomic(other, before, strlen(before)) == 1);
+    r |= assert(indexFile3D(other) == 1);
+    r |= assert(__writeFileAtomic(other, after, strlen(after)) == 1);
+
+    Level3D* l7 = parseFile3DRegion(other, create3DCoordinateMatrix(0, 0, 0, 0, 0, 0, createCoordinate3D(5, 0, 0)));
+
+    r |= assert(Level3D_getBlockCount(l7) == 1);
+
+    remove(other);
+    remove("levelz-test-region-2.lvlz.index");
+
+    remove(path);
+    remove("levelz-test-region.lvlz.journal");
+    remove("levelz-test-region.lvlz.index");
+
+    return r;
+}
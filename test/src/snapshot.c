@@ -0,0 +1,159 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "test.h"
+#include "levelz.h"
+
+void countBlocks(LevelObject3D* object, void* data) {
+    (*(int*) data)++;
+}
+
+typedef struct Reader {
+    LevelSnapshot2D* snapshot;
+    int count;
+    int errors;
+} Reader;
+
+void checkGrass(LevelObject2D* object, void* data) {
+    Reader* reader = (Reader*) data;
+    reader->count++;
+
+    if (strcmp(object->block->name, "grass") != 0) reader->errors++;
+    if (object->coordinate->x < 0 || object->coordinate->x > 63) reader->errors++;
+}
+
+void* readSnapshot(void* arg) {
+    Reader* reader = (Reader*) arg;
+    for (int pass = 0; pass < 50; pass++) {
+        reader->count = 0;
+        LevelSnapshot2D_forEach(reader->snapshot, checkGrass, reader);
+        if (reader->count != 4096) reader->errors++;
+
+        Block* block = LevelSnapshot2D_getBlock(reader->snapshot, createCoordinate2D(pass, pass));
+        if (block == 0 || strcmp(block->name, "grass") != 0) reader->errors++;
+    }
+
+    LevelSnapshot2D_release(reader->snapshot);
+    return 0;
+}
+
+int main() {
+    int r = 0;
+
+    Level2D* l1 = createLevel2D(createCoordinate2D(0, 0));
+    Level2D_addHeader(l1, "name", "before");
+    Level2D_addMatrix(l1, createBlock("grass"), create2DCoordinateMatrix(0, 63, 0, 63, createCoordinate2D(0, 0)));
+
+    LevelSnapshot2D* s1 = Level2D_snapshot(l1);
+
+    r |= assert(LevelSnapshot2D_getBlockCount(s1) == 4096);
+    r |= assert(s1->spawn->x == 0);
+
+    Level2D_addHeader(l1, "name", "after");
+    Level2D_addBlock(l1, createLevelObject2D(createBlock("stone"), createCoordinate2D(1, 1)));
+    Level2D_addBlock(l1, createLevelObject2D(createBlock("sand"), createCoordinate2D(-5, -5)));
+    Level2D_removeBlock(l1, l1->blocks[__Level2D_findBlock(l1, 40, 40)]);
+
+    r |= assert(LevelSnapshot2D_getBlockCount(s1) == 4096);
+    r |= assert(strcmp(LevelSnapshot2D_getHeader(s1, "name"), "before") == 0);
+    r |= assert(strcmp(LevelSnapshot2D_getBlock(s1, createCoordinate2D(1, 1))->name, "grass") == 0);
+    r |= assert(strcmp(LevelSnapshot2D_getBlock(s1, createCoordinate2D(40, 40))->name, "grass") == 0);
+    r |= assert(LevelSnapshot2D_getBlock(s1, createCoordinate2D(-5, -5)) == 0);
+    r |= assert(s1->retiredCount == 1);
+
+    LevelSnapshot2D* s2 = Level2D_snapshot(l1);
+
+    r |= assert(LevelSnapshot2D_getBlockCount(s2) == 4096);
+    r |= assert(strcmp(LevelSnapshot2D_getHeader(s2, "name"), "after") == 0);
+    r |= assert(strcmp(LevelSnapshot2D_getBlock(s2, createCoordinate2D(1, 1))->name, "stone") == 0);
+    r |= assert(strcmp(LevelSnapshot2D_getBlock(s2, createCoordinate2D(-5, -5))->name, "sand") == 0);
+    r |= assert(LevelSnapshot2D_getBlock(s2, createCoordinate2D(40, 40)) == 0);
+
+    // only the two edited chunks are copied, the other fourteen are shared
+    int shared = 0;
+    for (int i = 0; i < s1->chunkCapacity; i++) {
+        if (s1->chunks[i] == 0) continue;
+
+        for (int j = 0; j < s2->chunkCapacity; j++)
+            if (s1->chunks[i] == s2->chunks[j]) shared++;
+    }
+
+    r |= assert(shared == 14);
+
+    LevelSnapshot2D_release(s1);
+
+    r |= assert(strcmp(LevelSnapshot2D_getBlock(s2, createCoordinate2D(63, 63))->name, "grass") == 0);
+
+    LevelSnapshot2D_release(s2);
+
+    Level3D* l2 = createLevel3D(createCoordinate3D(0, 0, 0));
+    Level3D_addMatrix(l2, createBlock("stone"), create3DCoordinateMatrix(0, 31, 0, 31, 0, 31, createCoordinate3D(0, 0, 0)));
+
+    LevelSnapshot3D* s3 = Level3D_snapshot(l2);
+    Level3D_addBlock(l2, createLevelObject3D(createBlock("gold"), createCoordinate3D(31, 31, 31)));
+
+    int count = 0;
+    LevelSnapshot3D_forEach(s3, countBlocks, &count);
+
+    r |= assert(count == 32768);
+    r |= assert(strcmp(LevelSnapshot3D_getBlock(s3, createCoordinate3D(31, 31, 31))->name, "stone") == 0);
+    r |= assert(strcmp(Level3D_getBlock(l2, createCoordinate3D(31, 31, 31))->name, "gold") == 0);
+
+    LevelSnapshot3D_release(s3);
+
+    // readers iterate a snapshot while the owning thread keeps editing the level
+    Level2D* l3 = createLevel2D(createCoordinate2D(0, 0));
+    Level2D_addMatrix(l3, createBlock("grass"), create2DCoordinateMatrix(0, 63, 0, 63, createCoordinate2D(0, 0)));
+
+    LevelSnapshot2D* s4 = Level2D_snapshot(l3);
+
+    __Thread threads[4];
+    Reader readers[4];
+    for (int i = 0; i < 4; i++) {
+        readers[i].snapshot = LevelSnapshot2D_retain(s4);
+        readers[i].errors = 0;
+        __Thread_create(&threads[i], readSnapshot, &readers[i]);
+    }
+
+    Block* stone = createBlock("stone");
+    for (int i = 0; i < 2000; i++) {
+        int x = i % 64, y = (i * 7) % 64;
+        int position = __Level2D_findBlock(l3, x, y);
+        if (position >= 0)
+            Level2D_removeBlock(l3, l3->blocks[position]);
+
+        Level2D_addBlock(l3, createLevelObject2DAt(stone, makeCoordinate2D(x, y)));
+        Level2D_addBlock(l3, createLevelObject2DAt(stone, makeCoordinate2D(-x - 1, y)));
+
+        if (i % 100 == 0)
+            LevelSnapshot2D_release(Level2D_snapshot(l3));
+    }
+
+    for (int i = 0; i < 4; i++) {
+        __Thread_join(threads[i]);
+        r |= assert(readers[i].errors == 0);
+    }
+
+    r |= assert(LevelSnapshot2D_getBlockCount(s4) == 4096);
+    r |= assert(strcmp(Level2D_getBlock(l3, createCoordinate2D(0, 0))->name, "stone") == 0);
+
+    LevelSnapshot2D_release(s4);
+
+    // blocks too far out for a chunk are still part of a snapshot
+    Level3D* l5 = createLevel3D(createCoordinate3D(0, 0, 0));
+    Level3D_addBlock(l5, createLevelObject3DAt(createBlock("stone"), makeCoordinate3D(0, 0, 0)));
+    Level3D_addBlock(l5, createLevelObject3DAt(createBlock("dirt"), makeCoordinate3D(1e20, -1e20, 0)));
+
+    LevelSnapshot3D* s5 = Level3D_snapshot(l5);
+    Level3D_removeBlock(l5, l5->blocks[__Level3D_findBlock(l5, 1e20, -1e20, 0)]);
+
+    int seen = 0;
+    LevelSnapshot3D_forEach(s5, countBlocks, &seen);
+    r |= assert(seen == 2);
+    r |= assert(strcmp(LevelSnapshot3D_getBlock(s5, createCoordinate3D(1e20, -1e20, 0))->name, "dirt") == 0);
+    r |= assert(Level3D_getBlock(l5, createCoordinate3D(1e20, -1e20, 0)) == 0);
+
+    LevelSnapshot3D_release(s5);
+
+    return r;
+}
@@ -0,0 +1,105 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "test.h"
+#include "levelz.h"
+
+int main() {
+    int r = 0;
+
+    const char* path = "levelz-test-stream.lvlz";
+    remove("levelz-test-stream.lvlz.index");
+
+    Level3D* l1 = createLevel3D(createCoordinate3D(0, 0, 0));
+    Level3D_addMatrix(l1, createBlock("stone"), create3DCoordinateMatrix(0, 63, 0, 1, 0, 63, createCoordinate3D(0, 0, 0)));
+    Level3D_addBlock(l1, createLevelObject3D(Block_fromString("grass<snowy=true>"), createCoordinate3D(60, 1, 60)));
+
+    r |= assert(writeFile3D(path, l1) == 1);
+
+    // room for about four of the sixteen chunks
+    size_t chunkBytes = 16 * 2 * 16 * __LevelStream3D_objectBytes();
+    LevelStream3D* stream = createLevelStream3D(path, 0, 4 * chunkBytes, 0);
+
+    r |= assert(stream != 0);
+    r |= assert(Level3D_getBlockCount(stream->level) == 0);
+
+    int focus = LevelStream3D_addFocus(stream, createCoordinate3D(8, 0, 8));
+    LevelStream3D_update(stream);
+
+    r |= assert(LevelStream3D_isLoaded(stream, createCoordinate3D(0, 0, 0)));
+    r |= assert(Level3D_getBlockCount(stream->level) == 512);
+
+    r |= assert(strcmp(Block_getProperty(LevelStream3D_getBlock(stream, createCoordinate3D(60, 1, 60)), "snowy"), "true") == 0);
+    r |= assert(strcmp(LevelStream3D_getBlock(stream, createCoordinate3D(20, 0, 40))->name, "stone") == 0);
+    r |= assert(LevelStream3D_getBlock(stream, createCoordinate3D(100, 0, 0)) == 0);
+
+    LevelStream3D_addBlock(stream, createLevelObject3D(createBlock("gold"), createCoordinate3D(33, 0, 33)));
+
+    // touching every chunk keeps the stream within its budget
+    for (int x = 0; x < 64; x += 16)
+        for (int z = 0; z < 64; z += 16)
+            r |= assert(strcmp(LevelStream3D_getBlock(stream, createCoordinate3D(x, 0, z))->name, "stone") == 0);
+
+    r |= assert(stream->bytes <= stream->budget);
+    r |= assert(LevelStream3D_isLoaded(stream, createCoordinate3D(0, 0, 0)));
+    r |= assert(!LevelStream3D_isLoaded(stream, createCoordinate3D(33, 0, 33)));
+
+    // evicted edits are read back from the backing file
+    r |= assert(strcmp(LevelStream3D_getBlock(stream, createCoordinate3D(33, 0, 33))->name, "gold") == 0);
+
+    LevelStream3D_removeBlock(stream, createCoordinate3D(33, 0, 33));
+    for (int x = 0; x < 64; x += 16)
+        LevelStream3D_getBlock(stream, createCoordinate3D(x, 0, 63));
+
+    r |= assert(LevelStream3D_getBlock(stream, createCoordinate3D(33, 0, 33)) == 0);
+    r |= assert(LevelStream3D_getBlock(stream, createCoordinate3D(34, 0, 33)) == LevelStream3D_getBlock(stream, createCoordinate3D(0, 0, 0)));
+
+    // an equal block is replaced by the interned one
+    LevelStream3D_addBlock(stream, createLevelObject3D(createBlock("stone"), createCoordinate3D(34, 1, 33)));
+    r |= assert(LevelStream3D_getBlock(stream, createCoordinate3D(34, 1, 33)) == LevelStream3D_getBlock(stream, createCoordinate3D(0, 0, 0)));
+
+    // moving the focus prefetches the next chunk in the background
+    LevelStream3D_moveFocus(stream, focus, createCoordinate3D(24, 0, 8));
+    LevelStream3D_update(stream);
+
+    int done = !__LevelStream3D_chunk(stream, 2, 0, 0)->pending;
+    while (!done) {
+        __Mutex_lock(&stream->lock);
+        done = stream->results != 0;
+        __Mutex_unlock(&stream->lock);
+    }
+
+    LevelStream3D_update(stream);
+
+    r |= assert(LevelStream3D_isLoaded(stream, createCoordinate3D(40, 0, 8)));
+    r |= assert(LevelStream3D_isLoaded(stream, createCoordinate3D(24, 0, 8)));
+
+    LevelStream3D_free(stream);
+
+    remove(path);
+    remove("levelz-test-stream.lvlz.index");
+
+    // source entries are listed in the chunks they cover, unless they cover too many
+    Level3D* l2 = createLevel3D(createCoordinate3D(0, 0, 0));
+    Level3D_addMatrix(l2, createBlock("stone"), create3DCoordinateMatrix(0, 1, 0, 0, 0, 69999, createCoordinate3D(0, 0, 0)));
+    Level3D_addBlock(l2, createLevelObject3D(createBlock("dirt"), createCoordinate3D(5, 0, 5)));
+
+    r |= assert(writeFile3D(path, l2) == 1);
+
+    LevelStream3D* s2 = createLevelStream3D(path, 0, 64 * chunkBytes, 0);
+
+    r |= assert(s2 != 0);
+    r |= assert(s2->wideSourceCount == 1);
+    r |= assert(__LevelStream3D_chunk(s2, 0, 0, 0)->sourceCount == 1);
+    r |= assert(__LevelStream3D_chunk(s2, 0, 0, 1)->sourceCount == 0);
+    r |= assert(strcmp(LevelStream3D_getBlock(s2, createCoordinate3D(5, 0, 5))->name, "dirt") == 0);
+    r |= assert(strcmp(LevelStream3D_getBlock(s2, createCoordinate3D(1, 0, 65000))->name, "stone") == 0);
+    r |= assert(LevelStream3D_getBlock(s2, createCoordinate3D(2, 0, 65000)) == 0);
+
+    LevelStream3D_free(s2);
+
+    remove(path);
+    remove("levelz-test-stream.lvlz.index");
+
+    return r;
+}
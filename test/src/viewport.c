@@ -0,0 +1,93 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "test.h"
+#include "levelz.h"
+
+int main() {
+    int r = 0;
+
+    // a long horizontal level: a floor from x = 0 to 1023 and a pillar every 8 columns
+    Level2D* l1 = createLevel2D(createCoordinate2D(0, 0));
+    Level2D_setHeader(l1, createLevelHeader("scroll", "horizontal-right"));
+    Level2D_addMatrix(l1, createBlock("stone"), create2DCoordinateMatrix(0, 1023, 0, 0, createCoordinate2D(0, 0)));
+    for (int x = 0; x < 1024; x += 8)
+        Level2D_addBlock(l1, createLevelObject2DAt(createBlock("brick"), makeCoordinate2D(x, 1)));
+
+    r |= assert(Level2D_getScroll(l1) == HORIZONTAL_RIGHT);
+
+    LevelViewport2D* v1 = createLevelViewport2D(l1, 2);
+    LevelObject2D* objects[256];
+
+    int count = LevelViewport2D_view(v1, makeCoordinate2D(0, 0), makeCoordinate2D(31, 10), objects, 256);
+    r |= assert(count == 32 + 4);
+
+    // column-major order within the window
+    int ordered = 1;
+    for (int i = 1; i < count && i < 256; i++) {
+        Coordinate2D* a = objects[i - 1]->coordinate;
+        Coordinate2D* b = objects[i]->coordinate;
+        if (a->x > b->x || (a->x == b->x && a->y >= b->y)) ordered = 0;
+    }
+    r |= assert(ordered);
+
+    // the two strips to the right are prefetched, nothing to the left
+    LevelViewport2D_wait(v1);
+    r |= assert(LevelViewport2D_isDecoded(v1, 2));
+    r |= assert(LevelViewport2D_isDecoded(v1, 3));
+    r |= assert(!LevelViewport2D_isDecoded(v1, 4));
+    r |= assert(!LevelViewport2D_isDecoded(v1, -1));
+
+    // scrolling drops strips far behind the window
+    int total = 0;
+    for (int x = 0; x < 1024 - 32; x += 4)
+        total += LevelViewport2D_view(v1, makeCoordinate2D(x + 0.5, -1), makeCoordinate2D(x + 32.5, 0), objects, 256);
+    r |= assert(total == 248 * 32);
+    r |= assert(!LevelViewport2D_isDecoded(v1, 0));
+
+    // partial windows and capacity
+    r |= assert(LevelViewport2D_view(v1, makeCoordinate2D(10, 1), makeCoordinate2D(24, 1), objects, 1) == 2);
+    r |= assert(objects[0]->coordinate->x == 16);
+    r |= assert(LevelViewport2D_view(v1, makeCoordinate2D(5, 5), makeCoordinate2D(4, 4), objects, 256) == 0);
+
+    // edits show after a refresh
+    Level2D_addBlock(l1, createLevelObject2DAt(createBlock("brick"), makeCoordinate2D(12, 1)));
+    r |= assert(LevelViewport2D_view(v1, makeCoordinate2D(10, 1), makeCoordinate2D(20, 1), objects, 256) == 1);
+    LevelViewport2D_refresh(v1);
+    r |= assert(LevelViewport2D_view(v1, makeCoordinate2D(10, 1), makeCoordinate2D(20, 1), objects, 256) == 2);
+    r |= assert(objects[0]->coordinate->x == 12);
+
+    LevelViewport2D_free(v1);
+
+    // a vertical level scrolling down is stored in rows and prefetches below the window
+    Level2D* l2 = createLevel2D(createCoordinate2D(0, 0));
+    Level2D_setHeader(l2, createLevelHeader("scroll", "vertical-down"));
+    Level2D_addMatrix(l2, createBlock("stone"), create2DCoordinateMatrix(0, 3, -100, 0, createCoordinate2D(0, 0)));
+
+    r |= assert(Level2D_getScroll(l2) == VERTICAL_DOWN);
+
+    LevelViewport2D* v2 = createLevelViewport2D(l2, 1);
+    count = LevelViewport2D_view(v2, makeCoordinate2D(0, -15), makeCoordinate2D(1, 0), objects, 256);
+    r |= assert(count == 32);
+    r |= assert(objects[0]->coordinate->y == -15 && objects[0]->coordinate->x == 0);
+    r |= assert(objects[1]->coordinate->y == -15 && objects[1]->coordinate->x == 1);
+
+    LevelViewport2D_wait(v2);
+    r |= assert(LevelViewport2D_isDecoded(v2, -2));
+    r |= assert(!LevelViewport2D_isDecoded(v2, -3));
+
+    LevelViewport2D_free(v2);
+
+    // levels without a scroll header do not prefetch
+    Level2D* l3 = createLevel2D(createCoordinate2D(0, 0));
+    r |= assert(Level2D_getScroll(l3) == NONE);
+
+    LevelViewport2D* v3 = createLevelViewport2D(l3, 4);
+    r |= assert(LevelViewport2D_view(v3, makeCoordinate2D(0, 0), makeCoordinate2D(100, 100), objects, 256) == 0);
+    LevelViewport2D_wait(v3);
+    r |= assert(!LevelViewport2D_isDecoded(v3, 7));
+
+    LevelViewport2D_free(v3);
+
+    return r;
+}